@@ -729,3 +729,43 @@ void CO_process_TPDO(
         CO_TPDO_process(CO->TPDO[i], CO->SYNC, syncWas, timeDifference_us);
     }
 }
+
+
+#ifdef CO_USE_STATISTICS
+/******************************************************************************/
+void CO_getStats(CO_t *CO, CO_stats_t *stats){
+    CO_CANmodule_t *CANmodule = CO->CANmodule[0];
+    uint16_t i, j;
+
+    stats->CANmodule.rxMsg = CO_STAT_GET(CANmodule->stats.rxMsg);
+    stats->CANmodule.rxUnmatched = CO_STAT_GET(CANmodule->stats.rxUnmatched);
+    stats->CANmodule.rxError = CO_STAT_GET(CANmodule->stats.rxError);
+    stats->CANmodule.txMsg = CO_STAT_GET(CANmodule->stats.txMsg);
+    stats->CANmodule.txOverflow = CO_STAT_GET(CANmodule->stats.txOverflow);
+
+    stats->rxMsgNo = (CANmodule->rxSize < CO_STAT_NO_RX_MSGS) ? CANmodule->rxSize : CO_STAT_NO_RX_MSGS;
+    for(i=0; i<stats->rxMsgNo; i++){
+        stats->rxIdent[i] = (uint16_t)(CANmodule->rxArray[i].ident & 0x07FFU);
+        stats->rxCount[i] = CO_STAT_GET(CANmodule->rxArray[i].rxCount);
+    }
+
+    for(i=0; i<CO_NO_SDO_SERVER; i++){
+        CO_SDOstats_t *SDOstats = &CO->SDO[i]->stats;
+
+        stats->SDO[i].rxDropped = CO_STAT_GET(SDOstats->rxDropped);
+        stats->SDO[i].rxFifoFull = CO_STAT_GET(SDOstats->rxFifoFull);
+        stats->SDO[i].abortRx = CO_STAT_GET(SDOstats->abortRx);
+        for(j=0; j<CO_SDO_STAT_NO_ABORT_CODES; j++){
+            stats->SDO[i].abortTx[j] = CO_STAT_GET(SDOstats->abortTx[j]);
+        }
+    }
+
+    for(i=0; i<CO_NO_RPDO; i++){
+        stats->RPDO[i].rxOverwrite = CO_STAT_GET(CO->RPDO[i]->stats.rxOverwrite);
+        stats->RPDO[i].rxWrongLength = CO_STAT_GET(CO->RPDO[i]->stats.rxWrongLength);
+    }
+
+    stats->em.reported = CO_STAT_GET(CO->em->stats.reported);
+    stats->em.overflow = CO_STAT_GET(CO->em->stats.overflow);
+}
+#endif
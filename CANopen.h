@@ -145,6 +145,43 @@ typedef struct{
 extern CO_t *CO[2];
 
 
+#ifdef CO_USE_STATISTICS
+/** Maximum number of receive counters in CO_stats_t */
+#ifndef CO_STAT_NO_RX_MSGS
+    #define CO_STAT_NO_RX_MSGS  64
+#endif
+
+
+/**
+ * Snapshot of the statistics counters, see CO_USE_STATISTICS in CO_driver.h.
+ *
+ * Structure contains no pointers, so it can be copied as is, for example into
+ * shared memory, from where it is read by a monitoring process.
+ */
+typedef struct{
+    CO_CANstats_t       CANmodule;      /**< CAN module counters */
+    uint16_t            rxMsgNo;        /**< Number of valid members in rxIdent and rxCount */
+    uint16_t            rxIdent[CO_STAT_NO_RX_MSGS]; /**< CAN identifiers of receive buffers */
+    uint32_t            rxCount[CO_STAT_NO_RX_MSGS]; /**< Number of received messages for rxIdent */
+    CO_SDOstats_t       SDO[CO_NO_SDO_SERVER]; /**< SDO server counters */
+    CO_RPDOstats_t      RPDO[CO_NO_RPDO];/**< RPDO counters */
+    CO_EMstats_t        em;             /**< Emergency counters */
+}CO_stats_t;
+
+
+/**
+ * Copy statistics counters from CANopen objects into snapshot.
+ *
+ * Function may be called from any thread. Each counter is read atomically,
+ * but snapshot as a whole is not consistent.
+ *
+ * @param CO CANopen object.
+ * @param stats Snapshot to be written.
+ */
+void CO_getStats(CO_t *CO, CO_stats_t *stats);
+#endif
+
+
 /**
  * Function CO_sendNMTcommand() is simple function, which sends CANopen message.
  * This part of code is an example of custom definition of simple CANopen
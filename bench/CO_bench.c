@@ -0,0 +1,1133 @@
+/*
+ * Microbenchmarks for hot paths of CANopenNode.
+ *
+ * @file        CO_bench.c
+ * @ingroup     CO_bench
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Program runs CANopenNode objects on drvTemplate driver (no CAN hardware).
+ * Object dictionary is generated at startup and contains BENCH_NO_PDO RPDOs
+ * and BENCH_NO_PDO TPDOs, each with two mapped 32-bit variables. CAN messages
+ * are passed directly to the receive functions, registered in CO_CANmodule_t.
+ *
+ * Each test is repeated BENCH_REPEAT times and the fastest run is reported.
+ * Results are printed to stdout and written as CSV to file, specified as first
+ * argument (default: bench_results.csv).
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_Emergency.h"
+#include "CO_NMT_Heartbeat.h"
+#include "CO_SYNC.h"
+#include "CO_PDO.h"
+#include "crc16-ccitt.h"
+#include "CO_KVstore.h"
+#include "CO_flashSim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+#define BENCH_NO_PDO            512     /* Number of RPDOs and number of TPDOs */
+#define BENCH_VARS_PER_ARRAY    128     /* Number of mapped variables in one OD array */
+#define BENCH_NO_ARRAYS         ((BENCH_NO_PDO * 2) / BENCH_VARS_PER_ARRAY)
+#define BENCH_DOMAIN_SIZE       256     /* Size of variable for segmented and block transfer */
+#define BENCH_CRC_SIZE          4096    /* Size of data for CRC throughput */
+#define BENCH_REPEAT            5
+#define BENCH_KV_ENTRIES        64      /* Number of stored 32-bit parameters */
+#define BENCH_KV_SECTOR_SIZE    2048
+#define BENCH_KV_SECTORS        8
+#define BENCH_KV_POWER_CYCLES   10000   /* Power losses in kv_powerLossCheck() */
+#define BENCH_NODE_ID           0x10
+#ifdef CO_PDO_BIT_MAPPING
+#define BENCH_NO_BITPDO         32      /* Number of bit mapped RPDOs and TPDOs */
+#define BENCH_BITVARS_PER_PDO   7       /* 4 x 12 bits, 3 x 1 bit and 13-bit dummy */
+#else
+#define BENCH_NO_BITPDO         0
+#endif
+#ifdef CO_PDO_MPDO
+#define BENCH_NO_MPDO           2       /* DAM and SAM MPDO, each as RPDO and TPDO */
+#define BENCH_MPDO_PRODUCER     0x20    /* Node-ID of SAM-MPDO producer */
+#define BENCH_MPDO_TABLE_SIZE   4096    /* All RPDO mappable variables and dispatcher list */
+#else
+#define BENCH_NO_MPDO           0
+#endif
+
+/* Indexes of the generated Object Dictionary */
+#define BENCH_IDX_RPDO_DATA     0x6200U
+#define BENCH_IDX_TPDO_DATA     0x6000U
+#define BENCH_IDX_OCTET         0x2010U
+#define BENCH_IDX_BIT_DATA      0x6400U
+
+/* Indexes of CAN receive and transmit buffers */
+#define BENCH_RX_SYNC           0
+#define BENCH_RX_SDO            1
+#define BENCH_RX_RPDO           2
+#define BENCH_RX_BITPDO         (BENCH_RX_RPDO + BENCH_NO_PDO)
+#define BENCH_RX_MPDO           (BENCH_RX_BITPDO + BENCH_NO_BITPDO)
+#define BENCH_RX_NO             (BENCH_RX_MPDO + BENCH_NO_MPDO)
+#define BENCH_TX_SYNC           0
+#define BENCH_TX_EM             1
+#define BENCH_TX_SDO            2
+#define BENCH_TX_TPDO           3
+#define BENCH_TX_BITPDO         (BENCH_TX_TPDO + BENCH_NO_PDO)
+#define BENCH_TX_MPDO           (BENCH_TX_BITPDO + BENCH_NO_BITPDO)
+#define BENCH_TX_NO             (BENCH_TX_MPDO + BENCH_NO_MPDO)
+
+
+/* CANopen objects ************************************************************/
+static CO_CANmodule_t       CANmodule;
+static CO_CANrx_t           CANrx[BENCH_RX_NO];
+static CO_CANtx_t           CANtx[BENCH_TX_NO];
+static CO_SDO_t             SDO;
+static CO_EM_t              em;
+static CO_EMpr_t            emPr;
+static CO_SYNC_t            SYNC;
+static CO_RPDO_t            RPDO[BENCH_NO_PDO];
+static CO_TPDO_t            TPDO[BENCH_NO_PDO];
+#ifdef CO_PDO_BIT_MAPPING
+/* Bit mapped PDOs, their parameters are not in the Object Dictionary */
+static CO_RPDO_t            RPDObit[BENCH_NO_BITPDO];
+static CO_TPDO_t            TPDObit[BENCH_NO_BITPDO];
+#endif
+#ifdef CO_PDO_MPDO
+/* MPDOs, index 0 is DAM, index 1 is SAM, parameters are not in the Object Dictionary */
+static CO_RPDO_t            RPDOmpdo[BENCH_NO_MPDO];
+static CO_TPDO_t            TPDOmpdo[BENCH_NO_MPDO];
+static CO_MPDO_t            MPDO;
+static CO_MPDOobject_t      MPDOtable[BENCH_MPDO_TABLE_SIZE];
+static CO_MPDOobject_t      MPDOscanner[BENCH_VARS_PER_ARRAY];
+#endif
+static uint8_t              operatingState = CO_NMT_OPERATIONAL;
+
+
+/* Object Dictionary variables ************************************************/
+static uint32_t             OD_deviceType = 0x000F0191L;
+static uint8_t              OD_errorRegister;
+static uint32_t             OD_preDefinedErrorField[8];
+static uint8_t              OD_errorStatusBits[10];
+static uint32_t             OD_COB_ID_SYNC = 0x00000080L;
+static uint32_t             OD_commCyclePeriod;
+static uint32_t             OD_syncWindowLength;
+static uint8_t              OD_maxSubIndex[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+static uint32_t             OD_SDOserverCOB_ID[2] = {0x600L, 0x580L};
+static uint8_t              OD_octetString[BENCH_DOMAIN_SIZE];
+static uint32_t             OD_rpdoData[BENCH_NO_ARRAYS][BENCH_VARS_PER_ARRAY];
+static uint32_t             OD_tpdoData[BENCH_NO_ARRAYS][BENCH_VARS_PER_ARRAY];
+static CO_RPDOCommPar_t     OD_RPDOCommPar[BENCH_NO_PDO];
+static CO_RPDOMapPar_t      OD_RPDOMapPar[BENCH_NO_PDO];
+static CO_TPDOCommPar_t     OD_TPDOCommPar[BENCH_NO_PDO];
+static CO_TPDOMapPar_t      OD_TPDOMapPar[BENCH_NO_PDO];
+#ifdef CO_PDO_BIT_MAPPING
+static uint16_t             OD_bitData[BENCH_NO_BITPDO * BENCH_BITVARS_PER_PDO];
+static CO_RPDOCommPar_t     bitRPDOCommPar[BENCH_NO_BITPDO];
+static CO_RPDOMapPar_t      bitRPDOMapPar[BENCH_NO_BITPDO];
+static CO_TPDOCommPar_t     bitTPDOCommPar[BENCH_NO_BITPDO];
+static CO_TPDOMapPar_t      bitTPDOMapPar[BENCH_NO_BITPDO];
+#endif
+#ifdef CO_PDO_MPDO
+static CO_RPDOCommPar_t     mpdoRPDOCommPar[BENCH_NO_MPDO];
+static CO_RPDOMapPar_t      mpdoRPDOMapPar[BENCH_NO_MPDO];
+static CO_TPDOCommPar_t     mpdoTPDOCommPar[BENCH_NO_MPDO];
+static CO_TPDOMapPar_t      mpdoTPDOMapPar[BENCH_NO_MPDO];
+/* SAM-MPDO sends first TPDO data array and writes received into second RPDO data array */
+static const uint32_t       mpdoScannerList[1] = {
+    ((uint32_t)BENCH_VARS_PER_ARRAY << 24) | ((uint32_t)BENCH_IDX_TPDO_DATA << 8) | 1};
+static const uint64_t       mpdoDispatcherList[1] = {
+    ((uint64_t)BENCH_VARS_PER_ARRAY << 56) | ((uint64_t)(BENCH_IDX_RPDO_DATA + 1) << 40) | ((uint64_t)1 << 32)
+    | ((uint32_t)BENCH_IDX_TPDO_DATA << 16) | (1 << 8) | BENCH_MPDO_PRODUCER};
+#endif
+
+static CO_OD_entry_t       *OD;
+static CO_OD_extension_t   *ODExtensions;
+static uint16_t             ODSize;
+static CO_OD_entryRecord_t  OD_rec1200[3];
+static CO_OD_entryRecord_t  OD_recRPDOCommPar[BENCH_NO_PDO][3];
+static CO_OD_entryRecord_t  OD_recRPDOMapPar[BENCH_NO_PDO][9];
+static CO_OD_entryRecord_t  OD_recTPDOCommPar[BENCH_NO_PDO][7];
+static CO_OD_entryRecord_t  OD_recTPDOMapPar[BENCH_NO_PDO][9];
+
+
+/* Helper functions ***********************************************************/
+static uint64_t bench_ns(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_cycles(void){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void bench_errExit(const char *msg){
+    fprintf(stderr, "CO_bench: %s\n", msg);
+    exit(EXIT_FAILURE);
+}
+
+static void ODadd(uint16_t index, uint8_t maxSubIndex, uint16_t attribute, uint16_t length, void *pData){
+    CO_OD_entry_t *entry = &OD[ODSize++];
+
+    entry->index = index;
+    entry->maxSubIndex = maxSubIndex;
+    entry->attribute = attribute;
+    entry->length = length;
+    entry->pData = pData;
+}
+
+static void ODrec(CO_OD_entryRecord_t *rec, void *pData, uint16_t attribute, uint16_t length){
+    rec->pData = pData;
+    rec->attribute = attribute;
+    rec->length = length;
+}
+
+
+/* Generate Object Dictionary and initialize CANopen objects. *****************/
+#define ATTR_RO     (CO_ODA_MEM_ROM | CO_ODA_READABLE)
+#define ATTR_RW     (CO_ODA_MEM_RAM | CO_ODA_READABLE | CO_ODA_WRITEABLE)
+#define ATTR_RWMB   (ATTR_RW | CO_ODA_MB_VALUE)
+
+static void bench_init(void){
+    uint16_t i, j;
+    uint16_t noOfEntries = 17 + 4 * BENCH_NO_PDO + 2 * BENCH_NO_ARRAYS;
+
+    OD = (CO_OD_entry_t *) calloc(noOfEntries, sizeof(CO_OD_entry_t));
+    ODExtensions = (CO_OD_extension_t *) calloc(noOfEntries, sizeof(CO_OD_extension_t));
+    if(OD == NULL || ODExtensions == NULL){
+        bench_errExit("out of memory");
+    }
+
+    /* Communication profile area, entries must be sorted by index */
+    ODSize = 0;
+    ODadd(0x1000, 0, ATTR_RO | CO_ODA_MB_VALUE, 4, &OD_deviceType);
+    ODadd(0x1001, 0, CO_ODA_MEM_RAM | CO_ODA_READABLE, 1, &OD_errorRegister);
+    ODadd(0x1003, 8, ATTR_RWMB, 4, &OD_preDefinedErrorField[0]);
+    ODadd(0x1005, 0, ATTR_RWMB, 4, &OD_COB_ID_SYNC);
+    ODadd(0x1006, 0, ATTR_RWMB, 4, &OD_commCyclePeriod);
+    ODadd(0x1007, 0, ATTR_RWMB, 4, &OD_syncWindowLength);
+
+    ODrec(&OD_rec1200[0], &OD_maxSubIndex[2], ATTR_RO, 1);
+    ODrec(&OD_rec1200[1], &OD_SDOserverCOB_ID[0], ATTR_RO | CO_ODA_MB_VALUE, 4);
+    ODrec(&OD_rec1200[2], &OD_SDOserverCOB_ID[1], ATTR_RO | CO_ODA_MB_VALUE, 4);
+    ODadd(0x1200, 2, 0, 0, &OD_rec1200[0]);
+
+    for(i=0; i<BENCH_NO_PDO; i++){
+        CO_RPDOCommPar_t *c = &OD_RPDOCommPar[i];
+        CO_OD_entryRecord_t *r = &OD_recRPDOCommPar[i][0];
+
+        c->maxSubIndex = 2;
+        c->COB_IDUsedByRPDO = 0x200 + i;
+        c->transmissionType = 255;
+        ODrec(&r[0], &c->maxSubIndex, ATTR_RO, 1);
+        ODrec(&r[1], &c->COB_IDUsedByRPDO, ATTR_RWMB, 4);
+        ODrec(&r[2], &c->transmissionType, ATTR_RW, 1);
+        ODadd(0x1400 + i, 2, 0, 0, r);
+    }
+    for(i=0; i<BENCH_NO_PDO; i++){
+        CO_RPDOMapPar_t *m = &OD_RPDOMapPar[i];
+        CO_OD_entryRecord_t *r = &OD_recRPDOMapPar[i][0];
+        uint32_t *pMap = &m->mappedObject1;
+        uint16_t var = i * 2;
+
+        m->numberOfMappedObjects = 2;
+        pMap[0] = ((uint32_t)(BENCH_IDX_RPDO_DATA + var / BENCH_VARS_PER_ARRAY) << 16)
+                | ((uint32_t)(var % BENCH_VARS_PER_ARRAY + 1) << 8) | 0x20;
+        var++;
+        pMap[1] = ((uint32_t)(BENCH_IDX_RPDO_DATA + var / BENCH_VARS_PER_ARRAY) << 16)
+                | ((uint32_t)(var % BENCH_VARS_PER_ARRAY + 1) << 8) | 0x20;
+        ODrec(&r[0], &m->numberOfMappedObjects, ATTR_RW, 1);
+        for(j=0; j<8; j++){
+            ODrec(&r[j+1], &pMap[j], ATTR_RWMB, 4);
+        }
+        ODadd(0x1600 + i, 8, 0, 0, r);
+    }
+    for(i=0; i<BENCH_NO_PDO; i++){
+        CO_TPDOCommPar_t *c = &OD_TPDOCommPar[i];
+        CO_OD_entryRecord_t *r = &OD_recTPDOCommPar[i][0];
+
+        c->maxSubIndex = 6;
+        c->COB_IDUsedByTPDO = 0x180 + i;
+        c->transmissionType = 255;
+        ODrec(&r[0], &c->maxSubIndex, ATTR_RO, 1);
+        ODrec(&r[1], &c->COB_IDUsedByTPDO, ATTR_RWMB, 4);
+        ODrec(&r[2], &c->transmissionType, ATTR_RW, 1);
+        ODrec(&r[3], &c->inhibitTime, ATTR_RWMB, 2);
+        ODrec(&r[4], &c->compatibilityEntry, ATTR_RW, 1);
+        ODrec(&r[5], &c->eventTimer, ATTR_RWMB, 2);
+        ODrec(&r[6], &c->SYNCStartValue, ATTR_RW, 1);
+        ODadd(0x1800 + i, 6, 0, 0, r);
+    }
+    for(i=0; i<BENCH_NO_PDO; i++){
+        CO_TPDOMapPar_t *m = &OD_TPDOMapPar[i];
+        CO_OD_entryRecord_t *r = &OD_recTPDOMapPar[i][0];
+        uint32_t *pMap = &m->mappedObject1;
+        uint16_t var = i * 2;
+
+        m->numberOfMappedObjects = 2;
+        pMap[0] = ((uint32_t)(BENCH_IDX_TPDO_DATA + var / BENCH_VARS_PER_ARRAY) << 16)
+                | ((uint32_t)(var % BENCH_VARS_PER_ARRAY + 1) << 8) | 0x20;
+        var++;
+        pMap[1] = ((uint32_t)(BENCH_IDX_TPDO_DATA + var / BENCH_VARS_PER_ARRAY) << 16)
+                | ((uint32_t)(var % BENCH_VARS_PER_ARRAY + 1) << 8) | 0x20;
+        ODrec(&r[0], &m->numberOfMappedObjects, ATTR_RW, 1);
+        for(j=0; j<8; j++){
+            ODrec(&r[j+1], &pMap[j], ATTR_RWMB, 4);
+        }
+        ODadd(0x1A00 + i, 8, 0, 0, r);
+    }
+
+    /* Manufacturer and device profile area */
+    ODadd(BENCH_IDX_OCTET, 0, ATTR_RW, BENCH_DOMAIN_SIZE, &OD_octetString[0]);
+    for(i=0; i<BENCH_NO_ARRAYS; i++){
+        ODadd(BENCH_IDX_TPDO_DATA + i, BENCH_VARS_PER_ARRAY,
+              ATTR_RWMB | CO_ODA_TPDO_MAPABLE | CO_ODA_TPDO_DETECT_COS,
+              4, &OD_tpdoData[i][0]);
+    }
+    for(i=0; i<BENCH_NO_ARRAYS; i++){
+        ODadd(BENCH_IDX_RPDO_DATA + i, BENCH_VARS_PER_ARRAY,
+              ATTR_RWMB | CO_ODA_RPDO_MAPABLE, 4, &OD_rpdoData[i][0]);
+    }
+#ifdef CO_PDO_BIT_MAPPING
+    ODadd(BENCH_IDX_BIT_DATA, BENCH_NO_BITPDO * BENCH_BITVARS_PER_PDO,
+          ATTR_RWMB | CO_ODA_RPDO_MAPABLE | CO_ODA_TPDO_MAPABLE, 2, &OD_bitData[0]);
+#endif
+
+    /* CANopen objects */
+    if(CO_CANmodule_init(&CANmodule, 0, CANrx, BENCH_RX_NO, CANtx, BENCH_TX_NO, 1000) != CO_ERROR_NO){
+        bench_errExit("CO_CANmodule_init failed");
+    }
+    if(CO_SDO_init(&SDO, 0x600 + BENCH_NODE_ID, 0x580 + BENCH_NODE_ID, OD_H1200_SDO_SERVER_PARAM,
+                   NULL, OD, ODSize, ODExtensions, BENCH_NODE_ID,
+                   &CANmodule, BENCH_RX_SDO, &CANmodule, BENCH_TX_SDO) != CO_ERROR_NO){
+        bench_errExit("CO_SDO_init failed");
+    }
+    if(CO_EM_init(&em, &emPr, &SDO, &OD_errorStatusBits[0], sizeof(OD_errorStatusBits),
+                  &OD_errorRegister, &OD_preDefinedErrorField[0], 8,
+                  &CANmodule, BENCH_TX_EM, 0x80 + BENCH_NODE_ID) != CO_ERROR_NO){
+        bench_errExit("CO_EM_init failed");
+    }
+    if(CO_SYNC_init(&SYNC, &em, &SDO, &operatingState, OD_COB_ID_SYNC, OD_commCyclePeriod, 0,
+                    &CANmodule, BENCH_RX_SYNC, &CANmodule, BENCH_TX_SYNC) != CO_ERROR_NO){
+        bench_errExit("CO_SYNC_init failed");
+    }
+    for(i=0; i<BENCH_NO_PDO; i++){
+        if(CO_RPDO_init(&RPDO[i], &em, &SDO, &SYNC, &operatingState, BENCH_NODE_ID, 0, 0,
+                        &OD_RPDOCommPar[i], &OD_RPDOMapPar[i], 0x1400 + i, 0x1600 + i,
+                        &CANmodule, BENCH_RX_RPDO + i) != CO_ERROR_NO || !RPDO[i].valid){
+            bench_errExit("CO_RPDO_init failed");
+        }
+        if(CO_TPDO_init(&TPDO[i], &em, &SDO, &operatingState, BENCH_NODE_ID, 0, 0,
+                        &OD_TPDOCommPar[i], &OD_TPDOMapPar[i], 0x1800 + i, 0x1A00 + i,
+                        &CANmodule, BENCH_TX_TPDO + i) != CO_ERROR_NO || !TPDO[i].valid){
+            bench_errExit("CO_TPDO_init failed");
+        }
+    }
+#ifdef CO_PDO_BIT_MAPPING
+    for(i=0; i<BENCH_NO_BITPDO; i++){
+        static const uint8_t bits[8] = {12, 1, 12, 1, 12, 1, 12, 13};
+        uint32_t *pRMap = &bitRPDOMapPar[i].mappedObject1;
+        uint32_t *pTMap = &bitTPDOMapPar[i].mappedObject1;
+        uint16_t var = i * BENCH_BITVARS_PER_PDO;
+
+        for(j=0; j<8; j++){
+            if(j < 7){
+                pRMap[j] = ((uint32_t)BENCH_IDX_BIT_DATA << 16) | ((uint32_t)(var + j + 1) << 8) | bits[j];
+            }
+            else{
+                pRMap[j] = 0x00060000UL | bits[j];  /* UNSIGNED16 dummy */
+            }
+            pTMap[j] = pRMap[j];
+        }
+        bitRPDOMapPar[i].numberOfMappedObjects = 8;
+        bitTPDOMapPar[i].numberOfMappedObjects = 8;
+        bitRPDOCommPar[i].COB_IDUsedByRPDO = 0x480 + i;
+        bitRPDOCommPar[i].transmissionType = 255;
+        bitTPDOCommPar[i].COB_IDUsedByTPDO = 0x500 + i;
+        bitTPDOCommPar[i].transmissionType = 255;
+        if(CO_RPDO_init(&RPDObit[i], &em, &SDO, &SYNC, &operatingState, BENCH_NODE_ID, 0, 0,
+                        &bitRPDOCommPar[i], &bitRPDOMapPar[i], 0, 0,
+                        &CANmodule, BENCH_RX_BITPDO + i) != CO_ERROR_NO
+            || !RPDObit[i].valid || !RPDObit[i].bitMapped || RPDObit[i].dataLength != 8)
+        {
+            bench_errExit("CO_RPDO_init bit mapped failed");
+        }
+        if(CO_TPDO_init(&TPDObit[i], &em, &SDO, &operatingState, BENCH_NODE_ID, 0, 0,
+                        &bitTPDOCommPar[i], &bitTPDOMapPar[i], 0, 0,
+                        &CANmodule, BENCH_TX_BITPDO + i) != CO_ERROR_NO
+            || !TPDObit[i].valid || !TPDObit[i].bitMapped)
+        {
+            bench_errExit("CO_TPDO_init bit mapped failed");
+        }
+    }
+#endif
+#ifdef CO_PDO_MPDO
+    {
+        CO_RPDO_t *RPDOptrMPDO[BENCH_NO_MPDO];
+        CO_TPDO_t *TPDOptrMPDO[BENCH_NO_MPDO];
+
+        for(i=0; i<BENCH_NO_MPDO; i++){
+            mpdoRPDOMapPar[i].numberOfMappedObjects = (i == 0) ? CO_PDO_MPDO_DAM : CO_PDO_MPDO_SAM;
+            mpdoTPDOMapPar[i].numberOfMappedObjects = mpdoRPDOMapPar[i].numberOfMappedObjects;
+            mpdoTPDOMapPar[i].mappedObject1 = ((uint32_t)BENCH_IDX_TPDO_DATA << 16) | 0x0120;
+            mpdoRPDOCommPar[i].COB_IDUsedByRPDO = 0x680 + i;
+            mpdoRPDOCommPar[i].transmissionType = 255;
+            mpdoTPDOCommPar[i].COB_IDUsedByTPDO = 0x690 + i;
+            mpdoTPDOCommPar[i].transmissionType = 255;
+            if(CO_RPDO_init(&RPDOmpdo[i], &em, &SDO, &SYNC, &operatingState, BENCH_NODE_ID, 0, 0,
+                            &mpdoRPDOCommPar[i], &mpdoRPDOMapPar[i], 0, 0,
+                            &CANmodule, BENCH_RX_MPDO + i) != CO_ERROR_NO
+                || CO_TPDO_init(&TPDOmpdo[i], &em, &SDO, &operatingState, BENCH_NODE_ID, 0, 0,
+                            &mpdoTPDOCommPar[i], &mpdoTPDOMapPar[i], 0, 0,
+                            &CANmodule, BENCH_TX_MPDO + i) != CO_ERROR_NO)
+            {
+                bench_errExit("CO_RPDO_init or CO_TPDO_init MPDO failed");
+            }
+            RPDOptrMPDO[i] = &RPDOmpdo[i];
+            TPDOptrMPDO[i] = &TPDOmpdo[i];
+        }
+        if(CO_MPDO_init(&MPDO, &SDO, BENCH_NODE_ID, RPDOptrMPDO, BENCH_NO_MPDO, TPDOptrMPDO, BENCH_NO_MPDO,
+                        mpdoScannerList, 1, mpdoDispatcherList, 1,
+                        MPDOscanner, BENCH_VARS_PER_ARRAY, MPDOtable, BENCH_MPDO_TABLE_SIZE) != CO_ERROR_NO
+            || MPDO.noScanner != BENCH_VARS_PER_ARRAY || !RPDOmpdo[0].valid || !RPDOmpdo[1].valid
+            || !TPDOmpdo[0].valid || !TPDOmpdo[1].valid)
+        {
+            bench_errExit("CO_MPDO_init failed");
+        }
+    }
+#endif
+    CO_CANsetNormalMode(&CANmodule);
+}
+
+
+/* SDO client, which talks directly to the SDO server *************************/
+static void sdoRequest(const uint8_t d0, uint16_t index, uint8_t subIndex, const uint8_t *data){
+    CO_CANrxMsg_t msg;
+    CO_CANrx_t *rx = &CANmodule.rxArray[BENCH_RX_SDO];
+
+    msg.ident = 0x600 + BENCH_NODE_ID;
+    msg.DLC = 8;
+    msg.data[0] = d0;
+    msg.data[1] = (uint8_t) index;
+    msg.data[2] = (uint8_t) (index >> 8);
+    msg.data[3] = subIndex;
+    memcpy(&msg.data[4], data, 4);
+    rx->pFunct(rx->object, &msg);
+}
+
+static void sdoSegment(const uint8_t *data){
+    CO_CANrxMsg_t msg;
+    CO_CANrx_t *rx = &CANmodule.rxArray[BENCH_RX_SDO];
+
+    msg.ident = 0x600 + BENCH_NODE_ID;
+    msg.DLC = 8;
+    memcpy(&msg.data[0], data, 8);
+    rx->pFunct(rx->object, &msg);
+}
+
+static uint8_t sdoProcess(void){
+    uint16_t timerNext = 50;
+
+    if(CO_SDO_process(&SDO, true, 1, 1000, &timerNext) < 0){
+        bench_errExit("SDO transfer aborted");
+    }
+    return SDO.CANtxBuff->data[0];
+}
+
+
+/* Tests, each runs specified number of operations ****************************/
+static uint16_t ODfindIndex[1024];
+static volatile uint32_t sink;
+
+static void test_OD_find(uint32_t n){
+    uint32_t i, sum = 0;
+
+    for(i=0; i<n; i++){
+        sum += CO_OD_find(&SDO, ODfindIndex[i & 1023]);
+    }
+    sink = sum;
+}
+
+static void test_TPDOisCOS(uint32_t n){
+    uint32_t i, sum = 0;
+
+    for(i=0; i<n; i++){
+        sum += CO_TPDOisCOS(&TPDO[i % BENCH_NO_PDO]);
+    }
+    sink = sum;
+}
+
+static void test_TPDOsend(uint32_t n){
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        OD_tpdoData[0][0] = i;
+        CO_TPDOsend(&TPDO[i % BENCH_NO_PDO]);
+    }
+}
+
+static void test_RPDO_receive(uint32_t n){
+    uint32_t i;
+    CO_CANrxMsg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.DLC = 8;
+    for(i=0; i<n; i++){
+        CO_CANrx_t *rx = &CANmodule.rxArray[BENCH_RX_RPDO + i % BENCH_NO_PDO];
+
+        msg.ident = rx->ident;
+        msg.data[0] = (uint8_t) i;
+        rx->pFunct(rx->object, &msg);
+    }
+}
+
+static void test_RPDO_process(uint32_t n){
+    uint32_t i;
+    CO_CANrxMsg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.DLC = 8;
+    for(i=0; i<n; i++){
+        uint16_t pdo = i % BENCH_NO_PDO;
+        CO_CANrx_t *rx = &CANmodule.rxArray[BENCH_RX_RPDO + pdo];
+
+        msg.ident = rx->ident;
+        msg.data[0] = (uint8_t) i;
+        rx->pFunct(rx->object, &msg);
+        CO_RPDO_process(&RPDO[pdo], false);
+    }
+}
+
+#ifdef CO_PDO_BIT_MAPPING
+static void test_TPDOsend_bits(uint32_t n){
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        OD_bitData[0] = (uint16_t) i;
+        CO_TPDOsend(&TPDObit[i % BENCH_NO_BITPDO]);
+    }
+}
+
+static void test_RPDO_process_bits(uint32_t n){
+    uint32_t i;
+    CO_CANrxMsg_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.DLC = 8;
+    for(i=0; i<n; i++){
+        uint16_t pdo = i % BENCH_NO_BITPDO;
+        CO_CANrx_t *rx = &CANmodule.rxArray[BENCH_RX_BITPDO + pdo];
+
+        msg.ident = rx->ident;
+        msg.data[0] = (uint8_t) i;
+        rx->pFunct(rx->object, &msg);
+        CO_RPDO_process(&RPDObit[pdo], false);
+    }
+}
+#endif
+
+#ifdef CO_PDO_MPDO
+/* Each MPDO writes different variable, so receive and process run together */
+static void test_RPDO_process_MPDO(uint32_t n, uint8_t mpdo, uint8_t address){
+    uint32_t i;
+    CO_CANrxMsg_t msg;
+    CO_CANrx_t *rx = &CANmodule.rxArray[BENCH_RX_MPDO + mpdo];
+    uint16_t index = (mpdo == 0) ? BENCH_IDX_RPDO_DATA : BENCH_IDX_TPDO_DATA;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.ident = rx->ident;
+    msg.DLC = 8;
+    msg.data[0] = address;
+    for(i=0; i<n; i++){
+        uint16_t var = (uint16_t)(i % ((mpdo == 0) ? (BENCH_NO_ARRAYS * BENCH_VARS_PER_ARRAY) : BENCH_VARS_PER_ARRAY));
+        uint16_t idx = index + var / BENCH_VARS_PER_ARRAY;
+
+        msg.data[1] = (uint8_t) idx;
+        msg.data[2] = (uint8_t)(idx >> 8);
+        msg.data[3] = (uint8_t)(var % BENCH_VARS_PER_ARRAY + 1);
+        msg.data[4] = (uint8_t) i;
+        rx->pFunct(rx->object, &msg);
+        CO_RPDO_process(&RPDOmpdo[mpdo], false);
+    }
+}
+
+static void test_RPDO_process_DAM(uint32_t n){
+    test_RPDO_process_MPDO(n, 0, 0x80 | BENCH_NODE_ID);
+}
+
+static void test_RPDO_process_SAM(uint32_t n){
+    test_RPDO_process_MPDO(n, 1, BENCH_MPDO_PRODUCER);
+}
+
+static void test_TPDOsendMPDO_DAM(uint32_t n){
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        uint8_t data[4] = {(uint8_t) i, 0, 0, 0};
+
+        CO_TPDOsendMPDO(&TPDOmpdo[0], (uint8_t)(i % 127 + 1), BENCH_IDX_RPDO_DATA,
+                        (uint8_t)(i % BENCH_VARS_PER_ARRAY + 1), data);
+    }
+}
+
+static void test_TPDOsend_SAM(uint32_t n){
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        CO_TPDOsend(&TPDOmpdo[1]);
+    }
+}
+#endif
+
+#ifdef CO_PDO_PROCESS_IMAGE
+/* PDO data are exchanged with the process image. It is initialized by the
+ * first test and remains in use, so these tests must be the last PDO tests. */
+static CO_PDOimage_t        PI;
+static CO_RPDO_t           *RPDOptr[BENCH_NO_PDO];
+static CO_TPDO_t           *TPDOptr[BENCH_NO_PDO];
+static uint8_t              PIinput[BENCH_NO_PDO * 8];
+static uint8_t              PIoutput[BENCH_NO_PDO * 8];
+
+static void PIinit(void){
+    uint16_t i;
+
+    if(RPDO[0].PI != NULL) return;
+    for(i=0; i<BENCH_NO_PDO; i++){
+        RPDOptr[i] = &RPDO[i];
+        TPDOptr[i] = &TPDO[i];
+    }
+    if(CO_PDOimage_init(&PI, RPDOptr, BENCH_NO_PDO, TPDOptr, BENCH_NO_PDO, PIinput, PIoutput) != CO_ERROR_NO
+        || PI.inputUsed != BENCH_NO_PDO * 8 || CO_PDOimage_find(&PI, BENCH_IDX_RPDO_DATA, 3, true) != &PIinput[8])
+    {
+        bench_errExit("CO_PDOimage_init failed");
+    }
+}
+
+static void test_TPDOsend_image(uint32_t n){
+    uint32_t i;
+
+    PIinit();
+    for(i=0; i<n; i++){
+        PIoutput[0] = (uint8_t) i;
+        CO_TPDOsend(&TPDO[i % BENCH_NO_PDO]);
+    }
+}
+
+static void test_RPDO_process_image(uint32_t n){
+    PIinit();
+    test_RPDO_process(n);
+}
+#endif
+
+static void test_SDO_expedited_upload(uint32_t n){
+    uint32_t i;
+    const uint8_t zero[4] = {0, 0, 0, 0};
+
+    for(i=0; i<n; i++){
+        sdoRequest(0x40, 0x6000, 1 + (i & 0x3F), zero);
+        if((sdoProcess() & 0xE0) != 0x40) bench_errExit("expedited upload failed");
+    }
+}
+
+static void test_SDO_expedited_download(uint32_t n){
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        sdoRequest(0x23, 0x6200, 1 + (i & 0x3F), (const uint8_t *)&i);
+        if(sdoProcess() != 0x60) bench_errExit("expedited download failed");
+    }
+}
+
+#ifdef CO_SDO_FAST_PATH
+/* Response is sent from CAN receive, CO_SDO_process() is not called. Data
+ * are verified against the Object Dictionary. */
+static void test_SDO_fast_upload(uint32_t n){
+    uint32_t i;
+    const uint8_t zero[4] = {0, 0, 0, 0};
+
+    for(i=0; i<n; i++){
+        uint32_t value;
+
+        OD_tpdoData[0][i & 0x3F] = i;
+        sdoRequest(0x40, 0x6000, 1 + (i & 0x3F), zero);
+        CO_memcpySwap4(&value, &SDO.CANtxBuff->data[4]);
+        if(SDO.CANtxBuff->data[0] != 0x43 || value != i) bench_errExit("fast upload failed");
+        SDO.CANtxBuff->data[0] = 0;
+    }
+}
+
+static void test_SDO_fast_download(uint32_t n){
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        uint8_t data[4];
+
+        CO_memcpySwap4(data, &i);
+        sdoRequest(0x23, 0x6200, 1 + (i & 0x3F), data);
+        if(SDO.CANtxBuff->data[0] != 0x60 || OD_rpdoData[0][i & 0x3F] != i) bench_errExit("fast download failed");
+        SDO.CANtxBuff->data[0] = 0;
+    }
+}
+#endif
+
+static void test_SDO_segmented_upload(uint32_t n){
+    uint32_t i;
+    const uint8_t zero[4] = {0, 0, 0, 0};
+
+    for(i=0; i<n; i++){
+        uint8_t toggle = 0;
+        uint8_t seg[8];
+
+        sdoRequest(0x40, BENCH_IDX_OCTET, 0, zero);
+        if(sdoProcess() != 0x41) bench_errExit("segmented upload failed");
+        memset(seg, 0, sizeof(seg));
+        for(;;){
+            uint8_t resp;
+
+            seg[0] = 0x60 | toggle;
+            sdoSegment(seg);
+            resp = sdoProcess();
+            if((resp & 0xE0) != 0x00) bench_errExit("segmented upload failed");
+            if(resp & 0x01) break;
+            toggle ^= 0x10;
+        }
+    }
+}
+
+static void test_SDO_segmented_download(uint32_t n){
+    uint32_t i;
+    uint32_t size = BENCH_DOMAIN_SIZE;
+
+    for(i=0; i<n; i++){
+        uint8_t toggle = 0;
+        uint32_t offset = 0;
+        uint8_t seg[8];
+
+        sdoRequest(0x21, BENCH_IDX_OCTET, 0, (const uint8_t *)&size);
+        if(sdoProcess() != 0x60) bench_errExit("segmented download failed");
+        memset(seg, (uint8_t) i, sizeof(seg));
+        while(offset < size){
+            uint32_t len = size - offset;
+
+            if(len > 7) len = 7;
+            offset += len;
+            seg[0] = toggle | ((7 - len) << 1) | ((offset == size) ? 1 : 0);
+            sdoSegment(seg);
+            if((sdoProcess() & 0xE0) != 0x20) bench_errExit("segmented download failed");
+            toggle ^= 0x10;
+        }
+    }
+}
+
+static void test_SDO_block_download(uint32_t n){
+    uint32_t i;
+    uint32_t size = BENCH_DOMAIN_SIZE;
+
+    for(i=0; i<n; i++){
+        uint32_t offset = 0;
+        uint8_t seqno = 0;
+        uint8_t blksize;
+        uint8_t seg[8];
+        uint16_t crc;
+
+        memset(OD_octetString, (uint8_t) i, sizeof(OD_octetString));
+        sdoRequest(0xC6, BENCH_IDX_OCTET, 0, (const uint8_t *)&size);
+        if(sdoProcess() != 0xA4) bench_errExit("block download failed");
+        blksize = SDO.CANtxBuff->data[4];
+
+        /* sub-block segments are processed directly in receive function */
+        while(offset < size){
+            uint32_t len = size - offset;
+
+            if(len > 7) len = 7;
+            memset(seg, (uint8_t) i, sizeof(seg));
+            memcpy(&seg[1], &OD_octetString[offset], len);
+            offset += len;
+            seg[0] = ++seqno | ((offset == size) ? 0x80 : 0);
+            sdoSegment(seg);
+            if(seqno == blksize || offset == size){
+                if(sdoProcess() != 0xA2) bench_errExit("block download failed");
+                blksize = SDO.CANtxBuff->data[2];
+                seqno = 0;
+            }
+        }
+
+        crc = crc16_ccitt(OD_octetString, size, 0);
+        memset(seg, 0, sizeof(seg));
+        seg[0] = 0xC1 | ((uint8_t)((7 - size % 7) % 7) << 2);
+        seg[1] = (uint8_t) crc;
+        seg[2] = (uint8_t) (crc >> 8);
+        sdoSegment(seg);
+        if(sdoProcess() != 0xA1) bench_errExit("block download failed");
+    }
+}
+
+static void test_EM_report_process(uint32_t n){
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        CO_errorReport(&em, CO_EM_GENERIC_ERROR, CO_EMC_GENERIC, i);
+        CO_EM_process(&emPr, true, 10, 0);
+        CO_errorReset(&em, CO_EM_GENERIC_ERROR, i);
+        CO_EM_process(&emPr, true, 10, 0);
+    }
+}
+
+static void test_crc16_8(uint32_t n){
+    uint32_t i, sum = 0;
+
+    for(i=0; i<n; i++){
+        sum += crc16_ccitt(OD_octetString, 8, (unsigned short) i);
+    }
+    sink = sum;
+}
+
+static void test_crc16_889(uint32_t n){
+    static uint8_t buf[889];
+    uint32_t i, sum = 0;
+
+    for(i=0; i<n; i++){
+        sum += crc16_ccitt(buf, sizeof(buf), (unsigned short) i);
+    }
+    sink = sum;
+}
+
+#if CO_CRC16_SLICES > 0
+static uint8_t crcData[BENCH_CRC_SIZE];
+
+static void test_crc16_bytewise(uint32_t n){
+    uint32_t i, sum = 0;
+
+    for(i=0; i<n; i++){
+        sum += crc16_ccitt_bytewise(crcData, sizeof(crcData), (unsigned short) i);
+    }
+    sink = sum;
+}
+
+static void test_crc16_slicing(uint32_t n){
+    uint32_t i, sum = 0;
+
+    for(i=0; i<n; i++){
+        sum += crc16_ccitt_slicing(crcData, sizeof(crcData), (unsigned short) i);
+    }
+    sink = sum;
+}
+
+static void test_crc16_clmul(uint32_t n){
+    uint32_t i, sum = 0;
+
+    for(i=0; i<n; i++){
+        sum += crc16_ccitt_clmul(crcData, sizeof(crcData), (unsigned short) i);
+    }
+    sink = sum;
+}
+
+/* Verify, that all CRC implementations give the same result as the
+ * portable one, for all lengths up to 1024, different alignments and
+ * initial values. */
+static void crc16_crossCheck(void){
+    uint32_t i, len, offset, seed = 12345;
+
+    for(i=0; i<sizeof(crcData); i++){
+        seed = seed * 1103515245U + 12345U;
+        crcData[i] = (uint8_t)(seed >> 16);
+    }
+
+    for(offset=0; offset<4; offset++){
+        for(len=0; len<=1024; len++){
+            unsigned short init = (unsigned short)(seed = seed * 1103515245U + 12345U);
+            unsigned short ref = crc16_ccitt_bytewise(&crcData[offset], len, init);
+
+            if(crc16_ccitt_slicing(&crcData[offset], len, init) != ref
+                || crc16_ccitt_clmul(&crcData[offset], len, init) != ref
+                || crc16_ccitt(&crcData[offset], len, init) != ref)
+            {
+                fprintf(stderr, "crc16 mismatch: length=%u, offset=%u\n", len, offset);
+                bench_errExit("crc16 cross-check failed");
+            }
+        }
+    }
+    printf("crc16_ccitt: %s, cross-check passed\n", crc16_ccitt_implementation());
+}
+#endif
+
+
+/* Parameter storage in flash. One parameter is changed and stored in each
+ * operation: by appending to the key/value log or by erasing the sector and
+ * writing the whole image, as CO_Flash.c of the MCU drivers. */
+static uint32_t             kvData[BENCH_KV_ENTRIES];
+static CO_KVentry_t         kvEntries[BENCH_KV_ENTRIES];
+static CO_KVstore_t         kv;
+static CO_flashSim_t        kvSim;
+static CO_flashSim_t        pageSim;
+static uint32_t             kvStores;
+static uint32_t             pageStores;
+
+static void kv_init(void){
+    uint16_t i;
+
+    for(i=0; i<BENCH_KV_ENTRIES; i++){
+        kvEntries[i].key = 0x20000000UL | ((uint32_t)(i + 1U) << 8);
+        kvEntries[i].data = &kvData[i];
+        kvEntries[i].length = sizeof(kvData[i]);
+    }
+    if(CO_flashSim_init(&kvSim, BENCH_KV_SECTOR_SIZE, BENCH_KV_SECTORS, 4, NULL) != CO_ERROR_NO
+        || CO_flashSim_init(&pageSim, BENCH_KV_SECTOR_SIZE, BENCH_KV_SECTORS, 4, NULL) != CO_ERROR_NO
+        || CO_KVstore_init(&kv, &kvSim.flash, kvEntries, BENCH_KV_ENTRIES) != CO_ERROR_NO)
+    {
+        bench_errExit("flash simulator init failed");
+    }
+}
+
+static void test_KVstore_store(uint32_t n){
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        uint16_t entry = (uint16_t)(i % BENCH_KV_ENTRIES);
+
+        kvData[entry]++;
+        if(CO_KVstore_storeEntry(&kv, entry) != CO_ERROR_NO
+            || CO_KVstore_process(&kv, false) != CO_ERROR_NO)
+        {
+            bench_errExit("KVstore store failed");
+        }
+    }
+    kvStores += n;
+}
+
+static void test_page_rewrite(uint32_t n){
+    const CO_flash_t *flash = &pageSim.flash;
+    uint32_t i;
+
+    for(i=0; i<n; i++){
+        uint32_t crc;
+
+        kvData[i % BENCH_KV_ENTRIES]++;
+        crc = crc16_ccitt((unsigned char *)kvData, sizeof(kvData), 0);
+        if(flash->erase(flash->object, 0) != CO_ERROR_NO
+            || flash->write(flash->object, 0, kvData, sizeof(kvData)) != CO_ERROR_NO
+            || flash->write(flash->object, sizeof(kvData), &crc, sizeof(crc)) != CO_ERROR_NO)
+        {
+            bench_errExit("page rewrite failed");
+        }
+    }
+    pageStores += n;
+}
+
+/* Power loss at random write or erase during store and compaction. After
+ * each power cycle, every entry must have its last stored value, the entry,
+ * which was being stored, may also have the previous value. */
+static void kv_powerLossCheck(void){
+    static uint32_t plData[BENCH_KV_ENTRIES];
+    static uint32_t plStored[BENCH_KV_ENTRIES];
+    static CO_KVentry_t plEntries[BENCH_KV_ENTRIES];
+    CO_flashSim_t plSim;
+    CO_KVstore_t plKv;
+    uint32_t rnd = 12345, value = 0, cycle;
+    uint16_t i;
+
+    for(i=0; i<BENCH_KV_ENTRIES; i++){
+        plEntries[i].key = 0x20000000UL | ((uint32_t)(i + 1U) << 8);
+        plEntries[i].data = &plData[i];
+        plEntries[i].length = sizeof(plData[i]);
+        plData[i] = plStored[i] = 0;
+    }
+    if(CO_flashSim_init(&plSim, 256, 4, 4, NULL) != CO_ERROR_NO
+        || CO_KVstore_init(&plKv, &plSim.flash, plEntries, BENCH_KV_ENTRIES) != CO_ERROR_NO)
+    {
+        bench_errExit("power loss check: init failed");
+    }
+
+    for(cycle=0; cycle<BENCH_KV_POWER_CYCLES; cycle++){
+        uint16_t entry = 0;
+
+        /* store until power is lost */
+        rnd = rnd * 1103515245UL + 12345UL;
+        CO_flashSim_powerLoss(&plSim, (int32_t)((rnd >> 16) % 64U));
+        for(;;){
+            rnd = rnd * 1103515245UL + 12345UL;
+            entry = (uint16_t)((rnd >> 16) % BENCH_KV_ENTRIES);
+            plData[entry] = ++value;
+            if(CO_KVstore_storeEntry(&plKv, entry) != CO_ERROR_NO
+                || CO_KVstore_process(&plKv, false) != CO_ERROR_NO)
+            {
+                break;
+            }
+            plStored[entry] = value;
+        }
+        if(!plSim.powerLost){
+            bench_errExit("power loss check: store failed without power loss");
+        }
+
+        /* restart with default values in RAM */
+        CO_flashSim_powerCycle(&plSim);
+        memset(plData, 0, sizeof(plData));
+        if(CO_KVstore_init(&plKv, &plSim.flash, plEntries, BENCH_KV_ENTRIES) != CO_ERROR_NO){
+            bench_errExit("power loss check: init after power loss failed");
+        }
+        for(i=0; i<BENCH_KV_ENTRIES; i++){
+            if(plData[i] != plStored[i] && !(i == entry && plData[i] == value)){
+                printf("power loss check: cycle %u, entry %u: %u, expected %u\n",
+                       cycle, i, plData[i], plStored[i]);
+                bench_errExit("power loss check failed");
+            }
+            plStored[i] = plData[i];
+        }
+    }
+
+    CO_flashSim_close(&plSim);
+    printf("KVstore: %u power losses, no data lost\n", BENCH_KV_POWER_CYCLES);
+}
+
+/* Flash wear of both methods, erases per store and maximum erases of one
+ * sector determine the lifetime of the flash. */
+static void flash_report(const char *name, const CO_flashSim_t *sim, uint32_t stores){
+    uint32_t i, maxErase = 0;
+
+    for(i=0; i<sim->flash.sectorCount; i++){
+        if(sim->eraseCount[i] > maxErase){
+            maxErase = sim->eraseCount[i];
+        }
+    }
+    printf("%-30s %10u stores, %8.4f erases/store, %8.4f max sector erases/store, %6.1f bytes/store\n",
+           name, stores, (double)sim->erases / stores, (double)maxErase / stores,
+           (double)sim->bytesWritten / stores);
+}
+
+
+/* Test runner ****************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*test)(uint32_t n);
+    uint32_t            n;          /* number of operations in one run */
+}bench_t;
+
+static const bench_t benchmarks[] = {
+    {"CO_OD_find",                  test_OD_find,                   1000000},
+    {"CO_TPDOisCOS",                test_TPDOisCOS,                 1000000},
+    {"CO_TPDOsend",                 test_TPDOsend,                  1000000},
+    {"CO_PDO_receive",              test_RPDO_receive,              1000000},
+    {"CO_PDO_receive+RPDO_process", test_RPDO_process,              1000000},
+#ifdef CO_PDO_BIT_MAPPING
+    {"CO_TPDOsend_bits",            test_TPDOsend_bits,             1000000},
+    {"CO_PDO_receive+RPDO_bits",    test_RPDO_process_bits,         1000000},
+#endif
+#ifdef CO_PDO_MPDO
+    {"CO_PDO_receive+MPDO_DAM",     test_RPDO_process_DAM,          1000000},
+    {"CO_PDO_receive+MPDO_SAM",     test_RPDO_process_SAM,          1000000},
+    {"CO_TPDOsendMPDO_DAM",         test_TPDOsendMPDO_DAM,          1000000},
+    {"CO_TPDOsend_SAM",             test_TPDOsend_SAM,              1000000},
+#endif
+#ifdef CO_PDO_PROCESS_IMAGE
+    {"CO_TPDOsend_image",           test_TPDOsend_image,            1000000},
+    {"CO_PDO_receive+RPDO_image",   test_RPDO_process_image,        1000000},
+#endif
+    {"SDO_expedited_upload",        test_SDO_expedited_upload,      200000},
+    {"SDO_expedited_download",      test_SDO_expedited_download,    200000},
+#ifdef CO_SDO_FAST_PATH
+    {"SDO_fast_upload",             test_SDO_fast_upload,           200000},
+    {"SDO_fast_download",           test_SDO_fast_download,         200000},
+#endif
+    {"SDO_segmented_upload_256",    test_SDO_segmented_upload,      20000},
+    {"SDO_segmented_download_256",  test_SDO_segmented_download,    20000},
+    {"SDO_block_download_256",      test_SDO_block_download,        20000},
+    {"CO_errorReport+EM_process",   test_EM_report_process,         200000},
+    {"crc16_ccitt_8",               test_crc16_8,                   1000000},
+    {"crc16_ccitt_889",             test_crc16_889,                 20000},
+#if CO_CRC16_SLICES > 0
+    {"crc16_ccitt_bytewise_4096",   test_crc16_bytewise,            5000},
+    {"crc16_ccitt_slicing_4096",    test_crc16_slicing,             5000},
+    {"crc16_ccitt_clmul_4096",      test_crc16_clmul,               5000},
+#endif
+    {"KVstore_store_4",             test_KVstore_store,             200000},
+    {"page_rewrite_256",            test_page_rewrite,              200000},
+};
+
+
+int main(int argc, char *argv[]){
+    const char *fileName = (argc > 1) ? argv[1] : "bench_results.csv";
+    FILE *fp;
+    uint16_t i;
+
+    bench_init();
+    kv_init();
+    kv_powerLossCheck();
+#if CO_CRC16_SLICES > 0
+    crc16_crossCheck();
+#endif
+
+    for(i=0; i<1024; i++){
+        ODfindIndex[i] = OD[(i * 7919U) % ODSize].index;
+    }
+
+    fp = fopen(fileName, "w");
+    if(fp == NULL){
+        bench_errExit("can not open output file");
+    }
+    fprintf(fp, "name,ops,ns_per_op,cycles_per_op\n");
+    printf("%-30s %10s %12s %14s\n", "test", "ops", "ns/op", "cycles/op");
+
+    for(i=0; i<sizeof(benchmarks)/sizeof(benchmarks[0]); i++){
+        const bench_t *b = &benchmarks[i];
+        double bestNs = 0, bestCycles = 0;
+        int r;
+
+        b->test(b->n / 10); /* warm up */
+        for(r=0; r<BENCH_REPEAT; r++){
+            uint64_t t0, c0, t1, c1;
+
+            t0 = bench_ns();
+            c0 = bench_cycles();
+            b->test(b->n);
+            c1 = bench_cycles();
+            t1 = bench_ns();
+
+            if(r == 0 || (double)(t1 - t0) / b->n < bestNs){
+                bestNs = (double)(t1 - t0) / b->n;
+                bestCycles = (double)(c1 - c0) / b->n;
+            }
+        }
+
+        printf("%-30s %10u %12.2f %14.2f\n", b->name, b->n, bestNs, bestCycles);
+        fprintf(fp, "%s,%u,%.3f,%.3f\n", b->name, b->n, bestNs, bestCycles);
+    }
+
+    fclose(fp);
+    printf("Results written to %s\n", fileName);
+
+    flash_report("KVstore_store_4", &kvSim, kvStores);
+    flash_report("page_rewrite_256", &pageSim, pageStores);
+    CO_flashSim_close(&kvSim);
+    CO_flashSim_close(&pageSim);
+
+    return 0;
+}
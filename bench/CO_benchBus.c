@@ -0,0 +1,467 @@
+/*
+ * Throughput benchmarks of CANopenNode on the virtual CAN bus.
+ *
+ * @file        CO_benchBus.c
+ * @ingroup     CO_bench
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Program runs a master and BENCH_MAX_DRIVES drives on the virtual CAN bus
+ * (stack/virtualCAN) in simulated time. Results do not depend on the speed of
+ * the computer.
+ *
+ * Firmware download: master downloads BENCH_IMAGE_SIZE bytes image with SDO
+ * block transfer into the streamed domain of each drive, using SDO client
+ * engine with one channel per drive. Firmware upload reads the image back.
+ * Master is processed every BENCH_CYCLE_NS and drives every
+ * BENCH_DRIVE_CYCLE_NS. Transmit path of the master is either one CAN transmit
+ * buffer per SDO client (as on microcontroller) or the transmit queue of
+ * BENCH_TXQUEUE_SIZE messages (as socketCAN with default txqueuelen).
+ * Upload is received either directly into the buffer or into the stream with
+ * write callback through the window of BENCH_WINDOW_SIZE bytes (column
+ * window), so each block is written to the stream.
+ * Receiver of the block (drive by download, master by upload) optionally
+ * loses some of the segments, which must be repeated. Lost segment inside the
+ * block is detected by the next segment. If the first or the last segment of
+ * the block may also be lost (column edges), loss is detected only by the
+ * timeout of the receiver.
+ *
+ * Achieved rate is compared with the line rate: 7 bytes of data in each
+ * segment of average duration on the bus.
+ *
+ * Results are printed to stdout and written as CSV to file, specified as first
+ * argument (default: bench_bus_results.csv).
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_SDOmaster.h"
+#include "CO_SDOengine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define BENCH_MAX_DRIVES        8
+#define BENCH_IMAGE_SIZE        65536U  /* Size of the firmware image */
+#define BENCH_IDX_PROGRAM       0x1F50U /* Program data, streamed domain */
+#define BENCH_MASTER_ID         1
+#define BENCH_BITRATE           1000    /* kbps */
+#define BENCH_CYCLE_NS          1000000U
+#define BENCH_DRIVE_CYCLE_NS    100000U
+#define BENCH_TXQUEUE_SIZE      10
+#define BENCH_SDO_TIMEOUT       1000    /* ms */
+#define BENCH_WINDOW_SIZE       100U    /* Window of the stream by upload */
+
+
+/* Drive with SDO server and streamed domain for the firmware **************/
+typedef struct{
+    CO_CANmodule_t      CANmodule;
+    CO_CANrx_t          CANrx[1];
+    CO_CANtx_t          CANtx[1];
+    CO_SDO_t            SDO;
+    CO_OD_entry_t       OD[2];
+    CO_OD_extension_t   ODExtensions[2];
+    CO_OD_entryRecord_t rec1200[3];
+    uint8_t             maxSubIndex;
+    uint32_t            COB_ID[3];
+    uint8_t             SDObuffer[889];
+    CO_SDO_stream_t     stream;
+    uint8_t             image[BENCH_IMAGE_SIZE + 8];
+    void              (*receive)(void *object, const CO_CANrxMsg_t *message);
+    uint32_t            lossSeed;
+    uint16_t            lossPermille;
+    bool_t              lossEdges;
+}bench_drive_t;
+
+static bench_drive_t        drives[BENCH_MAX_DRIVES];
+
+static CO_CANmodule_t       masterCAN;
+static CO_CANrx_t           masterCANrx[BENCH_MAX_DRIVES + 1];
+static CO_CANtx_t           masterCANtx[BENCH_MAX_DRIVES + 1];
+static CO_CANtx_t           masterTxQueue[BENCH_TXQUEUE_SIZE];
+static CO_SDO_t             masterSDO;
+static CO_OD_entry_t        masterOD[1];
+static CO_OD_extension_t    masterODExtensions[1];
+static CO_OD_entryRecord_t  masterRec1200[3];
+static uint8_t              masterMaxSubIndex = 2;
+static uint32_t             masterCOB_ID[3] = {0, 0x600 + BENCH_MASTER_ID, 0x580 + BENCH_MASTER_ID};
+static CO_SDOengine_t       engine;
+static CO_SDOengineChannel_t channels[BENCH_MAX_DRIVES];
+static CO_SDOjob_t          jobs[BENCH_MAX_DRIVES];
+
+/* Receive functions of the master SDO clients, which lose segments */
+typedef struct{
+    CO_SDOclient_t     *client;
+    void              (*receive)(void *object, const CO_CANrxMsg_t *message);
+    void               *object;
+    uint32_t            lossSeed;
+    uint16_t            lossPermille;
+    bool_t              lossEdges;
+}bench_loss_t;
+
+static bench_loss_t         masterLoss[BENCH_MAX_DRIVES];
+
+static uint8_t              image[BENCH_IMAGE_SIZE];
+static uint8_t              uploaded[BENCH_MAX_DRIVES][BENCH_IMAGE_SIZE];
+static uint8_t              uploadWindow[BENCH_MAX_DRIVES][BENCH_WINDOW_SIZE];
+static CO_SDO_stream_t      uploadStream[BENCH_MAX_DRIVES];
+
+
+static void bench_errExit(const char *msg){
+    fprintf(stderr, "%s\n", msg);
+    exit(EXIT_FAILURE);
+}
+
+/* Write callback of the upload stream, object is uploaded[i]. */
+static int32_t upload_write(void *object, uint32_t offset, const uint8_t *buf, uint16_t count){
+    if((offset + count) > BENCH_IMAGE_SIZE || count > BENCH_WINDOW_SIZE){
+        return -1;
+    }
+    memcpy((uint8_t*)object + offset, buf, count);
+    return count;
+}
+
+static void ODrec(CO_OD_entryRecord_t *rec, void *pData, uint16_t attribute, uint16_t length){
+    rec->pData = pData;
+    rec->attribute = attribute;
+    rec->length = length;
+}
+
+static void OD1200(CO_OD_entry_t *OD, CO_OD_entryRecord_t *rec, uint8_t *maxSubIndex, uint32_t *COB_ID){
+    ODrec(&rec[0], maxSubIndex, CO_ODA_MEM_ROM | CO_ODA_READABLE, 1);
+    ODrec(&rec[1], &COB_ID[1], CO_ODA_MEM_ROM | CO_ODA_READABLE, 4);
+    ODrec(&rec[2], &COB_ID[2], CO_ODA_MEM_ROM | CO_ODA_READABLE, 4);
+    OD->index = 0x1200;
+    OD->maxSubIndex = 2;
+    OD->attribute = 0;
+    OD->length = 0;
+    OD->pData = rec;
+}
+
+
+/* Returns true, if segment of the block with blksize segments may be lost.
+ * Segment with bit 7 set (last segment of the transfer) is never lost, all
+ * responses of the server by block upload also have bit 7 set. */
+static bool_t bench_lossAllowed(uint8_t data0, uint8_t blksize, bool_t lossEdges){
+    uint8_t seqno = data0 & 0x7FU;
+
+    if((data0 & 0x80U) != 0U){
+        return false;
+    }
+    if(lossEdges){
+        return (seqno >= 1U && seqno <= blksize) ? true : false;
+    }
+    return (seqno > 1U && seqno < blksize) ? true : false;
+}
+
+
+/* Receive function of the drive, which loses segments of the block download
+ * with probability lossPermille. */
+static void drive_receive(void *object, const CO_CANrxMsg_t *message){
+    bench_drive_t *d = (bench_drive_t*)object;
+
+    if(d->lossPermille != 0U && d->SDO.state == CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK
+        && bench_lossAllowed(message->data[0], d->SDO.blksize, d->lossEdges))
+    {
+        d->lossSeed = d->lossSeed * 1103515245U + 12345U;
+        if(((d->lossSeed >> 16) % 1000U) < d->lossPermille){
+            return;
+        }
+    }
+    d->receive(&d->SDO, message);
+}
+
+
+/* Receive function of the master SDO client, which loses segments of the
+ * block upload, same as drive_receive(). */
+static void master_receive(void *object, const CO_CANrxMsg_t *message){
+    bench_loss_t *l = (bench_loss_t*)object;
+
+    if(l->lossPermille != 0U && (l->lossEdges || l->client->block_seqno != 0U)
+        && bench_lossAllowed(message->data[0], l->client->block_blksize, l->lossEdges))
+    {
+        l->lossSeed = l->lossSeed * 1103515245U + 12345U;
+        if(((l->lossSeed >> 16) % 1000U) < l->lossPermille){
+            return;
+        }
+    }
+    l->receive(l->object, message);
+}
+
+/* Insert master_receive() into the receive buffers of the SDO clients. It
+ * must be checked after CO_SDOengine_process(), because CO_SDOclient_setup()
+ * initializes receive buffer, if node-ID of the channel changes. */
+static void master_insertLoss(uint16_t noDrives){
+    uint16_t i;
+
+    for(i=0; i<noDrives; i++){
+        CO_CANrx_t *rx = &masterCANrx[i];
+
+        if(rx->pFunct != master_receive && rx->pFunct != NULL){
+            masterLoss[i].client = &channels[i].client;
+            masterLoss[i].receive = rx->pFunct;
+            masterLoss[i].object = rx->object;
+            rx->pFunct = master_receive;
+            rx->object = &masterLoss[i];
+        }
+    }
+}
+
+
+static void bench_init(void){
+    uint32_t i, seed = 12345;
+
+    if(CO_VCANbus_init(&CO_VCANbus[0], BENCH_BITRATE) != CO_ERROR_NO){
+        bench_errExit("virtual bus init failed");
+    }
+
+    for(i=0; i<BENCH_IMAGE_SIZE; i++){
+        seed = seed * 1103515245U + 12345U;
+        image[i] = (uint8_t)(seed >> 16);
+    }
+
+    /* master with SDO server, needed by SDO client, and engine */
+    OD1200(&masterOD[0], masterRec1200, &masterMaxSubIndex, masterCOB_ID);
+    if(CO_CANmodule_init(&masterCAN, 0, masterCANrx, BENCH_MAX_DRIVES + 1,
+                         masterCANtx, BENCH_MAX_DRIVES + 1, BENCH_BITRATE) != CO_ERROR_NO
+        || CO_SDO_init(&masterSDO, 0x600 + BENCH_MASTER_ID, 0x580 + BENCH_MASTER_ID, 0x1200, NULL,
+                       masterOD, 1, masterODExtensions, BENCH_MASTER_ID,
+                       &masterCAN, BENCH_MAX_DRIVES, &masterCAN, BENCH_MAX_DRIVES) != CO_ERROR_NO
+        || CO_SDOengine_init(&engine, &masterSDO, channels, BENCH_MAX_DRIVES,
+                             &masterCAN, 0, &masterCAN, 0, BENCH_SDO_TIMEOUT) != CO_ERROR_NO)
+    {
+        bench_errExit("master init failed");
+    }
+    CO_CANsetNormalMode(&masterCAN);
+
+    /* drives with node-IDs 2, 3, ... */
+    for(i=0; i<BENCH_MAX_DRIVES; i++){
+        bench_drive_t *d = &drives[i];
+        uint8_t nodeId = (uint8_t)(i + 2U);
+
+        d->maxSubIndex = 2;
+        d->COB_ID[1] = 0x600U + nodeId;
+        d->COB_ID[2] = 0x580U + nodeId;
+        OD1200(&d->OD[0], d->rec1200, &d->maxSubIndex, d->COB_ID);
+        d->OD[1].index = BENCH_IDX_PROGRAM;
+        d->OD[1].maxSubIndex = 0;
+        d->OD[1].attribute = CO_ODA_MEM_RAM | CO_ODA_READABLE | CO_ODA_WRITEABLE;
+        d->OD[1].length = 0;
+        d->OD[1].pData = NULL;
+
+        if(CO_CANmodule_init(&d->CANmodule, 0, d->CANrx, 1, d->CANtx, 1, BENCH_BITRATE) != CO_ERROR_NO
+            || CO_SDO_init(&d->SDO, 0x600U + nodeId, 0x580U + nodeId, 0x1200, NULL,
+                           d->OD, 2, d->ODExtensions, nodeId,
+                           &d->CANmodule, 0, &d->CANmodule, 0) != CO_ERROR_NO
+            || CO_SDO_initBuffer(&d->SDO, d->SDObuffer, sizeof(d->SDObuffer)) != CO_ERROR_NO)
+        {
+            bench_errExit("drive init failed");
+        }
+        d->stream.data = d->image;
+        d->stream.size = BENCH_IMAGE_SIZE;
+        CO_OD_configureStream(&d->SDO, BENCH_IDX_PROGRAM, &d->stream);
+
+        /* insert receive function, which loses messages */
+        d->receive = d->CANrx[0].pFunct;
+        d->CANrx[0].pFunct = drive_receive;
+        d->CANrx[0].object = d;
+        d->lossSeed = nodeId;
+        masterLoss[i].lossSeed = nodeId;
+        CO_CANsetNormalMode(&d->CANmodule);
+    }
+}
+
+
+/* Firmware download and upload **********************************************/
+typedef struct{
+    bool_t              upload;
+    uint16_t            noDrives;
+    bool_t              txQueue;
+    uint16_t            lossPermille;
+    bool_t              lossEdges;
+    bool_t              window;
+}bench_fw_t;
+
+static const bench_fw_t fwBenchmarks[] = {
+    {false, 1, false, 0,  false, false},
+    {false, 1, true,  0,  false, false},
+    {false, 4, false, 0,  false, false},
+    {false, 4, true,  0,  false, false},
+    {false, 8, true,  0,  false, false},
+    {false, 1, true,  5,  false, false},
+    {false, 4, true,  5,  false, false},
+    {false, 4, true,  20, false, false},
+    {false, 1, true,  5,  true,  false},
+    {false, 4, true,  5,  true,  false},
+    {true,  1, true,  0,  false, false},
+    {true,  4, true,  0,  false, false},
+    {true,  1, true,  5,  false, false},
+    {true,  1, true,  20, false, false},
+    {true,  4, true,  20, false, false},
+    {true,  1, true,  5,  true,  false},
+    {true,  4, true,  5,  true,  false},
+    {true,  1, true,  5,  true,  true},
+    {true,  4, true,  5,  true,  true},
+};
+
+
+static void bench_firmware(const bench_fw_t *b, FILE *fp){
+    CO_VCANbus_t *bus = &CO_VCANbus[0];
+    uint64_t t0 = bus->time_ns, t = t0, busy0 = bus->busyTime_ns, tDrive;
+    uint32_t frames0 = bus->frames, repeated = 0, blockSize = 0;
+    uint16_t timeDifference_ms = 0;
+    double seconds, rate, lineRate, frameTime;
+    uint16_t i;
+
+    if(CO_VCANmodule_initTxQueue(&masterCAN, b->txQueue ? masterTxQueue : NULL, BENCH_TXQUEUE_SIZE) != CO_ERROR_NO){
+        bench_errExit("tx queue init failed");
+    }
+
+    for(i=0; i<b->noDrives; i++){
+        CO_SDOclient_t *client = &channels[i].client;
+        CO_SDOjob_t *job = &jobs[i];
+
+        client->block_segmentsRepeated = 0;
+        client->block_size_cur = client->block_size_max;
+
+        memset(job, 0, sizeof(*job));
+        job->nodeId = (uint8_t)(i + 2U);
+        job->upload = b->upload;
+        job->blockEnable = true;
+        job->index = BENCH_IDX_PROGRAM;
+        job->dataSize = BENCH_IMAGE_SIZE;
+        if(b->upload){
+            memcpy(drives[i].image, image, BENCH_IMAGE_SIZE);
+            memset(uploaded[i], 0, BENCH_IMAGE_SIZE);
+            masterLoss[i].lossPermille = b->lossPermille;
+            masterLoss[i].lossEdges = b->lossEdges;
+            if(b->window){
+                uploadStream[i].data = NULL;
+                uploadStream[i].size = BENCH_IMAGE_SIZE;
+                uploadStream[i].object = uploaded[i];
+                uploadStream[i].write = upload_write;
+                job->stream = &uploadStream[i];
+                job->data = uploadWindow[i];
+                job->dataSize = BENCH_WINDOW_SIZE;
+            }
+            else{
+                job->data = uploaded[i];
+            }
+        }
+        else{
+            memset(drives[i].image, 0, sizeof(drives[i].image));
+            drives[i].lossPermille = b->lossPermille;
+            drives[i].lossEdges = b->lossEdges;
+            job->data = image;
+        }
+        if(CO_SDOengine_queue(&engine, job) != CO_ERROR_NO){
+            bench_errExit("queue failed");
+        }
+    }
+
+    for(;;){
+        uint16_t timerNext_ms = 1;
+        uint16_t unfinished = CO_SDOengine_process(&engine, timeDifference_ms, &timerNext_ms);
+
+        master_insertLoss(b->noDrives);
+        timeDifference_ms = 1;
+        for(tDrive = t + BENCH_DRIVE_CYCLE_NS; tDrive <= t + BENCH_CYCLE_NS; tDrive += BENCH_DRIVE_CYCLE_NS){
+            CO_VCANbus_process(bus, tDrive);
+            for(i=0; i<b->noDrives; i++){
+                CO_SDO_process(&drives[i].SDO, true, (tDrive == t + BENCH_CYCLE_NS) ? 1 : 0,
+                               BENCH_SDO_TIMEOUT, &timerNext_ms);
+            }
+        }
+        /* After the end, last message from the master is also transmitted */
+        if(unfinished == 0U){
+            break;
+        }
+        t += BENCH_CYCLE_NS;
+        if((t - t0) > 600000000000ULL){
+            bench_errExit("firmware transfer does not finish");
+        }
+    }
+
+    for(i=0; i<b->noDrives; i++){
+        if(jobs[i].result != CO_SDOcli_ok_communicationEnd
+            || memcmp(b->upload ? uploaded[i] : drives[i].image, image, BENCH_IMAGE_SIZE) != 0)
+        {
+            fprintf(stderr, "drive %u: result %d, abort code 0x%08X\n",
+                    i + 2U, (int)jobs[i].result, (unsigned)jobs[i].abortCode);
+            bench_errExit("firmware transfer failed");
+        }
+        repeated += channels[i].client.block_segmentsRepeated;
+        /* block size is determined by the client by upload and by the server by download */
+        blockSize += b->upload ? channels[i].client.block_size_cur : drives[i].SDO.blksize;
+        drives[i].lossPermille = 0;
+        masterLoss[i].lossPermille = 0;
+    }
+
+    seconds = (double)(t - t0) / 1e9;
+    rate = (double)BENCH_IMAGE_SIZE * b->noDrives / seconds;
+    frameTime = (double)(bus->busyTime_ns - busy0) / (bus->frames - frames0);
+    lineRate = 7.0 * 1e9 / frameTime;
+
+    printf("%-9s %6u %-9s %5.1f%% %-5s %-6s %10.0f %9.1f%% %7.1f%% %9u %6u\n",
+           b->upload ? "upload" : "download", b->noDrives, b->txQueue ? "queue" : "buffer", b->lossPermille / 10.0,
+           b->lossEdges ? "yes" : "no", b->window ? "stream" : "buffer",
+           rate, 100.0 * rate / lineRate,
+           100.0 * (double)(bus->busyTime_ns - busy0) / (double)(t - t0),
+           repeated, blockSize / b->noDrives);
+    fprintf(fp, "%s,%u,%s,%.1f,%s,%s,%.0f,%.1f,%.1f,%u,%u\n",
+            b->upload ? "upload" : "download", b->noDrives, b->txQueue ? "queue" : "buffer", b->lossPermille / 10.0,
+            b->lossEdges ? "yes" : "no", b->window ? "stream" : "buffer",
+            rate, 100.0 * rate / lineRate,
+            100.0 * (double)(bus->busyTime_ns - busy0) / (double)(t - t0),
+            repeated, blockSize / b->noDrives);
+}
+
+
+int main(int argc, char *argv[]){
+    const char *fileName = (argc > 1) ? argv[1] : "bench_bus_results.csv";
+    FILE *fp;
+    uint16_t i;
+
+    bench_init();
+
+    fp = fopen(fileName, "w");
+    if(fp == NULL){
+        bench_errExit("can not open output file");
+    }
+
+    printf("Firmware transfer, %u bytes per drive, %u kbps, master cycle %u us, drive cycle %u us\n",
+           BENCH_IMAGE_SIZE, BENCH_BITRATE, BENCH_CYCLE_NS / 1000U, BENCH_DRIVE_CYCLE_NS / 1000U);
+    printf("%-9s %6s %-9s %6s %-5s %-6s %10s %10s %8s %9s %6s\n",
+           "transfer", "drives", "tx_path", "loss", "edges", "window", "bytes/s", "line_rate", "bus_load", "repeated", "blksz");
+    fprintf(fp, "transfer,drives,tx_path,loss_percent,loss_edges,window,bytes_per_s,line_rate_percent,bus_load_percent,repeated_segments,block_size\n");
+
+    for(i=0; i<sizeof(fwBenchmarks)/sizeof(fwBenchmarks[0]); i++){
+        bench_firmware(&fwBenchmarks[i], fp);
+    }
+
+    fclose(fp);
+    printf("Results written to %s\n", fileName);
+
+    return 0;
+}
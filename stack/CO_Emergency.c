@@ -150,6 +150,10 @@ CO_ReturnError_t CO_EM_init(
     em->bufFull                 = 0U;
     em->wrongErrorReport        = 0U;
     em->pFunctSignal            = NULL;
+#ifdef CO_USE_STATISTICS
+    em->stats.reported          = 0U;
+    em->stats.overflow          = 0U;
+#endif
     emPr->em                    = em;
     emPr->errorRegister         = errorRegister;
     emPr->preDefErr             = preDefErr;
@@ -311,6 +315,9 @@ void CO_errorReport(CO_EM_t *em, const uint8_t errorBit, const uint16_t errorCod
         /* verify buffer full, set overflow */
         if(em->bufFull){
             em->bufFull = 2;
+#ifdef CO_USE_STATISTICS
+            CO_STAT_INC(em->stats.overflow);
+#endif
         }
         else{
             uint8_t bufCopy[8];
@@ -329,6 +336,9 @@ void CO_errorReport(CO_EM_t *em, const uint8_t errorBit, const uint16_t errorCod
             if(em->bufWritePtr == em->bufEnd) em->bufWritePtr = em->buf;
             if(em->bufWritePtr == em->bufReadPtr) em->bufFull = 1;
             CO_UNLOCK_EMCY();
+#ifdef CO_USE_STATISTICS
+            CO_STAT_INC(em->stats.reported);
+#endif
 
             /* Optional signal to RTOS, which can resume task, which handles CO_EM_process */
             if(em->pFunctSignal != NULL) {
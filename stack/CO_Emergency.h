@@ -265,6 +265,17 @@ typedef enum{
 #define CO_EM_INTERNAL_BUFFER_SIZE      10
 
 
+#ifdef CO_USE_STATISTICS
+/**
+ * Statistics counters of the emergency object, see CO_USE_STATISTICS in CO_driver.h.
+ */
+typedef struct{
+    uint32_t            reported;       /**< Errors written into internal buffer */
+    uint32_t            overflow;       /**< Errors lost, because internal buffer was full */
+}CO_EMstats_t;
+#endif
+
+
 /**
  * Emergerncy object for CO_errorReport(). It contains error buffer, to which new emergency
  * messages are written, when CO_errorReport() is called. This object is included in
@@ -281,6 +292,9 @@ typedef struct{
     uint8_t             bufFull;        /**< True if above buffer is full */
     uint8_t             wrongErrorReport;/**< Error in arguments to CO_errorReport() */
     void              (*pFunctSignal)(void);/**< From CO_EM_initCallback() or NULL */
+#ifdef CO_USE_STATISTICS
+    CO_EMstats_t        stats;          /**< Statistics counters */
+#endif
 }CO_EM_t;
 
 
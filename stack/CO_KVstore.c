@@ -0,0 +1,618 @@
+/*
+ * Log-structured key/value storage of Object Dictionary variables in flash.
+ *
+ * @file        CO_KVstore.c
+ * @ingroup     CO_KVstore
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_KVstore.h"
+#include "crc16-ccitt.h"
+
+#include <string.h>
+
+
+#define KV_MAGIC        0x4B565331UL    /* "KVS1" */
+#define KV_HDR_SIZE     8U              /* size of sector header and record header */
+#define KV_CHUNK        32U             /* buffer on stack for comparing data */
+#define KV_MIN_ERASED   2U              /* erased sectors before the head advances */
+
+
+/* Header at the beginning of each used sector. */
+typedef struct {
+    uint32_t    seq;
+    uint32_t    check;      /* seq ^ KV_MAGIC */
+} KV_sectorHeader_t;
+
+/* Header of each record, followed by data. */
+typedef struct {
+    uint32_t    key;
+    uint16_t    length;
+    uint16_t    crc;        /* CRC of key, length and data */
+} KV_recordHeader_t;
+
+
+/* Size of record in flash, including header and padding */
+static uint32_t recordSize(CO_KVstore_t *kv, uint16_t length) {
+    return (KV_HDR_SIZE + length + kv->align - 1U) & ~(uint32_t)(kv->align - 1U);
+}
+
+
+/* Find entry by key with binary search */
+static CO_KVentry_t *findEntry(CO_KVstore_t *kv, uint32_t key) {
+    uint16_t lo = 0, hi = kv->noEntries;
+
+    while(lo < hi) {
+        uint16_t mid = (uint16_t)((lo + hi) / 2U);
+        if(kv->entries[mid].key < key) {
+            lo = mid + 1U;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return (lo < kv->noEntries && kv->entries[lo].key == key) ? &kv->entries[lo] : NULL;
+}
+
+
+/* Find the end of programmed area: address after the last byte, which is
+ * not 0xFF, or start, if area is erased. */
+static CO_ReturnError_t programmedEnd(CO_KVstore_t *kv, uint32_t start, uint32_t end, uint32_t *last) {
+    uint8_t buf[KV_CHUNK];
+
+    while(end > start) {
+        uint32_t len = ((end - start) > KV_CHUNK) ? KV_CHUNK : (end - start);
+        uint32_t i;
+
+        if(kv->flash->read(kv->flash->object, end - len, buf, len) != CO_ERROR_NO) {
+            return CO_ERROR_DATA_CORRUPT;
+        }
+        for(i=len; i>0U; i--) {
+            if(buf[i-1U] != 0xFFU) {
+                *last = end - len + i;
+                return CO_ERROR_NO;
+            }
+        }
+        end -= len;
+    }
+    *last = start;
+    return CO_ERROR_NO;
+}
+
+
+/* Read and verify record at address. Returns false, if there is no valid record. */
+static bool_t readRecord(CO_KVstore_t *kv, uint32_t address, uint32_t sectorEnd, KV_recordHeader_t *rec) {
+    uint8_t buf[KV_CHUNK];
+    uint32_t offset;
+    uint16_t crc;
+
+    if((address + KV_HDR_SIZE) > sectorEnd
+        || kv->flash->read(kv->flash->object, address, rec, KV_HDR_SIZE) != CO_ERROR_NO
+        || rec->length == 0xFFFFU
+        || (address + recordSize(kv, rec->length)) > sectorEnd)
+    {
+        return false;
+    }
+
+    crc = crc16_ccitt((const unsigned char *)rec, 6, 0);
+    for(offset = 0; offset < rec->length; offset += KV_CHUNK) {
+        uint32_t len = rec->length - offset;
+        if(len > KV_CHUNK) {
+            len = KV_CHUNK;
+        }
+        if(kv->flash->read(kv->flash->object, address + KV_HDR_SIZE + offset, buf, len) != CO_ERROR_NO) {
+            return false;
+        }
+        crc = crc16_ccitt(buf, len, crc);
+    }
+    return crc == rec->crc;
+}
+
+
+/* Write data and then header of the record at kv->writeAddr. Source of data
+ * is RAM (src != NULL) or flash (srcAddress). */
+static CO_ReturnError_t writeRecord(CO_KVstore_t *kv, uint32_t key, uint16_t length,
+                                    const uint8_t *src, uint32_t srcAddress, uint16_t crc)
+{
+    const CO_flash_t *flash = kv->flash;
+    uint8_t buf[KV_CHUNK];
+    uint32_t address = kv->writeAddr + KV_HDR_SIZE;
+    uint32_t offset = 0;
+    KV_recordHeader_t rec;
+
+    /* data, last chunk is padded with 0xFF */
+    while(offset < length) {
+        uint32_t len = length - offset;
+        uint32_t lenAligned;
+
+        if(len > KV_CHUNK) {
+            len = KV_CHUNK;
+        }
+        lenAligned = (len + flash->writeSize - 1U) & ~(uint32_t)(flash->writeSize - 1U);
+        memset(&buf[len], 0xFF, lenAligned - len);
+        if(src != NULL) {
+            memcpy(buf, &src[offset], len);
+        }
+        else if(flash->read(flash->object, srcAddress + offset, buf, len) != CO_ERROR_NO) {
+            return CO_ERROR_DATA_CORRUPT;
+        }
+        if(flash->write(flash->object, address + offset, buf, lenAligned) != CO_ERROR_NO) {
+            return CO_ERROR_DATA_CORRUPT;
+        }
+        offset += len;
+    }
+
+    /* header commits the record */
+    rec.key = key;
+    rec.length = length;
+    rec.crc = crc;
+    if(flash->write(flash->object, kv->writeAddr, &rec, KV_HDR_SIZE) != CO_ERROR_NO) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    kv->writeAddr += recordSize(kv, length);
+
+    return CO_ERROR_NO;
+}
+
+
+/* Next erased sector becomes the head. */
+static CO_ReturnError_t advanceHead(CO_KVstore_t *kv) {
+    const CO_flash_t *flash = kv->flash;
+    KV_sectorHeader_t hdr;
+
+    if(kv->erased == 0U) {
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    kv->head = (uint16_t)((kv->head + 1U) % flash->sectorCount);
+    kv->seq++;
+    kv->erased--;
+    kv->writeAddr = kv->head * flash->sectorSize + KV_HDR_SIZE;
+
+    hdr.seq = kv->seq;
+    hdr.check = kv->seq ^ KV_MAGIC;
+    if(flash->write(flash->object, kv->head * flash->sectorSize, &hdr, KV_HDR_SIZE) != CO_ERROR_NO) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/* Make space for the record of given size in the head sector. */
+static CO_ReturnError_t reserve(CO_KVstore_t *kv, uint32_t size) {
+    uint32_t sectorEnd = (kv->head + 1U) * kv->flash->sectorSize;
+
+    if((kv->writeAddr + size) > sectorEnd) {
+        return advanceHead(kv);
+    }
+    return CO_ERROR_NO;
+}
+
+
+/* Copy one live record of the oldest sector to the head or erase the oldest
+ * sector, if all live records are copied. */
+static CO_ReturnError_t compactStep(CO_KVstore_t *kv) {
+    const CO_flash_t *flash = kv->flash;
+    uint16_t oldest;
+    uint32_t sectorEnd;
+    KV_recordHeader_t rec;
+
+    if((kv->erased + 1U) >= flash->sectorCount) {
+        return CO_ERROR_NO;     /* only head is used */
+    }
+
+    oldest = (uint16_t)((kv->head + 1U + kv->erased) % flash->sectorCount);
+    sectorEnd = (oldest + 1U) * flash->sectorSize;
+    if(kv->compactAddr == 0U) {
+        kv->compactAddr = oldest * flash->sectorSize + KV_HDR_SIZE;
+    }
+
+    if(readRecord(kv, kv->compactAddr, sectorEnd, &rec)) {
+        CO_KVentry_t *entry = findEntry(kv, rec.key);
+        uint32_t address = kv->compactAddr;
+        uint32_t size = recordSize(kv, rec.length);
+
+        kv->compactAddr += size;
+
+        /* copy record, if it is the newest one of the entry */
+        if(entry != NULL && entry->address == address) {
+            CO_ReturnError_t ret = reserve(kv, size);
+
+            if(ret == CO_ERROR_NO) {
+                entry->address = kv->writeAddr;
+                ret = writeRecord(kv, rec.key, rec.length, NULL, address + KV_HDR_SIZE, rec.crc);
+                kv->copies++;
+            }
+            return ret;
+        }
+        return CO_ERROR_NO;
+    }
+
+    /* skip garbage of the interrupted record */
+    if(kv->compactAddr < sectorEnd) {
+        uint32_t last;
+
+        if(programmedEnd(kv, kv->compactAddr, sectorEnd, &last) != CO_ERROR_NO) {
+            return CO_ERROR_DATA_CORRUPT;
+        }
+        if(last > kv->compactAddr) {
+            kv->compactAddr += kv->align;
+            return CO_ERROR_NO;
+        }
+    }
+
+    /* no more records, erase the sector */
+    kv->compactAddr = 0;
+    if(flash->erase(flash->object, oldest) != CO_ERROR_NO) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    kv->erased++;
+    kv->erases++;
+
+    return CO_ERROR_NO;
+}
+
+
+/* Keep KV_MIN_ERASED sectors after the head erased. Compaction itself may
+ * use the last one, if the head gets full. */
+static CO_ReturnError_t compactAll(CO_KVstore_t *kv) {
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    while(ret == CO_ERROR_NO && kv->erased < KV_MIN_ERASED) {
+        ret = compactStep(kv);
+    }
+    return ret;
+}
+
+
+/* Make space for the new record. Head advances only with KV_MIN_ERASED
+ * erased sectors, so one is left for compaction after power loss. */
+static CO_ReturnError_t makeSpace(CO_KVstore_t *kv, uint32_t size) {
+    uint16_t i;
+
+    for(i=0; i<=kv->flash->sectorCount; i++) {
+        uint32_t sectorEnd = (kv->head + 1U) * kv->flash->sectorSize;
+        CO_ReturnError_t ret = compactAll(kv);
+
+        if(ret != CO_ERROR_NO || (kv->writeAddr + size) <= sectorEnd) {
+            return ret;
+        }
+        ret = advanceHead(kv);
+        if(ret != CO_ERROR_NO) {
+            return ret;
+        }
+    }
+    return CO_ERROR_OUT_OF_MEMORY;
+}
+
+
+/* Read sector header, return true if it is valid. */
+static bool_t readSectorHeader(CO_KVstore_t *kv, uint16_t sector, KV_sectorHeader_t *hdr) {
+    return kv->flash->read(kv->flash->object, sector * kv->flash->sectorSize, hdr, KV_HDR_SIZE) == CO_ERROR_NO
+        && hdr->seq != 0xFFFFFFFFUL && hdr->check == (hdr->seq ^ KV_MAGIC);
+}
+
+
+/* Scan records of the sector and update addresses of the entries. Record,
+ * interrupted by power loss, leaves garbage, which is skipped by searching
+ * for the next valid record. Returns address, where the next record may be
+ * written. */
+static CO_ReturnError_t scanSector(CO_KVstore_t *kv, uint16_t sector, uint32_t *endAddr) {
+    uint32_t sectorEnd = (sector + 1U) * kv->flash->sectorSize;
+    uint32_t address = sector * kv->flash->sectorSize + KV_HDR_SIZE;
+    uint32_t last;
+    KV_recordHeader_t rec;
+
+    if(programmedEnd(kv, address, sectorEnd, &last) != CO_ERROR_NO) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    while(address < last) {
+        if(readRecord(kv, address, sectorEnd, &rec)) {
+            CO_KVentry_t *entry = findEntry(kv, rec.key);
+
+            if(entry != NULL && entry->length == rec.length) {
+                entry->address = address;
+            }
+            address += recordSize(kv, rec.length);
+        }
+        else {
+            address += kv->align;
+        }
+    }
+
+    /* programmed area may end with 0xFF data */
+    *endAddr = (address < sectorEnd) ? address : sectorEnd;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_KVstore_init(
+        CO_KVstore_t           *kv,
+        const CO_flash_t       *flash,
+        CO_KVentry_t            entries[],
+        uint16_t                noEntries)
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+    KV_sectorHeader_t hdr;
+    bool_t found = false;
+    uint16_t i;
+
+    /* verify arguments */
+    if(kv==NULL || flash==NULL || (entries==NULL && noEntries > 0U) || flash->sectorCount < 3U
+        || flash->writeSize == 0U || flash->writeSize > CO_KV_MAX_WRITE_SIZE
+        || (flash->writeSize & (flash->writeSize - 1U)) != 0U
+        || (flash->sectorSize % flash->writeSize) != 0U)
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* configure object variables */
+    kv->flash = flash;
+    kv->entries = entries;
+    kv->noEntries = noEntries;
+    kv->align = (flash->writeSize < 4U) ? 4U : flash->writeSize;
+    kv->head = 0;
+    kv->seq = 0;
+    kv->writeAddr = 0;
+    kv->erased = 0;
+    kv->compactAddr = 0;
+    kv->processEntry = 0;
+    kv->records = 0;
+    kv->copies = 0;
+    kv->erases = 0;
+
+    /* verify entries */
+    for(i=0; i<noEntries; i++) {
+        if((i > 0U && entries[i].key <= entries[i-1U].key) || entries[i].data == NULL
+            || recordSize(kv, entries[i].length) > (flash->sectorSize - KV_HDR_SIZE))
+        {
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        entries[i].address = CO_KV_NO_ADDRESS;
+    }
+
+    /* Find head (sector with the highest sequence number). Erase sectors
+     * with invalid header and not erased content. */
+    for(i=0; ret == CO_ERROR_NO && i<flash->sectorCount; i++) {
+        if(readSectorHeader(kv, i, &hdr)) {
+            if(!found || hdr.seq > kv->seq) {
+                kv->head = i;
+                kv->seq = hdr.seq;
+                found = true;
+            }
+        }
+        else {
+            uint32_t last;
+            ret = programmedEnd(kv, i * flash->sectorSize, (i + 1U) * flash->sectorSize, &last);
+            if(ret == CO_ERROR_NO && last != (i * flash->sectorSize)) {
+                ret = flash->erase(flash->object, i);
+                kv->erases++;
+            }
+        }
+    }
+    if(ret != CO_ERROR_NO) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    /* empty flash, first sector will be the head */
+    if(!found) {
+        kv->head = (uint16_t)(flash->sectorCount - 1U);
+        kv->erased = flash->sectorCount;
+        ret = advanceHead(kv);
+        return (ret == CO_ERROR_NO) ? CO_ERROR_NO : CO_ERROR_DATA_CORRUPT;
+    }
+
+    /* Scan used sectors from the oldest to the head. Count erased sectors
+     * after the head. */
+    for(i=1; ret == CO_ERROR_NO && i<=flash->sectorCount; i++) {
+        uint16_t sector = (uint16_t)((kv->head + i) % flash->sectorCount);
+        uint32_t endAddr = 0;
+
+        if(!readSectorHeader(kv, sector, &hdr)) {
+            if(kv->erased == (i - 1U)) {
+                kv->erased++;
+            }
+            continue;
+        }
+        ret = scanSector(kv, sector, &endAddr);
+        if(sector == kv->head) {
+            kv->writeAddr = endAddr;
+        }
+    }
+
+    /* copy stored values into RAM variables */
+    for(i=0; ret == CO_ERROR_NO && i<noEntries; i++) {
+        CO_KVentry_t *entry = &entries[i];
+
+        if(entry->address != CO_KV_NO_ADDRESS) {
+            CO_LOCK_OD();
+            ret = flash->read(flash->object, entry->address + KV_HDR_SIZE, entry->data, entry->length);
+            CO_UNLOCK_OD();
+        }
+    }
+
+    /* power loss during compaction */
+    if(ret == CO_ERROR_NO) {
+        ret = compactAll(kv);
+    }
+
+    return (ret == CO_ERROR_NO) ? CO_ERROR_NO : CO_ERROR_DATA_CORRUPT;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_KVstore_storeEntry(CO_KVstore_t *kv, uint16_t entryNo) {
+    CO_KVentry_t *entry;
+    const uint8_t *data;
+    uint8_t buf[KV_CHUNK];
+    bool_t changed;
+    uint32_t offset;
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    /* verify arguments */
+    if(kv==NULL || entryNo >= kv->noEntries) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    entry = &kv->entries[entryNo];
+    data = (const uint8_t *)entry->data;
+
+    /* compare with the newest record */
+    CO_LOCK_OD();
+    changed = entry->address == CO_KV_NO_ADDRESS;
+    for(offset = 0; !changed && offset < entry->length; offset += KV_CHUNK) {
+        uint32_t len = entry->length - offset;
+        if(len > KV_CHUNK) {
+            len = KV_CHUNK;
+        }
+        if(kv->flash->read(kv->flash->object, entry->address + KV_HDR_SIZE + offset, buf, len) != CO_ERROR_NO) {
+            ret = CO_ERROR_DATA_CORRUPT;
+            break;
+        }
+        changed = memcmp(buf, &data[offset], len) != 0;
+    }
+    CO_UNLOCK_OD();
+
+    if(!changed || ret != CO_ERROR_NO) {
+        return ret;
+    }
+
+    /* Append the record. Compaction may move the newest record of the entry. */
+    ret = makeSpace(kv, recordSize(kv, entry->length));
+    if(ret == CO_ERROR_NO) {
+        KV_recordHeader_t rec;
+        uint32_t address = kv->writeAddr;
+        uint16_t crc;
+
+        rec.key = entry->key;
+        rec.length = entry->length;
+
+        /* OD variable must not change between CRC and write */
+        CO_LOCK_OD();
+        crc = crc16_ccitt((const unsigned char *)&rec, 6, 0);
+        crc = crc16_ccitt(data, entry->length, crc);
+        ret = writeRecord(kv, entry->key, entry->length, data, 0, crc);
+        CO_UNLOCK_OD();
+
+        if(ret == CO_ERROR_NO) {
+            entry->address = address;
+            kv->records++;
+        }
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_KVstore_store(CO_KVstore_t *kv) {
+    CO_ReturnError_t ret = CO_ERROR_NO;
+    uint16_t i;
+
+    if(kv==NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    for(i=0; ret == CO_ERROR_NO && i<kv->noEntries; i++) {
+        ret = CO_KVstore_storeEntry(kv, i);
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_KVstore_process(CO_KVstore_t *kv, bool_t autoStore) {
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    if(kv==NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Keep one more erased sector than required, so store does not wait.
+     * One step per call, compaction continues from kv->compactAddr. */
+    if(kv->erased <= KV_MIN_ERASED) {
+        ret = compactStep(kv);
+    }
+
+    if(ret == CO_ERROR_NO && autoStore && kv->noEntries > 0U) {
+        ret = CO_KVstore_storeEntry(kv, kv->processEntry);
+        if(++kv->processEntry >= kv->noEntries) {
+            kv->processEntry = 0;
+        }
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_KVstore_format(CO_KVstore_t *kv) {
+    const CO_flash_t *flash;
+    uint16_t i;
+
+    if(kv==NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    flash = kv->flash;
+
+    /* erase used sectors, oldest first */
+    for(i=1; i<=flash->sectorCount; i++) {
+        uint16_t sector = (uint16_t)((kv->head + i) % flash->sectorCount);
+
+        if(i > kv->erased) {
+            if(flash->erase(flash->object, sector) != CO_ERROR_NO) {
+                return CO_ERROR_DATA_CORRUPT;
+            }
+            kv->erases++;
+        }
+    }
+    for(i=0; i<kv->noEntries; i++) {
+        kv->entries[i].address = CO_KV_NO_ADDRESS;
+    }
+    kv->erased = flash->sectorCount;
+    kv->compactAddr = 0;
+
+    /* sequence continues, so sectors are used evenly */
+    return advanceHead(kv);
+}
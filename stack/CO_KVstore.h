@@ -0,0 +1,243 @@
+/**
+ * Log-structured key/value storage of Object Dictionary variables in flash.
+ *
+ * @file        CO_KVstore.h
+ * @ingroup     CO_KVstore
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_KV_STORE_H
+#define CO_KV_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "CO_driver.h"
+
+
+/**
+ * @defgroup CO_KVstore Log-structured parameter storage
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Wear-levelled storage of Object Dictionary variables in NOR flash.
+ *
+ * Each stored variable (entry) has a key, usually index and subindex from
+ * the Object Dictionary. Instead of erasing and rewriting the whole flash page
+ * on each store, only changed entries are appended as records to the log.
+ * Record contains key, length, CRC and data. Data are written first and the
+ * record header last, so record, which was interrupted by power loss, fails
+ * CRC and is ignored. Following records are found by searching for the next
+ * valid record.
+ *
+ * Flash is used as a ring of sectors. Each used sector starts with a header
+ * containing sequence number. Records are appended to the head sector. When
+ * it is full, next erased sector becomes the head. Live records (the newest
+ * record of each entry) from the oldest sector are then copied to the head
+ * and the oldest sector is erased. So each sector is erased equally often.
+ * Head advances only if two sectors after it are erased, so compaction, which
+ * was interrupted by power loss, has always an erased sector available.
+ * CO_KVstore_process() keeps three erased sectors, if possible, by compacting
+ * the oldest sector one record at a time, so that store rarely has to wait for
+ * the compaction.
+ *
+ * CO_KVstore_init() reads sectors from the oldest to the head and finds the
+ * newest valid record of each entry. Sectors with invalid header, for example
+ * after interrupted erase, are erased. Interrupted compaction is finished.
+ *
+ * Flash is accessed through CO_flash_t interface. CO_flashSim.h provides RAM
+ * or file backed flash simulator with erase counters and power loss
+ * injection.
+ */
+
+
+/**
+ * Maximum program unit of the flash in bytes.
+ */
+#define CO_KV_MAX_WRITE_SIZE    8
+
+
+/**
+ * Flash memory interface.
+ *
+ * Flash has NOR semantics: erase sets all bytes in the sector to 0xFF, write
+ * may only clear bits. Address and length of write are multiple of writeSize.
+ * Functions return CO_ERROR_NO on success.
+ */
+typedef struct {
+    void               *object;         /**< Passed to the functions */
+    uint32_t            sectorSize;     /**< Erase unit in bytes, multiple of writeSize */
+    uint16_t            sectorCount;    /**< Number of sectors, at least 3 */
+    uint8_t             writeSize;      /**< Program unit: 1, 2, 4 or 8 bytes */
+    /** Read length bytes from address */
+    CO_ReturnError_t  (*read)(void *object, uint32_t address, void *buf, uint32_t length);
+    /** Program length bytes at address */
+    CO_ReturnError_t  (*write)(void *object, uint32_t address, const void *buf, uint32_t length);
+    /** Erase sector */
+    CO_ReturnError_t  (*erase)(void *object, uint16_t sector);
+} CO_flash_t;
+
+
+/**
+ * Stored variable.
+ */
+typedef struct {
+    /** Key, usually (index << 8) | subIndex. Entries must be sorted by key. */
+    uint32_t            key;
+    void               *data;           /**< Variable in RAM (Object Dictionary) */
+    uint16_t            length;         /**< Length of variable in bytes */
+    /** Flash address of the newest record, CO_KV_NO_ADDRESS if none. Set
+    by CO_KVstore_init(). */
+    uint32_t            address;
+} CO_KVentry_t;
+
+
+/** Value of CO_KVentry_t.address, if entry is not stored. */
+#define CO_KV_NO_ADDRESS        0xFFFFFFFFUL
+
+
+/**
+ * Key/value storage object.
+ */
+typedef struct {
+    const CO_flash_t   *flash;          /**< From CO_KVstore_init() */
+    CO_KVentry_t       *entries;        /**< From CO_KVstore_init() */
+    uint16_t            noEntries;      /**< From CO_KVstore_init() */
+    uint8_t             align;          /**< Alignment of records */
+    uint16_t            head;           /**< Sector, to which records are appended */
+    uint32_t            seq;            /**< Sequence number of the head sector */
+    uint32_t            writeAddr;      /**< Next free address in the head sector */
+    uint16_t            erased;         /**< Number of erased sectors after head */
+    uint32_t            compactAddr;    /**< Next record in the oldest sector, 0 if compaction not started */
+    uint16_t            processEntry;   /**< Next entry checked by CO_KVstore_process() */
+    uint32_t            records;        /**< Statistics: number of appended records */
+    uint32_t            copies;         /**< Statistics: number of records copied by compaction */
+    uint32_t            erases;         /**< Statistics: number of erased sectors */
+} CO_KVstore_t;
+
+
+/**
+ * Initialize key/value storage and load stored values.
+ *
+ * Data of entries, which are found in flash, are copied into RAM variables.
+ * Other variables keep default values. Empty flash is prepared for use.
+ *
+ * @param kv This object will be initialized.
+ * @param flash Flash interface.
+ * @param entries Array of stored variables, sorted by key.
+ * @param noEntries Number of entries.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_DATA_CORRUPT (flash access failed).
+ */
+CO_ReturnError_t CO_KVstore_init(
+        CO_KVstore_t           *kv,
+        const CO_flash_t       *flash,
+        CO_KVentry_t            entries[],
+        uint16_t                noEntries);
+
+
+/**
+ * Store one entry, if its value differs from the newest record.
+ *
+ * If CO_KVstore_process() did not keep enough erased sectors, function
+ * first finishes compaction of the oldest sectors, which may take several
+ * sector erases.
+ *
+ * @param kv Key/value storage object.
+ * @param entryNo Index of the entry in entries[].
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT,
+ * CO_ERROR_OUT_OF_MEMORY (live data do not fit into flash) or
+ * CO_ERROR_DATA_CORRUPT (flash access failed).
+ */
+CO_ReturnError_t CO_KVstore_storeEntry(CO_KVstore_t *kv, uint16_t entryNo);
+
+
+/**
+ * Store all changed entries.
+ *
+ * May be used with CANopen OD object at index 1010.
+ *
+ * @param kv Key/value storage object.
+ *
+ * @return Same as CO_KVstore_storeEntry().
+ */
+CO_ReturnError_t CO_KVstore_store(CO_KVstore_t *kv);
+
+
+/**
+ * Process background work.
+ *
+ * Function should be called cyclically. If there are less than three erased
+ * sectors, it does one step of the compaction: it copies one live record of
+ * the oldest sector to the head or erases the oldest sector. Position in the
+ * oldest sector is kept in the object. So function blocks at most for one
+ * sector erase or for reading and writing one record of the longest entry,
+ * plus a read of the rest of the sector, if it ends with garbage of an
+ * interrupted record. If autoStore is true, it also checks one entry and
+ * stores it, if changed, see CO_KVstore_storeEntry().
+ *
+ * @param kv Key/value storage object.
+ * @param autoStore Store changed entries automatically.
+ *
+ * @return Same as CO_KVstore_storeEntry().
+ */
+CO_ReturnError_t CO_KVstore_process(CO_KVstore_t *kv, bool_t autoStore);
+
+
+/**
+ * Erase all stored records.
+ *
+ * RAM variables are not changed, default values are used after next
+ * CO_KVstore_init(). May be used with CANopen OD object at index 1011.
+ *
+ * @param kv Key/value storage object.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_DATA_CORRUPT.
+ */
+CO_ReturnError_t CO_KVstore_format(CO_KVstore_t *kv);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
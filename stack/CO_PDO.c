@@ -52,6 +52,56 @@
 #include "CO_PDO.h"
 #include <string.h>
 
+
+#ifdef CO_PDO_MPDO
+#if (CO_MPDO_RX_FIFO_SIZE < 1) || (CO_MPDO_RX_FIFO_SIZE > 128) || ((CO_MPDO_RX_FIFO_SIZE & (CO_MPDO_RX_FIFO_SIZE - 1)) != 0)
+    #error CO_MPDO_RX_FIFO_SIZE must be a power of two from 1 to 128
+#endif
+
+/* MPDO receive FIFO has single producer (CO_PDO_receive()) and single
+ * consumer (CO_RPDO_process()), see also receive FIFO in CO_SDO.c. */
+#if defined(__GNUC__)
+    #define CO_MPDO_FIFO_LOAD(cnt)          __atomic_load_n(&(cnt), __ATOMIC_ACQUIRE)
+    #define CO_MPDO_FIFO_STORE(cnt, val)    __atomic_store_n(&(cnt), (val), __ATOMIC_RELEASE)
+#else
+    #define CO_MPDO_FIFO_LOAD(cnt)          (cnt)
+    #define CO_MPDO_FIFO_STORE(cnt, val)    ((cnt) = (val))
+#endif
+
+
+/*
+ * Store received MPDO into FIFO.
+ *
+ * DAM-MPDO is stored, if it is addressed to this node or to all nodes. SAM-MPDO
+ * is stored from any producer, its dispatcher list entry is verified later.
+ */
+static void CO_MPDOreceive(CO_RPDO_t *RPDO, const uint8_t *data){
+    uint8_t wr = RPDO->MPDOfifoWr;
+    uint8_t address = data[0];
+
+    if(RPDO->MPDOmode == CO_PDO_MPDO_DAM){
+        if((address & 0x80U) == 0U || ((address & 0x7FU) != 0U && (address & 0x7FU) != RPDO->nodeId)){
+            return;
+        }
+    }
+    else if((address & 0x80U) != 0U){
+        return;
+    }
+
+    /* verify FIFO overflow */
+    if((uint8_t)(wr - CO_MPDO_FIFO_LOAD(RPDO->MPDOfifoRd)) >= CO_MPDO_RX_FIFO_SIZE){
+#ifdef CO_USE_STATISTICS
+        CO_STAT_INC(RPDO->stats.rxOverwrite);
+#endif
+        return;
+    }
+
+    memcpy(RPDO->MPDOfifo[wr & (CO_MPDO_RX_FIFO_SIZE - 1U)], data, 8U);
+    CO_MPDO_FIFO_STORE(RPDO->MPDOfifoWr, (uint8_t)(wr + 1U));
+}
+#endif
+
+
 /*
  * Read received message from CAN module.
  *
@@ -70,6 +120,12 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
         (*RPDO->operatingState == CO_NMT_OPERATIONAL) &&
         (msg->DLC >= RPDO->dataLength))
     {
+#ifdef CO_PDO_MPDO
+        if(RPDO->MPDOmode != 0U) {
+            CO_MPDOreceive(RPDO, msg->data);
+        }
+        else
+#endif
         if(RPDO->synchronous && RPDO->SYNC->CANrxToggle) {
             /* copy data into second buffer and set 'new message' flag */
             RPDO->CANrxData[1][0] = msg->data[0];
@@ -81,6 +137,11 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
             RPDO->CANrxData[1][6] = msg->data[6];
             RPDO->CANrxData[1][7] = msg->data[7];
 
+#ifdef CO_USE_STATISTICS
+            if(RPDO->CANrxNew[1]){
+                CO_STAT_INC(RPDO->stats.rxOverwrite);
+            }
+#endif
             RPDO->CANrxNew[1] = true;
         }
         else {
@@ -94,9 +155,19 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
             RPDO->CANrxData[0][6] = msg->data[6];
             RPDO->CANrxData[0][7] = msg->data[7];
 
+#ifdef CO_USE_STATISTICS
+            if(RPDO->CANrxNew[0]){
+                CO_STAT_INC(RPDO->stats.rxOverwrite);
+            }
+#endif
             RPDO->CANrxNew[0] = true;
         }
     }
+#ifdef CO_USE_STATISTICS
+    else if(msg->DLC < RPDO->dataLength){
+        CO_STAT_INC(RPDO->stats.rxWrongLength);
+    }
+#endif
 }
 
 
@@ -199,7 +270,9 @@ static void CO_TPDOconfigCom(CO_TPDO_t* TPDO, uint32_t COB_IDUsedByTPDO, uint8_t
  * @param map PDO mapping parameter.
  * @param R_T 0 for RPDO map, 1 for TPDO map.
  * @param ppData Pointer to returning parameter: pointer to data of mapped variable.
- * @param pLength Pointer to returning parameter: *add* length of mapped variable.
+ * @param pLength Pointer to returning parameter: *add* length of mapped variable
+ * in bits. Length of variable must be multiple of 8 bits, if CO_PDO_BIT_MAPPING
+ * is not defined.
  * @param pSendIfCOSFlags Pointer to returning parameter: sendIfCOSFlags variable.
  * @param pIsMultibyteVar Pointer to returning parameter: true for multibyte variable.
  *
@@ -225,24 +298,25 @@ static uint32_t CO_PDOfindMap(
     subIndex = (uint8_t)(map>>8);
     dataLen = (uint8_t) map;   /* data length in bits */
 
+#ifndef CO_PDO_BIT_MAPPING
     /* data length must be byte aligned */
     if(dataLen&0x07) return CO_SDO_AB_NO_MAP;   /* Object cannot be mapped to the PDO. */
-
-    dataLen >>= 3;    /* new data length is in bytes */
-    *pLength += dataLen;
+#endif
 
     /* total PDO length can not be more than 8 bytes */
-    if(*pLength > 8) return CO_SDO_AB_MAP_LEN;  /* The number and length of the objects to be mapped would exceed PDO length. */
+    if(((uint16_t)*pLength + dataLen) > 64) return CO_SDO_AB_MAP_LEN;  /* The number and length of the objects to be mapped would exceed PDO length. */
+    *pLength += dataLen;
 
     /* is there a reference to dummy entries */
     if(index <=7 && subIndex == 0){
         static uint32_t dummyTX = 0;
         static uint32_t dummyRX;
-        uint8_t dummySize = 4;
+        uint8_t dummySize = 32;
 
-        if(index<2) dummySize = 0;
-        else if(index==2 || index==5) dummySize = 1;
-        else if(index==3 || index==6) dummySize = 2;
+        if(index<1) dummySize = 0;
+        else if(index==1) dummySize = 1;
+        else if(index==2 || index==5) dummySize = 8;
+        else if(index==3 || index==6) dummySize = 16;
 
         /* is size of variable big enough for map */
         if(dummySize < dataLen) return CO_SDO_AB_NO_MAP;   /* Object cannot be mapped to the PDO. */
@@ -251,6 +325,7 @@ static uint32_t CO_PDOfindMap(
         if(R_T == 0) *ppData = (uint8_t*) &dummyRX;
         else         *ppData = (uint8_t*) &dummyTX;
 
+        *pIsMultibyteVar = 0;
         return 0;
     }
 
@@ -269,7 +344,7 @@ static uint32_t CO_PDOfindMap(
 
     /* is size of variable big enough for map */
     objectLen = CO_OD_getLength(SDO, entryNo, subIndex);
-    if(objectLen < dataLen) return CO_SDO_AB_NO_MAP;   /* Object cannot be mapped to the PDO. */
+    if(((uint16_t)objectLen * 8) < dataLen) return CO_SDO_AB_NO_MAP;   /* Object cannot be mapped to the PDO. */
 
     /* mark multibyte variable */
     *pIsMultibyteVar = (attr&CO_ODA_MB_VALUE) ? 1 : 0;
@@ -279,14 +354,14 @@ static uint32_t CO_PDOfindMap(
 #ifdef CO_BIG_ENDIAN
     /* skip unused MSB bytes */
     if(*pIsMultibyteVar){
-        *ppData += objectLen - dataLen;
+        *ppData += objectLen - ((dataLen + 7) >> 3);
     }
 #endif
 
-    /* setup change of state flags */
-    if(attr&CO_ODA_TPDO_DETECT_COS){
+    /* setup change of state flags for each byte of the PDO, which contains the variable */
+    if(attr&CO_ODA_TPDO_DETECT_COS && dataLen > 0){
         int16_t i;
-        for(i=*pLength-dataLen; i<*pLength; i++){
+        for(i=(*pLength-dataLen)>>3; i<=((*pLength-1)>>3); i++){
             *pSendIfCOSFlags |= 1<<i;
         }
     }
@@ -295,6 +370,399 @@ static uint32_t CO_PDOfindMap(
 }
 
 
+#ifdef CO_PDO_PROCESS_IMAGE
+/*
+ * Place data of the PDO into the process image after its mapping changed.
+ *
+ * Data of the following PDOs are moved, so image stays contiguous. Data of
+ * the PDO are initialized from the mapped Object Dictionary variables and
+ * mapPointers are redirected into the image.
+ *
+ * @param image Input or output image.
+ * @param pUsed Pointer to number of used bytes in the image, updated.
+ * @param slot Data of the PDO in the image.
+ * @param oldLength Previous data length of the PDO.
+ * @param newLength New data length of the PDO.
+ * @param mapPointer Pointers to the mapped variables of the PDO.
+ */
+static void CO_PDOimage_place(
+        uint8_t                *image,
+        uint16_t               *pUsed,
+        uint8_t                *slot,
+        uint8_t                 oldLength,
+        uint8_t                 newLength,
+        uint8_t               **mapPointer)
+{
+    uint8_t *tail = slot + oldLength;
+    uint8_t i;
+
+    memmove(slot + newLength, tail, *pUsed - (uint16_t)(tail - image));
+    *pUsed = *pUsed - oldLength + newLength;
+
+    for(i=0; i<newLength; i++){
+        slot[i] = *mapPointer[i];
+        mapPointer[i] = &slot[i];
+    }
+}
+
+
+/*
+ * Copy PDO data between the process image and the CAN message. Full PDO is
+ * copied as single 8-byte word, library memcpy() is slower for short data.
+ */
+static void CO_PDOimage_copy(uint8_t *dest, const uint8_t *src, uint8_t length){
+    if(length == 8){
+        memcpy(dest, src, 8);
+    }
+    else{
+        while(length-- > 0){
+            *(dest++) = *(src++);
+        }
+    }
+}
+
+
+/*
+ * Shift data of the PDO in the process image.
+ */
+static void CO_PDOimage_shift(uint8_t **pImage, uint8_t **mapPointer, uint8_t length, int16_t delta){
+    uint8_t i;
+
+    *pImage += delta;
+    for(i=0; i<length; i++){
+        mapPointer[i] += delta;
+    }
+}
+
+
+/*
+ * Place data of the RPDO into the input image, see CO_PDOimage_place().
+ */
+static void CO_RPDOimagePlace(CO_RPDO_t *RPDO, uint8_t oldLength){
+    CO_PDOimage_t *PI = RPDO->PI;
+    int16_t delta = (int16_t)RPDO->dataLength - oldLength;
+    bool_t following = false;
+    uint16_t i;
+
+    /* Mapping is written from SDO, while other PDOs may be processed
+     * (CO_process_SYNC_RPDO() and CO_process_TPDO() are called with OD
+     * locked). Their data and pointers are moved, so lock OD here too. */
+    CO_LOCK_OD();
+    CO_PDOimage_place(PI->input, &PI->inputUsed, RPDO->image,
+                      oldLength, RPDO->dataLength, RPDO->mapPointer);
+
+    for(i=0; i<PI->noRPDO; i++){
+        CO_RPDO_t *R = PI->RPDO[i];
+
+        if(following){
+            CO_PDOimage_shift(&R->image, R->mapPointer, R->dataLength, delta);
+        }
+        else if(R == RPDO){
+            following = true;
+        }
+    }
+    CO_UNLOCK_OD();
+}
+
+
+/*
+ * Place data of the TPDO into the output image, see CO_PDOimage_place().
+ */
+static void CO_TPDOimagePlace(CO_TPDO_t *TPDO, uint8_t oldLength){
+    CO_PDOimage_t *PI = TPDO->PI;
+    int16_t delta = (int16_t)TPDO->dataLength - oldLength;
+    bool_t following = false;
+    uint16_t i;
+
+    /* see CO_RPDOimagePlace() */
+    CO_LOCK_OD();
+    CO_PDOimage_place(PI->output, &PI->outputUsed, TPDO->image,
+                      oldLength, TPDO->dataLength, TPDO->mapPointer);
+
+    for(i=0; i<PI->noTPDO; i++){
+        CO_TPDO_t *T = PI->TPDO[i];
+
+        if(following){
+            CO_PDOimage_shift(&T->image, T->mapPointer, T->dataLength, delta);
+        }
+        else if(T == TPDO){
+            following = true;
+        }
+    }
+    CO_UNLOCK_OD();
+}
+#endif
+
+
+#if defined(CO_PDO_BIT_MAPPING) || defined(CO_PDO_MPDO)
+/* Source of the mapPointers of bit mapped PDO and MPDO, their data are
+ * accessed through bitOp or MPDO objects. */
+static uint8_t CO_PDO_noData[8];
+#endif
+
+
+#ifdef CO_PDO_MPDO
+/*
+ * Position of the key in the MPDO hash table (multiplicative hashing).
+ */
+static uint16_t CO_MPDOhash(const CO_MPDO_t *MPDO, uint32_t key){
+    return (uint16_t)((uint32_t)(key * 0x9E3779B1UL) >> 16) & (MPDO->tableSize - 1U);
+}
+
+
+/*
+ * Find object in the MPDO hash table. Table has always at least one empty
+ * entry, which ends the search.
+ */
+static CO_MPDOobject_t *CO_MPDOfind(const CO_MPDO_t *MPDO, uint32_t key){
+    uint16_t i = CO_MPDOhash(MPDO, key);
+
+    for(;;){
+        CO_MPDOobject_t *obj = &MPDO->table[i];
+
+        if(obj->key == key){
+            return obj;
+        }
+        if(obj->key == 0U){
+            return NULL;
+        }
+        i = (i + 1U) & (MPDO->tableSize - 1U);
+    }
+}
+
+
+/*
+ * Resolve Object Dictionary variable for MPDO.
+ *
+ * @param SDO SDO object.
+ * @param obj Object, pData, length and MBvar are written.
+ * @param index Index of the variable.
+ * @param subIndex Subindex of the variable.
+ * @param attrMask Required attributes of the variable.
+ *
+ * @return True if variable exists, has required attributes and is not longer than 4 bytes.
+ */
+static bool_t CO_MPDOresolve(
+        CO_SDO_t               *SDO,
+        CO_MPDOobject_t        *obj,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint16_t                attrMask)
+{
+    uint16_t entryNo = CO_OD_find(SDO, index);
+    uint16_t length;
+
+    if(entryNo == 0xFFFF || subIndex > SDO->OD[entryNo].maxSubIndex){
+        return false;
+    }
+    if((CO_OD_getAttribute(SDO, entryNo, subIndex) & attrMask) != attrMask){
+        return false;
+    }
+    length = CO_OD_getLength(SDO, entryNo, subIndex);
+    if(length == 0U || length > 4U){
+        return false;
+    }
+
+    obj->pData = (uint8_t*) CO_OD_getDataPointer(SDO, entryNo, subIndex);
+    obj->length = (uint8_t) length;
+    obj->MBvar = (CO_OD_getAttribute(SDO, entryNo, subIndex) & CO_ODA_MB_VALUE) ? 1 : 0;
+
+    return true;
+}
+
+
+/*
+ * Insert object into the MPDO hash table. Object with the same key is replaced.
+ */
+static CO_ReturnError_t CO_MPDOinsert(CO_MPDO_t *MPDO, const CO_MPDOobject_t *obj){
+    uint16_t i = CO_MPDOhash(MPDO, obj->key);
+
+    while(MPDO->table[i].key != 0U && MPDO->table[i].key != obj->key){
+        i = (i + 1U) & (MPDO->tableSize - 1U);
+    }
+    if(MPDO->table[i].key == 0U){
+        if((MPDO->tableUsed + 1U) >= MPDO->tableSize){
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
+        MPDO->tableUsed++;
+    }
+    MPDO->table[i] = *obj;
+
+    return CO_ERROR_NO;
+}
+
+
+/*
+ * Copy data between MPDO (little endian) and Object Dictionary variable.
+ */
+static void CO_MPDOcopy(uint8_t *dest, const uint8_t *src, uint8_t length, uint8_t MBvar){
+#ifdef CO_BIG_ENDIAN
+    if(MBvar){
+        src += length;
+        while(length-- > 0U){
+            *(dest++) = *(--src);
+        }
+        return;
+    }
+#endif
+    (void)MBvar;
+    while(length-- > 0U){
+        *(dest++) = *(src++);
+    }
+}
+
+
+/*
+ * Write received MPDOs from FIFO into Object Dictionary.
+ */
+static void CO_MPDOprocess(CO_RPDO_t *RPDO){
+    uint8_t rd = RPDO->MPDOfifoRd;
+
+    while(CO_MPDO_FIFO_LOAD(RPDO->MPDOfifoWr) != rd){
+        const uint8_t *data = RPDO->MPDOfifo[rd & (CO_MPDO_RX_FIFO_SIZE - 1U)];
+        const CO_MPDOobject_t *obj;
+        uint32_t key;
+
+        key = (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+              ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+        if((key & 0x80U) != 0U){
+            key = (key & 0xFFFFFF00UL) | 0x80U;     /* DAM, destination is not part of the key */
+        }
+
+        /* objects, which are not in the table, are ignored */
+        obj = CO_MPDOfind(RPDO->MPDO, key);
+        if(obj != NULL){
+            CO_MPDOcopy(obj->pData, &data[4], obj->length, obj->MBvar);
+        }
+
+        rd++;
+        CO_MPDO_FIFO_STORE(RPDO->MPDOfifoRd, rd);
+    }
+}
+
+
+/*
+ * Send one object as MPDO.
+ */
+static int16_t CO_MPDOsend(CO_TPDO_t *TPDO, uint32_t key, const CO_MPDOobject_t *obj){
+    uint8_t *data = &TPDO->CANtxBuff->data[0];
+
+    data[0] = (uint8_t) key;
+    data[1] = (uint8_t)(key >> 8);
+    data[2] = (uint8_t)(key >> 16);
+    data[3] = (uint8_t)(key >> 24);
+    data[4] = data[5] = data[6] = data[7] = 0;
+    CO_MPDOcopy(&data[4], obj->pData, obj->length, obj->MBvar);
+    TPDO->sendRequest = 0;
+
+    return CO_CANsend(TPDO->CANdevTx, TPDO->CANtxBuff);
+}
+#endif
+
+
+#ifdef CO_PDO_BIT_MAPPING
+
+
+/*
+ * Compile mapped variable into bit operations, see CO_PDObitOp_t.
+ *
+ * @param bitOp Array of operations of the PDO.
+ * @param pNoBitOps Pointer to number of operations, incremented.
+ * @param pData Pointer to data of mapped variable.
+ * @param position Position of the variable in the PDO in bits.
+ * @param length Length of the variable in bits.
+ * @param MBvar True for multibyte variable.
+ */
+static void CO_PDObitCompile(
+        CO_PDObitOp_t          *bitOp,
+        uint8_t                *pNoBitOps,
+        uint8_t                *pData,
+        uint8_t                 position,
+        uint8_t                 length,
+        uint8_t                 MBvar)
+{
+    uint8_t noBytes = (length + 7) >> 3;
+    uint8_t k;
+
+    for(k=0; k<noBytes; k++){
+        CO_PDObitOp_t *op = &bitOp[(*pNoBitOps)++];
+        uint8_t bits = length - k * 8;
+
+        if(bits > 8) bits = 8;
+#ifdef CO_BIG_ENDIAN
+        op->var = MBvar ? (pData + noBytes - 1 - k) : (pData + k);
+#else
+        op->var = pData + k;
+        (void)MBvar;
+#endif
+        op->mask = (uint8_t)((1U << bits) - 1U);
+        op->shift = position + k * 8;
+    }
+}
+
+
+/*
+ * Read PDO data as 64-bit little endian number.
+ */
+static uint64_t CO_PDObitLoad(const uint8_t *data){
+    uint64_t pdo;
+#ifdef CO_BIG_ENDIAN
+    int8_t i;
+
+    pdo = 0;
+    for(i=7; i>=0; i--){
+        pdo = (pdo << 8) | data[i];
+    }
+#else
+    memcpy(&pdo, data, 8);
+#endif
+    return pdo;
+}
+
+
+/*
+ * Write PDO data from 64-bit little endian number.
+ */
+static void CO_PDObitStore(uint8_t *data, uint64_t pdo){
+#ifdef CO_BIG_ENDIAN
+    uint8_t i;
+
+    for(i=0; i<8; i++){
+        data[i] = (uint8_t)pdo;
+        pdo >>= 8;
+    }
+#else
+    memcpy(data, &pdo, 8);
+#endif
+}
+
+
+/*
+ * Copy PDO data into mapped variables.
+ */
+static void CO_PDObitUnpack(const CO_PDObitOp_t *op, uint8_t noBitOps, const uint8_t *data){
+    uint64_t pdo = CO_PDObitLoad(data);
+
+    for(; noBitOps>0; noBitOps--, op++){
+        *op->var = (uint8_t)((*op->var & ~op->mask) | ((uint8_t)(pdo >> op->shift) & op->mask));
+    }
+}
+
+
+/*
+ * Get PDO data from mapped variables.
+ */
+static uint64_t CO_PDObitPack(const CO_PDObitOp_t *op, uint8_t noBitOps){
+    uint64_t pdo = 0;
+
+    for(; noBitOps>0; noBitOps--, op++){
+        pdo |= (uint64_t)(*op->var & op->mask) << op->shift;
+    }
+    return pdo;
+}
+#endif
+
+
 /*
  * Configure RPDO Mapping parameter.
  *
@@ -310,10 +778,38 @@ static uint32_t CO_PDOfindMap(
  */
 static uint32_t CO_RPDOconfigMap(CO_RPDO_t* RPDO, uint8_t noOfMappedObjects){
     int16_t i;
-    uint8_t length = 0;
+    uint8_t length = 0;     /* in bits */
     uint32_t ret = 0;
     const uint32_t* pMap = &RPDO->RPDOMapPar->mappedObject1;
 
+#ifdef CO_PDO_BIT_MAPPING
+    RPDO->bitMapped = false;
+    RPDO->noBitOps = 0;
+#endif
+#ifdef CO_PDO_MPDO
+    /* MPDO has always 8 bytes, objects are found in MPDO hash table */
+    RPDO->MPDOmode = 0;
+    if(noOfMappedObjects > 8){
+        if(RPDO->MPDO != NULL && noOfMappedObjects >= CO_PDO_MPDO_SAM){
+            RPDO->MPDOmode = noOfMappedObjects;
+            RPDO->MPDOfifoRd = RPDO->MPDOfifoWr;
+            for(i=0; i<8; i++){
+                RPDO->mapPointer[i] = &CO_PDO_noData[i];
+            }
+            length = 64;
+        }
+        else{
+            ret = CO_SDO_AB_MAP_LEN;
+        }
+        noOfMappedObjects = 0;
+    }
+#else
+    if(noOfMappedObjects > 8){
+        ret = CO_SDO_AB_MAP_LEN;
+        noOfMappedObjects = 0;
+    }
+#endif
+
     for(i=noOfMappedObjects; i>0; i--){
         int16_t j;
         uint8_t* pData;
@@ -333,28 +829,60 @@ static uint32_t CO_RPDOconfigMap(CO_RPDO_t* RPDO, uint8_t noOfMappedObjects){
                 &MBvar);
         if(ret){
             length = 0;
+#ifdef CO_PDO_BIT_MAPPING
+            RPDO->bitMapped = false;
+            RPDO->noBitOps = 0;
+#endif
             CO_errorReport(RPDO->em, CO_EM_PDO_WRONG_MAPPING, CO_EMC_PROTOCOL_ERROR, map);
             break;
         }
 
+#ifdef CO_PDO_BIT_MAPPING
+        /* bit operations are used, if any variable is not byte aligned */
+        CO_PDObitCompile(RPDO->bitOp, &RPDO->noBitOps, pData, prevLength, length - prevLength, MBvar);
+        if(((prevLength | length) & 0x07) != 0){
+            RPDO->bitMapped = true;
+            continue;
+        }
+#endif
+
         /* write PDO data pointers */
 #ifdef CO_BIG_ENDIAN
         if(MBvar){
-            for(j=length-1; j>=prevLength; j--)
+            for(j=(length>>3)-1; j>=(prevLength>>3); j--)
                 RPDO->mapPointer[j] = pData++;
         }
         else{
-            for(j=prevLength; j<length; j++)
+            for(j=prevLength>>3; j<(length>>3); j++)
                 RPDO->mapPointer[j] = pData++;
         }
 #else
-        for(j=prevLength; j<length; j++){
+        for(j=prevLength>>3; j<(length>>3); j++){
             RPDO->mapPointer[j] = pData++;
         }
 #endif
 
     }
 
+#ifdef CO_PDO_BIT_MAPPING
+    if(RPDO->bitMapped){
+        for(i=0; i<8; i++){
+            RPDO->mapPointer[i] = &CO_PDO_noData[i];
+        }
+    }
+#endif
+    length = (length + 7) >> 3;   /* data length in bytes */
+
+#ifdef CO_PDO_PROCESS_IMAGE
+    if(RPDO->PI != NULL){
+        uint8_t oldLength = RPDO->dataLength;
+
+        RPDO->dataLength = length;
+        CO_RPDOimagePlace(RPDO, oldLength);
+        return ret;
+    }
+#endif
+
     RPDO->dataLength = length;
 
     return ret;
@@ -376,15 +904,66 @@ static uint32_t CO_RPDOconfigMap(CO_RPDO_t* RPDO, uint8_t noOfMappedObjects){
  */
 static uint32_t CO_TPDOconfigMap(CO_TPDO_t* TPDO, uint8_t noOfMappedObjects){
     int16_t i;
-    uint8_t length = 0;
+    uint8_t length = 0;     /* in bits */
     uint32_t ret = 0;
     const uint32_t* pMap = &TPDO->TPDOMapPar->mappedObject1;
 
     TPDO->sendIfCOSFlags = 0;
+#ifdef CO_PDO_BIT_MAPPING
+    TPDO->bitMapped = false;
+    TPDO->noBitOps = 0;
+    TPDO->COSmask = 0;
+#endif
+#ifdef CO_PDO_MPDO
+    /* MPDO has always 8 bytes, SAM-MPDO sends objects from the scanner list
+     * and DAM-MPDO sends the first mapped object. */
+    TPDO->MPDOmode = 0;
+    TPDO->MPDOscan = 0;
+    if(noOfMappedObjects > 8){
+        if(TPDO->MPDO == NULL || noOfMappedObjects < CO_PDO_MPDO_SAM){
+            ret = CO_SDO_AB_MAP_LEN;
+        }
+        else if(noOfMappedObjects == CO_PDO_MPDO_SAM){
+            if(TPDO->MPDO->noScanner == 0U){
+                ret = CO_SDO_AB_NO_MAP;
+            }
+        }
+        else{
+            CO_MPDOobject_t *obj = &TPDO->MPDOobject;
+            uint32_t map = TPDO->TPDOMapPar->mappedObject1;
+            uint8_t bits = 0;
+            uint8_t COSflags = 0;
+
+            ret = CO_PDOfindMap(TPDO->SDO, map, 1, &obj->pData, &bits, &COSflags, &obj->MBvar);
+            if(ret == 0 && (bits == 0 || bits > 32 || (bits & 0x07) != 0)){
+                ret = CO_SDO_AB_NO_MAP;
+            }
+            obj->key = ((map >> 8) & 0x00FFFF00UL) | ((map & 0x0000FF00UL) << 16);
+            obj->length = bits >> 3;
+        }
+        if(ret){
+            if(TPDO->MPDO != NULL) CO_errorReport(TPDO->em, CO_EM_PDO_WRONG_MAPPING, CO_EMC_PROTOCOL_ERROR, TPDO->TPDOMapPar->mappedObject1);
+        }
+        else{
+            TPDO->MPDOmode = noOfMappedObjects;
+            for(i=0; i<8; i++){
+                TPDO->mapPointer[i] = &CO_PDO_noData[i];
+            }
+            length = 64;
+        }
+        noOfMappedObjects = 0;
+    }
+#else
+    if(noOfMappedObjects > 8){
+        ret = CO_SDO_AB_MAP_LEN;
+        noOfMappedObjects = 0;
+    }
+#endif
 
     for(i=noOfMappedObjects; i>0; i--){
         int16_t j;
         uint8_t* pData;
+        uint8_t COSflags = 0;
         uint8_t prevLength = length;
         uint8_t MBvar;
         uint32_t map = *(pMap++);
@@ -396,32 +975,71 @@ static uint32_t CO_TPDOconfigMap(CO_TPDO_t* TPDO, uint8_t noOfMappedObjects){
                 1,
                 &pData,
                 &length,
-                &TPDO->sendIfCOSFlags,
+                &COSflags,
                 &MBvar);
         if(ret){
             length = 0;
+#ifdef CO_PDO_BIT_MAPPING
+            TPDO->bitMapped = false;
+            TPDO->noBitOps = 0;
+#endif
             CO_errorReport(TPDO->em, CO_EM_PDO_WRONG_MAPPING, CO_EMC_PROTOCOL_ERROR, map);
             break;
         }
+        TPDO->sendIfCOSFlags |= COSflags;
+
+#ifdef CO_PDO_BIT_MAPPING
+        /* bit operations are used, if any variable is not byte aligned */
+        if(COSflags != 0){
+            uint8_t bits = length - prevLength;
+            uint64_t mask = (bits >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << bits) - 1);
+
+            TPDO->COSmask |= mask << prevLength;
+        }
+        CO_PDObitCompile(TPDO->bitOp, &TPDO->noBitOps, pData, prevLength, length - prevLength, MBvar);
+        if(((prevLength | length) & 0x07) != 0){
+            TPDO->bitMapped = true;
+            continue;
+        }
+#endif
 
         /* write PDO data pointers */
 #ifdef CO_BIG_ENDIAN
         if(MBvar){
-            for(j=length-1; j>=prevLength; j--)
+            for(j=(length>>3)-1; j>=(prevLength>>3); j--)
                 TPDO->mapPointer[j] = pData++;
         }
         else{
-            for(j=prevLength; j<length; j++)
+            for(j=prevLength>>3; j<(length>>3); j++)
                 TPDO->mapPointer[j] = pData++;
         }
 #else
-        for(j=prevLength; j<length; j++){
+        for(j=prevLength>>3; j<(length>>3); j++){
             TPDO->mapPointer[j] = pData++;
         }
 #endif
 
     }
 
+#ifdef CO_PDO_BIT_MAPPING
+    if(TPDO->bitMapped){
+        for(i=0; i<8; i++){
+            TPDO->mapPointer[i] = &CO_PDO_noData[i];
+        }
+    }
+#endif
+    length = (length + 7) >> 3;   /* data length in bytes */
+
+#ifdef CO_PDO_PROCESS_IMAGE
+    if(TPDO->PI != NULL){
+        uint8_t oldLength = TPDO->dataLength;
+
+        TPDO->dataLength = length;
+        CO_TPDOimagePlace(TPDO, oldLength);
+        return ret;
+    }
+#endif
+
     TPDO->dataLength = length;
 
     return ret;
@@ -623,7 +1241,11 @@ static CO_SDO_abortCode_t CO_ODF_RPDOmap(CO_ODF_arg_t *ODF_arg){
     if(ODF_arg->subIndex == 0){
         uint8_t *value = (uint8_t*) ODF_arg->data;
 
-        if(*value > 8)
+        if(*value > 8
+#ifdef CO_PDO_MPDO
+            && (RPDO->MPDO == NULL || *value < CO_PDO_MPDO_SAM)
+#endif
+        )
             return CO_SDO_AB_MAP_LEN;  /* Number and length of object to be mapped exceeds PDO length. */
 
         /* configure mapping */
@@ -689,7 +1311,11 @@ static CO_SDO_abortCode_t CO_ODF_TPDOmap(CO_ODF_arg_t *ODF_arg){
     if(ODF_arg->subIndex == 0){
         uint8_t *value = (uint8_t*) ODF_arg->data;
 
-        if(*value > 8)
+        if(*value > 8
+#ifdef CO_PDO_MPDO
+            && (TPDO->MPDO == NULL || *value < CO_PDO_MPDO_SAM)
+#endif
+        )
             return CO_SDO_AB_MAP_LEN;  /* Number and length of object to be mapped exceeds PDO length. */
 
         /* configure mapping */
@@ -762,8 +1388,20 @@ CO_ReturnError_t CO_RPDO_init(
 
     /* configure communication and mapping */
     RPDO->CANrxNew[0] = RPDO->CANrxNew[1] = false;
+#ifdef CO_USE_STATISTICS
+    RPDO->stats.rxOverwrite = 0U;
+    RPDO->stats.rxWrongLength = 0U;
+#endif
     RPDO->CANdevRx = CANdevRx;
     RPDO->CANdevRxIdx = CANdevRxIdx;
+#ifdef CO_PDO_PROCESS_IMAGE
+    RPDO->PI = NULL;
+    RPDO->image = NULL;
+#endif
+#ifdef CO_PDO_MPDO
+    RPDO->MPDO = NULL;
+    RPDO->MPDOfifoWr = RPDO->MPDOfifoRd = 0;
+#endif
 
     CO_RPDOconfigMap(RPDO, RPDOMapPar->numberOfMappedObjects);
     CO_RPDOconfigCom(RPDO, RPDOCommPar->COB_IDUsedByRPDO);
@@ -811,6 +1449,13 @@ CO_ReturnError_t CO_TPDO_init(
     /* configure communication and mapping */
     TPDO->CANdevTx = CANdevTx;
     TPDO->CANdevTxIdx = CANdevTxIdx;
+#ifdef CO_PDO_PROCESS_IMAGE
+    TPDO->PI = NULL;
+    TPDO->image = NULL;
+#endif
+#ifdef CO_PDO_MPDO
+    TPDO->MPDO = NULL;
+#endif
     TPDO->syncCounter = 255;
     TPDO->inhibitTimer = 0;
     TPDO->eventTimer = ((uint32_t) TPDOCommPar->eventTimer) * 1000;
@@ -836,6 +1481,15 @@ uint8_t CO_TPDOisCOS(CO_TPDO_t *TPDO){
     uint8_t* pPDOdataByte;
     uint8_t** ppODdataByte;
 
+#ifdef CO_PDO_BIT_MAPPING
+    /* Bit mapped PDO, which is not in the process image, compares mapped bits */
+    if(TPDO->bitMapped && TPDO->mapPointer[0] == &CO_PDO_noData[0]){
+        uint64_t changed = CO_PDObitPack(TPDO->bitOp, TPDO->noBitOps) ^ CO_PDObitLoad(TPDO->CANtxBuff->data);
+
+        return ((changed & TPDO->COSmask) != 0) ? 1 : 0;
+    }
+#endif
+
     pPDOdataByte = &TPDO->CANtxBuff->data[TPDO->dataLength];
     ppODdataByte = &TPDO->mapPointer[TPDO->dataLength];
 
@@ -888,6 +1542,40 @@ int16_t CO_TPDOsend(CO_TPDO_t *TPDO){
         }
     }
 #endif
+#ifdef CO_PDO_MPDO
+    /* Send next object from the scanner list or DAM object to all nodes. */
+    if(TPDO->MPDOmode == CO_PDO_MPDO_SAM){
+        const CO_MPDOobject_t *obj = &TPDO->MPDO->scanner[TPDO->MPDOscan];
+
+        if(++TPDO->MPDOscan >= TPDO->MPDO->noScanner){
+            TPDO->MPDOscan = 0;
+        }
+        return CO_MPDOsend(TPDO, obj->key, obj);
+    }
+    if(TPDO->MPDOmode == CO_PDO_MPDO_DAM){
+        return CO_MPDOsend(TPDO, TPDO->MPDOobject.key | 0x80U, &TPDO->MPDOobject);
+    }
+#endif
+#ifdef CO_PDO_PROCESS_IMAGE
+    /* Copy data from process image. */
+    if(TPDO->PI != NULL){
+        CO_PDOimage_copy(&TPDO->CANtxBuff->data[0], TPDO->image, TPDO->dataLength);
+        TPDO->sendRequest = 0;
+
+        return CO_CANsend(TPDO->CANdevTx, TPDO->CANtxBuff);
+    }
+#endif
+
+#ifdef CO_PDO_BIT_MAPPING
+    /* Pack data from Object dictionary. */
+    if(TPDO->bitMapped){
+        CO_PDObitStore(&TPDO->CANtxBuff->data[0], CO_PDObitPack(TPDO->bitOp, TPDO->noBitOps));
+        TPDO->sendRequest = 0;
+
+        return CO_CANsend(TPDO->CANdevTx, TPDO->CANtxBuff);
+    }
+#endif
+
     i = TPDO->dataLength;
     pPDOdataByte = &TPDO->CANtxBuff->data[0];
     ppODdataByte = &TPDO->mapPointer[0];
@@ -909,7 +1597,18 @@ void CO_RPDO_process(CO_RPDO_t *RPDO, bool_t syncWas){
     if(!RPDO->valid || !(*RPDO->operatingState == CO_NMT_OPERATIONAL))
     {
         RPDO->CANrxNew[0] = RPDO->CANrxNew[1] = false;
+#ifdef CO_PDO_MPDO
+        CO_MPDO_FIFO_STORE(RPDO->MPDOfifoRd, CO_MPDO_FIFO_LOAD(RPDO->MPDOfifoWr));
+#endif
+    }
+#ifdef CO_PDO_MPDO
+    else if(RPDO->MPDOmode != 0U)
+    {
+        if(!RPDO->synchronous || syncWas){
+            CO_MPDOprocess(RPDO);
+        }
     }
+#endif
     else if(!RPDO->synchronous || syncWas)
     {
         uint8_t bufNo = 0;
@@ -931,6 +1630,18 @@ void CO_RPDO_process(CO_RPDO_t *RPDO, bool_t syncWas){
             /* Copy data to Object dictionary. If between the copy operation CANrxNew
              * is set to true by receive thread, then copy the latest data again. */
             RPDO->CANrxNew[bufNo] = false;
+#ifdef CO_PDO_PROCESS_IMAGE
+            if(RPDO->PI != NULL){
+                CO_PDOimage_copy(RPDO->image, pPDOdataByte, RPDO->dataLength);
+            }
+            else
+#endif
+#ifdef CO_PDO_BIT_MAPPING
+            if(RPDO->bitMapped){
+                CO_PDObitUnpack(RPDO->bitOp, RPDO->noBitOps, pPDOdataByte);
+            }
+            else
+#endif
             for(; i>0; i--) {
                 **(ppODdataByte++) = *(pPDOdataByte++);
             }
@@ -1029,3 +1740,276 @@ void CO_TPDO_process(
     TPDO->inhibitTimer = (TPDO->inhibitTimer > timeDifference_us) ? (TPDO->inhibitTimer - timeDifference_us) : 0;
     TPDO->eventTimer = (TPDO->eventTimer > timeDifference_us) ? (TPDO->eventTimer - timeDifference_us) : 0;
 }
+
+
+#ifdef CO_PDO_PROCESS_IMAGE
+/******************************************************************************/
+CO_ReturnError_t CO_PDOimage_init(
+        CO_PDOimage_t          *PI,
+        CO_RPDO_t              *RPDO[],
+        uint16_t                noRPDO,
+        CO_TPDO_t              *TPDO[],
+        uint16_t                noTPDO,
+        uint8_t                *input,
+        uint8_t                *output)
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(PI==NULL || (noRPDO>0 && (RPDO==NULL || input==NULL)) ||
+        (noTPDO>0 && (TPDO==NULL || output==NULL))){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<noRPDO; i++){
+        if(RPDO[i] == NULL) return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<noTPDO; i++){
+        if(TPDO[i] == NULL) return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    PI->input = input;
+    PI->output = output;
+    PI->RPDO = RPDO;
+    PI->TPDO = TPDO;
+    PI->noRPDO = noRPDO;
+    PI->noTPDO = noTPDO;
+    PI->inputUsed = 0;
+    PI->outputUsed = 0;
+
+    /* append data of each PDO to the image */
+    for(i=0; i<noRPDO; i++){
+        CO_RPDO_t *R = RPDO[i];
+
+        R->image = &input[PI->inputUsed];
+        CO_PDOimage_place(input, &PI->inputUsed, R->image, 0, R->dataLength, R->mapPointer);
+        R->PI = PI;
+    }
+    for(i=0; i<noTPDO; i++){
+        CO_TPDO_t *T = TPDO[i];
+
+        T->image = &output[PI->outputUsed];
+        CO_PDOimage_place(output, &PI->outputUsed, T->image, 0, T->dataLength, T->mapPointer);
+        T->PI = PI;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+uint8_t *CO_PDOimage_find(
+        CO_PDOimage_t          *PI,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        bool_t                  input)
+{
+    uint16_t noPDO = input ? PI->noRPDO : PI->noTPDO;
+    uint16_t i;
+
+    for(i=0; i<noPDO; i++){
+        const uint32_t *pMap;
+        uint8_t noMapped;
+        uint8_t *data;
+        uint8_t position = 0;
+        uint8_t j;
+
+        if(input){
+            if(PI->RPDO[i]->dataLength == 0) continue;
+            pMap = &PI->RPDO[i]->RPDOMapPar->mappedObject1;
+            noMapped = PI->RPDO[i]->RPDOMapPar->numberOfMappedObjects;
+            data = PI->RPDO[i]->image;
+        }
+        else{
+            if(PI->TPDO[i]->dataLength == 0) continue;
+            pMap = &PI->TPDO[i]->TPDOMapPar->mappedObject1;
+            noMapped = PI->TPDO[i]->TPDOMapPar->numberOfMappedObjects;
+            data = PI->TPDO[i]->image;
+        }
+
+        if(noMapped > 8) continue;  /* MPDO */
+        for(j=0; j<noMapped; j++){
+            uint32_t map = pMap[j];
+
+            if((uint16_t)(map>>16) == index && (uint8_t)(map>>8) == subIndex){
+                return data + (position >> 3);
+            }
+            position += (uint8_t)map;
+        }
+    }
+
+    return NULL;
+}
+#endif
+
+
+#ifdef CO_PDO_MPDO
+/******************************************************************************/
+CO_ReturnError_t CO_MPDO_init(
+        CO_MPDO_t              *MPDO,
+        CO_SDO_t               *SDO,
+        uint8_t                 nodeId,
+        CO_RPDO_t              *RPDO[],
+        uint16_t                noRPDO,
+        CO_TPDO_t              *TPDO[],
+        uint16_t                noTPDO,
+        const uint32_t          scannerList[],
+        uint8_t                 noScannerList,
+        const uint64_t          dispatcherList[],
+        uint8_t                 noDispatcherList,
+        CO_MPDOobject_t         scanner[],
+        uint16_t                scannerSize,
+        CO_MPDOobject_t         table[],
+        uint16_t                tableSize)
+{
+    const uint16_t attrRPDO = CO_ODA_RPDO_MAPABLE | CO_ODA_WRITEABLE;
+    const uint16_t attrTPDO = CO_ODA_TPDO_MAPABLE | CO_ODA_READABLE;
+    CO_MPDOobject_t obj;
+    uint16_t i;
+
+    /* verify arguments */
+    if(MPDO==NULL || SDO==NULL || nodeId<1 || nodeId>127 ||
+        (noRPDO>0 && RPDO==NULL) || (noTPDO>0 && TPDO==NULL) ||
+        (noScannerList>0 && (scannerList==NULL || scanner==NULL)) ||
+        (noDispatcherList>0 && dispatcherList==NULL) ||
+        table==NULL || tableSize<2 || (tableSize & (tableSize - 1U)) != 0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<noRPDO; i++){
+        if(RPDO[i] == NULL) return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<noTPDO; i++){
+        if(TPDO[i] == NULL) return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    MPDO->table = table;
+    MPDO->tableSize = tableSize;
+    MPDO->tableUsed = 0;
+    MPDO->scanner = scanner;
+    MPDO->scannerSize = scannerSize;
+    MPDO->noScanner = 0;
+    memset(table, 0, sizeof(CO_MPDOobject_t) * tableSize);
+
+    /* DAM-MPDO may write any RPDO mappable variable */
+    for(i=0; i<SDO->ODSize; i++){
+        uint16_t index = SDO->OD[i].index;
+        uint16_t sub;
+
+        for(sub=0; sub<=SDO->OD[i].maxSubIndex; sub++){
+            if(CO_MPDOresolve(SDO, &obj, index, (uint8_t)sub, attrRPDO)){
+                CO_ReturnError_t r;
+
+                obj.key = 0x80U | ((uint32_t)index << 8) | ((uint32_t)sub << 24);
+                r = CO_MPDOinsert(MPDO, &obj);
+                if(r != CO_ERROR_NO) return r;
+            }
+        }
+    }
+
+    /* SAM-MPDO writes variables from the dispatcher list */
+    for(i=0; i<noDispatcherList; i++){
+        uint64_t entry = dispatcherList[i];
+        uint8_t producer = (uint8_t) entry;
+        uint8_t producerSub = (uint8_t)(entry >> 8);
+        uint16_t producerIndex = (uint16_t)(entry >> 16);
+        uint8_t localSub = (uint8_t)(entry >> 32);
+        uint16_t localIndex = (uint16_t)(entry >> 40);
+        uint8_t blockSize = (uint8_t)(entry >> 56);
+        uint8_t j;
+
+        if(entry == 0U) continue;
+        if(producer < 1 || producer > 127 || ((uint16_t)producerSub + blockSize) > 256U
+            || ((uint16_t)localSub + blockSize) > 256U)
+        {
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        for(j=0; j<blockSize; j++){
+            CO_ReturnError_t r;
+
+            if(!CO_MPDOresolve(SDO, &obj, localIndex, localSub + j, attrRPDO)){
+                return CO_ERROR_ILLEGAL_ARGUMENT;
+            }
+            obj.key = producer | ((uint32_t)producerIndex << 8) | ((uint32_t)(uint8_t)(producerSub + j) << 24);
+            r = CO_MPDOinsert(MPDO, &obj);
+            if(r != CO_ERROR_NO) return r;
+        }
+    }
+
+    /* SAM-MPDO sends variables from the scanner list */
+    for(i=0; i<noScannerList; i++){
+        uint32_t entry = scannerList[i];
+        uint8_t subIndex = (uint8_t) entry;
+        uint16_t index = (uint16_t)(entry >> 8);
+        uint8_t blockSize = (uint8_t)(entry >> 24);
+        uint8_t j;
+
+        if(entry == 0U) continue;
+        if(((uint16_t)subIndex + blockSize) > 256U){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        for(j=0; j<blockSize; j++){
+            if(MPDO->noScanner >= scannerSize){
+                return CO_ERROR_OUT_OF_MEMORY;
+            }
+            if(!CO_MPDOresolve(SDO, &scanner[MPDO->noScanner], index, subIndex + j, attrTPDO)){
+                return CO_ERROR_ILLEGAL_ARGUMENT;
+            }
+            scanner[MPDO->noScanner].key = nodeId | ((uint32_t)index << 8) | ((uint32_t)(uint8_t)(subIndex + j) << 24);
+            MPDO->noScanner++;
+        }
+    }
+
+    /* configure PDOs, which are mapped as MPDO */
+    for(i=0; i<noRPDO; i++){
+        CO_RPDO_t *R = RPDO[i];
+
+        R->MPDO = MPDO;
+        if(R->RPDOMapPar->numberOfMappedObjects > 8){
+            CO_RPDOconfigMap(R, R->RPDOMapPar->numberOfMappedObjects);
+            CO_RPDOconfigCom(R, R->RPDOCommPar->COB_IDUsedByRPDO);
+        }
+    }
+    for(i=0; i<noTPDO; i++){
+        CO_TPDO_t *T = TPDO[i];
+        const CO_TPDOCommPar_t *par = T->TPDOCommPar;
+
+        T->MPDO = MPDO;
+        if(T->TPDOMapPar->numberOfMappedObjects > 8){
+            CO_TPDOconfigMap(T, T->TPDOMapPar->numberOfMappedObjects);
+            CO_TPDOconfigCom(T, par->COB_IDUsedByTPDO, ((par->transmissionType<=240) ? 1 : 0));
+            if((par->transmissionType>240 && par->transmissionType<254) || par->SYNCStartValue>240){
+                T->valid = false;
+            }
+        }
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+int16_t CO_TPDOsendMPDO(
+        CO_TPDO_t              *TPDO,
+        uint8_t                 nodeId,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        const uint8_t           data[4])
+{
+    CO_MPDOobject_t obj;
+
+    if(TPDO->MPDOmode != CO_PDO_MPDO_DAM || nodeId > 127 || data == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if(!TPDO->valid || *TPDO->operatingState != CO_NMT_OPERATIONAL){
+        return CO_ERROR_TX_UNCONFIGURED;
+    }
+
+    /* data are already in CANopen byte order */
+    obj.pData = (uint8_t*) data;
+    obj.length = 4;
+    obj.MBvar = 0;
+
+    return CO_MPDOsend(TPDO, 0x80U | nodeId | ((uint32_t)index << 8) | ((uint32_t)subIndex << 24), &obj);
+}
+#endif
@@ -69,7 +69,7 @@ extern "C" {
  *
  * Features of the PDO as implemented here, in CANopenNode:
  *  - Dynamic PDO mapping.
- *  - Map granularity of one byte.
+ *  - Map granularity of one byte, or one bit if CO_PDO_BIT_MAPPING is defined.
  *  - After RPDO is received from CAN bus, its data are copied to buffer.
  *    Function CO_RPDO_process() (called by application) copies data to
  *    mapped objects in Object Dictionary. Synchronous RPDOs are processed AFTER
@@ -77,9 +77,81 @@ extern "C" {
  *  - Function CO_TPDO_process() (called by application) sends TPDO if
  *    necessary. There are possible different transmission types, including
  *    automatic detection of Change of State of specific variable.
+ *  - Optional process image, see CO_PDOimage_init().
+ *  - Optional multiplexed PDOs (MPDO), if CO_PDO_MPDO is defined, see
+ *    CO_MPDO_init().
  */
 
 
+#ifdef CO_PDO_PROCESS_IMAGE
+struct CO_PDOimage_t;
+#endif
+
+
+#ifdef CO_PDO_BIT_MAPPING
+/**
+ * Maximum number of bit operations of one PDO. Mapped variable of n bits
+ * needs (n + 7) / 8 operations, eight variables in 64 bits need at most 15.
+ */
+#define CO_PDO_BIT_OPS          16
+
+/**
+ * One operation of the bit mapping.
+ *
+ * If any mapped variable of the PDO is not byte aligned, its mapping is
+ * compiled into these operations, when mapping is configured. Each operation
+ * transfers up to 8 bits between one byte of the mapped variable and PDO data,
+ * taken as 64-bit little endian number. CO_RPDO_process() and CO_TPDOsend()
+ * then execute fixed sequence of shifts and masks without branches.
+ * Dummy entries are compiled as other variables.
+ */
+typedef struct{
+    uint8_t            *var;            /**< Byte of the mapped variable */
+    uint8_t             mask;           /**< Mapped bits of the byte */
+    uint8_t             shift;          /**< Position of the byte in PDO data in bits */
+}CO_PDObitOp_t;
+#endif
+
+
+#ifdef CO_PDO_MPDO
+struct CO_MPDO_t;
+
+/**
+ * Size of the MPDO receive FIFO of the RPDO.
+ *
+ * Number of received MPDOs, which are stored until CO_RPDO_process() writes
+ * them into Object Dictionary. Unlike other PDOs, each MPDO carries different
+ * object, so MPDOs must not overwrite each other. Value must be a power of
+ * two, from 1 to 128.
+ */
+    #ifndef CO_MPDO_RX_FIFO_SIZE
+        #define CO_MPDO_RX_FIFO_SIZE  8
+    #endif
+
+/** Number of mapped objects of Source Address Mode MPDO (scanner list) */
+#define CO_PDO_MPDO_SAM         0xFEU
+/** Number of mapped objects of Destination Address Mode MPDO */
+#define CO_PDO_MPDO_DAM         0xFFU
+
+
+/**
+ * Object of the MPDO.
+ *
+ * MPDO carries the multiplexer in the first four bytes: address byte
+ * (bit 7 set for DAM, node-ID in bits 0..6), index and subindex. Data of one
+ * object, up to four bytes, follow. Multiplexer, read as 32-bit little endian
+ * number, is the key of the object. Address byte of the key is 0x80 for DAM
+ * (destination node-ID is not part of the key) and producer node-ID for SAM.
+ */
+typedef struct{
+    uint32_t            key;            /**< Multiplexer, zero for empty entry */
+    uint8_t            *pData;          /**< Variable in Object Dictionary */
+    uint8_t             length;         /**< Length of the variable, from 1 to 4 bytes */
+    uint8_t             MBvar;          /**< True for multibyte variable */
+}CO_MPDOobject_t;
+#endif
+
+
 /**
  * RPDO communication parameter. The same as record from Object dictionary (index 0x1400+).
  */
@@ -105,7 +177,8 @@ typedef struct{
  */
 typedef struct{
     /** Actual number of mapped objects from 0 to 8. To change mapped object,
-    this value must be 0. */
+    this value must be 0. With CO_PDO_MPDO also #CO_PDO_MPDO_SAM or
+    #CO_PDO_MPDO_DAM for MPDO consumer. */
     uint8_t             numberOfMappedObjects;
     /** Location and size of the mapped object. Bit meanings `0xIIIISSLL`:
         - Bit  0-7:  Data Length in bits.
@@ -162,7 +235,9 @@ typedef struct{
  */
 typedef struct{
     /** Actual number of mapped objects from 0 to 8. To change mapped object,
-    this value must be 0. */
+    this value must be 0. With CO_PDO_MPDO also #CO_PDO_MPDO_SAM (objects
+    from scanner list) or #CO_PDO_MPDO_DAM (mappedObject1 is sent) for MPDO
+    producer. */
     uint8_t             numberOfMappedObjects;
     /** Location and size of the mapped object. Bit meanings `0xIIIISSLL`:
         - Bit  0-7:  Data Length in bits.
@@ -179,6 +254,21 @@ typedef struct{
 }CO_TPDOMapPar_t;
 
 
+#ifdef CO_USE_STATISTICS
+/**
+ * Statistics counters of the RPDO, see CO_USE_STATISTICS in CO_driver.h.
+ */
+typedef struct{
+    /** Received messages, which overwrote previous, not yet processed message.
+    For MPDO: received messages, which were dropped, because MPDO receive FIFO
+    was full. */
+    uint32_t            rxOverwrite;
+    /** Received messages, which were shorter than mapped data length */
+    uint32_t            rxWrongLength;
+}CO_RPDOstats_t;
+#endif
+
+
 /**
  * RPDO object.
  */
@@ -206,6 +296,31 @@ typedef struct{
     uint8_t             CANrxData[2][8];
     CO_CANmodule_t     *CANdevRx;       /**< From CO_RPDO_init() */
     uint16_t            CANdevRxIdx;    /**< From CO_RPDO_init() */
+#ifdef CO_USE_STATISTICS
+    CO_RPDOstats_t      stats;          /**< Statistics counters */
+#endif
+#ifdef CO_PDO_PROCESS_IMAGE
+    struct CO_PDOimage_t *PI;           /**< From CO_PDOimage_init() or NULL */
+    /** Data of this PDO in the input image, if PI is not NULL */
+    uint8_t            *image;
+#endif
+#ifdef CO_PDO_BIT_MAPPING
+    /** True, if mapping is not byte aligned and bitOp is used instead of mapPointer */
+    bool_t              bitMapped;
+    uint8_t             noBitOps;       /**< Number of operations in bitOp */
+    CO_PDObitOp_t       bitOp[CO_PDO_BIT_OPS]; /**< Compiled mapping */
+#endif
+#ifdef CO_PDO_MPDO
+    struct CO_MPDO_t   *MPDO;           /**< From CO_MPDO_init() or NULL */
+    /** #CO_PDO_MPDO_SAM or #CO_PDO_MPDO_DAM for MPDO consumer, 0 otherwise */
+    uint8_t             MPDOmode;
+    /** Received MPDOs, filled by CO_PDO_receive() and emptied by CO_RPDO_process() */
+    uint8_t             MPDOfifo[CO_MPDO_RX_FIFO_SIZE][8];
+    /** Number of messages written into MPDOfifo (modulo 256) */
+    volatile uint8_t    MPDOfifoWr;
+    /** Number of messages read from MPDOfifo (modulo 256) */
+    volatile uint8_t    MPDOfifoRd;
+#endif
 }CO_RPDO_t;
 
 
@@ -242,9 +357,99 @@ typedef struct{
     CO_CANmodule_t     *CANdevTx;       /**< From CO_TPDO_init() */
     CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer inside CANdev */
     uint16_t            CANdevTxIdx;    /**< From CO_TPDO_init() */
+#ifdef CO_PDO_PROCESS_IMAGE
+    struct CO_PDOimage_t *PI;           /**< From CO_PDOimage_init() or NULL */
+    /** Data of this PDO in the output image, if PI is not NULL */
+    uint8_t            *image;
+#endif
+#ifdef CO_PDO_BIT_MAPPING
+    /** True, if mapping is not byte aligned and bitOp is used instead of mapPointer */
+    bool_t              bitMapped;
+    uint8_t             noBitOps;       /**< Number of operations in bitOp */
+    CO_PDObitOp_t       bitOp[CO_PDO_BIT_OPS]; /**< Compiled mapping */
+    /** Bits of the PDO data, which are verified by CO_TPDOisCOS() */
+    uint64_t            COSmask;
+#endif
+#ifdef CO_PDO_MPDO
+    struct CO_MPDO_t   *MPDO;           /**< From CO_MPDO_init() or NULL */
+    /** #CO_PDO_MPDO_SAM or #CO_PDO_MPDO_DAM for MPDO producer, 0 otherwise */
+    uint8_t             MPDOmode;
+    /** Next object from the scanner list, which will be sent by SAM-MPDO */
+    uint16_t            MPDOscan;
+    /** Mapped object of DAM-MPDO */
+    CO_MPDOobject_t     MPDOobject;
+#endif
 }CO_TPDO_t;
 
 
+#ifdef CO_PDO_PROCESS_IMAGE
+/**
+ * Process image object.
+ *
+ * Data of all RPDOs are laid out contiguously in the input image and data
+ * of all TPDOs in the output image, in order of PDOs and mapped objects.
+ * Data are in CANopen (little endian) byte order, the same as in the CAN
+ * message. CO_RPDO_process() copies received PDO into the input image and
+ * CO_TPDOsend() copies the output image into the PDO, each with single
+ * memcpy(). Application reads inputs from and writes outputs to the image,
+ * so its I/O scan touches few cache lines instead of the whole OD.
+ *
+ * Mapped Object Dictionary variables are not accessed by PDOs in this mode.
+ * They provide initial values of the image only, when PDO is mapped. Bit
+ * mapped PDO (see CO_PDO_BIT_MAPPING) is in the image as packed PDO data,
+ * with initial value zero. MPDO (see CO_PDO_MPDO) does not use its data in
+ * the image.
+ * Application may get location of the mapped object with CO_PDOimage_find().
+ * Location changes, if mapping of the previous PDO changes. Data are then
+ * moved inside CO_LOCK_OD() section, so application must access the image
+ * and location from CO_PDOimage_find() with OD locked, if threads are used.
+ */
+typedef struct CO_PDOimage_t{
+    uint8_t            *input;          /**< From CO_PDOimage_init() */
+    uint8_t            *output;         /**< From CO_PDOimage_init() */
+    CO_RPDO_t         **RPDO;           /**< From CO_PDOimage_init() */
+    CO_TPDO_t         **TPDO;           /**< From CO_PDOimage_init() */
+    uint16_t            noRPDO;         /**< From CO_PDOimage_init() */
+    uint16_t            noTPDO;         /**< From CO_PDOimage_init() */
+    uint16_t            inputUsed;      /**< Bytes used in the input image */
+    uint16_t            outputUsed;     /**< Bytes used in the output image */
+}CO_PDOimage_t;
+#endif
+
+
+#ifdef CO_PDO_MPDO
+/**
+ * MPDO object.
+ *
+ * Multiplexed PDO (CiA 301) transfers one object of up to four bytes together
+ * with its address, so a single COB-ID serves many objects and many nodes:
+ *  - DAM-MPDO (destination address mode): producer, usually a master, writes
+ *    object with given index and subindex into the consumer with given
+ *    node-ID, or into all consumers, if node-ID is zero. Any RPDO mappable
+ *    object of the consumer may be written. See CO_TPDOsendMPDO().
+ *  - SAM-MPDO (source address mode): producer sends objects from its scanner
+ *    list, one object at each transmission of the TPDO. Address includes
+ *    producer node-ID and index and subindex in producer. Consumer writes
+ *    object, which is assigned to that address by its dispatcher list.
+ *
+ * PDO becomes MPDO, if numberOfMappedObjects in its mapping parameter is
+ * #CO_PDO_MPDO_SAM or #CO_PDO_MPDO_DAM. Consumer must not search Object
+ * Dictionary for each received MPDO. CO_MPDO_init() resolves the scanner list,
+ * the dispatcher list and all DAM objects once and stores them in hash table,
+ * so CO_RPDO_process() finds the object of the MPDO in constant time.
+ */
+typedef struct CO_MPDO_t{
+    CO_MPDOobject_t    *table;          /**< From CO_MPDO_init() */
+    uint16_t            tableSize;      /**< From CO_MPDO_init() */
+    uint16_t            tableUsed;      /**< Number of used entries in table */
+    CO_MPDOobject_t    *scanner;        /**< From CO_MPDO_init() */
+    uint16_t            scannerSize;    /**< From CO_MPDO_init() */
+    /** Number of objects in scanner, blocks of the scanner list are expanded */
+    uint16_t            noScanner;
+}CO_MPDO_t;
+#endif
+
+
 /**
  * Initialize RPDO object.
  *
@@ -398,6 +603,137 @@ void CO_TPDO_process(
         bool_t                  syncWas,
         uint32_t                timeDifference_us);
 
+
+#ifdef CO_PDO_PROCESS_IMAGE
+/**
+ * Initialize process image and move PDO data into it.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_RPDO_init() and CO_TPDO_init(). Image is initialized from mapped
+ * Object Dictionary variables. Later changes of the PDO mapping are placed
+ * into the image automatically.
+ *
+ * @param PI This object will be initialized.
+ * @param RPDO Array of pointers to RPDO objects, for example CO->RPDO.
+ * @param noRPDO Number of RPDOs.
+ * @param TPDO Array of pointers to TPDO objects, for example CO->TPDO.
+ * @param noTPDO Number of TPDOs.
+ * @param input Input image, size must be at least 8 * noRPDO bytes.
+ * @param output Output image, size must be at least 8 * noTPDO bytes.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_PDOimage_init(
+        CO_PDOimage_t          *PI,
+        CO_RPDO_t              *RPDO[],
+        uint16_t                noRPDO,
+        CO_TPDO_t              *TPDO[],
+        uint16_t                noTPDO,
+        uint8_t                *input,
+        uint8_t                *output);
+
+
+/**
+ * Find location of the mapped object in the process image.
+ *
+ * @param PI This object.
+ * @param index Index of the mapped object.
+ * @param subIndex Subindex of the mapped object.
+ * @param input True for input image (RPDO), false for output image (TPDO).
+ *
+ * @return Pointer to the first occurrence of the object in the image or NULL,
+ * if object is not mapped. For bit mapped object it points to the byte, which
+ * contains the first bit of the object.
+ */
+uint8_t *CO_PDOimage_find(
+        CO_PDOimage_t          *PI,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        bool_t                  input);
+#endif
+
+
+#ifdef CO_PDO_MPDO
+/**
+ * Initialize MPDO object and enable MPDOs.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_RPDO_init() and CO_TPDO_init(). PDOs, which have numberOfMappedObjects
+ * #CO_PDO_MPDO_SAM or #CO_PDO_MPDO_DAM, are configured as MPDOs. Mapping of
+ * other PDOs may be changed into MPDO later.
+ *
+ * Lists have the format of CiA 301 object scanner list (index 0x1FA0+) and
+ * object dispatcher list (index 0x1FD0+). Zero entries are not used.
+ *
+ * @param MPDO This object will be initialized.
+ * @param SDO SDO server object.
+ * @param nodeId CANopen Node ID of this device, address of SAM-MPDO.
+ * @param RPDO Array of pointers to RPDO objects, for example CO->RPDO.
+ * @param noRPDO Number of RPDOs.
+ * @param TPDO Array of pointers to TPDO objects, for example CO->TPDO.
+ * @param noTPDO Number of TPDOs.
+ * @param scannerList Objects sent by SAM-MPDO producer. Bit meanings
+ * `0xBBIIIISS`: block size (number of consecutive subindexes), index and
+ * subindex. May be NULL.
+ * @param noScannerList Number of entries in scannerList.
+ * @param dispatcherList Objects written by SAM-MPDO consumer. Bit meanings
+ * `0xBBIIIISSiiiissNN`: block size, local index and subindex, producer index
+ * and subindex, producer node-ID. May be NULL.
+ * @param noDispatcherList Number of entries in dispatcherList.
+ * @param scanner Array for resolved objects of the scanner list.
+ * @param scannerSize Size of the above array.
+ * @param table Hash table for received objects. It contains all RPDO mappable
+ * objects of Object Dictionary (for DAM-MPDO) and all objects from the
+ * dispatcher list.
+ * @param tableSize Size of the above array, must be a power of two and
+ * larger than number of objects.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT (also
+ * wrong object in the lists) or CO_ERROR_OUT_OF_MEMORY (too small arrays).
+ */
+CO_ReturnError_t CO_MPDO_init(
+        CO_MPDO_t              *MPDO,
+        CO_SDO_t               *SDO,
+        uint8_t                 nodeId,
+        CO_RPDO_t              *RPDO[],
+        uint16_t                noRPDO,
+        CO_TPDO_t              *TPDO[],
+        uint16_t                noTPDO,
+        const uint32_t          scannerList[],
+        uint8_t                 noScannerList,
+        const uint64_t          dispatcherList[],
+        uint8_t                 noDispatcherList,
+        CO_MPDOobject_t         scanner[],
+        uint16_t                scannerSize,
+        CO_MPDOobject_t         table[],
+        uint16_t                tableSize);
+
+
+/**
+ * Send DAM-MPDO with any object to any node.
+ *
+ * TPDO must be configured as DAM-MPDO producer, valid and in NMT operational
+ * state. Function sends immediately, it does not verify inhibit time.
+ * Application, which sends many MPDOs, must retry, when function returns
+ * CO_ERROR_TX_OVERFLOW.
+ *
+ * @param TPDO TPDO object.
+ * @param nodeId Node-ID of the consumer or 0 for all nodes.
+ * @param index Index of the object in the consumer.
+ * @param subIndex Subindex of the object in the consumer.
+ * @param data Four data bytes in CANopen (little endian) byte order.
+ *
+ * @return Same as CO_CANsend(), CO_ERROR_ILLEGAL_ARGUMENT if TPDO is not
+ * DAM-MPDO or CO_ERROR_TX_UNCONFIGURED if TPDO is not valid or operational.
+ */
+int16_t CO_TPDOsendMPDO(
+        CO_TPDO_t              *TPDO,
+        uint8_t                 nodeId,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        const uint8_t           data[4]);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
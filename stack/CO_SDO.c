@@ -63,6 +63,78 @@
     #error CO_SDO_BUFFER_SIZE must be greater than 7
 #endif
 
+#if (CO_SDO_RX_FIFO_SIZE < 1) || (CO_SDO_RX_FIFO_SIZE > 128) || ((CO_SDO_RX_FIFO_SIZE & (CO_SDO_RX_FIFO_SIZE - 1)) != 0)
+    #error CO_SDO_RX_FIFO_SIZE must be a power of two from 1 to 128
+#endif
+
+
+/* Receive FIFO has single producer (CO_SDO_receive()) and single consumer
+ * (CO_SDO_process()), so it needs no lock. Counter is published after the
+ * data, and read before the data. */
+#if defined(__GNUC__)
+    #define CO_SDO_FIFO_LOAD(cnt)           __atomic_load_n(&(cnt), __ATOMIC_ACQUIRE)
+    #define CO_SDO_FIFO_STORE(cnt, val)     __atomic_store_n(&(cnt), (val), __ATOMIC_RELEASE)
+#else
+    #define CO_SDO_FIFO_LOAD(cnt)           (cnt)
+    #define CO_SDO_FIFO_STORE(cnt, val)     ((cnt) = (val))
+#endif
+
+
+#ifdef CO_SDO_FAST_PATH
+/* Lock between CO_SDO_process() and the fast path in CAN receive. Only try
+ * is possible, nobody waits. Without atomic operations lock works if CAN
+ * receive is an interrupt, which can not be interrupted by the mainline. */
+#if defined(__GNUC__)
+    #define CO_SDO_TRY_LOCK(lock)           (!__atomic_test_and_set(&(lock), __ATOMIC_ACQUIRE))
+    #define CO_SDO_UNLOCK(lock)             __atomic_clear(&(lock), __ATOMIC_RELEASE)
+#else
+    #define CO_SDO_TRY_LOCK(lock)           ((lock) ? false : ((lock) = true))
+    #define CO_SDO_UNLOCK(lock)             ((lock) = false)
+#endif
+#endif
+
+
+/* Window into memory of the streamed domain, one full block */
+#define CO_SDO_STREAM_WINDOW           (7U*127U)
+
+
+#ifdef CO_USE_STATISTICS
+const uint32_t CO_SDO_statAbortCode[CO_SDO_STAT_NO_ABORT_CODES] = {
+    CO_SDO_AB_TOGGLE_BIT,
+    CO_SDO_AB_TIMEOUT,
+    CO_SDO_AB_CMD,
+    CO_SDO_AB_BLOCK_SIZE,
+    CO_SDO_AB_SEQ_NUM,
+    CO_SDO_AB_CRC,
+    CO_SDO_AB_OUT_OF_MEM,
+    CO_SDO_AB_UNSUPPORTED_ACCESS,
+    CO_SDO_AB_WRITEONLY,
+    CO_SDO_AB_READONLY,
+    CO_SDO_AB_NOT_EXIST,
+    CO_SDO_AB_NO_MAP,
+    CO_SDO_AB_MAP_LEN,
+    CO_SDO_AB_PRAM_INCOMPAT,
+    CO_SDO_AB_DEVICE_INCOMPAT,
+    CO_SDO_AB_HW,
+    CO_SDO_AB_TYPE_MISMATCH,
+    CO_SDO_AB_DATA_LONG,
+    CO_SDO_AB_DATA_SHORT,
+    CO_SDO_AB_SUB_UNKNOWN,
+    CO_SDO_AB_INVALID_VALUE,
+    CO_SDO_AB_VALUE_HIGH,
+    CO_SDO_AB_VALUE_LOW,
+    CO_SDO_AB_MAX_LESS_MIN,
+    CO_SDO_AB_NO_RESOURCE,
+    CO_SDO_AB_GENERAL,
+    CO_SDO_AB_DATA_TRANSF,
+    CO_SDO_AB_DATA_LOC_CTRL,
+    CO_SDO_AB_DATA_DEV_STATE,
+    CO_SDO_AB_DATA_OD,
+    CO_SDO_AB_NO_DATA,
+    0U                              /* other abort codes */
+};
+#endif
+
 
 /* Helper functions. **********************************************************/
 void CO_memcpy(uint8_t dest[], const uint8_t src[], const uint16_t size){
@@ -174,6 +246,108 @@ void CO_memcpySwap8(void* dest, const void* src){
 #endif
 
 
+#ifdef CO_SDO_FAST_PATH
+/*
+ * Answer expedited upload or download request directly from CAN receive.
+ *
+ * Works only with plain variables without Object dictionary function and if
+ * SDO server is idle, see CO_SDO_FAST_PATH.
+ *
+ * @return true, if response was sent.
+ */
+static bool_t CO_SDO_fastPath(CO_SDO_t *SDO, const uint8_t data[]){
+    uint8_t *txData = SDO->CANtxBuff->data;
+    uint8_t *ODdata;
+    uint16_t index, entryNo, attr, length, len;
+    uint8_t subIndex;
+    bool_t reading;
+    bool_t done = false;
+
+    /* expedited upload or expedited download initiate */
+    if(data[0] == 0x40U){
+        reading = true;
+    }
+    else if((data[0] & 0xE2U) == 0x22U){
+        reading = false;
+    }
+    else{
+        return false;
+    }
+
+    if(!CO_SDO_TRY_LOCK(SDO->fastPathLock)){
+        return false;
+    }
+
+    /* SDO server must be idle and previous requests processed */
+    if((SDO->state != CO_SDO_ST_IDLE) || SDO->CANrxNew || !SDO->NMTisPreOrOperational ||
+       SDO->CANtxBuff->bufferFull || (CO_SDO_FIFO_LOAD(SDO->CANrxFifoRd) != SDO->CANrxFifoWr)){
+        CO_SDO_UNLOCK(SDO->fastPathLock);
+        return false;
+    }
+
+    index = data[2];
+    index = index << 8 | data[1];
+    subIndex = data[3];
+    entryNo = CO_OD_find(SDO, index);
+
+    /* Only plain variable. Object 1003,00 is special, see CO_SDO_writeOD(). */
+    if((entryNo != 0xFFFFU) && (subIndex <= SDO->OD[entryNo].maxSubIndex) && (index != 0x1003U) &&
+       ((SDO->ODExtensions == NULL) || (SDO->ODExtensions[entryNo].pODFunc == NULL)))
+    {
+        ODdata = (uint8_t*)CO_OD_getDataPointer(SDO, entryNo, subIndex);
+        length = CO_OD_getLength(SDO, entryNo, subIndex);
+        attr = CO_OD_getAttribute(SDO, entryNo, subIndex);
+
+        if(reading){
+            len = length;
+            done = ((attr & CO_ODA_READABLE) != 0U) ? true : false;
+        }
+        else{
+            len = ((data[0] & 0x01U) != 0U) ? (4U - ((data[0] >> 2U) & 0x03U)) : length;
+            done = ((attr & CO_ODA_WRITEABLE) != 0U) ? true : false;
+        }
+
+        if((ODdata == NULL) || (length == 0U) || (length > 4U) || (len != length)){
+            done = false;
+        }
+    }
+
+    if(done){
+        uint8_t *SDOdata = reading ? &txData[4] : (uint8_t*)&data[4];
+        uint8_t i;
+
+        txData[0] = reading ? (0x43U | ((4U - length) << 2U)) : 0x60U;
+        txData[1] = data[1];
+        txData[2] = data[2];
+        txData[3] = data[3];
+        txData[4] = txData[5] = txData[6] = txData[7] = 0U;
+
+        /* copy data, swap them if processor is not little endian (CANopen is) */
+        CO_LOCK_OD();
+        for(i=0U; i<length; i++){
+#ifdef CO_BIG_ENDIAN
+            uint8_t j = ((attr & CO_ODA_MB_VALUE) != 0U) ? (length - 1U - i) : i;
+#else
+            uint8_t j = i;
+#endif
+            if(reading){
+                SDOdata[j] = ODdata[i];
+            }
+            else{
+                ODdata[i] = SDOdata[j];
+            }
+        }
+        CO_UNLOCK_OD();
+
+        CO_CANsend(SDO->CANdevTx, SDO->CANtxBuff);
+    }
+
+    CO_SDO_UNLOCK(SDO->fastPathLock);
+    return done;
+}
+#endif
+
+
 /*
  * Read received message from CAN module.
  *
@@ -187,73 +361,97 @@ static void CO_SDO_receive(void *object, const CO_CANrxMsg_t *msg){
 
     SDO = (CO_SDO_t*)object;   /* this is the correct pointer type of the first argument */
 
-    /* WARNING: When doing a SDO block upload and immediately after that
-     * starting another SDO request, this request is dropped. Especially if
-     * processing function has slow response.
+    /* Messages are queued, so request, which immediately follows the end of
+     * block upload, is not dropped, if processing function has slow response.
      * See: https://github.com/CANopenNode/CANopenNode/issues/39 */
 
-    /* verify message length and message overflow (previous message was not processed yet) */
-    if((msg->DLC == 8U) && (!SDO->CANrxNew)){
-        if(SDO->state != CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK) {
-            /* copy data and set 'new message' flag */
-            SDO->CANrxData[0] = msg->data[0];
-            SDO->CANrxData[1] = msg->data[1];
-            SDO->CANrxData[2] = msg->data[2];
-            SDO->CANrxData[3] = msg->data[3];
-            SDO->CANrxData[4] = msg->data[4];
-            SDO->CANrxData[5] = msg->data[5];
-            SDO->CANrxData[6] = msg->data[6];
-            SDO->CANrxData[7] = msg->data[7];
+    /* verify message length */
+    if(msg->DLC != 8U){
+#ifdef CO_USE_STATISTICS
+        CO_STAT_INC(SDO->stats.rxDropped);
+#endif
+        return;
+    }
 
-            SDO->CANrxNew = true;
+    if(SDO->state != CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK) {
+        uint8_t wr = SDO->CANrxFifoWr;
+
+#ifdef CO_SDO_FAST_PATH
+        if(CO_SDO_fastPath(SDO, msg->data)){
+            return;
         }
-        else {
-            /* block download, copy data directly */
-            uint8_t seqno;
+#endif
 
-            SDO->CANrxData[0] = msg->data[0];
-            seqno = SDO->CANrxData[0] & 0x7fU;
-            SDO->timeoutTimer = 0;
+        /* verify FIFO overflow */
+        if((uint8_t)(wr - CO_SDO_FIFO_LOAD(SDO->CANrxFifoRd)) >= CO_SDO_RX_FIFO_SIZE){
+#ifdef CO_USE_STATISTICS
+            CO_STAT_INC(SDO->stats.rxFifoFull);
+#endif
+            return;
+        }
 
-            /* check correct sequence number. */
-            if(seqno == (SDO->sequence + 1U)) {
-                /* sequence is correct */
-                uint8_t i;
-
-                SDO->sequence++;
-
-                /* copy data */
-                for(i=1; i<8; i++) {
-                    SDO->ODF_arg.data[SDO->bufferOffset++] = msg->data[i]; //SDO->ODF_arg.data is equal as SDO->databuffer
-                    if(SDO->bufferOffset >= CO_SDO_BUFFER_SIZE) {
-                        /* buffer full, break reception */
-                        SDO->state = CO_SDO_ST_DOWNLOAD_BL_SUB_RESP;
-                        SDO->CANrxNew = true;
-                        break;
-                    }
-                }
+        /* copy data and publish the message */
+        CO_memcpy(SDO->CANrxFifo[wr & (CO_SDO_RX_FIFO_SIZE - 1U)], msg->data, 8U);
+        CO_SDO_FIFO_STORE(SDO->CANrxFifoWr, (uint8_t)(wr + 1U));
 
-                /* break reception if last segment or block sequence is too large */
-                if(((SDO->CANrxData[0] & 0x80U) == 0x80U) || (SDO->sequence >= SDO->blksize)) {
+        /* Optional signal to RTOS, which can resume task, which handles SDO server. */
+        if(SDO->pFunctSignal != NULL) {
+            SDO->pFunctSignal();
+        }
+    }
+    /* verify message overflow (previous message was not processed yet) */
+    else if(!SDO->CANrxNew){
+        /* block download, copy data directly */
+        uint8_t seqno;
+
+        SDO->CANrxData[0] = msg->data[0];
+        seqno = SDO->CANrxData[0] & 0x7fU;
+        SDO->timeoutTimer = 0;
+        SDO->timeoutSubblock = false;
+
+        /* check correct sequence number. */
+        if(seqno == (SDO->sequence + 1U)) {
+            /* sequence is correct */
+            uint8_t i;
+
+            SDO->sequence++;
+
+            /* copy data */
+            for(i=1; i<8; i++) {
+                SDO->ODF_arg.data[SDO->bufferOffset++] = msg->data[i]; //SDO->ODF_arg.data is SDO buffer or memory of the stream
+                if(SDO->bufferOffset >= SDO->windowSize) {
+                    /* buffer full, break reception */
                     SDO->state = CO_SDO_ST_DOWNLOAD_BL_SUB_RESP;
                     SDO->CANrxNew = true;
+                    break;
                 }
             }
-            else if((seqno == SDO->sequence) || (SDO->sequence == 0U)){
-                /* Ignore message, if it is duplicate or if sequence didn't started yet. */
-            }
-            else {
-                /* seqno is totally wrong, break reception. */
+
+            /* break reception if last segment or block sequence is too large */
+            if(((SDO->CANrxData[0] & 0x80U) == 0x80U) || (SDO->sequence >= SDO->blksize)) {
                 SDO->state = CO_SDO_ST_DOWNLOAD_BL_SUB_RESP;
                 SDO->CANrxNew = true;
             }
         }
+        else if((seqno == SDO->sequence) || (SDO->sequence == 0U)){
+            /* Ignore message, if it is duplicate or if sequence didn't started yet. */
+        }
+        else {
+            /* seqno is totally wrong, break reception. */
+            SDO->state = CO_SDO_ST_DOWNLOAD_BL_SUB_RESP;
+            SDO->CANrxNew = true;
+        }
 
         /* Optional signal to RTOS, which can resume task, which handles SDO server. */
         if(SDO->CANrxNew && SDO->pFunctSignal != NULL) {
             SDO->pFunctSignal();
         }
     }
+#ifdef CO_USE_STATISTICS
+    else{
+        CO_STAT_INC(SDO->stats.rxDropped);
+    }
+#endif
 }
 
 
@@ -316,6 +514,7 @@ CO_ReturnError_t CO_SDO_init(
             SDO->ODExtensions[i].pODFunc = NULL;
             SDO->ODExtensions[i].object = NULL;
             SDO->ODExtensions[i].flags = NULL;
+            SDO->ODExtensions[i].stream = NULL;
         }
     }
     /* copy object dictionary from parent */
@@ -330,7 +529,29 @@ CO_ReturnError_t CO_SDO_init(
     SDO->nodeId = nodeId;
     SDO->state = CO_SDO_ST_IDLE;
     SDO->CANrxNew = false;
+    SDO->CANrxFifoWr = 0U;
+    SDO->CANrxFifoRd = 0U;
+#ifdef CO_SDO_FAST_PATH
+    SDO->fastPathLock = false;
+    SDO->NMTisPreOrOperational = false;
+#endif
     SDO->pFunctSignal = NULL;
+    SDO->buffer = SDO->databuffer;
+    SDO->bufferSize = CO_SDO_BUFFER_SIZE;
+    SDO->windowSize = CO_SDO_BUFFER_SIZE;
+    SDO->stream = NULL;
+#ifdef CO_USE_STATISTICS
+    {
+        uint8_t i;
+
+        SDO->stats.rxDropped = 0U;
+        SDO->stats.rxFifoFull = 0U;
+        SDO->stats.abortRx = 0U;
+        for(i=0U; i<CO_SDO_STAT_NO_ABORT_CODES; i++){
+            SDO->stats.abortTx[i] = 0U;
+        }
+    }
+#endif
 
 
     /* Configure Object dictionary entry at index 0x1200 */
@@ -378,6 +599,25 @@ void CO_SDO_initCallback(
 }
 
 
+/******************************************************************************/
+CO_ReturnError_t CO_SDO_initBuffer(
+        CO_SDO_t               *SDO,
+        uint8_t                *buffer,
+        uint16_t                bufferSize)
+{
+    /* verify arguments */
+    if(SDO==NULL || buffer==NULL || bufferSize<7U || SDO->state!=CO_SDO_ST_IDLE){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    SDO->buffer = buffer;
+    SDO->bufferSize = bufferSize;
+    SDO->windowSize = bufferSize;
+
+    return CO_ERROR_NO;
+}
+
+
 /******************************************************************************/
 void CO_OD_configure(
         CO_SDO_t               *SDO,
@@ -410,6 +650,21 @@ void CO_OD_configure(
 }
 
 
+/******************************************************************************/
+void CO_OD_configureStream(
+        CO_SDO_t               *SDO,
+        uint16_t                index,
+        CO_SDO_stream_t        *stream)
+{
+    uint16_t entryNo;
+
+    entryNo = CO_OD_find(SDO, index);
+    if(entryNo < 0xFFFFU){
+        SDO->ODExtensions[entryNo].stream = stream;
+    }
+}
+
+
 /******************************************************************************/
 uint16_t CO_OD_find(CO_SDO_t *SDO, uint16_t index){
     /* Fast search in ordered Object Dictionary. If indexes are mixed, this won't work. */
@@ -456,7 +711,7 @@ uint16_t CO_OD_getLength(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex){
 
     if(object->maxSubIndex == 0U){    /* Object type is Var */
         if(object->pData == 0){ /* data type is domain */
-            return CO_SDO_BUFFER_SIZE;
+            return SDO->bufferSize;
         }
         else{
             return object->length;
@@ -468,7 +723,7 @@ uint16_t CO_OD_getLength(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex){
         }
         else if(object->pData == 0){
             /* data type is domain */
-            return CO_SDO_BUFFER_SIZE;
+            return SDO->bufferSize;
         }
         else{
             return object->length;
@@ -477,7 +732,7 @@ uint16_t CO_OD_getLength(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex){
     else{                            /* Object type is Record */
         if(((const CO_OD_entryRecord_t*)(object->pData))[subIndex].pData == 0){
             /* data type is domain */
-            return CO_SDO_BUFFER_SIZE;
+            return SDO->bufferSize;
         }
         else{
             return ((const CO_OD_entryRecord_t*)(object->pData))[subIndex].length;
@@ -592,7 +847,9 @@ uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
         CO_OD_extension_t *ext = &SDO->ODExtensions[SDO->entryNo];
         SDO->ODF_arg.object = ext->object;
     }
-    SDO->ODF_arg.data = SDO->databuffer;
+    SDO->ODF_arg.data = SDO->buffer;
+    SDO->windowSize = SDO->bufferSize;
+    SDO->stream = NULL;
     SDO->ODF_arg.dataLength = CO_OD_getLength(SDO, SDO->entryNo, subIndex);
     SDO->ODF_arg.attribute = CO_OD_getAttribute(SDO, SDO->entryNo, subIndex);
     SDO->ODF_arg.pFlags = CO_OD_getFlagsPointer(SDO, SDO->entryNo, subIndex);
@@ -604,9 +861,10 @@ uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
     SDO->ODF_arg.dataLengthTotal = (SDO->ODF_arg.ODdataStorage) ? SDO->ODF_arg.dataLength : 0U;
 
     SDO->ODF_arg.offset = 0U;
+    SDO->ODF_arg.pending = false;
 
     /* verify length */
-    if(SDO->ODF_arg.dataLength > CO_SDO_BUFFER_SIZE){
+    if(SDO->ODF_arg.dataLength > SDO->bufferSize){
         return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
     }
 
@@ -614,6 +872,155 @@ uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
 }
 
 
+/*
+ * Streamed domain, see CO_SDO_stream_t. ODF_arg.offset is position in the
+ * stream after the data in ODF_arg.data.
+ */
+/* Call Object dictionary function at the beginning or end of the transfer. */
+static uint32_t CO_SDO_streamNotify(CO_SDO_t *SDO){
+    CO_OD_extension_t *ext = &SDO->ODExtensions[SDO->entryNo];
+
+    SDO->ODF_arg.dataLength = 0U;
+    SDO->ODF_arg.pending = false;
+
+    return (ext->pODFunc != NULL) ? ext->pODFunc(&SDO->ODF_arg) : 0U;
+}
+
+/* Window for downloaded data: directly in memory, if at least one segment
+ * fits, otherwise in the SDO buffer. */
+static void CO_SDO_streamWriteWindow(CO_SDO_t *SDO){
+    CO_SDO_stream_t *stream = SDO->stream;
+    uint32_t offset = SDO->ODF_arg.offset;
+
+    if((stream->data != NULL) && (offset < stream->size) && ((stream->size - offset) >= 7U)){
+        uint32_t len = stream->size - offset;
+
+        if(len > CO_SDO_STREAM_WINDOW){
+            len = CO_SDO_STREAM_WINDOW;
+        }
+        SDO->ODF_arg.data = &stream->data[offset];
+        SDO->windowSize = (uint16_t)(len - (len % 7U));
+    }
+    else{
+        SDO->ODF_arg.data = SDO->buffer;
+        SDO->windowSize = SDO->bufferSize;
+    }
+    SDO->ODF_arg.dataLength = SDO->windowSize;
+}
+
+/* Move window over memory of the uploaded stream by consumed bytes and
+ * extend it to the maximum size. */
+static void CO_SDO_streamSlide(CO_SDO_t *SDO, uint16_t consumed){
+    CO_SDO_stream_t *stream = SDO->stream;
+    uint32_t start = (uint32_t)(SDO->ODF_arg.data - stream->data) + consumed;
+    uint32_t len = stream->size - start;
+
+    if(len > CO_SDO_STREAM_WINDOW){
+        len = CO_SDO_STREAM_WINDOW;
+    }
+    SDO->ODF_arg.data = &stream->data[start];
+    SDO->ODF_arg.dataLength = (uint16_t)len;
+    SDO->ODF_arg.offset = start + len;
+    SDO->ODF_arg.lastSegment = (SDO->ODF_arg.offset >= stream->size) ? true : false;
+}
+
+/* Start the streamed transfer. */
+static uint32_t CO_SDO_streamBegin(CO_SDO_t *SDO, bool_t reading){
+    uint32_t abortCode;
+
+    if((SDO->ODF_arg.attribute & (reading ? CO_ODA_READABLE : CO_ODA_WRITEABLE)) == 0U){
+        return reading ? CO_SDO_AB_WRITEONLY : CO_SDO_AB_READONLY;
+    }
+
+    SDO->stream = SDO->ODExtensions[SDO->entryNo].stream;
+    SDO->ODF_arg.reading = reading;
+    SDO->ODF_arg.lastSegment = false;
+    abortCode = CO_SDO_streamNotify(SDO);
+    SDO->ODF_arg.lastSegment = true;
+    if(!reading){
+        CO_SDO_streamWriteWindow(SDO);
+    }
+    else{
+        SDO->ODF_arg.dataLength = SDO->windowSize;
+    }
+
+    return abortCode;
+}
+
+/* Read data from the stream, instead of calling Object dictionary function. */
+static uint32_t CO_SDO_streamRead(CO_SDO_t *SDO){
+    CO_SDO_stream_t *stream = SDO->stream;
+
+    if(stream->data != NULL){
+        /* first window, then CO_SDO_streamSlide() */
+        SDO->ODF_arg.data = stream->data;
+        CO_SDO_streamSlide(SDO, 0U);
+    }
+    else{
+        uint16_t len = 0U;
+
+        while(len < SDO->ODF_arg.dataLength){
+            int32_t n = stream->read(stream->object, SDO->ODF_arg.offset + len,
+                                     &SDO->ODF_arg.data[len], SDO->ODF_arg.dataLength - len);
+            if(n < 0){
+                return CO_SDO_AB_GENERAL;
+            }
+            if(n == 0){
+                break;
+            }
+            len += (uint16_t)n;
+        }
+        SDO->ODF_arg.lastSegment = (len < SDO->ODF_arg.dataLength)
+            || ((stream->size != 0U) && ((SDO->ODF_arg.offset + len) >= stream->size));
+        SDO->ODF_arg.dataLength = len;
+        SDO->ODF_arg.offset += len;
+    }
+
+    if(SDO->ODF_arg.firstSegment){
+        SDO->ODF_arg.dataLengthTotal = stream->size;
+        if(SDO->ODF_arg.dataLength == 0U){
+            return CO_SDO_AB_NO_DATA;
+        }
+    }
+    SDO->ODF_arg.firstSegment = false;
+
+    return 0U;
+}
+
+/* Write data to the stream, instead of calling Object dictionary function. */
+static uint32_t CO_SDO_streamWrite(CO_SDO_t *SDO, uint16_t length){
+    CO_SDO_stream_t *stream = SDO->stream;
+    uint32_t offset = SDO->ODF_arg.offset;
+
+    if(stream->data != NULL){
+        /* data in the SDO buffer are copied, data in the window are in place */
+        if((offset > stream->size) || (length > (stream->size - offset))){
+            return CO_SDO_AB_DATA_LONG;
+        }
+        if(SDO->ODF_arg.data != &stream->data[offset]){
+            CO_memcpy(&stream->data[offset], SDO->ODF_arg.data, length);
+        }
+    }
+    else if(length > 0U){
+        if((stream->size != 0U) && ((offset > stream->size) || (length > (stream->size - offset)))){
+            return CO_SDO_AB_DATA_LONG;
+        }
+        if(stream->write(stream->object, offset, SDO->ODF_arg.data, length) != (int32_t)length){
+            return CO_SDO_AB_GENERAL;
+        }
+    }
+    SDO->ODF_arg.offset = offset + length;
+    SDO->ODF_arg.firstSegment = false;
+
+    if(SDO->ODF_arg.lastSegment){
+        return CO_SDO_streamNotify(SDO);
+    }
+    CO_SDO_streamWriteWindow(SDO);
+
+    return 0U;
+}
+
+
 /******************************************************************************/
 uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize){
     uint8_t *SDObuffer = SDO->ODF_arg.data;
@@ -625,6 +1032,11 @@ uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize){
     if((SDO->ODF_arg.attribute & CO_ODA_READABLE) == 0)
         return CO_SDO_AB_WRITEONLY;     /* attempt to read a write-only object */
 
+    /* streamed domain */
+    if(SDO->stream != NULL){
+        return CO_SDO_streamRead(SDO);
+    }
+
     /* find extension */
     if(SDO->ODExtensions != NULL){
         ext = &SDO->ODExtensions[SDO->entryNo];
@@ -690,6 +1102,11 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
         return CO_SDO_AB_READONLY;     /* attempt to write a read-only object */
     }
 
+    /* streamed domain */
+    if(SDO->stream != NULL){
+        return CO_SDO_streamWrite(SDO, length);
+    }
+
     /* length of domain data is application specific and not verified */
     if(ODdata == 0){
         SDO->ODF_arg.dataLength = length;
@@ -718,6 +1135,7 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
 
     /* call Object dictionary function if registered */
     SDO->ODF_arg.reading = false;
+    SDO->ODF_arg.pending = false;
     if(SDO->ODExtensions != NULL){
         CO_OD_extension_t *ext = &SDO->ODExtensions[SDO->entryNo];
 
@@ -749,8 +1167,294 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
 }
 
 
+/*
+ * Local transfer, see CO_SDO_localDownload(). Same sequence of CO_SDO_readOD()
+ * and CO_SDO_writeOD() calls as by transfer from the network, but data are
+ * taken from or written directly to the caller's buffer.
+ */
+/* Lock SDO server for local transfer. Server must be idle, without request
+ * left in CANrxNew (if its transmit buffer was full). */
+static bool_t CO_SDO_localLock(CO_SDO_t *SDO){
+#ifdef CO_SDO_FAST_PATH
+    /* exclude the fast path in CAN receive, it holds the lock shortly */
+    if(!CO_SDO_TRY_LOCK(SDO->fastPathLock)){
+        return false;
+    }
+#endif
+    if((SDO->state == CO_SDO_ST_IDLE) && (!SDO->CANrxNew)){
+        return true;
+    }
+#ifdef CO_SDO_FAST_PATH
+    CO_SDO_UNLOCK(SDO->fastPathLock);
+#endif
+    return false;
+}
+
+/* Unlock SDO server after local transfer. */
+static void CO_SDO_localUnlock(CO_SDO_t *SDO){
+#ifdef CO_SDO_FAST_PATH
+    CO_SDO_UNLOCK(SDO->fastPathLock);
+#else
+    (void)SDO;
+#endif
+}
+
+/* Start local transfer. */
+static uint32_t CO_SDO_localBegin(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex, bool_t reading){
+    uint32_t abortCode;
+
+    abortCode = CO_SDO_initTransfer(SDO, index, subIndex);
+    if(abortCode != 0U){
+        return abortCode;
+    }
+
+    if((SDO->ODF_arg.attribute & (reading ? CO_ODA_READABLE : CO_ODA_WRITEABLE)) == 0U){
+        return reading ? CO_SDO_AB_WRITEONLY : CO_SDO_AB_READONLY;
+    }
+
+    /* streamed domain */
+    if((SDO->ODF_arg.ODdataStorage == NULL) && (SDO->ODExtensions != NULL)
+        && (SDO->ODExtensions[SDO->entryNo].stream != NULL))
+    {
+        abortCode = CO_SDO_streamBegin(SDO, reading);
+    }
+
+    return abortCode;
+}
+
+/* Write data in segments of the SDO buffer size. */
+static uint32_t CO_SDO_localWrite(CO_SDO_t *SDO, uint8_t *data, uint32_t dataSize){
+    uint32_t offset = 0U;
+
+    /* verify length except for domain data type */
+    if((SDO->ODF_arg.ODdataStorage != NULL) && (dataSize != SDO->ODF_arg.dataLength)){
+        return CO_SDO_AB_TYPE_MISMATCH;
+    }
+    SDO->ODF_arg.dataLengthTotal = dataSize;
+
+    do{
+        uint32_t len = dataSize - offset;
+        uint32_t abortCode;
+
+        if(len > SDO->windowSize){
+            len = SDO->windowSize;
+        }
+        SDO->ODF_arg.data = &data[offset];
+        SDO->ODF_arg.lastSegment = ((offset + len) == dataSize) ? true : false;
+
+        abortCode = CO_SDO_writeOD(SDO, (uint16_t)len);
+        if(abortCode != 0U){
+            SDO->ODF_arg.pending = false;
+            return abortCode;
+        }
+        offset += len;
+    }while(offset < dataSize);
+
+    return 0U;
+}
+
+/* Read data, domains directly into buf, variables and memory of the stream
+ * are copied. */
+static uint32_t CO_SDO_localRead(CO_SDO_t *SDO, uint8_t *buf, uint32_t bufSize, uint32_t *pDataSize){
+    CO_SDO_stream_t *stream = SDO->stream;
+    uint32_t offset = 0U;
+    uint8_t probe;
+
+    for(;;){
+        uint32_t space = bufSize - offset;
+        uint32_t abortCode = 0U;
+        uint16_t len;
+
+        if(SDO->ODF_arg.ODdataStorage != NULL){
+            abortCode = CO_SDO_readOD(SDO, SDO->bufferSize);
+        }
+        else if((stream != NULL) && (stream->data != NULL)){
+            if(SDO->ODF_arg.firstSegment){
+                abortCode = CO_SDO_readOD(SDO, SDO->windowSize);
+            }
+            else{
+                CO_SDO_streamSlide(SDO, SDO->ODF_arg.dataLength);
+            }
+        }
+        else{
+            len = (space > SDO->windowSize) ? SDO->windowSize : (uint16_t)space;
+            if(len > 0U){
+                SDO->ODF_arg.data = &buf[offset];
+            }
+            else if(stream != NULL){
+                /* buffer is full, verify end of the stream of unknown size */
+                SDO->ODF_arg.data = &probe;
+                len = 1U;
+            }
+            else{
+                return CO_SDO_AB_OUT_OF_MEM;
+            }
+            SDO->ODF_arg.dataLength = len;
+            abortCode = CO_SDO_readOD(SDO, len);
+        }
+        if(abortCode != 0U){
+            return abortCode;
+        }
+
+        /* copy data, if not read in place */
+        len = SDO->ODF_arg.dataLength;
+        if(len > space){
+            return CO_SDO_AB_OUT_OF_MEM;
+        }
+        if(SDO->ODF_arg.data != &buf[offset]){
+            CO_memcpy(&buf[offset], SDO->ODF_arg.data, len);
+        }
+        offset += len;
+
+        if(SDO->ODF_arg.lastSegment){
+            break;
+        }
+    }
+
+    *pDataSize = offset;
+
+    return (stream != NULL) ? CO_SDO_streamNotify(SDO) : 0U;
+}
+
+
+/******************************************************************************/
+CO_SDO_localReturn_t CO_SDO_localDownload(
+        CO_SDO_t               *SDO,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint8_t                *data,
+        uint32_t                dataSize,
+        uint32_t               *pSDOabortCode)
+{
+    uint32_t abortCode;
+
+    /* verify arguments */
+    if(SDO == NULL || pSDOabortCode == NULL || (data == NULL && dataSize != 0U)){
+        if(pSDOabortCode != NULL){
+            *pSDOabortCode = CO_SDO_AB_DEVICE_INCOMPAT;
+        }
+        return CO_SDO_LOCAL_DONE;
+    }
+
+    if(!CO_SDO_localLock(SDO)){
+        return CO_SDO_LOCAL_BUSY;
+    }
+
+    abortCode = CO_SDO_localBegin(SDO, index, subIndex, false);
+    if(abortCode == 0U){
+        abortCode = CO_SDO_localWrite(SDO, data, dataSize);
+    }
+    *pSDOabortCode = abortCode;
+
+    /* Object dictionary function completes the write later. Server stays
+     * busy, fast path in CAN receive does not use it any more. */
+    if((abortCode == 0U) && SDO->ODF_arg.pending){
+        SDO->state = CO_SDO_ST_LOCAL_PENDING;
+        CO_SDO_localUnlock(SDO);
+        return CO_SDO_LOCAL_PENDING;
+    }
+
+    SDO->stream = NULL;
+    CO_SDO_localUnlock(SDO);
+
+    return CO_SDO_LOCAL_DONE;
+}
+
+
+/******************************************************************************/
+CO_SDO_localReturn_t CO_SDO_localDownloadPending(
+        CO_SDO_t               *SDO,
+        uint32_t               *pSDOabortCode)
+{
+    uint32_t abortCode = CO_SDO_AB_DEVICE_INCOMPAT;
+
+    /* verify arguments */
+    if(pSDOabortCode == NULL){
+        return CO_SDO_LOCAL_DONE;
+    }
+    if(SDO == NULL || SDO->state != CO_SDO_ST_LOCAL_PENDING){
+        *pSDOabortCode = CO_SDO_AB_DEVICE_INCOMPAT;
+        return CO_SDO_LOCAL_DONE;
+    }
+
+    /* call Object dictionary function again, same as in
+     * CO_SDO_ST_DOWNLOAD_PENDING */
+    if(SDO->ODExtensions != NULL){
+        CO_OD_extension_t *ext = &SDO->ODExtensions[SDO->entryNo];
+
+        if(ext->pODFunc != NULL){
+            abortCode = ext->pODFunc(&SDO->ODF_arg);
+        }
+    }
+    *pSDOabortCode = abortCode;
+
+    if((abortCode == 0U) && SDO->ODF_arg.pending){
+        return CO_SDO_LOCAL_PENDING;
+    }
+
+    CO_SDO_localCancel(SDO);
+
+    return CO_SDO_LOCAL_DONE;
+}
+
+
+/******************************************************************************/
+void CO_SDO_localCancel(CO_SDO_t *SDO){
+    if((SDO != NULL) && (SDO->state == CO_SDO_ST_LOCAL_PENDING)){
+        SDO->ODF_arg.pending = false;
+        SDO->stream = NULL;
+        SDO->state = CO_SDO_ST_IDLE;
+    }
+}
+
+
+/******************************************************************************/
+CO_SDO_localReturn_t CO_SDO_localUpload(
+        CO_SDO_t               *SDO,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint8_t                *buf,
+        uint32_t                bufSize,
+        uint32_t               *pDataSize,
+        uint32_t               *pSDOabortCode)
+{
+    /* verify arguments */
+    if(SDO == NULL || buf == NULL || pDataSize == NULL || pSDOabortCode == NULL){
+        if(pSDOabortCode != NULL){
+            *pSDOabortCode = CO_SDO_AB_DEVICE_INCOMPAT;
+        }
+        return CO_SDO_LOCAL_DONE;
+    }
+    *pDataSize = 0U;
+
+    if(!CO_SDO_localLock(SDO)){
+        return CO_SDO_LOCAL_BUSY;
+    }
+
+    *pSDOabortCode = CO_SDO_localBegin(SDO, index, subIndex, true);
+    if(*pSDOabortCode == 0U){
+        *pSDOabortCode = CO_SDO_localRead(SDO, buf, bufSize, pDataSize);
+    }
+    SDO->stream = NULL;
+    CO_SDO_localUnlock(SDO);
+
+    return CO_SDO_LOCAL_DONE;
+}
+
+
 /******************************************************************************/
 static void CO_SDO_abort(CO_SDO_t *SDO, uint32_t code){
+#ifdef CO_USE_STATISTICS
+    uint8_t i;
+
+    /* last counter is for unknown abort codes */
+    for(i=0U; i<(CO_SDO_STAT_NO_ABORT_CODES-1U); i++){
+        if(CO_SDO_statAbortCode[i] == code){
+            break;
+        }
+    }
+    CO_STAT_INC(SDO->stats.abortTx[i]);
+#endif
     SDO->CANtxBuff->data[0] = 0x80;
     SDO->CANtxBuff->data[1] = SDO->ODF_arg.index & 0xFF;
     SDO->CANtxBuff->data[2] = (SDO->ODF_arg.index>>8) & 0xFF;
@@ -762,8 +1466,10 @@ static void CO_SDO_abort(CO_SDO_t *SDO, uint32_t code){
 }
 
 
-/******************************************************************************/
-int8_t CO_SDO_process(
+/*
+ * SDO server state machine, see CO_SDO_process().
+ */
+static int8_t CO_SDO_processServer(
         CO_SDO_t               *SDO,
         bool_t                  NMTisPreOrOperational,
         uint16_t                timeDifference_ms,
@@ -773,6 +1479,25 @@ int8_t CO_SDO_process(
     CO_SDO_state_t state = CO_SDO_ST_IDLE;
     bool_t timeoutSubblockDownolad = false;
     bool_t sendResponse = false;
+    uint16_t timeoutTime;
+
+    /* Local download waits for the Object dictionary function, see
+     * CO_SDO_localDownloadPending(). Requests wait in the receive FIFO. */
+    if(SDO->state == CO_SDO_ST_LOCAL_PENDING){
+        return 1;
+    }
+
+    /* take next message from the receive FIFO. In block download messages are
+     * received directly into CANrxData. */
+    if((!SDO->CANrxNew) && (SDO->state != CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK)){
+        uint8_t rd = SDO->CANrxFifoRd;
+
+        if(CO_SDO_FIFO_LOAD(SDO->CANrxFifoWr) != rd){
+            CO_memcpy(SDO->CANrxData, SDO->CANrxFifo[rd & (CO_SDO_RX_FIFO_SIZE - 1U)], 8U);
+            CO_SDO_FIFO_STORE(SDO->CANrxFifoRd, (uint8_t)(rd + 1U));
+            SDO->CANrxNew = true;
+        }
+    }
 
     /* return if idle */
     if((SDO->state == CO_SDO_ST_IDLE) && (!SDO->CANrxNew)){
@@ -783,11 +1508,29 @@ int8_t CO_SDO_process(
     if(!NMTisPreOrOperational){
         SDO->state = CO_SDO_ST_IDLE;
         SDO->CANrxNew = false;
+        CO_SDO_FIFO_STORE(SDO->CANrxFifoRd, CO_SDO_FIFO_LOAD(SDO->CANrxFifoWr));
         return 0;
     }
 
+    /* Download is waiting for the Object dictionary function. Response is
+     * already prepared, client may only abort. */
+    if(SDO->state == CO_SDO_ST_DOWNLOAD_PENDING){
+        if((SDO->CANrxNew) && (SDO->CANrxData[0] == CCS_ABORT)){
+#ifdef CO_USE_STATISTICS
+            CO_STAT_INC(SDO->stats.abortRx);
+#endif
+            SDO->state = CO_SDO_ST_IDLE;
+            SDO->CANrxNew = false;
+            return -1;
+        }
+        SDO->CANrxNew = false;
+        if(!SDO->CANtxBuff->bufferFull){
+            state = CO_SDO_ST_DOWNLOAD_PENDING;
+        }
+    }
+
     /* Is something new to process? */
-    if((!SDO->CANtxBuff->bufferFull) && ((SDO->CANrxNew) || (SDO->state == CO_SDO_ST_UPLOAD_BL_SUBBLOCK))){
+    else if((!SDO->CANtxBuff->bufferFull) && ((SDO->CANrxNew) || (SDO->state == CO_SDO_ST_UPLOAD_BL_SUBBLOCK))){
         uint8_t CCS = SDO->CANrxData[0] >> 5;   /* Client command specifier */
 
         /* reset timeout */
@@ -800,6 +1543,9 @@ int8_t CO_SDO_process(
 
         /* Is abort from client? */
         if((SDO->CANrxNew) && (SDO->CANrxData[0] == CCS_ABORT)){
+#ifdef CO_USE_STATISTICS
+            CO_STAT_INC(SDO->stats.abortRx);
+#endif
             SDO->state = CO_SDO_ST_IDLE;
             SDO->CANrxNew = false;
             return -1;
@@ -829,6 +1575,17 @@ int8_t CO_SDO_process(
                 return -1;
             }
 
+            /* streamed domain */
+            if((SDO->ODF_arg.ODdataStorage == NULL) && (SDO->ODExtensions != NULL)
+                && (SDO->ODExtensions[SDO->entryNo].stream != NULL))
+            {
+                abortCode = CO_SDO_streamBegin(SDO, (CCS == CCS_UPLOAD_INITIATE) || (CCS == CCS_UPLOAD_BLOCK));
+                if(abortCode != 0U){
+                    CO_SDO_abort(SDO, abortCode);
+                    return -1;
+                }
+            }
+
             /* download */
             if((CCS == CCS_DOWNLOAD_INITIATE) || (CCS == CCS_DOWNLOAD_BLOCK)){
                 if((SDO->ODF_arg.attribute & CO_ODA_WRITEABLE) == 0U){
@@ -847,7 +1604,7 @@ int8_t CO_SDO_process(
 
             /* upload */
             else{
-                abortCode = CO_SDO_readOD(SDO, CO_SDO_BUFFER_SIZE);
+                abortCode = CO_SDO_readOD(SDO, SDO->bufferSize);
                 if(abortCode != 0U){
                     CO_SDO_abort(SDO, abortCode);
                     return -1;
@@ -864,19 +1621,25 @@ int8_t CO_SDO_process(
         }
     }
 
-    /* verify SDO timeout */
-    if(SDO->timeoutTimer < SDOtimeoutTime){
+    /* verify SDO timeout. Object dictionary function, which completes the
+     * download, has own timeout, client only waits for the response then. */
+    timeoutTime = (SDO->state == CO_SDO_ST_DOWNLOAD_PENDING) ? CO_SDO_PENDING_TIMEOUT : SDOtimeoutTime;
+    if(SDO->timeoutTimer < timeoutTime){
         SDO->timeoutTimer += timeDifference_ms;
     }
-    if(SDO->timeoutTimer >= SDOtimeoutTime){
-        if((SDO->state == CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK) && (SDO->sequence != 0) && (!SDO->CANtxBuff->bufferFull)){
-            timeoutSubblockDownolad = true;
-            state = CO_SDO_ST_DOWNLOAD_BL_SUB_RESP;
-        }
-        else{
-            CO_SDO_abort(SDO, CO_SDO_AB_TIMEOUT); /* SDO protocol timed out */
-            return -1;
-        }
+    /* Sub-block timeout in block download, same as in the client by block
+     * upload. First or last segment(s) of the sub-block were lost, respond
+     * with the sequence number of the last segment received (may be 0), so
+     * client repeats the rest. Response is sent once, if client is silent
+     * then, SDO times out. */
+    if((SDO->state == CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK) && (SDO->timeoutTimer >= (SDOtimeoutTime / 2U))
+        && (!SDO->timeoutSubblock) && (!SDO->CANtxBuff->bufferFull)){
+        timeoutSubblockDownolad = true;
+        state = CO_SDO_ST_DOWNLOAD_BL_SUB_RESP;
+    }
+    else if(SDO->timeoutTimer >= timeoutTime){
+        CO_SDO_abort(SDO, CO_SDO_AB_TIMEOUT); /* SDO protocol timed out */
+        return -1;
     }
 
     /* return immediately if still idle */
@@ -979,7 +1742,7 @@ int8_t CO_SDO_process(
                         return -1;
                     }
 
-                    SDO->ODF_arg.dataLength = CO_SDO_BUFFER_SIZE;
+                    SDO->ODF_arg.dataLength = SDO->windowSize;
                     SDO->bufferOffset = 0;
                 }
             }
@@ -1022,7 +1785,7 @@ int8_t CO_SDO_process(
             SDO->CANtxBuff->data[3] = SDO->CANrxData[3];
 
             /* blksize */
-            SDO->blksize = (CO_SDO_BUFFER_SIZE > (7*127)) ? 127 : (CO_SDO_BUFFER_SIZE / 7);
+            SDO->blksize = (SDO->windowSize > (7*127)) ? 127 : (SDO->windowSize / 7);
             SDO->CANtxBuff->data[4] = SDO->blksize;
 
             /* is CRC enabled */
@@ -1044,6 +1807,7 @@ int8_t CO_SDO_process(
 
             SDO->bufferOffset = 0;
             SDO->sequence = 0;
+            SDO->timeoutSubblock = false;
             SDO->state = CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK;
 
             /* send response */
@@ -1065,6 +1829,11 @@ int8_t CO_SDO_process(
             SDO->CANtxBuff->data[0] = 0xA2;
             SDO->CANtxBuff->data[1] = SDO->sequence;
             SDO->sequence = 0;
+            SDO->timeoutSubblock = timeoutSubblockDownolad;
+
+            /* segments, which were received after the break of reception,
+             * will be repeated by the client */
+            CO_SDO_FIFO_STORE(SDO->CANrxFifoRd, CO_SDO_FIFO_LOAD(SDO->CANrxFifoWr));
 
             /* empty buffer in domain data type if not last segment */
             if((SDO->ODF_arg.ODdataStorage == 0) && (SDO->bufferOffset != 0) && !lastSegmentInSubblock){
@@ -1081,12 +1850,12 @@ int8_t CO_SDO_process(
                     return -1;
                 }
 
-                SDO->ODF_arg.dataLength = CO_SDO_BUFFER_SIZE;
+                SDO->ODF_arg.dataLength = SDO->windowSize;
                 SDO->bufferOffset = 0;
             }
 
             /* blksize */
-            len = CO_SDO_BUFFER_SIZE - SDO->bufferOffset;
+            len = SDO->windowSize - SDO->bufferOffset;
             SDO->blksize = (len > (7*127)) ? 127 : (len / 7);
             SDO->CANtxBuff->data[2] = SDO->blksize;
 
@@ -1094,7 +1863,7 @@ int8_t CO_SDO_process(
             if(lastSegmentInSubblock) {
                 SDO->state = CO_SDO_ST_DOWNLOAD_BL_END;
             }
-            else if(SDO->bufferOffset >= CO_SDO_BUFFER_SIZE) {
+            else if(SDO->bufferOffset >= SDO->windowSize) {
                 CO_SDO_abort(SDO, CO_SDO_AB_DEVICE_INCOMPAT);
                 return -1;
             }
@@ -1147,6 +1916,29 @@ int8_t CO_SDO_process(
             break;
         }
 
+        case CO_SDO_ST_DOWNLOAD_PENDING:{
+            /* call Object dictionary function again, until it completes */
+            abortCode = CO_SDO_AB_DEVICE_INCOMPAT;
+            if(SDO->ODExtensions != NULL){
+                CO_OD_extension_t *ext = &SDO->ODExtensions[SDO->entryNo];
+
+                if(ext->pODFunc != NULL){
+                    abortCode = ext->pODFunc(&SDO->ODF_arg);
+                }
+            }
+            if(abortCode != 0U){
+                CO_SDO_abort(SDO, abortCode);
+                return -1;
+            }
+
+            /* send the prepared response */
+            if(!SDO->ODF_arg.pending){
+                SDO->state = CO_SDO_ST_IDLE;
+                sendResponse = true;
+            }
+            break;
+        }
+
         case CO_SDO_ST_UPLOAD_INITIATE:{
             /* default response */
             SDO->CANtxBuff->data[1] = SDO->CANrxData[1];
@@ -1161,6 +1953,14 @@ int8_t CO_SDO_process(
                 SDO->CANtxBuff->data[0] = 0x43U | ((4U-SDO->ODF_arg.dataLength) << 2U);
                 SDO->state = CO_SDO_ST_IDLE;
 
+                if(SDO->stream != NULL){
+                    abortCode = CO_SDO_streamNotify(SDO);
+                    if(abortCode != 0U){
+                        CO_SDO_abort(SDO, abortCode);
+                        return -1;
+                    }
+                }
+
                 sendResponse = true;
             }
 
@@ -1204,8 +2004,18 @@ int8_t CO_SDO_process(
             len = SDO->ODF_arg.dataLength - SDO->bufferOffset;
             if(len > 7U) len = 7U;
 
+            /* Streamed memory, move the window */
+            if((SDO->stream != NULL) && (SDO->stream->data != NULL)){
+                if((len < 7U) && (!SDO->ODF_arg.lastSegment)){
+                    CO_SDO_streamSlide(SDO, SDO->bufferOffset);
+                    SDO->bufferOffset = 0;
+                    len = SDO->ODF_arg.dataLength;
+                    if(len > 7U) len = 7U;
+                }
+            }
+
             /* If data type is domain, re-fill the data buffer if neccessary and indicated so. */
-            if((SDO->ODF_arg.ODdataStorage == 0) && (len < 7U) && (!SDO->ODF_arg.lastSegment)){
+            else if((SDO->ODF_arg.ODdataStorage == 0) && (len < 7U) && (!SDO->ODF_arg.lastSegment)){
                 /* copy previous data to the beginning */
                 for(i=0U; i<len; i++){
                     SDO->ODF_arg.data[i] = SDO->ODF_arg.data[SDO->bufferOffset+i];
@@ -1213,10 +2023,10 @@ int8_t CO_SDO_process(
 
                 /* move the beginning of the data buffer */
                 SDO->ODF_arg.data += len;
-                SDO->ODF_arg.dataLength = CO_OD_getLength(SDO, SDO->entryNo, SDO->ODF_arg.subIndex) - len;
+                SDO->ODF_arg.dataLength = SDO->windowSize - len;
 
                 /* read next data from Object dictionary function */
-                abortCode = CO_SDO_readOD(SDO, CO_SDO_BUFFER_SIZE);
+                abortCode = CO_SDO_readOD(SDO, SDO->windowSize);
                 if(abortCode != 0U){
                     CO_SDO_abort(SDO, abortCode);
                     return -1;
@@ -1244,6 +2054,14 @@ int8_t CO_SDO_process(
             if((SDO->bufferOffset == SDO->ODF_arg.dataLength) && (SDO->ODF_arg.lastSegment)){
                 SDO->CANtxBuff->data[0] |= 0x01;
                 SDO->state = CO_SDO_ST_IDLE;
+
+                if(SDO->stream != NULL){
+                    abortCode = CO_SDO_streamNotify(SDO);
+                    if(abortCode != 0U){
+                        CO_SDO_abort(SDO, abortCode);
+                        return -1;
+                    }
+                }
             }
 
             /* send response */
@@ -1350,9 +2168,14 @@ int8_t CO_SDO_process(
                     break;
                 }
 
-                /* move remaining data to the beginning */
-                for(i=ackseq*7, j=0; i<SDO->ODF_arg.dataLength; i++, j++)
-                    SDO->ODF_arg.data[j] = SDO->ODF_arg.data[i];
+                /* move remaining data to the beginning, streamed memory is not copied */
+                if((SDO->stream != NULL) && (SDO->stream->data != NULL)){
+                    SDO->ODF_arg.data += ackseq * 7U;
+                }
+                else{
+                    for(i=ackseq*7, j=0; i<SDO->ODF_arg.dataLength; i++, j++)
+                        SDO->ODF_arg.data[j] = SDO->ODF_arg.data[i];
+                }
 
                 /* set remaining data length in buffer */
                 SDO->ODF_arg.dataLength -= ackseq * 7U;
@@ -1360,15 +2183,27 @@ int8_t CO_SDO_process(
                 /* new block size */
                 SDO->blksize = SDO->CANrxData[2];
 
+                /* Streamed memory, extend the window */
+                if((SDO->stream != NULL) && (SDO->stream->data != NULL)){
+                    if((SDO->ODF_arg.dataLength < (SDO->blksize*7U)) && (!SDO->ODF_arg.lastSegment)){
+                        uint32_t offset = SDO->ODF_arg.offset;
+
+                        CO_SDO_streamSlide(SDO, 0U);
+                        if(SDO->crcEnabled){
+                            SDO->crc = crc16_ccitt(&SDO->stream->data[offset], SDO->ODF_arg.offset - offset, SDO->crc);
+                        }
+                    }
+                }
+
                 /* If data type is domain, re-fill the data buffer if necessary and indicated so. */
-                if((SDO->ODF_arg.ODdataStorage == 0) && (SDO->ODF_arg.dataLength < (SDO->blksize*7U)) && (!SDO->ODF_arg.lastSegment)){
+                else if((SDO->ODF_arg.ODdataStorage == 0) && (SDO->ODF_arg.dataLength < (SDO->blksize*7U)) && (!SDO->ODF_arg.lastSegment)){
                     /* move the beginning of the data buffer */
                     len = SDO->ODF_arg.dataLength; /* length of valid data in buffer */
                     SDO->ODF_arg.data += len;
-                    SDO->ODF_arg.dataLength = CO_OD_getLength(SDO, SDO->entryNo, SDO->ODF_arg.subIndex) - len;
+                    SDO->ODF_arg.dataLength = SDO->windowSize - len;
 
                     /* read next data from Object dictionary function */
-                    abortCode = CO_SDO_readOD(SDO, CO_SDO_BUFFER_SIZE);
+                    abortCode = CO_SDO_readOD(SDO, SDO->windowSize);
                     if(abortCode != 0U){
                         CO_SDO_abort(SDO, abortCode);
                         return -1;
@@ -1447,6 +2282,10 @@ int8_t CO_SDO_process(
                 return -1;
             }
 
+            /* transfer is finished, abort is not possible any more */
+            if(SDO->stream != NULL){
+                (void)CO_SDO_streamNotify(SDO);
+            }
             SDO->state = CO_SDO_ST_IDLE;
             break;
         }
@@ -1457,6 +2296,17 @@ int8_t CO_SDO_process(
         }
     }
 
+    /* Object dictionary function completes the download later */
+    if(SDO->ODF_arg.pending && (SDO->state == CO_SDO_ST_IDLE)){
+        SDO->state = CO_SDO_ST_DOWNLOAD_PENDING;
+        sendResponse = false;
+    }
+
+    /* Object dictionary function is polled each millisecond meanwhile */
+    if((SDO->state == CO_SDO_ST_DOWNLOAD_PENDING) && (timerNext_ms != NULL) && (*timerNext_ms > 1U)){
+        *timerNext_ms = 1U;
+    }
+
     /* free buffer and send message */
     SDO->CANrxNew = false;
     if(sendResponse) {
@@ -1467,5 +2317,41 @@ int8_t CO_SDO_process(
         return 1;
     }
 
+    /* Set timerNext_ms to 0 to inform OS to call this function again without
+     * delay, if next request is already waiting in the receive FIFO. */
+    if((timerNext_ms != NULL) && (CO_SDO_FIFO_LOAD(SDO->CANrxFifoWr) != SDO->CANrxFifoRd)){
+        *timerNext_ms = 0;
+    }
+
     return 0;
 }
+
+
+/******************************************************************************/
+int8_t CO_SDO_process(
+        CO_SDO_t               *SDO,
+        bool_t                  NMTisPreOrOperational,
+        uint16_t                timeDifference_ms,
+        uint16_t                SDOtimeoutTime,
+        uint16_t               *timerNext_ms)
+{
+#ifdef CO_SDO_FAST_PATH
+    int8_t ret;
+
+    /* fast path in CAN receive is just sending response, SDO server is idle */
+    if(!CO_SDO_TRY_LOCK(SDO->fastPathLock)){
+        if(timerNext_ms != NULL){
+            *timerNext_ms = 0;
+        }
+        return 0;
+    }
+
+    SDO->NMTisPreOrOperational = NMTisPreOrOperational;
+    ret = CO_SDO_processServer(SDO, NMTisPreOrOperational, timeDifference_ms, SDOtimeoutTime, timerNext_ms);
+    CO_SDO_UNLOCK(SDO->fastPathLock);
+
+    return ret;
+#else
+    return CO_SDO_processServer(SDO, NMTisPreOrOperational, timeDifference_ms, SDOtimeoutTime, timerNext_ms);
+#endif
+}
@@ -318,6 +318,21 @@ typedef enum{
  *     registered. Data may be verified and manipulated inside that function. After
  *     function exits, data are copied to location as specified in CO_OD_entry_t.
  *
+ * ####Deferred download response
+ *     If Object dictionary function can not complete the write immediately (for
+ *     example data are stored to a file by another thread), it may set
+ *     ODF_arg->pending and return 0. Data are copied to the Object dictionary
+ *     as usual, but SDO server withholds the response to the client. It then
+ *     calls the function again from each CO_SDO_process() with pending still
+ *     set, until function clears it. Return value of that call is the result
+ *     of the transfer. Other CANopen objects run normally meanwhile. Pending
+ *     is only honoured at the write, which finishes the transfer. SDO server
+ *     requests the next call within 1 ms with timerNext_ms. SDO timeout does
+ *     not apply meanwhile, #CO_SDO_PENDING_TIMEOUT does. If client aborts or
+ *     pending timeout expires, function is not called any more.
+ *     Local download completes the same way, see
+ *     CO_SDO_localDownloadPending().
+ *
  * ####SDO upload (reading from Object dictionary)
  *     Before start of SDO upload, data are read from Object dictionary into
  *     internal buffer. If necessary, bytes are swapped.
@@ -334,6 +349,23 @@ typedef enum{
  *     data, which are longer than #CO_SDO_BUFFER_SIZE. In that case
  *     Object dictionary function is called multiple times between SDO transfer.
  *
+ * ####Streamed domain
+ *     Large domains (log files, firmware images) may be transferred from or
+ *     to a stream, configured with CO_OD_configureStream(), see
+ *     CO_SDO_stream_t. SDO server then reads and writes segments directly
+ *     from the memory or through the read/write callbacks of the stream and
+ *     does not call Object dictionary function for data. Instead, function (if
+ *     registered) is called with dataLength equal to zero twice per transfer:
+ *     at the beginning (firstSegment is true), where it may prepare the stream
+ *     or refuse the transfer, and after the last byte is transferred
+ *     (lastSegment is true). At download the second call may use
+ *     ODF_arg->pending. If transfer is aborted, second call is omitted.
+ *     Local access (CO_SDO_localDownload(), CO_SDO_localUpload()) uses the
+ *     stream in the same way: function is called twice, and data are copied
+ *     between the caller's buffer and the stream memory or callbacks, one
+ *     window at a time. Pending second call of the local download is
+ *     completed with CO_SDO_localDownloadPending().
+ *
  * ####Parameter to function:
  *     ODF_arg     - Pointer to CO_ODF_arg_t object filled before function call.
  *
@@ -352,13 +384,58 @@ typedef enum{
  * If data type is domain, data length is not limited to SDO buffer size. If
  * block transfer is implemented, value should be set to 889.
  *
- * Value can be in range from 7 to 889 bytes.
+ * Value can be in range from 7 to 889 bytes. Each SDO server may use own
+ * buffer of different size, see CO_SDO_initBuffer().
  */
     #ifndef CO_SDO_BUFFER_SIZE
         #define CO_SDO_BUFFER_SIZE    32
     #endif
 
 
+/**
+ * Size of the SDO server receive FIFO.
+ *
+ * Number of received SDO requests, which are stored until CO_SDO_process()
+ * handles them. Client may, for example, send new request immediately after
+ * the end of block upload, before the server has processed the previous
+ * message. Value must be a power of two, from 1 to 128.
+ */
+    #ifndef CO_SDO_RX_FIFO_SIZE
+        #define CO_SDO_RX_FIFO_SIZE   4
+    #endif
+
+
+/**
+ * Timeout of the deferred download response in milliseconds.
+ *
+ * Maximum time, which Object dictionary function may spend to complete the
+ * download after ODF_arg->pending was set, see @ref CO_SDO_OD_function. SDO
+ * server then aborts the transfer with CO_SDO_AB_TIMEOUT. Value must be from 1
+ * to 60000. Timeout of the SDO client should be longer.
+ */
+    #ifndef CO_SDO_PENDING_TIMEOUT
+        #define CO_SDO_PENDING_TIMEOUT    10000U
+    #endif
+
+
+/**
+ * SDO server fast path.
+ *
+ * If CO_SDO_FAST_PATH is defined, expedited upload and expedited download
+ * requests are answered directly from the CAN receive interrupt or thread,
+ * without waiting for CO_SDO_process(). Fast path is used only for variables
+ * with length from 1 to 4 bytes, which have no @ref CO_SDO_OD_function
+ * registered, and only if SDO server is idle in operational or
+ * pre-operational NMT state. Data are copied inside CO_LOCK_OD() section, so
+ * this section must be usable from the CAN receive interrupt or thread.
+ * All other requests, including the ones which end with SDO abort, are
+ * processed by CO_SDO_process() as usual.
+ */
+#ifdef CO_DOXYGEN
+    #define CO_SDO_FAST_PATH
+#endif
+
+
 /**
  * Object Dictionary attributes. Bit masks for attribute in CO_OD_entry_t.
  */
@@ -479,6 +556,8 @@ typedef enum {
     CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK  = 0x15U,
     CO_SDO_ST_DOWNLOAD_BL_SUB_RESP  = 0x16U,
     CO_SDO_ST_DOWNLOAD_BL_END       = 0x17U,
+    CO_SDO_ST_DOWNLOAD_PENDING      = 0x18U,
+    CO_SDO_ST_LOCAL_PENDING         = 0x19U,
     CO_SDO_ST_UPLOAD_INITIATE       = 0x21U,
     CO_SDO_ST_UPLOAD_SEGMENTED      = 0x22U,
     CO_SDO_ST_UPLOAD_BL_INITIATE    = 0x24U,
@@ -488,6 +567,20 @@ typedef enum {
 } CO_SDO_state_t;
 
 
+/**
+ * Return values of CO_SDO_localDownload() and similar functions.
+ */
+typedef enum{
+    /** Transfer is finished, see abort code */
+    CO_SDO_LOCAL_DONE               = 0,
+    /** SDO server is busy, nothing was transferred. Call function again */
+    CO_SDO_LOCAL_BUSY               = 1,
+    /** Data are written, Object dictionary function completes the write
+    later. Call CO_SDO_localDownloadPending() */
+    CO_SDO_LOCAL_PENDING            = 2
+}CO_SDO_localReturn_t;
+
+
 /**
  * Object for one entry with specific index in @ref CO_SDO_objectDictionary.
  */
@@ -583,9 +676,41 @@ typedef struct{
     /** Used by domain data type. In case of multiple segments, this indicates the offset
     into the buffer this segment starts at. */
     uint32_t            offset;
+    /** Used by download. @ref CO_SDO_OD_function may set it to true, if the
+    write is completed asynchronously, see @ref CO_SDO_OD_function. */
+    bool_t              pending;
 }CO_ODF_arg_t;
 
 
+/**
+ * Source or sink of the streamed domain, see CO_OD_configureStream().
+ *
+ * Stream is either memory (data is not NULL) or a pair of callbacks, for
+ * example around a file descriptor. Memory is accessed directly by the SDO
+ * server, without copying through the SDO buffer. At download into memory,
+ * up to 6 bytes after the received data may be overwritten by padding of the
+ * last segment. Callbacks are called with the SDO buffer, each time it is
+ * emptied or must be refilled.
+ */
+typedef struct{
+    /** Memory of the domain or NULL, if callbacks are used. */
+    uint8_t            *data;
+    /** Size of the memory. If callbacks are used: total length by upload (0
+    if not known, then read returns 0 at the end) and maximum length by
+    download (0 if not limited). Object dictionary function may set it at the
+    beginning of the transfer. */
+    uint32_t            size;
+    /** Informative parameter passed to the callbacks. */
+    void               *object;
+    /** Read up to count bytes from position offset into buf. Return number of
+    bytes read, 0 at the end of data or negative value on error. */
+    int32_t           (*read)(void *object, uint32_t offset, uint8_t *buf, uint16_t count);
+    /** Write count bytes from buf to position offset. Return count or
+    negative value on error. */
+    int32_t           (*write)(void *object, uint32_t offset, const uint8_t *buf, uint16_t count);
+}CO_SDO_stream_t;
+
+
 /**
  * Object is used as array inside CO_SDO_t, parallel to @ref CO_SDO_objectDictionary.
  *
@@ -600,17 +725,71 @@ typedef struct{
     /** Pointer to #CO_SDO_OD_flags_t. If object type is array or record, this
     variable points to array with length equal to number of subindexes. */
     uint8_t            *flags;
+    /** Pointer to stream for domain data, see CO_OD_configureStream(). */
+    CO_SDO_stream_t    *stream;
 }CO_OD_extension_t;
 
 
+#ifdef CO_USE_STATISTICS
+/**
+ * Number of abort counters in CO_SDOstats_t. Each abort code from
+ * #CO_SDO_abortCode_t has own counter, the last one counts other codes.
+ */
+#define CO_SDO_STAT_NO_ABORT_CODES      32
+
+
+/**
+ * Abort codes, which belong to the counters in CO_SDOstats_t.abortTx.
+ * Last member is zero and stands for all other abort codes.
+ */
+extern const uint32_t CO_SDO_statAbortCode[CO_SDO_STAT_NO_ABORT_CODES];
+
+
+/**
+ * Statistics counters of the SDO server, see CO_USE_STATISTICS in CO_driver.h.
+ */
+typedef struct{
+    /** Received messages, which were dropped, because of wrong length or
+    because previous block download message was not processed yet */
+    uint32_t            rxDropped;
+    /** Received messages, which were dropped, because receive FIFO was full,
+    see #CO_SDO_RX_FIFO_SIZE */
+    uint32_t            rxFifoFull;
+    /** Number of transfers aborted by SDO client */
+    uint32_t            abortRx;
+    /** Number of transfers aborted by this SDO server, for each abort code
+    from CO_SDO_statAbortCode[] */
+    uint32_t            abortTx[CO_SDO_STAT_NO_ABORT_CODES];
+}CO_SDOstats_t;
+#endif
+
+
 /**
  * SDO server object.
  */
 typedef struct{
-    /** 8 data bytes of the received message. */
+    /** 8 data bytes of the received message, which is being processed. */
     uint8_t             CANrxData[8];
+    /** Receive FIFO, filled by CO_SDO_receive() and emptied into CANrxData
+    by CO_SDO_process(). */
+    uint8_t             CANrxFifo[CO_SDO_RX_FIFO_SIZE][8];
+    /** Number of messages written into CANrxFifo (modulo 256), changed only
+    by CO_SDO_receive() */
+    volatile uint8_t    CANrxFifoWr;
+    /** Number of messages read from CANrxFifo (modulo 256), changed only
+    by CO_SDO_process() */
+    volatile uint8_t    CANrxFifoRd;
     /** SDO data buffer of size #CO_SDO_BUFFER_SIZE. */
     uint8_t             databuffer[CO_SDO_BUFFER_SIZE];
+    /** SDO data buffer in use, databuffer or from CO_SDO_initBuffer(). */
+    uint8_t            *buffer;
+    /** Size of the above buffer. */
+    uint16_t            bufferSize;
+    /** Capacity of ODF_arg.data in the current transfer: bufferSize or size
+    of the window into memory of the stream. */
+    uint16_t            windowSize;
+    /** Stream of the current transfer or NULL. */
+    CO_SDO_stream_t    *stream;
     /** Internal flag indicates, that this object has own OD */
     bool_t              ownOD;
     /** Pointer to the @ref CO_SDO_objectDictionary (array) */
@@ -635,6 +814,9 @@ typedef struct{
     uint8_t             sequence;
     /** Timeout timer for SDO communication */
     uint16_t            timeoutTimer;
+    /** True, if response to the sub-block in block download was sent after
+    sub-block timeout and no segment was received since then */
+    bool_t              timeoutSubblock;
     /** Number of segments per block with 1 <= blksize <= 127 */
     uint8_t             blksize;
     /** True, if CRC calculation by block transfer is enabled */
@@ -645,7 +827,7 @@ typedef struct{
     uint8_t             lastLen;
     /** Indication end of block transfer */
     bool_t              endOfTransfer;
-    /** Variable indicates, if new SDO message received from CAN bus */
+    /** Variable indicates, if CANrxData contains new SDO message */
     bool_t              CANrxNew;
     /** From CO_SDO_initCallback() or NULL */
     void              (*pFunctSignal)(void);
@@ -653,6 +835,17 @@ typedef struct{
     CO_CANmodule_t     *CANdevTx;
     /** CAN transmit buffer inside CANdev for CAN tx message */
     CO_CANtx_t         *CANtxBuff;
+#ifdef CO_SDO_FAST_PATH
+    /** Set while CO_SDO_process() or the fast path in CAN receive works with
+    the SDO server, see #CO_SDO_FAST_PATH */
+    volatile bool_t     fastPathLock;
+    /** From the last CO_SDO_process() call */
+    volatile bool_t     NMTisPreOrOperational;
+#endif
+#ifdef CO_USE_STATISTICS
+    /** Statistics counters */
+    CO_SDOstats_t       stats;
+#endif
 }CO_SDO_t;
 
 
@@ -800,6 +993,27 @@ void CO_SDO_initCallback(
         void                  (*pFunctSignal)(void));
 
 
+/**
+ * Use external SDO data buffer.
+ *
+ * By default SDO server uses internal buffer of size #CO_SDO_BUFFER_SIZE.
+ * Larger buffer enables larger blocks in block transfer and less calls to
+ * @ref CO_SDO_OD_function by domains. Function must be called after each
+ * CO_SDO_init(), while SDO server is idle.
+ *
+ * @param SDO This object.
+ * @param buffer Buffer, must be at least as large as the largest variable in
+ * @ref CO_SDO_objectDictionary.
+ * @param bufferSize Size of the buffer, at least 7 bytes.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDO_initBuffer(
+        CO_SDO_t               *SDO,
+        uint8_t                *buffer,
+        uint16_t                bufferSize);
+
+
 /**
  * Process SDO communication.
  *
@@ -851,6 +1065,24 @@ void CO_OD_configure(
         uint8_t                 flagsSize);
 
 
+/**
+ * Configure stream for domain data of one @ref CO_SDO_objectDictionary entry.
+ *
+ * SDO server then transfers all domain subindexes of the object from or to
+ * the stream, see @ref CO_SDO_OD_function. If OD entry does not exist,
+ * function returns silently. May be combined with CO_OD_configure().
+ *
+ * @param SDO This object.
+ * @param index Index of object in the Object dictionary.
+ * @param stream Pointer to stream, specified by application, or NULL to
+ * disable streaming.
+ */
+void CO_OD_configureStream(
+        CO_SDO_t               *SDO,
+        uint16_t                index,
+        CO_SDO_stream_t        *stream);
+
+
 /**
  * Find object with specific index in Object dictionary.
  *
@@ -959,6 +1191,104 @@ uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize);
  */
 uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length);
 
+
+/**
+ * Write data to own @ref CO_SDO_objectDictionary without CAN communication.
+ *
+ * Function has the same effect as SDO download from the network: attributes
+ * and length are verified, @ref CO_SDO_OD_function is called and streamed
+ * domains are written to their stream. Domain data are passed to the Object
+ * dictionary function in segments of the size of the SDO buffer, as by
+ * segmented transfer.
+ *
+ * Function does not block. If SDO server is in the middle of the transfer
+ * from the network or the fast path in CAN receive works with it at the
+ * moment, CO_SDO_LOCAL_BUSY is returned and nothing is written. If Object dictionary function sets ODF_arg->pending (deferred
+ * download response), CO_SDO_LOCAL_PENDING is returned and SDO server stays
+ * busy. Caller must then call CO_SDO_localDownloadPending() or
+ * CO_SDO_localCancel(). Requests from the network wait in the receive FIFO
+ * meanwhile.
+ *
+ * Function must be called from the same thread as CO_SDO_process().
+ *
+ * @param SDO This object.
+ * @param index Index of the object in Object dictionary.
+ * @param subIndex subIndex of the object in Object dictionary.
+ * @param data Data to be written. By big endian processor multi byte
+ * values are swapped in place. Data must stay valid until transfer is
+ * finished.
+ * @param dataSize Size of data.
+ * @param [out] pSDOabortCode 0 on success, otherwise #CO_SDO_abortCode_t,
+ * if transfer is finished.
+ *
+ * @return #CO_SDO_localReturn_t.
+ */
+CO_SDO_localReturn_t CO_SDO_localDownload(
+        CO_SDO_t               *SDO,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint8_t                *data,
+        uint32_t                dataSize,
+        uint32_t               *pSDOabortCode);
+
+
+/**
+ * Continue local download, which returned CO_SDO_LOCAL_PENDING.
+ *
+ * Function calls Object dictionary function once, same as CO_SDO_process()
+ * does in deferred download response. Caller should call it periodically,
+ * for example each millisecond, until transfer is finished. Caller is
+ * responsible for the timeout, see CO_SDO_localCancel().
+ *
+ * @param SDO This object.
+ * @param [out] pSDOabortCode 0 on success, otherwise #CO_SDO_abortCode_t,
+ * if transfer is finished.
+ *
+ * @return CO_SDO_LOCAL_DONE or CO_SDO_LOCAL_PENDING.
+ */
+CO_SDO_localReturn_t CO_SDO_localDownloadPending(
+        CO_SDO_t               *SDO,
+        uint32_t               *pSDOabortCode);
+
+
+/**
+ * Cancel local download, which returned CO_SDO_LOCAL_PENDING.
+ *
+ * Object dictionary function is not called any more, same as if client
+ * aborts download from the network. SDO server becomes idle.
+ *
+ * @param SDO This object.
+ */
+void CO_SDO_localCancel(CO_SDO_t *SDO);
+
+
+/**
+ * Read data from own @ref CO_SDO_objectDictionary without CAN communication.
+ *
+ * Same as CO_SDO_localDownload(), but for SDO upload. Upload finishes with
+ * the first call or returns CO_SDO_LOCAL_BUSY.
+ *
+ * @param SDO This object.
+ * @param index Index of the object in Object dictionary.
+ * @param subIndex subIndex of the object in Object dictionary.
+ * @param buf Buffer for data.
+ * @param bufSize Size of the buffer. If data are larger, CO_SDO_AB_OUT_OF_MEM
+ * is returned.
+ * @param [out] pDataSize Size of the data read.
+ * @param [out] pSDOabortCode 0 on success, otherwise #CO_SDO_abortCode_t,
+ * if transfer is finished.
+ *
+ * @return CO_SDO_LOCAL_DONE or CO_SDO_LOCAL_BUSY.
+ */
+CO_SDO_localReturn_t CO_SDO_localUpload(
+        CO_SDO_t               *SDO,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint8_t                *buf,
+        uint32_t                bufSize,
+        uint32_t               *pDataSize,
+        uint32_t               *pSDOabortCode);
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
@@ -0,0 +1,406 @@
+/*
+ * Engine, which runs many SDO client transfers in parallel.
+ *
+ * @file        CO_SDOengine.c
+ * @ingroup     CO_SDOengine
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_SDOengine.h"
+
+
+/* Bit of the node in CO_SDOengine_t.nodeBusy */
+#define NODE_WORD(nodeId)       ((nodeId) >> 5)
+#define NODE_BIT(nodeId)        (1UL << ((nodeId) & 0x1FU))
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOengine_init(
+        CO_SDOengine_t         *engine,
+        CO_SDO_t               *SDO,
+        CO_SDOengineChannel_t   channels[],
+        uint16_t                noChannels,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx,
+        uint16_t                SDOtimeoutTime)
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(engine==NULL || SDO==NULL || channels==NULL || noChannels==0U ||
+        CANdevRx==NULL || CANdevTx==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    engine->channels = channels;
+    engine->noChannels = noChannels;
+    engine->window = noChannels;
+    engine->active = 0U;
+    engine->first = 0U;
+    engine->SDOtimeoutTime = SDOtimeoutTime;
+    engine->head = NULL;
+    engine->tail = NULL;
+    engine->queued = 0U;
+    for(i=0U; i<4U; i++){
+        engine->nodeBusy[i] = 0U;
+    }
+
+    /* Configure channels, each with own CAN buffers */
+    for(i=0U; i<noChannels; i++){
+        CO_SDOengineChannel_t *ch = &channels[i];
+        CO_ReturnError_t err;
+
+        ch->job = NULL;
+        ch->clientPar.maxSubIndex = 3U;
+        err = CO_SDOclient_init(&ch->client, SDO, &ch->clientPar,
+                CANdevRx, CANdevRxIdx + i, CANdevTx, CANdevTxIdx + i);
+        if(err != CO_ERROR_NO){
+            return err;
+        }
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_SDOengine_initCallback(
+        CO_SDOengine_t         *engine,
+        void                  (*pFunctSignal)(void))
+{
+    if(engine != NULL){
+        uint16_t i;
+
+        for(i=0U; i<engine->noChannels; i++){
+            CO_SDOclient_initCallback(&engine->channels[i].client, pFunctSignal);
+        }
+    }
+}
+
+
+/*
+ * Verify job, which is going to be queued.
+ */
+static bool_t CO_SDOengine_jobValid(const CO_SDOjob_t *job){
+    return (job != NULL) && (job->nodeId != 0U) && (job->nodeId <= 127U) &&
+           ((job->stream != NULL) || ((job->data != NULL) && (job->dataSize != 0U)));
+}
+
+
+/*
+ * Add job to the end of the queue.
+ */
+static void CO_SDOengine_append(CO_SDOengine_t *engine, CO_SDOjob_t *job, CO_SDObatch_t *batch){
+    job->result = CO_SDOcli_waitingServerResponse;
+    job->abortCode = CO_SDO_AB_NONE;
+    job->transferred = 0U;
+    job->next = NULL;
+    job->batch = batch;
+
+    if(engine->head == NULL){
+        engine->head = job;
+    }
+    else{
+        engine->tail->next = job;
+    }
+    engine->tail = job;
+    engine->queued++;
+}
+
+
+/*
+ * Remove job from the queue. prev is the job before it or NULL.
+ */
+static void CO_SDOengine_unlink(CO_SDOengine_t *engine, CO_SDOjob_t *prev, CO_SDOjob_t *job){
+    if(prev == NULL){
+        engine->head = job->next;
+    }
+    else{
+        prev->next = job->next;
+    }
+    if(engine->tail == job){
+        engine->tail = prev;
+    }
+    engine->queued--;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOengine_queue(CO_SDOengine_t *engine, CO_SDOjob_t *job){
+    /* verify arguments */
+    if(engine==NULL || !CO_SDOengine_jobValid(job)){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    CO_SDOengine_append(engine, job, NULL);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOengine_queueBatch(CO_SDOengine_t *engine, CO_SDObatch_t *batch){
+    uint16_t i;
+
+    /* verify arguments */
+    if(engine==NULL || batch==NULL || batch->jobs==NULL || batch->noJobs==0U){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0U; i<batch->noJobs; i++){
+        if(!CO_SDOengine_jobValid(&batch->jobs[i])){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
+
+    batch->finished = 0U;
+    batch->errors = 0U;
+    for(i=0U; i<batch->noJobs; i++){
+        CO_SDOengine_append(engine, &batch->jobs[i], batch);
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/*
+ * Finish the job and inform application.
+ */
+static void CO_SDOengine_finish(CO_SDOjob_t *job, CO_SDOclient_return_t result){
+    /* job may be queued again from its callback */
+    CO_SDObatch_t *batch = job->batch;
+
+    job->result = result;
+    if(job->pFunct != NULL){
+        job->pFunct(job);
+    }
+
+    if(batch != NULL){
+        if(result != CO_SDOcli_ok_communicationEnd){
+            batch->errors++;
+        }
+        batch->finished++;
+        if((batch->finished == batch->noJobs) && (batch->pFunct != NULL)){
+            batch->pFunct(batch);
+        }
+    }
+}
+
+
+/*
+ * Initiate transfer of the job on the channel. SDO client setup does not
+ * reconfigure CAN reception, if channel was last used for the same node.
+ */
+static CO_SDOclient_return_t CO_SDOengine_initiate(CO_SDOengineChannel_t *ch, CO_SDOjob_t *job){
+    CO_SDOclient_return_t ret;
+
+    ret = CO_SDOclient_setup(&ch->client, 0U, 0U, job->nodeId);
+    if(ret == CO_SDOcli_ok_communicationEnd && job->stream != NULL){
+        uint16_t windowSize = (job->dataSize > 0xFFFFU) ? 0xFFFFU : (uint16_t)job->dataSize;
+
+        if(job->upload){
+            ret = CO_SDOclientUploadInitiateStream(&ch->client, job->index, job->subIndex,
+                    job->stream, job->data, windowSize, job->blockEnable ? 1U : 0U);
+        }
+        else{
+            ret = CO_SDOclientDownloadInitiateStream(&ch->client, job->index, job->subIndex,
+                    job->stream, job->data, windowSize, job->blockEnable ? 1U : 0U);
+        }
+    }
+    else if(ret == CO_SDOcli_ok_communicationEnd){
+        if(job->upload){
+            ret = CO_SDOclientUploadInitiate(&ch->client, job->index, job->subIndex,
+                    job->data, job->dataSize, job->blockEnable ? 1U : 0U);
+        }
+        else{
+            ret = CO_SDOclientDownloadInitiate(&ch->client, job->index, job->subIndex,
+                    job->data, job->dataSize, job->blockEnable ? 1U : 0U);
+        }
+    }
+
+    if(ret == CO_SDOcli_ok_communicationEnd){
+        ch->job = job;
+    }
+    else{
+        CO_SDOclientClose(&ch->client);
+    }
+
+    return ret;
+}
+
+
+/*
+ * Start queued jobs on free channels, until window is full. Job, whose SDO
+ * server is busy with other channel, stays in the queue.
+ */
+static void CO_SDOengine_start(CO_SDOengine_t *engine){
+    CO_SDOjob_t *prev = NULL;
+    CO_SDOjob_t *job = engine->head;
+
+    while((job != NULL) && (engine->active < engine->window) && (engine->active < engine->noChannels)){
+        CO_SDOjob_t *next = job->next;
+        uint8_t nodeId = job->nodeId;
+        CO_SDOengineChannel_t *ch = NULL;
+        CO_SDOclient_return_t ret;
+        uint16_t i;
+
+        if((engine->nodeBusy[NODE_WORD(nodeId)] & NODE_BIT(nodeId)) != 0U){
+            prev = job;
+            job = next;
+            continue;
+        }
+
+        /* find free channel, preferably the one last used for this node */
+        for(i=0U; i<engine->noChannels; i++){
+            CO_SDOengineChannel_t *c = &engine->channels[i];
+
+            if(c->job == NULL){
+                if(c->clientPar.nodeIDOfTheSDOServer == nodeId){
+                    ch = c;
+                    break;
+                }
+                if(ch == NULL){
+                    ch = c;
+                }
+            }
+        }
+
+        CO_SDOengine_unlink(engine, prev, job);
+
+        ret = CO_SDOengine_initiate(ch, job);
+        if(ret == CO_SDOcli_ok_communicationEnd){
+            engine->active++;
+            engine->nodeBusy[NODE_WORD(nodeId)] |= NODE_BIT(nodeId);
+        }
+        else{
+            CO_SDOengine_finish(job, ret);
+        }
+
+        job = next;
+    }
+}
+
+
+/******************************************************************************/
+uint16_t CO_SDOengine_process(
+        CO_SDOengine_t         *engine,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint16_t i;
+
+    /* Process active transfers. First processed channel rotates, so that all
+     * channels have equal access to the shared transmit queue. */
+    for(i=0U; (i<engine->noChannels) && (engine->active > 0U); i++){
+        uint16_t chNo = engine->first + i;
+        CO_SDOengineChannel_t *ch;
+        CO_SDOjob_t *job;
+        CO_SDOclient_return_t ret;
+        uint8_t nodeId;
+
+        if(chNo >= engine->noChannels){
+            chNo -= engine->noChannels;
+        }
+        ch = &engine->channels[chNo];
+        job = ch->job;
+        if(job == NULL){
+            continue;
+        }
+
+        if(job->upload){
+            ret = CO_SDOclientUpload(&ch->client, timeDifference_ms,
+                    engine->SDOtimeoutTime, &job->transferred, &job->abortCode);
+        }
+        else{
+            ret = CO_SDOclientDownload(&ch->client, timeDifference_ms,
+                    engine->SDOtimeoutTime, &job->abortCode);
+        }
+
+        if(ret > 0){
+            /* Set timerNext_ms to 0 to inform OS to call this function again without delay. */
+            if((ret == CO_SDOcli_blockDownldInProgress) && (timerNext_ms != NULL)){
+                *timerNext_ms = 0U;
+            }
+            continue;
+        }
+
+        /* transfer is finished */
+        nodeId = job->nodeId;
+        CO_SDOclientClose(&ch->client);
+        ch->job = NULL;
+        CO_SDOengine_finish(job, ret);
+
+        /* Start the next queued job for the same node on this channel without
+         * delay. Node stays busy and channel stays active. */
+        while(ch->job == NULL){
+            CO_SDOjob_t *prev = NULL;
+            CO_SDOjob_t *nextJob = engine->head;
+
+            while((nextJob != NULL) && (nextJob->nodeId != nodeId)){
+                prev = nextJob;
+                nextJob = nextJob->next;
+            }
+            if(nextJob == NULL){
+                engine->active--;
+                engine->nodeBusy[NODE_WORD(nodeId)] &= ~NODE_BIT(nodeId);
+                break;
+            }
+
+            CO_SDOengine_unlink(engine, prev, nextJob);
+            ret = CO_SDOengine_initiate(ch, nextJob);
+            if(ret != CO_SDOcli_ok_communicationEnd){
+                CO_SDOengine_finish(nextJob, ret);
+            }
+        }
+    }
+
+    engine->first++;
+    if(engine->first >= engine->noChannels){
+        engine->first = 0U;
+    }
+
+    /* start new transfers */
+    if(engine->head != NULL){
+        CO_SDOengine_start(engine);
+    }
+
+    return engine->active + engine->queued;
+}
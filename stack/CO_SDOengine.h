@@ -0,0 +1,294 @@
+/**
+ * Engine, which runs many SDO client transfers in parallel.
+ *
+ * @file        CO_SDOengine.h
+ * @ingroup     CO_SDOengine
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_SDO_ENGINE_H
+#define CO_SDO_ENGINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_SDOmaster.h"
+
+
+/**
+ * @defgroup CO_SDOengine SDO client engine
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Parallel SDO client transfers for CANopen masters.
+ *
+ * Single CO_SDOclient_t serves one transfer at a time, so configuration of
+ * many nodes is strictly sequential and most of the time is spent waiting for
+ * server responses. SDO client engine owns several SDO client channels, each
+ * with own CAN receive and transmit buffer. Application queues transfers
+ * (jobs) with CO_SDOengine_queue(). CO_SDOengine_process() starts queued jobs
+ * on free channels and processes all active transfers. Each channel talks to
+ * one SDO server at a time and the same server is never used by two channels
+ * at once, so jobs for the same node are executed in queue order. Number of
+ * simultaneously active channels is limited by CO_SDOengine_t.window.
+ *
+ * When job is finished, its result is stored into the job and its callback is
+ * called. Engine must be processed from single thread, for example from
+ * mainline together with other CANopen objects. CO_SDOengine_initCallback()
+ * may be used to wake up that thread (for example by writing to eventfd),
+ * when SDO response is received.
+ *
+ * Engine is standalone object. Application reserves noChannels consecutive
+ * receive and transmit buffers in the CAN module for it.
+ *
+ * Many objects can be read or written with one call of
+ * CO_SDOengine_queueBatch(). Batch is an array of jobs with common completion
+ * callback, which is called after the last job of the batch is finished. Each
+ * job keeps own result and abort code. When a job is finished, the next queued
+ * job for the same node is started immediately on the same channel, so
+ * requests to one node follow back to back and the CAN reception of the channel
+ * is not reconfigured. New node gets preferably the free channel, which was
+ * last used for that node.
+ */
+
+
+struct CO_SDObatch_t;
+
+
+/**
+ * SDO client job.
+ *
+ * Job is allocated by application and must stay valid until its callback is
+ * called. Members from nodeId to object are set by application, other members
+ * are set by engine.
+ */
+typedef struct CO_SDOjob_t{
+    /** Node-ID of the SDO server, 1..127 */
+    uint8_t             nodeId;
+    /** True for upload (read from server), false for download */
+    bool_t              upload;
+    /** Try block transfer */
+    bool_t              blockEnable;
+    /** Index of object in object dictionary in remote node */
+    uint16_t            index;
+    /** Subindex of object in object dictionary in remote node */
+    uint8_t             subIndex;
+    /** Data to be written or buffer for data to be read, in little-endian
+    format */
+    uint8_t            *data;
+    /** By download size of data, by upload size of buffer */
+    uint32_t            dataSize;
+    /** Stream or NULL. If set, data are transferred from or to the stream,
+    see CO_SDOclientDownloadInitiateStream(), and data and dataSize specify
+    the window (may be NULL with memory stream). */
+    CO_SDO_stream_t    *stream;
+    /** Called from CO_SDOengine_process(), when job is finished. May be NULL.
+    Job may be queued again from the callback. */
+    void              (*pFunct)(struct CO_SDOjob_t *job);
+    /** Pointer to object for use by application in the callback */
+    void               *object;
+    /** Result of the transfer: CO_SDOcli_ok_communicationEnd or negative
+    value from #CO_SDOclient_return_t */
+    CO_SDOclient_return_t result;
+    /** SDO abort code, CO_SDO_AB_NONE on success */
+    uint32_t            abortCode;
+    /** By upload number of received bytes */
+    uint32_t            transferred;
+    /** Next job in the queue, internal */
+    struct CO_SDOjob_t *next;
+    /** Batch, to which job belongs, or NULL, internal */
+    struct CO_SDObatch_t *batch;
+}CO_SDOjob_t;
+
+
+/**
+ * Batch of SDO client jobs.
+ *
+ * Batch is allocated by application together with its jobs and must stay
+ * valid until its callback is called. Members from jobs to object are set by
+ * application, other members are set by engine.
+ */
+typedef struct CO_SDObatch_t{
+    /** Array of jobs. Members from nodeId to object must be filled in each job,
+    job callback may be NULL. */
+    CO_SDOjob_t        *jobs;
+    /** Number of jobs in the array */
+    uint16_t            noJobs;
+    /** Called from CO_SDOengine_process(), after all jobs are finished. May
+    be NULL. Batch may be queued again from the callback. */
+    void              (*pFunct)(struct CO_SDObatch_t *batch);
+    /** Pointer to object for use by application in the callback */
+    void               *object;
+    /** Number of finished jobs */
+    uint16_t            finished;
+    /** Number of finished jobs, which were not successful */
+    uint16_t            errors;
+}CO_SDObatch_t;
+
+
+/**
+ * SDO client channel inside engine.
+ */
+typedef struct{
+    CO_SDOclient_t      client;         /**< SDO client object */
+    CO_SDOclientPar_t   clientPar;      /**< SDO client parameter, not in Object dictionary */
+    CO_SDOjob_t        *job;            /**< Active job or NULL, if channel is free */
+}CO_SDOengineChannel_t;
+
+
+/**
+ * SDO client engine object.
+ */
+typedef struct{
+    CO_SDOengineChannel_t *channels;    /**< From CO_SDOengine_init() */
+    uint16_t            noChannels;     /**< From CO_SDOengine_init() */
+    /** Maximum number of simultaneously active channels, 1..noChannels. Set
+    to noChannels in CO_SDOengine_init(). Can be changed by application. */
+    uint16_t            window;
+    uint16_t            active;         /**< Number of active channels */
+    uint16_t            first;          /**< Channel, which is processed first, rotates */
+    uint16_t            SDOtimeoutTime; /**< From CO_SDOengine_init() */
+    CO_SDOjob_t        *head;           /**< First queued job or NULL */
+    CO_SDOjob_t        *tail;           /**< Last queued job */
+    uint16_t            queued;         /**< Number of queued jobs */
+    uint32_t            nodeBusy[4];    /**< Bit for each node, which is served by active channel */
+}CO_SDOengine_t;
+
+
+/**
+ * Initialize SDO client engine.
+ *
+ * Function must be called in the communication reset section.
+ *
+ * @param engine This object will be initialized.
+ * @param SDO SDO server object of this node, see CO_SDOclient_init().
+ * @param channels Array of channels, allocated by application.
+ * @param noChannels Number of channels.
+ * @param CANdevRx CAN device for SDO client reception.
+ * @param CANdevRxIdx Index of the first of noChannels receive buffers in
+ * the above CAN device.
+ * @param CANdevTx CAN device for SDO client transmission.
+ * @param CANdevTxIdx Index of the first of noChannels transmit buffers in
+ * the above CAN device.
+ * @param SDOtimeoutTime Timeout time for SDO communication in milliseconds.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOengine_init(
+        CO_SDOengine_t         *engine,
+        CO_SDO_t               *SDO,
+        CO_SDOengineChannel_t   channels[],
+        uint16_t                noChannels,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx,
+        uint16_t                SDOtimeoutTime);
+
+
+/**
+ * Initialize callback function for all channels.
+ *
+ * Function is called after SDO response is received from the CAN bus, see
+ * CO_SDOclient_initCallback().
+ *
+ * @param engine This object.
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_SDOengine_initCallback(
+        CO_SDOengine_t         *engine,
+        void                  (*pFunctSignal)(void));
+
+
+/**
+ * Add job to the end of the queue.
+ *
+ * Job is started by next CO_SDOengine_process(). Function must be called from
+ * the same thread as CO_SDOengine_process().
+ *
+ * @param engine This object.
+ * @param job Job with filled members from nodeId to object.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOengine_queue(CO_SDOengine_t *engine, CO_SDOjob_t *job);
+
+
+/**
+ * Add all jobs of the batch to the end of the queue.
+ *
+ * Jobs are verified first, so either all or none of them are queued. Jobs for
+ * the same node are executed in array order. Function must be called from the
+ * same thread as CO_SDOengine_process().
+ *
+ * @param engine This object.
+ * @param batch Batch with filled members from jobs to object.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOengine_queueBatch(CO_SDOengine_t *engine, CO_SDObatch_t *batch);
+
+
+/**
+ * Process SDO client engine.
+ *
+ * Function must be called cyclically. It processes active transfers, finishes
+ * them and starts queued jobs on free channels.
+ *
+ * @param engine This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process(). Set to
+ * 0, if transfer is sending block of messages.
+ *
+ * @return Number of unfinished jobs, active and queued.
+ */
+uint16_t CO_SDOengine_process(
+        CO_SDOengine_t         *engine,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
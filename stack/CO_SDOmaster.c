@@ -79,6 +79,7 @@
 /* client states */
 #define SDO_STATE_NOTDEFINED            0
 #define SDO_STATE_ABORT                 1
+#define SDO_STATE_LOCAL_PENDING         2
 
 /* DOWNLOAD EXPEDITED/SEGMENTED */
 #define SDO_STATE_DOWNLOAD_INITIATE     10
@@ -151,19 +152,18 @@ static void CO_SDOclient_receive(void *object, const CO_CANrxMsg_t *msg){
 
                 SDO_C->block_seqno++;
 
-                /* copy data */
+                /* copy data, bytes beyond the buffer are only counted. Unused
+                 * bytes of the last segment are subtracted at the end. */
                 for(i=1; i<8; i++) {
-                    SDO_C->buffer[SDO_C->dataSizeTransfered++] = msg->data[i];
-                    if(SDO_C->dataSizeTransfered >= SDO_C->bufferSize) {
-                        /* buffer full, break reception */
-                        SDO_C->state = SDO_STATE_BLOCKUPLOAD_SUB_END;
-                        SDO_C->CANrxNew = true;
-                        break;
+                    if((SDO_C->dataSizeTransfered - SDO_C->streamOffset) < SDO_C->bufferSize) {
+                        SDO_C->buffer[SDO_C->dataSizeTransfered - SDO_C->streamOffset] = msg->data[i];
                     }
+                    SDO_C->dataSizeTransfered++;
                 }
 
-                /* break reception if last segment or block sequence is too large */
-                if(((SDO_C->CANrxData[0] & 0x80U) == 0x80U) || (SDO_C->block_seqno >= SDO_C->block_blksize)) {
+                /* break reception if last segment, block sequence is too large or buffer is full */
+                if(((SDO_C->CANrxData[0] & 0x80U) == 0x80U) || (SDO_C->block_seqno >= SDO_C->block_blksize)
+                    || ((SDO_C->dataSizeTransfered - SDO_C->streamOffset) >= SDO_C->bufferSize)) {
                     SDO_C->state = SDO_STATE_BLOCKUPLOAD_SUB_END;
                     SDO_C->CANrxNew = true;
                 }
@@ -172,7 +172,9 @@ static void CO_SDOclient_receive(void *object, const CO_CANrxMsg_t *msg){
                 /* Ignore message, if it is duplicate or if sequence didn't started yet. */
             }
             else {
-                /* seqno is totally wrong, break reception. */
+                /* seqno is totally wrong, break reception. Segment is not
+                 * accepted, so it must not be treated as the last one. */
+                SDO_C->CANrxData[0] = 0;
                 SDO_C->state = SDO_STATE_BLOCKUPLOAD_SUB_END;
                 SDO_C->CANrxNew = true;
             }
@@ -208,6 +210,8 @@ CO_ReturnError_t CO_SDOclient_init(
 
     SDO_C->pst    = 21; /*  block transfer */
     SDO_C->block_size_max = 127; /*  block transfer */
+    SDO_C->block_size_cur = 127;
+    SDO_C->block_segmentsRepeated = 0;
 
     SDO_C->SDO = SDO;
     SDO_C->SDOClientPar = SDOClientPar;
@@ -323,6 +327,38 @@ static void CO_SDOclient_abort(CO_SDOclient_t *SDO_C, uint32_t code){
 }
 
 
+/*
+ * Adapt block size of block upload, before block is acknowledged. If not all
+ * segments of the block were received, block size is halved, otherwise it is
+ * increased by one quarter. Block size is between 2 and block_size_max.
+ * Segments, which were sent after lost one, are repeated by the server, so
+ * smaller blocks waste less bus time, when messages are lost.
+ */
+static void CO_SDOclient_adaptBlockSize(CO_SDOclient_t *SDO_C, uint8_t received, uint8_t sent){
+    uint16_t cur = SDO_C->block_size_cur;
+
+    if(received < sent){
+        SDO_C->block_segmentsRepeated += (uint32_t)(sent - received);
+        cur /= 2U;
+    }
+    else{
+        cur += (cur / 4U) + 1U;
+    }
+
+    if(cur > SDO_C->block_size_max){
+        cur = SDO_C->block_size_max;
+    }
+    /* block must fit into the window of the stream */
+    if((SDO_C->stream != NULL) && (cur > (SDO_C->bufferSize / 7U))){
+        cur = (uint16_t)(SDO_C->bufferSize / 7U);
+    }
+    if(cur < 2U){
+        cur = 2U;
+    }
+    SDO_C->block_size_cur = (uint8_t)cur;
+}
+
+
 /******************************************************************************/
 static void CO_SDOTxBufferClear(CO_SDOclient_t *SDO_C) {
     uint16_t i;
@@ -334,28 +370,55 @@ static void CO_SDOTxBufferClear(CO_SDOclient_t *SDO_C) {
 }
 
 
+/*
+ * Get pointer to count bytes of download data at offset. If stream callbacks
+ * are used, window is refilled from the stream, if data are not inside it.
+ * Return NULL, if stream read fails.
+ */
+static const uint8_t *CO_SDOclient_txData(CO_SDOclient_t *SDO_C, uint32_t offset, uint16_t count){
+    CO_SDO_stream_t *stream = SDO_C->stream;
+
+    if(stream == NULL){
+        return &SDO_C->buffer[offset];
+    }
+
+    if((offset < SDO_C->streamOffset) || ((offset + count) > (SDO_C->streamOffset + SDO_C->streamLength))){
+        uint32_t len = SDO_C->bufferSize - offset;
+
+        if(len > SDO_C->windowSize){
+            len = SDO_C->windowSize;
+        }
+        SDO_C->streamOffset = offset;
+        SDO_C->streamLength = 0U;
+        while(SDO_C->streamLength < len){
+            int32_t n = stream->read(stream->object, offset + SDO_C->streamLength,
+                                     &SDO_C->buffer[SDO_C->streamLength],
+                                     (uint16_t)(len - SDO_C->streamLength));
+            if(n <= 0){
+                SDO_C->streamLength = 0U;
+                return NULL;
+            }
+            SDO_C->streamLength += (uint16_t)n;
+        }
+    }
+
+    return &SDO_C->buffer[offset - SDO_C->streamOffset];
+}
+
+
 /*******************************************************************************
  *
  * DOWNLOAD
  *
  *
  ******************************************************************************/
-CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
+static CO_SDOclient_return_t CO_SDOclient_downloadInitiate(
         CO_SDOclient_t         *SDO_C,
         uint16_t                index,
         uint8_t                 subIndex,
-        uint8_t                *dataTx,
-        uint32_t                dataSize,
         uint8_t                 blockEnable)
 {
-    /* verify parameters */
-    if(SDO_C == NULL || dataTx == 0 || dataSize == 0) {
-        return CO_SDOcli_wrongArguments;
-    }
-
-    /* save parameters */
-    SDO_C->buffer = dataTx;
-    SDO_C->bufferSize = dataSize;
+    uint32_t dataSize = SDO_C->bufferSize;
 
     SDO_C->state = SDO_STATE_DOWNLOAD_INITIATE;
 
@@ -370,11 +433,19 @@ CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
 
     /* if nodeIDOfTheSDOServer == node-ID of this node, then exchange data with this node */
     if(SDO_C->SDOClientPar->nodeIDOfTheSDOServer == SDO_C->SDO->nodeId){
+        SDO_C->timeoutTimer = 0;
         return CO_SDOcli_ok_communicationEnd;
     }
 
     if(dataSize <= 4){
         uint16_t i;
+        const uint8_t *dataTx = CO_SDOclient_txData(SDO_C, 0, (uint16_t)dataSize);
+
+        if(dataTx == NULL){
+            SDO_C->state = SDO_STATE_NOTDEFINED;
+            return CO_SDOcli_wrongArguments;
+        }
+
         /* expedited transfer */
         SDO_C->CANtxBuff->data[0] = 0x23 | ((4-dataSize) << 2);
 
@@ -416,6 +487,65 @@ CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
 }
 
 
+/******************************************************************************/
+CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint8_t                *dataTx,
+        uint32_t                dataSize,
+        uint8_t                 blockEnable)
+{
+    /* verify parameters */
+    if(SDO_C == NULL || dataTx == 0 || dataSize == 0) {
+        return CO_SDOcli_wrongArguments;
+    }
+
+    /* save parameters */
+    SDO_C->buffer = dataTx;
+    SDO_C->bufferSize = dataSize;
+    SDO_C->stream = NULL;
+    SDO_C->streamOffset = 0;
+
+    return CO_SDOclient_downloadInitiate(SDO_C, index, subIndex, blockEnable);
+}
+
+
+/******************************************************************************/
+CO_SDOclient_return_t CO_SDOclientDownloadInitiateStream(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        CO_SDO_stream_t        *stream,
+        uint8_t                *window,
+        uint16_t                windowSize,
+        uint8_t                 blockEnable)
+{
+    /* memory is sent directly */
+    if(stream != NULL && stream->data != NULL){
+        return CO_SDOclientDownloadInitiate(SDO_C, index, subIndex, stream->data, stream->size, blockEnable);
+    }
+
+    /* verify parameters */
+    if(SDO_C == NULL || stream == NULL || stream->read == NULL || stream->size == 0
+        || window == NULL || windowSize < 7
+        || SDO_C->SDOClientPar->nodeIDOfTheSDOServer == SDO_C->SDO->nodeId)
+    {
+        return CO_SDOcli_wrongArguments;
+    }
+
+    /* save parameters, window is empty */
+    SDO_C->buffer = window;
+    SDO_C->bufferSize = stream->size;
+    SDO_C->stream = stream;
+    SDO_C->streamOffset = 0;
+    SDO_C->streamLength = 0;
+    SDO_C->windowSize = windowSize;
+
+    return CO_SDOclient_downloadInitiate(SDO_C, index, subIndex, blockEnable);
+}
+
+
 /******************************************************************************/
 CO_SDOclient_return_t CO_SDOclientDownload(
         CO_SDOclient_t         *SDO_C,
@@ -435,25 +565,38 @@ CO_SDOclient_return_t CO_SDOclientDownload(
 
     /* if nodeIDOfTheSDOServer == node-ID of this node, then exchange data with this node */
     if(SDO_C->SDO && SDO_C->SDOClientPar->nodeIDOfTheSDOServer == SDO_C->SDO->nodeId){
-        SDO_C->state = SDO_STATE_NOTDEFINED;
+        CO_SDO_localReturn_t localRet;
+
         SDO_C->CANrxNew = false;
 
-        /* If SDO server is busy return error */
-        if(SDO_C->SDO->state != 0){
-            return CO_SDOcli_endedWithClientAbort;
+        /* write data to the Object dictionary. Repeat, if SDO server is busy,
+         * or wait for the Object dictionary function. */
+        if(SDO_C->state == SDO_STATE_LOCAL_PENDING){
+            localRet = CO_SDO_localDownloadPending(SDO_C->SDO, pSDOabortCode);
         }
-
-        /* init ODF_arg */
-        *pSDOabortCode = CO_SDO_initTransfer(SDO_C->SDO, SDO_C->index, SDO_C->subIndex);
-        if((*pSDOabortCode) != CO_SDO_AB_NONE){
-            return CO_SDOcli_endedWithServerAbort;
+        else{
+            localRet = CO_SDO_localDownload(SDO_C->SDO, SDO_C->index, SDO_C->subIndex,
+                                            SDO_C->buffer, SDO_C->bufferSize, pSDOabortCode);
         }
 
-        /* set buffer */
-        SDO_C->SDO->ODF_arg.data = SDO_C->buffer;
+        if(localRet != CO_SDO_LOCAL_DONE){
+            if(localRet == CO_SDO_LOCAL_PENDING){
+                SDO_C->state = SDO_STATE_LOCAL_PENDING;
+            }
+            if(SDO_C->timeoutTimer < SDOtimeoutTime){
+                SDO_C->timeoutTimer += timeDifference_ms;
+            }
+            if(SDO_C->timeoutTimer >= SDOtimeoutTime){
+                CO_SDO_localCancel(SDO_C->SDO);
+                SDO_C->state = SDO_STATE_NOTDEFINED;
+                *pSDOabortCode = CO_SDO_AB_TIMEOUT;
+                return CO_SDOcli_endedWithTimeout;
+            }
+            *pSDOabortCode = CO_SDO_AB_NONE;
+            return CO_SDOcli_waitingServerResponse;
+        }
 
-        /* write data to the Object dictionary */
-        *pSDOabortCode = CO_SDO_writeOD(SDO_C->SDO, SDO_C->bufferSize);
+        SDO_C->state = SDO_STATE_NOTDEFINED;
         if((*pSDOabortCode) != CO_SDO_AB_NONE){
             return CO_SDOcli_endedWithServerAbort;
         }
@@ -548,6 +691,8 @@ CO_SDOclient_return_t CO_SDOclientDownload(
                     SDO_C->block_seqno = 0;
                     SDO_C->bufferOffset = 0;
                     SDO_C->bufferOffsetACK = 0;
+                    SDO_C->crc = 0;
+                    SDO_C->crcOffset = 0;
                     SDO_C->state = SDO_STATE_BLOCKDOWNLOAD_INPORGRES;
 
                     break;
@@ -569,6 +714,9 @@ CO_SDOclient_return_t CO_SDOclientDownload(
                         break;
                     }
                     /*  check number of segments */
+                    if(SDO_C->CANrxData[1] < SDO_C->block_seqno){
+                        SDO_C->block_segmentsRepeated += (uint32_t)(SDO_C->block_seqno - SDO_C->CANrxData[1]);
+                    }
                     if(SDO_C->CANrxData[1] != SDO_C->block_blksize){
                         /*  NOT all segments transferred successfully */
                         SDO_C->bufferOffsetACK += SDO_C->CANrxData[1] * 7;
@@ -650,12 +798,20 @@ CO_SDOclient_return_t CO_SDOclientDownload(
             /*  SEGMENTED */
         case SDO_STATE_DOWNLOAD_REQUEST:{
             uint16_t i, j;
+            const uint8_t *dataTx;
             /* calculate length to be sent */
-            j = SDO_C->bufferSize - SDO_C->bufferOffset;
-            if(j > 7) j = 7;
+            j = ((SDO_C->bufferSize - SDO_C->bufferOffset) > 7) ? 7 : (uint16_t)(SDO_C->bufferSize - SDO_C->bufferOffset);
+            dataTx = CO_SDOclient_txData(SDO_C, SDO_C->bufferOffset, j);
+            if(dataTx == NULL){
+                *pSDOabortCode = CO_SDO_AB_GENERAL;
+                SDO_C->state = SDO_STATE_NOTDEFINED;
+                CO_SDOclient_abort(SDO_C, *pSDOabortCode);
+                ret = CO_SDOcli_endedWithClientAbort;
+                break;
+            }
             /* fill data bytes */
             for(i=0; i<j; i++)
-                SDO_C->CANtxBuff->data[i+1] = SDO_C->buffer[SDO_C->bufferOffset + i];
+                SDO_C->CANtxBuff->data[i+1] = dataTx[i];
 
             for(; i<7; i++)
                 SDO_C->CANtxBuff->data[i+1] = 0;
@@ -675,37 +831,65 @@ CO_SDOclient_return_t CO_SDOclientDownload(
 
         /*  BLOCK */
         case SDO_STATE_BLOCKDOWNLOAD_INPORGRES:{
-            SDO_C->block_seqno += 1;
-            SDO_C->CANtxBuff->data[0] = SDO_C->block_seqno;
+            /* Send segments, until transmit buffer is full or block is
+             * finished. Driver may accept more than one message, for example
+             * into transmit queue of the operating system. */
+            while((SDO_C->state == SDO_STATE_BLOCKDOWNLOAD_INPORGRES) &&
+                  !SDO_C->CANtxBuff->bufferFull)
+            {
+                uint32_t bufferOffset = SDO_C->bufferOffset;
+                uint8_t blksize = SDO_C->block_blksize;
+                const uint8_t *dataTx;
+                uint16_t len;
+                uint8_t i;
 
-            if(SDO_C->block_seqno >= SDO_C->block_blksize){
-                SDO_C->state = SDO_STATE_BLOCKDOWNLOAD_BLOCK_ACK;
-            }
-            /*  set data */
-            SDO_C->block_noData = 0;
+                /*  get data */
+                len = ((SDO_C->bufferSize - bufferOffset) > 7) ? 7 : (uint16_t)(SDO_C->bufferSize - bufferOffset);
+                dataTx = CO_SDOclient_txData(SDO_C, bufferOffset, len);
+                if(dataTx == NULL){
+                    *pSDOabortCode = CO_SDO_AB_GENERAL;
+                    CO_SDOclient_abort(SDO_C, *pSDOabortCode);
+                    ret = CO_SDOcli_endedWithClientAbort;
+                    break;
+                }
 
-            uint8_t i;
-            for(i = 1; i < 8; i++){
-                if(SDO_C->bufferOffset < SDO_C->bufferSize){
-                    SDO_C->CANtxBuff->data[i] = *(SDO_C->buffer + SDO_C->bufferOffset);
+                /* CRC is calculated, when data are sent first time */
+                if(bufferOffset == SDO_C->crcOffset){
+                    SDO_C->crc = crc16_ccitt(dataTx, len, SDO_C->crc);
+                    SDO_C->crcOffset += len;
                 }
-                else{
-                    SDO_C->CANtxBuff->data[i] = 0;
-                    SDO_C->block_noData += 1;
+
+                SDO_C->block_seqno += 1;
+                SDO_C->CANtxBuff->data[0] = SDO_C->block_seqno;
+
+                if(SDO_C->block_seqno >= SDO_C->block_blksize){
+                    SDO_C->state = SDO_STATE_BLOCKDOWNLOAD_BLOCK_ACK;
                 }
+                /*  set data */
+                SDO_C->block_noData = 7 - len;
 
-                SDO_C->bufferOffset += 1;
-            }
+                for(i = 0; i < 7; i++){
+                    SDO_C->CANtxBuff->data[i + 1] = (i < len) ? dataTx[i] : 0;
+                }
+                SDO_C->bufferOffset += 7;
 
-            if(SDO_C->bufferOffset >= SDO_C->bufferSize){
-                SDO_C->CANtxBuff->data[0] |= 0x80;
-                SDO_C->block_blksize = SDO_C->block_seqno;
-                SDO_C->state = SDO_STATE_BLOCKDOWNLOAD_BLOCK_ACK;
-            }
+                if(SDO_C->bufferOffset >= SDO_C->bufferSize){
+                    SDO_C->CANtxBuff->data[0] |= 0x80;
+                    SDO_C->block_blksize = SDO_C->block_seqno;
+                    SDO_C->state = SDO_STATE_BLOCKDOWNLOAD_BLOCK_ACK;
+                }
 
-            /*  tx data */
-            SDO_C->timeoutTimer = 0;
-            CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff);
+                /*  tx data */
+                SDO_C->timeoutTimer = 0;
+                if(CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff) != CO_ERROR_NO){
+                    /* message was not accepted, repeat segment in next call */
+                    SDO_C->block_seqno -= 1;
+                    SDO_C->bufferOffset = bufferOffset;
+                    SDO_C->block_blksize = blksize;
+                    SDO_C->state = SDO_STATE_BLOCKDOWNLOAD_INPORGRES;
+                    break;
+                }
+            }
 
             break;
         }
@@ -713,18 +897,15 @@ CO_SDOclient_return_t CO_SDOclientDownload(
         case SDO_STATE_BLOCKDOWNLOAD_CRC:{
             SDO_C->CANtxBuff->data[0] = (CCS_DOWNLOAD_BLOCK<<5) | (SDO_C->block_noData << 2) | 0x01;
 
-            uint16_t tmp16;
-
-            tmp16 = crc16_ccitt((unsigned char *)SDO_C->buffer, (unsigned int)SDO_C->bufferSize, 0);
+            /*  CRC was calculated incrementally */
+            SDO_C->CANtxBuff->data[1] = (uint8_t) SDO_C->crc;
+            SDO_C->CANtxBuff->data[2] = (uint8_t) (SDO_C->crc>>8);
 
-            SDO_C->CANtxBuff->data[1] = (uint8_t) tmp16;
-            SDO_C->CANtxBuff->data[2] = (uint8_t) (tmp16>>8);
-
-            /*  set state */
-            SDO_C->state = SDO_STATE_BLOCKDOWNLOAD_CRC_ACK;
-            /*  tx data */
+            /*  tx data, repeat in next call, if message was not accepted */
             SDO_C->timeoutTimer = 0;
-            CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff);
+            if(CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff) == CO_ERROR_NO){
+                SDO_C->state = SDO_STATE_BLOCKDOWNLOAD_CRC_ACK;
+            }
 
             break;
         }
@@ -742,27 +923,58 @@ CO_SDOclient_return_t CO_SDOclientDownload(
 }
 
 
+/*
+ * Maximum number of bytes, which can be received by upload.
+ */
+static uint32_t CO_SDOclient_rxCapacity(CO_SDOclient_t *SDO_C){
+    if(SDO_C->stream == NULL){
+        return SDO_C->bufferSize;
+    }
+    return (SDO_C->stream->size != 0U) ? SDO_C->stream->size : 0xFFFFFFFFUL;
+}
+
+
+/*
+ * Received data up to position end are complete. Update CRC of block upload
+ * and write data from the window to the stream, if stream callbacks are used.
+ * Return SDO abort code.
+ */
+static uint32_t CO_SDOclient_rxCommit(CO_SDOclient_t *SDO_C, uint32_t end){
+    CO_SDO_stream_t *stream = SDO_C->stream;
+
+    if(SDO_C->crcEnabled && (end > SDO_C->crcOffset)){
+        SDO_C->crc = crc16_ccitt(&SDO_C->buffer[SDO_C->crcOffset - SDO_C->streamOffset],
+                                 end - SDO_C->crcOffset, SDO_C->crc);
+    }
+    SDO_C->crcOffset = end;
+
+    if((stream != NULL) && (end > SDO_C->streamOffset)){
+        uint16_t length = (uint16_t)(end - SDO_C->streamOffset);
+
+        if(stream->write(stream->object, SDO_C->streamOffset, SDO_C->buffer, length) != (int32_t)length){
+            return CO_SDO_AB_GENERAL;
+        }
+        SDO_C->streamOffset = end;
+    }
+
+    return CO_SDO_AB_NONE;
+}
+
+
 /*******************************************************************************
  *
  * UPLOAD
  *
  ******************************************************************************/
-CO_SDOclient_return_t CO_SDOclientUploadInitiate(
+static CO_SDOclient_return_t CO_SDOclient_uploadInitiate(
         CO_SDOclient_t         *SDO_C,
         uint16_t                index,
         uint8_t                 subIndex,
-        uint8_t                *dataRx,
-        uint32_t                dataRxSize,
         uint8_t                 blockEnable)
 {
-    /* verify parameters */
-    if(SDO_C == NULL || dataRx == 0 || dataRxSize < 4) {
-        return CO_SDOcli_wrongArguments;
-    }
-
-    /* save parameters */
-    SDO_C->buffer = dataRx;
-    SDO_C->bufferSize = dataRxSize;
+    SDO_C->crcEnabled = 0;
+    SDO_C->crc = 0;
+    SDO_C->crcOffset = 0;
 
     /* prepare CAN tx message */
     CO_SDOTxBufferClear(SDO_C);
@@ -774,6 +986,11 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
     SDO_C->CANtxBuff->data[2] = index >> 8;
     SDO_C->CANtxBuff->data[3] = subIndex;
 
+    /* if nodeIDOfTheSDOServer == node-ID of this node, then exchange data with this node */
+    if(SDO_C->SDOClientPar->nodeIDOfTheSDOServer == SDO_C->SDO->nodeId){
+        SDO_C->timeoutTimer = 0;
+        return CO_SDOcli_ok_communicationEnd;
+    }
 
     if(blockEnable == 0){
         SDO_C->state = SDO_STATE_UPLOAD_INITIATED;
@@ -789,7 +1006,13 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
         SDO_C->CANtxBuff->data[0] |= 0x04;
 
         /*  set number of segments in block */
-        SDO_C->block_blksize = SDO_C->block_size_max;
+        if(SDO_C->block_size_cur > SDO_C->block_size_max){
+            SDO_C->block_size_cur = SDO_C->block_size_max;
+        }
+        if((SDO_C->stream != NULL) && (SDO_C->block_size_cur > (SDO_C->bufferSize / 7U))){
+            SDO_C->block_size_cur = (uint8_t)(SDO_C->bufferSize / 7U);
+        }
+        SDO_C->block_blksize = SDO_C->block_size_cur;
         if ((SDO_C->block_blksize *7) > SDO_C->bufferSize){
             return CO_SDOcli_wrongArguments;
         }
@@ -801,11 +1024,6 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
         SDO_C->block_seqno = 0;
     }
 
-    /* if nodeIDOfTheSDOServer == node-ID of this node, then exchange data with this node */
-    if(SDO_C->SDOClientPar->nodeIDOfTheSDOServer == SDO_C->SDO->nodeId){
-        return CO_SDOcli_ok_communicationEnd;
-    }
-
     /* empty receive buffer, reset timeout timer and send message */
     SDO_C->CANrxNew = false;
     SDO_C->timeoutTimer = 0;
@@ -816,6 +1034,63 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
 }
 
 
+/******************************************************************************/
+CO_SDOclient_return_t CO_SDOclientUploadInitiate(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint8_t                *dataRx,
+        uint32_t                dataRxSize,
+        uint8_t                 blockEnable)
+{
+    /* verify parameters */
+    if(SDO_C == NULL || dataRx == 0 || dataRxSize < 4) {
+        return CO_SDOcli_wrongArguments;
+    }
+
+    /* save parameters */
+    SDO_C->buffer = dataRx;
+    SDO_C->bufferSize = dataRxSize;
+    SDO_C->stream = NULL;
+    SDO_C->streamOffset = 0;
+
+    return CO_SDOclient_uploadInitiate(SDO_C, index, subIndex, blockEnable);
+}
+
+
+/******************************************************************************/
+CO_SDOclient_return_t CO_SDOclientUploadInitiateStream(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        CO_SDO_stream_t        *stream,
+        uint8_t                *window,
+        uint16_t                windowSize,
+        uint8_t                 blockEnable)
+{
+    /* data are received directly into memory */
+    if(stream != NULL && stream->data != NULL){
+        return CO_SDOclientUploadInitiate(SDO_C, index, subIndex, stream->data, stream->size, blockEnable);
+    }
+
+    /* verify parameters */
+    if(SDO_C == NULL || stream == NULL || stream->write == NULL
+        || window == NULL || windowSize < ((blockEnable != 0) ? 14 : 7)
+        || SDO_C->SDOClientPar->nodeIDOfTheSDOServer == SDO_C->SDO->nodeId)
+    {
+        return CO_SDOcli_wrongArguments;
+    }
+
+    /* save parameters, window is empty */
+    SDO_C->buffer = window;
+    SDO_C->bufferSize = windowSize;
+    SDO_C->stream = stream;
+    SDO_C->streamOffset = 0;
+
+    return CO_SDOclient_uploadInitiate(SDO_C, index, subIndex, blockEnable);
+}
+
+
 /******************************************************************************/
 CO_SDOclient_return_t CO_SDOclientUpload(
         CO_SDOclient_t         *SDO_C,
@@ -838,41 +1113,29 @@ CO_SDOclient_return_t CO_SDOclientUpload(
 
     /* if nodeIDOfTheSDOServer == node-ID of this node, then exchange data with this node */
     if(SDO_C->SDO && SDO_C->SDOClientPar->nodeIDOfTheSDOServer == SDO_C->SDO->nodeId){
-        SDO_C->state = SDO_STATE_NOTDEFINED;
         SDO_C->CANrxNew = false;
 
-        /* If SDO server is busy return error */
-        if(SDO_C->SDO->state != 0){
-            *pSDOabortCode = CO_SDO_AB_DEVICE_INCOMPAT;
-            return CO_SDOcli_endedWithClientAbort;
-        }
-
-        /* init ODF_arg */
-        *pSDOabortCode = CO_SDO_initTransfer(SDO_C->SDO, SDO_C->index, SDO_C->subIndex);
-        if((*pSDOabortCode) != CO_SDO_AB_NONE){
-            return CO_SDOcli_endedWithServerAbort;
+        /* read data from the Object dictionary, repeat if SDO server is busy */
+        if(CO_SDO_localUpload(SDO_C->SDO, SDO_C->index, SDO_C->subIndex, SDO_C->buffer,
+                              SDO_C->bufferSize, pDataSize, pSDOabortCode) != CO_SDO_LOCAL_DONE)
+        {
+            if(SDO_C->timeoutTimer < SDOtimeoutTime){
+                SDO_C->timeoutTimer += timeDifference_ms;
+            }
+            if(SDO_C->timeoutTimer >= SDOtimeoutTime){
+                SDO_C->state = SDO_STATE_NOTDEFINED;
+                *pSDOabortCode = CO_SDO_AB_TIMEOUT;
+                return CO_SDOcli_endedWithTimeout;
+            }
+            *pSDOabortCode = CO_SDO_AB_NONE;
+            return CO_SDOcli_waitingServerResponse;
         }
 
-        /* set buffer and length if domain */
-        SDO_C->SDO->ODF_arg.data = SDO_C->buffer;
-        if(SDO_C->SDO->ODF_arg.ODdataStorage == 0)
-            SDO_C->SDO->ODF_arg.dataLength = SDO_C->bufferSize;
-
-        /* read data from the Object dictionary */
-        *pSDOabortCode = CO_SDO_readOD(SDO_C->SDO, SDO_C->bufferSize);
+        SDO_C->state = SDO_STATE_NOTDEFINED;
         if((*pSDOabortCode) != CO_SDO_AB_NONE){
             return CO_SDOcli_endedWithServerAbort;
         }
 
-        /* set data size */
-        *pDataSize = SDO_C->SDO->ODF_arg.dataLength;
-
-        /* is SDO buffer too small */
-        if(SDO_C->SDO->ODF_arg.lastSegment == 0){
-            *pSDOabortCode = CO_SDO_AB_OUT_OF_MEM;    /* Out of memory */
-            return CO_SDOcli_endedWithServerAbort;
-        }
-
         return CO_SDOcli_ok_communicationEnd;
     }
 
@@ -909,6 +1172,11 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                         SDO_C->state = SDO_STATE_NOTDEFINED;
                         SDO_C->CANrxNew = false;
 
+                        /* server has finished, abort is not sent */
+                        *pSDOabortCode = CO_SDOclient_rxCommit(SDO_C, *pDataSize);
+                        if(*pSDOabortCode != CO_SDO_AB_NONE){
+                            return CO_SDOcli_endedWithClientAbort;
+                        }
                         return CO_SDOcli_ok_communicationEnd;
                     }
                     else{
@@ -938,8 +1206,18 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                     }
                     /* get size */
                     size = 7 - ((SDO_C->CANrxData[0]>>1)&0x07);
+                    /* write full window to the stream */
+                    if((SDO_C->stream != NULL) && ((SDO_C->bufferOffset + size) > SDO_C->bufferSize)){
+                        *pSDOabortCode = CO_SDOclient_rxCommit(SDO_C, SDO_C->streamOffset + SDO_C->bufferOffset);
+                        SDO_C->bufferOffset = 0;
+                        if(*pSDOabortCode != CO_SDO_AB_NONE){
+                            SDO_C->state = SDO_STATE_ABORT;
+                            break;
+                        }
+                    }
                     /* verify length */
-                    if((SDO_C->bufferOffset + size) > SDO_C->bufferSize){
+                    if(((SDO_C->bufferOffset + size) > SDO_C->bufferSize)
+                        || ((SDO_C->streamOffset + SDO_C->bufferOffset + size) > CO_SDOclient_rxCapacity(SDO_C))){
                         *pSDOabortCode = CO_SDO_AB_OUT_OF_MEM;    /* Out of memory */
                         SDO_C->state = SDO_STATE_ABORT;
                         break;
@@ -950,9 +1228,14 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                     SDO_C->bufferOffset += size;
                     /* If no more segments to be uploaded, finish communication */
                     if(SDO_C->CANrxData[0] & 0x01){
-                        *pDataSize = SDO_C->bufferOffset;
+                        *pDataSize = SDO_C->streamOffset + SDO_C->bufferOffset;
                         SDO_C->state = SDO_STATE_NOTDEFINED;
                         SDO_C->CANrxNew = false;
+                        /* server has finished, abort is not sent */
+                        *pSDOabortCode = CO_SDOclient_rxCommit(SDO_C, *pDataSize);
+                        if(*pSDOabortCode != CO_SDO_AB_NONE){
+                            return CO_SDOcli_endedWithClientAbort;
+                        }
                         return CO_SDOcli_ok_communicationEnd;
                     }
                     /* set state */
@@ -998,12 +1281,14 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                     }
 
                     /*  check available buffer size */
-                    if (SDO_C->dataSize > SDO_C->bufferSize){
+                    if (SDO_C->dataSize > CO_SDOclient_rxCapacity(SDO_C)){
                         *pSDOabortCode = CO_SDO_AB_OUT_OF_MEM;
                         SDO_C->state = SDO_STATE_ABORT;
                     }
 
                     SDO_C->dataSizeTransfered =0;
+                    SDO_C->crc = 0;
+                    SDO_C->crcOffset = 0;
                 }
                 else if (SCS == SCS_UPLOAD_INITIATE){ /*  switch to regular segmented transfer */
                     if(SDO_C->CANrxData[0] & 0x02){
@@ -1021,6 +1306,11 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                         SDO_C->state = SDO_STATE_NOTDEFINED;
                         SDO_C->CANrxNew = false;
 
+                        /* server has finished, abort is not sent */
+                        *pSDOabortCode = CO_SDOclient_rxCommit(SDO_C, *pDataSize);
+                        if(*pSDOabortCode != CO_SDO_AB_NONE){
+                            return CO_SDOcli_endedWithClientAbort;
+                        }
                         return CO_SDOcli_ok_communicationEnd;
                     }
                     else{
@@ -1059,12 +1349,15 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                 }
                 else {
                     /* Is SDO buffer overflow? */
-                    if(SDO_C->dataSizeTransfered >= SDO_C->bufferSize) {
+                    if(SDO_C->dataSizeTransfered >= CO_SDOclient_rxCapacity(SDO_C)) {
                         *pSDOabortCode = CO_SDO_AB_OUT_OF_MEM;
                         SDO_C->state = SDO_STATE_ABORT;
                     }
                     else {
-                        SDO_C->state = SDO_STATE_BLOCKUPLOAD_BLOCK_ACK;
+                        /* received data are final, write them to the stream */
+                        *pSDOabortCode = CO_SDOclient_rxCommit(SDO_C, SDO_C->dataSizeTransfered);
+                        SDO_C->state = (*pSDOabortCode == CO_SDO_AB_NONE) ?
+                                       SDO_STATE_BLOCKUPLOAD_BLOCK_ACK : SDO_STATE_ABORT;
                     }
                 }
                 break;
@@ -1076,11 +1369,22 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                     SDO_C->dataSizeTransfered -= tmp32;
 
                     SDO_C->state = SDO_STATE_BLOCKUPLOAD_BLOCK_END;
-                    if (SDO_C->crcEnabled){
+                    if (SDO_C->dataSizeTransfered > CO_SDOclient_rxCapacity(SDO_C)){
+                        *pSDOabortCode = CO_SDO_AB_OUT_OF_MEM;
+                    }
+                    else{
+                        /* rest of data, CRC is calculated over all data */
+                        *pSDOabortCode = CO_SDOclient_rxCommit(SDO_C, SDO_C->dataSizeTransfered);
+                    }
+
+                    if (*pSDOabortCode != CO_SDO_AB_NONE){
+                        SDO_C->state = SDO_STATE_ABORT;
+                    }
+                    else if (SDO_C->crcEnabled){
                         uint16_t tmp16;
                         CO_memcpySwap2(&tmp16, &SDO_C->CANrxData[1]);
 
-                        if (tmp16 != crc16_ccitt((unsigned char *)SDO_C->buffer, (unsigned int)SDO_C->dataSizeTransfered, 0)){
+                        if (tmp16 != SDO_C->crc){
                             *pSDOabortCode = CO_SDO_AB_CRC;
                             SDO_C->state = SDO_STATE_ABORT;
                         }
@@ -1120,8 +1424,17 @@ CO_SDOclient_return_t CO_SDOclientUpload(
         CO_SDOclient_abort(SDO_C, *pSDOabortCode);
         return CO_SDOcli_endedWithTimeout;
     }
-    if(SDO_C->timeoutTimerBLOCK >= (SDOtimeoutTime/2)){ /*  block TMO */
-        SDO_C->state = SDO_STATE_BLOCKUPLOAD_BLOCK_ACK;
+    if((SDO_C->timeoutTimerBLOCK >= (SDOtimeoutTime/2)) && (SDO_C->state == SDO_STATE_BLOCKUPLOAD_INPROGRES)){ /*  block TMO */
+        /* last segment(s) of the block were lost, received data are final,
+         * same as in SDO_STATE_BLOCKUPLOAD_SUB_END */
+        if(SDO_C->dataSizeTransfered >= CO_SDOclient_rxCapacity(SDO_C)) {
+            *pSDOabortCode = CO_SDO_AB_OUT_OF_MEM;
+        }
+        else {
+            *pSDOabortCode = CO_SDOclient_rxCommit(SDO_C, SDO_C->dataSizeTransfered);
+        }
+        SDO_C->state = (*pSDOabortCode == CO_SDO_AB_NONE) ?
+                       SDO_STATE_BLOCKUPLOAD_BLOCK_ACK : SDO_STATE_ABORT;
     }
 
 
@@ -1182,6 +1495,7 @@ CO_SDOclient_return_t CO_SDOclientUpload(
             /*  header */
             SDO_C->CANtxBuff->data[0] = (CCS_UPLOAD_BLOCK<<5) | 0x02;
             SDO_C->CANtxBuff->data[1] = SDO_C->block_seqno;
+            CO_SDOclient_adaptBlockSize(SDO_C, SDO_C->block_seqno, SDO_C->block_blksize);
 
             /*  set next block size */
             if (SDO_C->dataSize != 0){
@@ -1191,8 +1505,8 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                 }
                 else{
                     tmp32 = ((SDO_C->dataSize - SDO_C->dataSizeTransfered) / 7);
-                    if(tmp32 >= SDO_C->block_size_max){
-                        SDO_C->block_blksize = SDO_C->block_size_max;
+                    if(tmp32 >= SDO_C->block_size_cur){
+                        SDO_C->block_blksize = SDO_C->block_size_cur;
                     }
                     else{
                         if((SDO_C->dataSize - SDO_C->dataSizeTransfered) % 7 == 0)
@@ -1206,11 +1520,19 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                 }
             }
             else{
+                SDO_C->block_blksize = SDO_C->block_size_cur;
                 SDO_C->block_seqno = 0;
                 SDO_C->timeoutTimerBLOCK = 0;
 
                 SDO_C->state = SDO_STATE_BLOCKUPLOAD_INPROGRES;
             }
+            /* next block must fit into the free space of the window */
+            if((SDO_C->stream != NULL) && (SDO_C->block_blksize != 0U)){
+                tmp32 = (SDO_C->bufferSize - (SDO_C->dataSizeTransfered - SDO_C->streamOffset)) / 7U;
+                if(SDO_C->block_blksize > tmp32){
+                    SDO_C->block_blksize = (uint8_t)tmp32;
+                }
+            }
             SDO_C->CANtxBuff->data[2] = SDO_C->block_blksize;
             CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff);
 
@@ -1245,6 +1567,9 @@ CO_SDOclient_return_t CO_SDOclientUpload(
 /******************************************************************************/
 void CO_SDOclientClose(CO_SDOclient_t *SDO_C){
     if(SDO_C != NULL) {
+        if(SDO_C->state == SDO_STATE_LOCAL_PENDING){
+            CO_SDO_localCancel(SDO_C->SDO);
+        }
         SDO_C->state = SDO_STATE_NOTDEFINED;
     }
 }
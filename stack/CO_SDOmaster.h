@@ -119,10 +119,12 @@ typedef struct{
     CO_SDO_t           *SDO;
     /** Internal state of the SDO client */
     uint8_t             state;
-    /** Pointer to data buffer supplied by user */
+    /** Pointer to data buffer supplied by user. If stream callbacks are used,
+    it is window into the stream. */
     uint8_t            *buffer;
-    /** By download application indicates data size in buffer.
-    By upload application indicates buffer size */
+    /** By download application indicates data size in buffer (size of the
+    stream, if stream callbacks are used). By upload application indicates
+    buffer size */
     uint32_t            bufferSize;
     /** Offset in buffer of next data segment being read/written */
     uint32_t            bufferOffset;
@@ -165,6 +167,13 @@ typedef struct{
     /** Maximum number of segments in one block. Set in CO_SDOclient_init(). Can
     be changed by application to 2 .. 127. */
     uint8_t             block_size_max;
+    /** Block size requested from the server by block upload, 2 .. block_size_max.
+    It is halved after block with lost segments and increased after each
+    complete block. (By block download block size is determined by the server.)
+    Set to block_size_max in CO_SDOclient_init(). */
+    uint8_t             block_size_cur;
+    /** Number of segments, which were repeated in block transfers, statistics */
+    uint32_t            block_segmentsRepeated;
     /** Last sector number */
     uint8_t             block_seqno;
     /** Block size in current transfer */
@@ -177,7 +186,19 @@ typedef struct{
     uint32_t            COB_IDClientToServerPrev;
     /** Previous value of the COB_IDServerToClient */
     uint32_t            COB_IDServerToClientPrev;
-
+    /** Stream with callbacks of the current transfer or NULL, see
+    CO_SDOclientDownloadInitiateStream() */
+    CO_SDO_stream_t    *stream;
+    /** Position of buffer[0] in the stream, 0 if stream is not used */
+    uint32_t            streamOffset;
+    /** By download with stream number of valid bytes in buffer */
+    uint16_t            streamLength;
+    /** By download with stream size of buffer */
+    uint16_t            windowSize;
+    /** CRC of the data in block transfer, calculated incrementally */
+    uint16_t            crc;
+    /** Number of data bytes included in crc */
+    uint32_t            crcOffset;
 }CO_SDOclient_t;
 
 
@@ -236,7 +257,11 @@ void CO_SDOclient_initCallback(
  * nodeIDOfTheSDOServer is used with default COB-ID.
  * @param nodeIDOfTheSDOServer Node-ID of the SDO server. If zero, SDO client
  * object is not used. If it is the same as node-ID of this node, then data will
- * be exchanged with this node (without CAN communication).
+ * be exchanged with this node (without CAN communication). Transfer is then
+ * usually completed with the first call to CO_SDOclientDownload() or
+ * CO_SDOclientUpload(), see CO_SDO_localDownload(). If own SDO server is busy
+ * or Object dictionary function completes the download later, functions
+ * return CO_SDOcli_waitingServerResponse and SDOtimeoutTime applies.
  *
  * @return #CO_SDOclient_return_t
  */
@@ -275,6 +300,44 @@ CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
         uint8_t                 blockEnable);
 
 
+/**
+ * Initiate SDO download communication from a stream.
+ *
+ * Same as CO_SDOclientDownloadInitiate(), but data are read from the stream
+ * on demand, so data of any size are transferred with constant memory.
+ *
+ * If stream is memory (stream->data is not NULL), data are sent directly from
+ * it, window is not used. For example, file may be mapped into memory with
+ * mmap(), see CO_Linux_streamOpenRead(). Otherwise stream->read() is called
+ * from CO_SDOclientDownload() to refill the window. It may be called more
+ * than once for the same position, if block segments are repeated.
+ * stream->size must specify the size of the data.
+ *
+ * Access to the Object Dictionary of the own node (nodeIDOfTheSDOServer is
+ * own node-ID) is only possible with memory stream.
+ *
+ * @param SDO_C This object.
+ * @param index Index of object in object dictionary in remote node.
+ * @param subIndex Subindex of object in object dictionary in remote node.
+ * @param stream Source of data, must be valid until end of communication.
+ * @param window Buffer for data from stream->read(), may be NULL with memory
+ * stream.
+ * @param windowSize Size of the window, at least 7 bytes. It is read at once
+ * from the stream.
+ * @param blockEnable Try to initiate block transfer.
+ *
+ * @return #CO_SDOclient_return_t
+ */
+CO_SDOclient_return_t CO_SDOclientDownloadInitiateStream(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        CO_SDO_stream_t        *stream,
+        uint8_t                *window,
+        uint16_t                windowSize,
+        uint8_t                 blockEnable);
+
+
 /**
  * Process SDO download communication.
  *
@@ -282,6 +345,12 @@ CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
  * download communication initiated with CO_SDOclientDownloadInitiate().
  * Function is non-blocking.
  *
+ * During block download function sends segments of the block, until CAN
+ * transmit buffer is full or block is finished. If CO_CANsend() fails, segment
+ * is sent again in next call.
+ * While it returns CO_SDOcli_blockDownldInProgress, it should be called again
+ * without delay.
+ *
  * @param SDO_C This object.
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
  * @param SDOtimeoutTime Timeout time for SDO communication in milliseconds.
@@ -325,6 +394,45 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
         uint8_t                 blockEnable);
 
 
+/**
+ * Initiate SDO upload communication into a stream.
+ *
+ * Same as CO_SDOclientUploadInitiate(), but received data are written into
+ * the stream, so data of any size are transferred with constant memory.
+ *
+ * If stream is memory (stream->data is not NULL), data are received directly
+ * into it and stream->size is its size. Otherwise data are collected in the
+ * window and written with stream->write() from CO_SDOclientUpload(), when
+ * the window is full, after each block and at the end. stream->size is then
+ * maximum length of the data, 0 if not limited. By block upload number of
+ * segments in the block is limited to windowSize / 7, so window of 889 bytes
+ * allows maximum block size.
+ *
+ * Access to the Object Dictionary of the own node (nodeIDOfTheSDOServer is
+ * own node-ID) is only possible with memory stream.
+ *
+ * @param SDO_C This object.
+ * @param index Index of object in object dictionary in remote node.
+ * @param subIndex Subindex of object in object dictionary in remote node.
+ * @param stream Sink for data, must be valid until end of communication.
+ * @param window Buffer for data for stream->write(), may be NULL with memory
+ * stream.
+ * @param windowSize Size of the window, at least 7 bytes (14 with block
+ * transfer).
+ * @param blockEnable Try to initiate block transfer.
+ *
+ * @return #CO_SDOclient_return_t
+ */
+CO_SDOclient_return_t CO_SDOclientUploadInitiateStream(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        CO_SDO_stream_t        *stream,
+        uint8_t                *window,
+        uint16_t                windowSize,
+        uint8_t                 blockEnable);
+
+
 /**
  * Process SDO upload communication.
  *
@@ -336,7 +444,8 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
  * @param SDOtimeoutTime Timeout time for SDO communication in milliseconds.
  * @param pDataSize pointer to external variable, where size of received
- * data will be written.
+ * data will be written. With stream it is total size of data written to the
+ * stream.
  * @param pSDOabortCode Pointer to external variable written by this function
  * in case of error in communication.
  *
@@ -356,6 +465,8 @@ CO_SDOclient_return_t CO_SDOclientUpload(
  * Function must be called after finish of each SDO client communication cycle.
  * It disables reception of SDO client CAN messages. It is necessary, because
  * CO_SDOclient_receive function may otherwise write into undefined SDO buffer.
+ * Unfinished download to own Object dictionary is cancelled, see
+ * CO_SDO_localCancel().
  */
 void CO_SDOclientClose(CO_SDOclient_t *SDO_C);
 
@@ -0,0 +1,241 @@
+/*
+ * Flash memory simulator for CO_KVstore.
+ *
+ * @file        CO_flashSim.c
+ * @ingroup     CO_KVstore
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_flashSim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Mirror changed area into the file */
+static CO_ReturnError_t simSync(CO_flashSim_t *sim, uint32_t address, uint32_t length) {
+    if(sim->fp != NULL) {
+        if(fseek(sim->fp, (long)address, SEEK_SET) != 0
+            || fwrite(&sim->mem[address], 1, length, sim->fp) != length
+            || fflush(sim->fp) != 0)
+        {
+            return CO_ERROR_DATA_CORRUPT;
+        }
+    }
+    return CO_ERROR_NO;
+}
+
+
+/* Returns true, if power is lost before or during this operation */
+static bool_t simPowerLoss(CO_flashSim_t *sim, bool_t *interrupted) {
+    *interrupted = false;
+    if(sim->powerLost) {
+        return true;
+    }
+    if(sim->failAfter == 0) {
+        sim->powerLost = true;
+        sim->failAfter = -1;
+        *interrupted = true;
+    }
+    else if(sim->failAfter > 0) {
+        sim->failAfter--;
+    }
+    return false;
+}
+
+
+static CO_ReturnError_t simRead(void *object, uint32_t address, void *buf, uint32_t length) {
+    CO_flashSim_t *sim = (CO_flashSim_t *)object;
+
+    if(sim->powerLost || address > sim->size || length > (sim->size - address)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    memcpy(buf, &sim->mem[address], length);
+    sim->reads++;
+
+    return CO_ERROR_NO;
+}
+
+
+static CO_ReturnError_t simWrite(void *object, uint32_t address, const void *buf, uint32_t length) {
+    CO_flashSim_t *sim = (CO_flashSim_t *)object;
+    const uint8_t *data = (const uint8_t *)buf;
+    bool_t interrupted;
+    uint32_t i;
+
+    if(address > sim->size || length > (sim->size - address)
+        || (address % sim->flash.writeSize) != 0U || (length % sim->flash.writeSize) != 0U)
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if(simPowerLoss(sim, &interrupted)) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    /* bits can only be cleared */
+    for(i=0; i<length; i++) {
+        if((sim->mem[address + i] & data[i]) != data[i]) {
+            return CO_ERROR_DATA_CORRUPT;
+        }
+    }
+
+    /* interrupted write programs only the first half */
+    if(interrupted) {
+        length /= 2U;
+    }
+    for(i=0; i<length; i++) {
+        sim->mem[address + i] &= data[i];
+    }
+    sim->writes++;
+    sim->bytesWritten += length;
+
+    if(simSync(sim, address, length) != CO_ERROR_NO || interrupted) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    return CO_ERROR_NO;
+}
+
+
+static CO_ReturnError_t simErase(void *object, uint16_t sector) {
+    CO_flashSim_t *sim = (CO_flashSim_t *)object;
+    uint32_t address = sector * sim->flash.sectorSize;
+    uint32_t length = sim->flash.sectorSize;
+    bool_t interrupted;
+
+    if(sector >= sim->flash.sectorCount) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if(simPowerLoss(sim, &interrupted)) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    /* interrupted erase erases only the second half */
+    if(interrupted) {
+        length /= 2U;
+        address += length;
+    }
+    memset(&sim->mem[address], 0xFF, length);
+    sim->erases++;
+    sim->eraseCount[sector]++;
+
+    if(simSync(sim, address, length) != CO_ERROR_NO || interrupted) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_flashSim_init(
+        CO_flashSim_t          *sim,
+        uint32_t                sectorSize,
+        uint16_t                sectorCount,
+        uint8_t                 writeSize,
+        const char             *fileName)
+{
+    /* verify arguments */
+    if(sim==NULL || sectorSize==0U || sectorCount==0U || writeSize==0U
+        || (sectorSize % writeSize) != 0U)
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* configure object variables */
+    memset(sim, 0, sizeof(CO_flashSim_t));
+    sim->flash.object = sim;
+    sim->flash.sectorSize = sectorSize;
+    sim->flash.sectorCount = sectorCount;
+    sim->flash.writeSize = writeSize;
+    sim->flash.read = simRead;
+    sim->flash.write = simWrite;
+    sim->flash.erase = simErase;
+    sim->size = sectorSize * sectorCount;
+    sim->failAfter = -1;
+
+    sim->mem = (uint8_t *)malloc(sim->size);
+    sim->eraseCount = (uint32_t *)calloc(sectorCount, sizeof(uint32_t));
+    if(sim->mem == NULL || sim->eraseCount == NULL) {
+        CO_flashSim_close(sim);
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    memset(sim->mem, 0xFF, sim->size);
+
+    /* load contents from the file or create erased file */
+    if(fileName != NULL) {
+        sim->fp = fopen(fileName, "r+b");
+        if(sim->fp == NULL || fread(sim->mem, 1, sim->size, sim->fp) != sim->size) {
+            memset(sim->mem, 0xFF, sim->size);
+            if(sim->fp != NULL) {
+                fclose(sim->fp);
+            }
+            sim->fp = fopen(fileName, "w+b");
+            if(sim->fp == NULL || simSync(sim, 0, sim->size) != CO_ERROR_NO) {
+                CO_flashSim_close(sim);
+                return CO_ERROR_ILLEGAL_ARGUMENT;
+            }
+        }
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_flashSim_close(CO_flashSim_t *sim) {
+    if(sim->fp != NULL) {
+        fclose(sim->fp);
+        sim->fp = NULL;
+    }
+    free(sim->mem);
+    free(sim->eraseCount);
+    sim->mem = NULL;
+    sim->eraseCount = NULL;
+}
+
+
+/******************************************************************************/
+void CO_flashSim_powerLoss(CO_flashSim_t *sim, int32_t afterOps) {
+    sim->failAfter = afterOps;
+}
+
+
+/******************************************************************************/
+void CO_flashSim_powerCycle(CO_flashSim_t *sim) {
+    sim->powerLost = false;
+}
@@ -0,0 +1,142 @@
+/**
+ * Flash memory simulator for CO_KVstore.
+ *
+ * @file        CO_flashSim.h
+ * @ingroup     CO_KVstore
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_FLASH_SIM_H
+#define CO_FLASH_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "CO_driver.h"
+#include "CO_KVstore.h"
+#include <stdio.h>
+
+
+/**
+ * @addtogroup CO_KVstore
+ * @{
+ *
+ * Flash simulator keeps flash contents in RAM and optionally mirrors them
+ * into a file, so contents survive program restart. It implements NOR
+ * semantics strictly: write, which would set a programmed bit back to 1,
+ * fails. It counts operations and erases of each sector. Power loss can be
+ * scheduled after given number of write or erase operations: that operation
+ * is only half done and all further operations fail until
+ * CO_flashSim_powerCycle().
+ */
+
+
+/**
+ * Flash simulator object.
+ */
+typedef struct {
+    CO_flash_t          flash;          /**< Interface for CO_KVstore_init() */
+    uint8_t            *mem;            /**< Flash contents */
+    uint32_t            size;           /**< Size of flash in bytes */
+    uint32_t           *eraseCount;     /**< Number of erases for each sector */
+    FILE               *fp;             /**< File, if flash is file backed */
+    uint32_t            reads;          /**< Number of read operations */
+    uint32_t            writes;         /**< Number of write operations */
+    uint32_t            erases;         /**< Number of erase operations */
+    uint32_t            bytesWritten;   /**< Number of written bytes */
+    /** Number of write and erase operations until power loss, -1 if disabled */
+    int32_t             failAfter;
+    bool_t              powerLost;      /**< True after power loss */
+} CO_flashSim_t;
+
+
+/**
+ * Initialize flash simulator.
+ *
+ * @param sim This object will be initialized.
+ * @param sectorSize Size of the sector in bytes.
+ * @param sectorCount Number of sectors.
+ * @param writeSize Program unit, 1, 2, 4 or 8 bytes.
+ * @param fileName File for flash contents or NULL for RAM only. If file
+ * exists and has correct size, contents are loaded from it, otherwise flash
+ * is erased.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_OUT_OF_MEMORY.
+ */
+CO_ReturnError_t CO_flashSim_init(
+        CO_flashSim_t          *sim,
+        uint32_t                sectorSize,
+        uint16_t                sectorCount,
+        uint8_t                 writeSize,
+        const char             *fileName);
+
+
+/**
+ * Close file and free memory.
+ *
+ * @param sim Flash simulator object.
+ */
+void CO_flashSim_close(CO_flashSim_t *sim);
+
+
+/**
+ * Schedule power loss.
+ *
+ * @param sim Flash simulator object.
+ * @param afterOps Number of successful write or erase operations before the
+ * interrupted one, -1 to disable.
+ */
+void CO_flashSim_powerLoss(CO_flashSim_t *sim, int32_t afterOps);
+
+
+/**
+ * Restore power after power loss. Flash contents are retained.
+ *
+ * @param sim Flash simulator object.
+ */
+void CO_flashSim_powerCycle(CO_flashSim_t *sim);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -0,0 +1,815 @@
+/*
+ * CANopen ASCII gateway, CiA 309-3.
+ *
+ * @file        CO_gateway_ascii.c
+ * @ingroup     CO_gateway_ascii
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_Emergency.h"
+#include "CO_NMT_Heartbeat.h"
+#include "CO_gateway_ascii.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Size of the response, worst case is string or hex data */
+#define CO_GWA_RESPONSE_SIZE    (CO_GW_ASCII_DATA_SIZE * 2U + 32U)
+
+/* Kinds of datatypes */
+#define CO_GWA_UNSIGNED         0U
+#define CO_GWA_SIGNED           1U
+#define CO_GWA_REAL             2U
+#define CO_GWA_STRING           3U
+#define CO_GWA_HEX              4U
+
+/* Datatypes, size is 0 for variable length */
+static const struct{
+    const char         *name;
+    uint8_t             size;
+    uint8_t             kind;
+}CO_GWA_types[] = {
+    {"b",   1U, CO_GWA_UNSIGNED},
+    {"u8",  1U, CO_GWA_UNSIGNED},
+    {"u16", 2U, CO_GWA_UNSIGNED},
+    {"u32", 4U, CO_GWA_UNSIGNED},
+    {"u64", 8U, CO_GWA_UNSIGNED},
+    {"i8",  1U, CO_GWA_SIGNED},
+    {"i16", 2U, CO_GWA_SIGNED},
+    {"i32", 4U, CO_GWA_SIGNED},
+    {"i64", 8U, CO_GWA_SIGNED},
+    {"r32", 4U, CO_GWA_REAL},
+    {"r64", 8U, CO_GWA_REAL},
+    {"vs",  0U, CO_GWA_STRING},
+    {"os",  0U, CO_GWA_HEX},
+    {"d",   0U, CO_GWA_HEX}
+};
+
+#define CO_GWA_NO_TYPES         (sizeof(CO_GWA_types) / sizeof(CO_GWA_types[0]))
+#define CO_GWA_BOOLEAN          0U      /* index of "b" */
+
+
+/*
+ * Helper functions for text.
+ */
+/* Get next token separated by spaces and terminate it. Return NULL, if none. */
+static char *CO_GWA_token(char **pos){
+    char *tok = *pos;
+
+    while(*tok == ' ' || *tok == '\t'){
+        tok++;
+    }
+    if(*tok == '\0'){
+        *pos = tok;
+        return NULL;
+    }
+
+    *pos = tok;
+    while(**pos != '\0' && **pos != ' ' && **pos != '\t'){
+        (*pos)++;
+    }
+    if(**pos != '\0'){
+        *(*pos)++ = '\0';
+    }
+
+    return tok;
+}
+
+/* Convert the whole token to number, decimal or with 0x prefix. */
+static bool_t CO_GWA_number(const char *tok, uint32_t max, uint32_t *value){
+    char *end;
+    unsigned long v;
+
+    if(tok == NULL || *tok < '0' || *tok > '9'){
+        return false;
+    }
+    errno = 0;
+    v = strtoul(tok, &end, 0);
+    if(*end != '\0' || errno == ERANGE || v > max){
+        return false;
+    }
+    *value = (uint32_t)v;
+
+    return true;
+}
+
+/* Compare command with its full name, which may be abbreviated to min chars. */
+static bool_t CO_GWA_is(const char *tok, const char *name, size_t min){
+    size_t len = strlen(tok);
+
+    return (len >= min && strncmp(tok, name, len) == 0) ? true : false;
+}
+
+/* Value of hex digit or -1. */
+static int CO_GWA_hexDigit(char c){
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+
+/*
+ * Convert value from text into CANopen data (little endian). Return size of
+ * data or -1 on error.
+ */
+static int32_t CO_GWA_encode(uint8_t type, char *text, uint8_t *data){
+    uint8_t size = CO_GWA_types[type].size;
+    uint64_t u = 0U;
+    char *end = NULL;
+    char *tok;
+    uint32_t len = 0U;
+    uint8_t i;
+
+    /* string may contain spaces */
+    if(CO_GWA_types[type].kind == CO_GWA_STRING){
+        while(*text == ' ' || *text == '\t'){
+            text++;
+        }
+        if(*text == '"'){
+            /* quoted, "" is a quote */
+            text++;
+            for(;;){
+                if(*text == '\0'){
+                    return -1;
+                }
+                if(*text == '"'){
+                    if(text[1] != '"'){
+                        break;
+                    }
+                    text++;
+                }
+                if(len >= CO_GW_ASCII_DATA_SIZE){
+                    return -1;
+                }
+                data[len++] = (uint8_t)*text++;
+            }
+            text++;
+            if(CO_GWA_token(&text) != NULL){
+                return -1;
+            }
+        }
+        else{
+            len = (uint32_t)strlen(text);
+            while(len > 0U && (text[len - 1U] == ' ' || text[len - 1U] == '\t')){
+                len--;
+            }
+            if(len > CO_GW_ASCII_DATA_SIZE){
+                return -1;
+            }
+            memcpy(data, text, len);
+        }
+        return (int32_t)len;
+    }
+
+    tok = CO_GWA_token(&text);
+    if(tok == NULL || CO_GWA_token(&text) != NULL){
+        return -1;
+    }
+
+    switch(CO_GWA_types[type].kind){
+        case CO_GWA_UNSIGNED:
+            if(*tok == '-'){
+                return -1;
+            }
+            errno = 0;
+            u = strtoull(tok, &end, 0);
+            /* strtoull() saturates, so out of range value is only in errno */
+            if(errno == ERANGE){
+                return -1;
+            }
+            if(size < 8U && (u >> (size * 8U)) != 0U){
+                return -1;
+            }
+            if(type == CO_GWA_BOOLEAN && u > 1U){
+                return -1;
+            }
+            break;
+
+        case CO_GWA_SIGNED:{
+            int64_t s;
+            errno = 0;
+            s = strtoll(tok, &end, 0);
+            if(errno == ERANGE){
+                return -1;
+            }
+            if(size < 8U){
+                int64_t lim = (int64_t)1 << (size * 8U - 1U);
+                if(s < -lim || s >= lim){
+                    return -1;
+                }
+            }
+            u = (uint64_t)s;
+            break;
+        }
+
+        case CO_GWA_REAL:
+            if(size == 4U){
+                float f = strtof(tok, &end);
+                uint32_t u32;
+                memcpy(&u32, &f, sizeof(u32));
+                u = u32;
+            }
+            else{
+                double d = strtod(tok, &end);
+                memcpy(&u, &d, sizeof(u));
+            }
+            break;
+
+        default:
+            /* hex digits */
+            while(*tok != '\0'){
+                int hi = CO_GWA_hexDigit(tok[0]);
+                int lo = (hi < 0) ? -1 : CO_GWA_hexDigit(tok[1]);
+                if(lo < 0 || len >= CO_GW_ASCII_DATA_SIZE){
+                    return -1;
+                }
+                data[len++] = (uint8_t)((hi << 4) | lo);
+                tok += 2;
+            }
+            return (int32_t)len;
+    }
+
+    if(end == tok || *end != '\0'){
+        return -1;
+    }
+    for(i = 0U; i < size; i++){
+        data[i] = (uint8_t)(u >> (i * 8U));
+    }
+
+    return size;
+}
+
+
+/*
+ * Convert CANopen data into text. Return length of text or -1, if data size
+ * does not match datatype.
+ */
+static int CO_GWA_decode(uint8_t type, const uint8_t *data, uint32_t size, char *text){
+    uint8_t typeSize = CO_GWA_types[type].size;
+    uint64_t u = 0U;
+    uint32_t i;
+    int len = 0;
+
+    if(typeSize != 0U){
+        if(size != typeSize){
+            return -1;
+        }
+        for(i = 0U; i < size; i++){
+            u |= (uint64_t)data[i] << (i * 8U);
+        }
+    }
+
+    switch(CO_GWA_types[type].kind){
+        case CO_GWA_UNSIGNED:
+            len = sprintf(text, "%llu", (unsigned long long)u);
+            break;
+
+        case CO_GWA_SIGNED:
+            /* sign extend */
+            if(typeSize < 8U && (u >> (typeSize * 8U - 1U)) != 0U){
+                u |= ~(uint64_t)0 << (typeSize * 8U);
+            }
+            len = sprintf(text, "%lld", (long long)u);
+            break;
+
+        case CO_GWA_REAL:
+            if(typeSize == 4U){
+                uint32_t u32 = (uint32_t)u;
+                float f;
+                memcpy(&f, &u32, sizeof(f));
+                len = sprintf(text, "%.9g", (double)f);
+            }
+            else{
+                double d;
+                memcpy(&d, &u, sizeof(d));
+                len = sprintf(text, "%.17g", d);
+            }
+            break;
+
+        case CO_GWA_STRING:
+            text[len++] = '"';
+            for(i = 0U; i < size && data[i] != 0U; i++){
+                if(data[i] == '"'){
+                    text[len++] = '"';
+                }
+                text[len++] = (char)data[i];
+            }
+            text[len++] = '"';
+            text[len] = '\0';
+            break;
+
+        default:
+            for(i = 0U; i < size; i++){
+                len += sprintf(&text[len], "%02x", data[i]);
+            }
+            text[len] = '\0';
+            break;
+    }
+
+    return len;
+}
+
+
+/*
+ * Responses.
+ */
+/* Write response with optional sequence. */
+static void CO_GWA_respond(CO_GWascii_t *gw, CO_GWconn_t *conn,
+        bool_t hasSequence, uint32_t sequence, const char *text)
+{
+    char resp[CO_GWA_RESPONSE_SIZE + 16U];
+    int len;
+
+    if(hasSequence){
+        len = sprintf(resp, "[%lu] %s\r\n", (unsigned long)sequence, text);
+    }
+    else{
+        len = sprintf(resp, "%s\r\n", text);
+    }
+    gw->pFunctWrite(conn->object, resp, (uint16_t)len);
+}
+
+/* Write error response. */
+static void CO_GWA_error(CO_GWascii_t *gw, CO_GWconn_t *conn,
+        bool_t hasSequence, uint32_t sequence, CO_GWascii_error_t error)
+{
+    char text[16];
+
+    sprintf(text, "ERROR: %d", (int)error);
+    CO_GWA_respond(gw, conn, hasSequence, sequence, text);
+}
+
+
+/* Called from CO_SDOengine_process(), when SDO transfer is finished. */
+static void CO_GWA_parse(CO_GWascii_t *gw, CO_GWconn_t *conn);
+
+static void CO_GWA_jobDone(CO_SDOjob_t *job){
+    CO_GWrequest_t *req = (CO_GWrequest_t *)job->object;
+    CO_GWascii_t *gw = req->gw;
+    uint16_t i;
+
+    /* connection may be closed meanwhile */
+    if(req->conn != NULL){
+        char text[CO_GWA_RESPONSE_SIZE];
+
+        if(job->result != CO_SDOcli_ok_communicationEnd){
+            if(job->abortCode != CO_SDO_AB_NONE){
+                sprintf(text, "ERROR: 0x%08lX", (unsigned long)job->abortCode);
+            }
+            else{
+                sprintf(text, "ERROR: %d", (int)CO_GWA_ERR_STATE);
+            }
+        }
+        else if(!job->upload){
+            strcpy(text, "OK");
+        }
+        else if(CO_GWA_decode(req->dataType, req->data, job->transferred, text) < 0){
+            sprintf(text, "ERROR: 0x%08lX", (unsigned long)CO_SDO_AB_TYPE_MISMATCH);
+        }
+        CO_GWA_respond(gw, req->conn, req->hasSequence, req->sequence, text);
+    }
+    req->conn = NULL;
+    req->busy = false;
+
+    /* continue with lines, which were waiting for the free request */
+    for(i = 0U; i < gw->noConns; i++){
+        CO_GWconn_t *conn = &gw->conns[i];
+
+        if(conn->open){
+            CO_GWA_parse(gw, conn);
+            if(conn->blocked && conn->lineLen < CO_GW_ASCII_LINE_SIZE){
+                conn->blocked = false;
+                if(gw->pFunctReady != NULL){
+                    gw->pFunctReady(conn->object);
+                }
+            }
+        }
+    }
+}
+
+
+/* Get free request or NULL. */
+static CO_GWrequest_t *CO_GWA_freeRequest(CO_GWascii_t *gw){
+    uint16_t i;
+
+    for(i = 0U; i < gw->noRequests; i++){
+        if(!gw->requests[i].busy){
+            return &gw->requests[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+/* Execute one line. */
+static void CO_GWA_command(CO_GWascii_t *gw, CO_GWconn_t *conn, char *line){
+    char *pos = line;
+    char *tok;
+    bool_t hasSequence = false;
+    uint32_t sequence = 0U;
+    uint32_t numbers[2];
+    uint8_t noNumbers = 0U;
+    uint32_t node;
+    uint32_t index, subIndex;
+    uint8_t type;
+    uint8_t command = 0U;
+    CO_GWascii_error_t err = CO_GWA_ERR_SYNTAX;
+
+    tok = CO_GWA_token(&pos);
+    if(tok == NULL){
+        return; /* empty line */
+    }
+
+    /* sequence */
+    if(tok[0] == '['){
+        size_t len = strlen(tok);
+
+        if(len < 3U || tok[len - 1U] != ']'){
+            CO_GWA_error(gw, conn, false, 0U, CO_GWA_ERR_SYNTAX);
+            return;
+        }
+        tok[len - 1U] = '\0';
+        if(!CO_GWA_number(&tok[1], 0xFFFFFFFFUL, &sequence)){
+            CO_GWA_error(gw, conn, false, 0U, CO_GWA_ERR_SYNTAX);
+            return;
+        }
+        hasSequence = true;
+        tok = CO_GWA_token(&pos);
+    }
+
+    /* optional net and node */
+    while(noNumbers < 2U && CO_GWA_number(tok, 0xFFFFFFFFUL, &numbers[noNumbers])){
+        noNumbers++;
+        tok = CO_GWA_token(&pos);
+    }
+    if(tok == NULL){
+        CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_SYNTAX);
+        return;
+    }
+    if(noNumbers == 2U && numbers[0] != 1U){
+        CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_NET);
+        return;
+    }
+    node = (noNumbers > 0U) ? numbers[noNumbers - 1U] : gw->defaultNode;
+
+    /* SDO read and write */
+    if(CO_GWA_is(tok, "read", 1U) || CO_GWA_is(tok, "write", 1U)){
+        bool_t upload = (tok[0] == 'r') ? true : false;
+        CO_GWrequest_t *req;
+        int32_t size = 0;
+
+        if(node == 0U){
+            CO_GWA_error(gw, conn, hasSequence, sequence,
+                         (noNumbers > 0U) ? CO_GWA_ERR_NODE : CO_GWA_ERR_NO_NODE);
+            return;
+        }
+        if(node > 127U){
+            CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_NODE);
+            return;
+        }
+        if(!CO_GWA_number(CO_GWA_token(&pos), 0xFFFFU, &index)
+            || !CO_GWA_number(CO_GWA_token(&pos), 0xFFU, &subIndex)
+            || (tok = CO_GWA_token(&pos)) == NULL)
+        {
+            CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_SYNTAX);
+            return;
+        }
+        for(type = 0U; type < CO_GWA_NO_TYPES; type++){
+            if(strcmp(tok, CO_GWA_types[type].name) == 0){
+                break;
+            }
+        }
+        if(type == CO_GWA_NO_TYPES || (upload && CO_GWA_token(&pos) != NULL)){
+            CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_SYNTAX);
+            return;
+        }
+
+        /* request is free, see CO_GWA_parse() */
+        req = CO_GWA_freeRequest(gw);
+        if(!upload){
+            size = CO_GWA_encode(type, pos, req->data);
+            if(size <= 0){
+                CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_SYNTAX);
+                return;
+            }
+        }
+
+        req->gw = gw;
+        req->conn = conn;
+        req->hasSequence = hasSequence;
+        req->sequence = sequence;
+        req->dataType = type;
+        req->job.nodeId = (uint8_t)node;
+        req->job.upload = upload;
+        req->job.blockEnable = false;
+        req->job.index = (uint16_t)index;
+        req->job.subIndex = (uint8_t)subIndex;
+        req->job.data = req->data;
+        req->job.dataSize = upload ? CO_GW_ASCII_DATA_SIZE : (uint32_t)size;
+        req->job.stream = NULL;
+        req->job.pFunct = CO_GWA_jobDone;
+        req->job.object = req;
+
+        if(CO_SDOengine_queue(gw->engine, &req->job) != CO_ERROR_NO){
+            req->conn = NULL;
+            CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_STATE);
+            return;
+        }
+        req->busy = true;
+        return;
+    }
+
+    /* NMT commands */
+    if(CO_GWA_is(tok, "start", 5U)){
+        command = CO_NMT_ENTER_OPERATIONAL;
+    }
+    else if(CO_GWA_is(tok, "stop", 4U)){
+        command = CO_NMT_ENTER_STOPPED;
+    }
+    else if(CO_GWA_is(tok, "preoperational", 5U)){
+        command = CO_NMT_ENTER_PRE_OPERATIONAL;
+    }
+    else if(CO_GWA_is(tok, "reset", 5U)){
+        tok = CO_GWA_token(&pos);
+        if(tok != NULL && CO_GWA_is(tok, "node", 4U)){
+            command = CO_NMT_RESET_NODE;
+        }
+        else if(tok != NULL && CO_GWA_is(tok, "communication", 4U)){
+            command = CO_NMT_RESET_COMMUNICATION;
+        }
+        else{
+            CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_SYNTAX);
+            return;
+        }
+    }
+
+    if(command != 0U){
+        if(CO_GWA_token(&pos) != NULL){
+            err = CO_GWA_ERR_SYNTAX;
+        }
+        else if(node > 127U){
+            err = CO_GWA_ERR_NODE;
+        }
+        else if(noNumbers == 0U && gw->defaultNode == 0U){
+            err = CO_GWA_ERR_NO_NODE;
+        }
+        else if(gw->pFunctNMT == NULL){
+            err = CO_GWA_ERR_NOT_SUPPORTED;
+        }
+        else if(gw->pFunctNMT(gw->NMTobject, command, (uint8_t)node) != 0U){
+            err = CO_GWA_ERR_STATE;
+        }
+        else{
+            CO_GWA_respond(gw, conn, hasSequence, sequence, "OK");
+            return;
+        }
+        CO_GWA_error(gw, conn, hasSequence, sequence, err);
+        return;
+    }
+
+    /* gateway settings */
+    if(CO_GWA_is(tok, "set", 3U) && noNumbers == 0U){
+        uint32_t value;
+
+        tok = CO_GWA_token(&pos);
+        if(tok == NULL || !CO_GWA_number(CO_GWA_token(&pos), 0xFFFFU, &value)
+            || CO_GWA_token(&pos) != NULL)
+        {
+            err = CO_GWA_ERR_SYNTAX;
+        }
+        else if(strcmp(tok, "network") == 0){
+            err = (value == 1U) ? 0 : CO_GWA_ERR_NET;
+        }
+        else if(strcmp(tok, "node") == 0){
+            err = (value >= 1U && value <= 127U) ? 0 : CO_GWA_ERR_NODE;
+            if(err == 0){
+                gw->defaultNode = (uint8_t)value;
+            }
+        }
+        else if(strcmp(tok, "sdo_timeout") == 0){
+            err = (value > 0U) ? 0 : CO_GWA_ERR_SYNTAX;
+            if(err == 0){
+                gw->engine->SDOtimeoutTime = (uint16_t)value;
+            }
+        }
+        else{
+            err = CO_GWA_ERR_NOT_SUPPORTED;
+        }
+
+        if(err == 0){
+            CO_GWA_respond(gw, conn, hasSequence, sequence, "OK");
+        }
+        else{
+            CO_GWA_error(gw, conn, hasSequence, sequence, err);
+        }
+        return;
+    }
+
+    CO_GWA_error(gw, conn, hasSequence, sequence, CO_GWA_ERR_NOT_SUPPORTED);
+}
+
+
+/*
+ * Execute complete lines from the connection buffer. Each line may need a
+ * request, so parsing stops, if all requests are busy.
+ */
+static void CO_GWA_parse(CO_GWascii_t *gw, CO_GWconn_t *conn){
+    char line[CO_GW_ASCII_LINE_SIZE + 1U];
+
+    for(;;){
+        char *end = (char *)memchr(conn->line, '\n', conn->lineLen);
+        uint16_t len;
+
+        if(end == NULL){
+            /* line too long, report error once and skip the rest of it */
+            if(conn->lineLen == CO_GW_ASCII_LINE_SIZE){
+                if(!conn->discard){
+                    CO_GWA_error(gw, conn, false, 0U, CO_GWA_ERR_SYNTAX);
+                    conn->discard = true;
+                }
+                conn->lineLen = 0U;
+            }
+            break;
+        }
+        if(!conn->discard && CO_GWA_freeRequest(gw) == NULL){
+            break;
+        }
+
+        /* take the line out of the buffer */
+        len = (uint16_t)(end - conn->line);
+        memcpy(line, conn->line, len);
+        line[len] = '\0';
+        if(len > 0U && line[len - 1U] == '\r'){
+            line[len - 1U] = '\0';
+        }
+        conn->lineLen -= len + 1U;
+        memmove(conn->line, end + 1, conn->lineLen);
+
+        if(conn->discard){
+            conn->discard = false;
+        }
+        else{
+            CO_GWA_command(gw, conn, line);
+        }
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_GWascii_init(
+        CO_GWascii_t           *gw,
+        CO_SDOengine_t         *engine,
+        CO_GWrequest_t          requests[],
+        uint16_t                noRequests,
+        CO_GWconn_t             conns[],
+        uint16_t                noConns,
+        uint8_t                 defaultNode,
+        uint8_t               (*pFunctNMT)(void *object, uint8_t command, uint8_t nodeId),
+        void                   *NMTobject,
+        void                  (*pFunctWrite)(void *object, const char *text, uint16_t length),
+        void                  (*pFunctReady)(void *object))
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(gw == NULL || engine == NULL || requests == NULL || noRequests == 0U
+        || conns == NULL || noConns == 0U || defaultNode > 127U || pFunctWrite == NULL)
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    gw->engine = engine;
+    gw->requests = requests;
+    gw->noRequests = noRequests;
+    gw->conns = conns;
+    gw->noConns = noConns;
+    gw->defaultNode = defaultNode;
+    gw->pFunctNMT = pFunctNMT;
+    gw->NMTobject = NMTobject;
+    gw->pFunctWrite = pFunctWrite;
+    gw->pFunctReady = pFunctReady;
+
+    for(i = 0U; i < noRequests; i++){
+        requests[i].gw = gw;
+        requests[i].conn = NULL;
+        requests[i].busy = false;
+    }
+    for(i = 0U; i < noConns; i++){
+        conns[i].object = NULL;
+        conns[i].lineLen = 0U;
+        conns[i].open = false;
+        conns[i].blocked = false;
+        conns[i].discard = false;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_GWconn_t *CO_GWascii_open(CO_GWascii_t *gw, void *object){
+    uint16_t i;
+
+    for(i = 0U; i < gw->noConns; i++){
+        CO_GWconn_t *conn = &gw->conns[i];
+
+        if(!conn->open){
+            conn->object = object;
+            conn->lineLen = 0U;
+            conn->open = true;
+            conn->blocked = false;
+            conn->discard = false;
+            return conn;
+        }
+    }
+
+    return NULL;
+}
+
+
+/******************************************************************************/
+void CO_GWascii_close(CO_GWascii_t *gw, CO_GWconn_t *conn){
+    uint16_t i;
+
+    /* requests stay busy in the engine, their responses are discarded */
+    for(i = 0U; i < gw->noRequests; i++){
+        if(gw->requests[i].conn == conn){
+            gw->requests[i].conn = NULL;
+        }
+    }
+    conn->open = false;
+}
+
+
+/******************************************************************************/
+uint16_t CO_GWascii_receive(
+        CO_GWascii_t           *gw,
+        CO_GWconn_t            *conn,
+        const char             *data,
+        uint16_t                length)
+{
+    uint16_t accepted = 0U;
+
+    while(accepted < length){
+        uint16_t len = length - accepted;
+        uint16_t space = CO_GW_ASCII_LINE_SIZE - conn->lineLen;
+
+        if(space == 0U){
+            conn->blocked = true;
+            break;
+        }
+        if(len > space){
+            len = space;
+        }
+        memcpy(&conn->line[conn->lineLen], &data[accepted], len);
+        conn->lineLen += len;
+        accepted += len;
+
+        CO_GWA_parse(gw, conn);
+    }
+
+    return accepted;
+}
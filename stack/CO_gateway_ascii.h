@@ -0,0 +1,268 @@
+/**
+ * CANopen ASCII gateway, CiA 309-3.
+ *
+ * @file        CO_gateway_ascii.h
+ * @ingroup     CO_gateway_ascii
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_GATEWAY_ASCII_H
+#define CO_GATEWAY_ASCII_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_SDOmaster.h"
+#include "CO_SDOengine.h"
+
+
+/**
+ * @defgroup CO_gateway_ascii ASCII gateway
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * CANopen gateway with ASCII command set, CiA 309-3.
+ *
+ * Gateway reads text commands from one or more connections (for example
+ * sockets), executes them and writes the responses back. Transport is
+ * provided by the application through callbacks, see CO_Linux_gateway.h for
+ * Unix domain sockets.
+ *
+ * SDO requests are queued as jobs into CO_SDOengine_t, so requests from all
+ * connections are executed in parallel for different nodes and in order for
+ * the same node. Connection may send next requests before the responses to
+ * the previous arrive. Response to the request contains its sequence number,
+ * so responses to requests for different nodes may arrive in different order.
+ * If all request objects are in use, received lines stay in the connection
+ * buffer. When the buffer is full, CO_GWascii_receive() accepts no more data
+ * until pFunctReady is called.
+ *
+ * Supported commands:
+ * ~~~{.txt}
+ * [<sequence>] [[<net>] <node>] r[ead] <index> <subindex> <datatype>
+ * [<sequence>] [[<net>] <node>] w[rite] <index> <subindex> <datatype> <value>
+ * [<sequence>] [[<net>] <node>] start
+ * [<sequence>] [[<net>] <node>] stop
+ * [<sequence>] [[<net>] <node>] preop[erational]
+ * [<sequence>] [[<net>] <node>] reset node
+ * [<sequence>] [[<net>] <node>] reset comm[unication]
+ * [<sequence>] set network <net>
+ * [<sequence>] set node <node>
+ * [<sequence>] set sdo_timeout <milliseconds>
+ * ~~~
+ *
+ * Sequence is a number in square brackets. Network must be 1. If node is not
+ * given, default node is used. Node 0 with NMT command addresses all nodes.
+ * Datatypes are b, u8, u16, u32, u64, i8, i16, i32, i64, r32, r64, vs
+ * (visible string, in double quotes, if it contains spaces), os (octet
+ * string) and d (domain). Octet string and domain are written as hex digits.
+ * Integers may be decimal or hexadecimal with 0x prefix.
+ *
+ * Responses are "[<sequence>] OK", "[<sequence>] <value>",
+ * "[<sequence>] ERROR: <SDO abort code>" (hexadecimal) or
+ * "[<sequence>] ERROR: <code>" with #CO_GWascii_error_t. Lines are terminated
+ * by CR LF.
+ */
+
+
+/** Size of the receive buffer of one connection, maximum length of the line. */
+#ifndef CO_GW_ASCII_LINE_SIZE
+    #define CO_GW_ASCII_LINE_SIZE   400U
+#endif
+
+/** Size of the data buffer of one request, maximum size of SDO data. */
+#ifndef CO_GW_ASCII_DATA_SIZE
+    #define CO_GW_ASCII_DATA_SIZE   127U
+#endif
+
+
+/**
+ * Error codes of the gateway, CiA 309-3.
+ */
+typedef enum{
+    CO_GWA_ERR_NOT_SUPPORTED        = 100,  /**< Request not supported */
+    CO_GWA_ERR_SYNTAX               = 101,  /**< Syntax error */
+    CO_GWA_ERR_STATE                = 102,  /**< Request not processed due to internal state */
+    CO_GWA_ERR_TIMEOUT              = 103,  /**< Time-out */
+    CO_GWA_ERR_NO_NET               = 104,  /**< No default net set */
+    CO_GWA_ERR_NO_NODE              = 105,  /**< No default node set */
+    CO_GWA_ERR_NET                  = 106,  /**< Unsupported net */
+    CO_GWA_ERR_NODE                 = 107   /**< Unsupported node */
+}CO_GWascii_error_t;
+
+
+struct CO_GWascii_t;
+
+
+/**
+ * Connection to the gateway.
+ */
+typedef struct{
+    /** Object passed to pFunctWrite and pFunctReady, from CO_GWascii_open() */
+    void               *object;
+    char                line[CO_GW_ASCII_LINE_SIZE]; /**< Received characters */
+    uint16_t            lineLen;        /**< Number of characters in line */
+    bool_t              open;           /**< Connection is in use */
+    bool_t              blocked;        /**< Received data was not accepted */
+    bool_t              discard;        /**< Skip characters of too long line */
+}CO_GWconn_t;
+
+
+/**
+ * Request, which waits for SDO transfer.
+ */
+typedef struct{
+    CO_SDOjob_t         job;            /**< SDO job, job.object points to this */
+    struct CO_GWascii_t *gw;            /**< Gateway */
+    CO_GWconn_t        *conn;           /**< Connection or NULL, if it was closed */
+    bool_t              busy;           /**< Request is in use */
+    bool_t              hasSequence;    /**< Sequence was given */
+    uint32_t            sequence;       /**< Sequence number */
+    uint8_t             dataType;       /**< Index in the table of datatypes */
+    uint8_t             data[CO_GW_ASCII_DATA_SIZE]; /**< SDO data */
+}CO_GWrequest_t;
+
+
+/**
+ * ASCII gateway object.
+ */
+typedef struct CO_GWascii_t{
+    CO_SDOengine_t     *engine;         /**< From CO_GWascii_init() */
+    CO_GWrequest_t     *requests;       /**< From CO_GWascii_init() */
+    uint16_t            noRequests;     /**< From CO_GWascii_init() */
+    CO_GWconn_t        *conns;          /**< From CO_GWascii_init() */
+    uint16_t            noConns;        /**< From CO_GWascii_init() */
+    uint8_t             defaultNode;    /**< Default node, 0 if not set */
+    /** From CO_GWascii_init() */
+    uint8_t           (*pFunctNMT)(void *object, uint8_t command, uint8_t nodeId);
+    void               *NMTobject;      /**< From CO_GWascii_init() */
+    /** From CO_GWascii_init() */
+    void              (*pFunctWrite)(void *object, const char *text, uint16_t length);
+    /** From CO_GWascii_init() */
+    void              (*pFunctReady)(void *object);
+}CO_GWascii_t;
+
+
+/**
+ * Initialize ASCII gateway.
+ *
+ * @param gw This object will be initialized.
+ * @param engine SDO client engine for SDO requests.
+ * @param requests Array of request objects, allocated by application. It
+ * limits the number of SDO requests in progress.
+ * @param noRequests Number of request objects.
+ * @param conns Array of connection objects, allocated by application.
+ * @param noConns Number of connection objects.
+ * @param defaultNode Default node-ID, 0 if not set.
+ * @param pFunctNMT Function, which sends NMT command, for example
+ * CO_sendNMTcommand(). Returns 0 on success. If NULL, NMT commands are not
+ * supported.
+ * @param NMTobject Object passed to pFunctNMT.
+ * @param pFunctWrite Function, which writes response to the connection.
+ * @param pFunctReady Function, which is called, when blocked connection can
+ * receive data again, see CO_GWascii_receive(). May be NULL.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_GWascii_init(
+        CO_GWascii_t           *gw,
+        CO_SDOengine_t         *engine,
+        CO_GWrequest_t          requests[],
+        uint16_t                noRequests,
+        CO_GWconn_t             conns[],
+        uint16_t                noConns,
+        uint8_t                 defaultNode,
+        uint8_t               (*pFunctNMT)(void *object, uint8_t command, uint8_t nodeId),
+        void                   *NMTobject,
+        void                  (*pFunctWrite)(void *object, const char *text, uint16_t length),
+        void                  (*pFunctReady)(void *object));
+
+
+/**
+ * Open new connection.
+ *
+ * @param gw This object.
+ * @param object Object passed to pFunctWrite and pFunctReady.
+ *
+ * @return Connection or NULL, if all are in use.
+ */
+CO_GWconn_t *CO_GWascii_open(CO_GWascii_t *gw, void *object);
+
+
+/**
+ * Close connection.
+ *
+ * Responses to the requests in progress are discarded.
+ *
+ * @param gw This object.
+ * @param conn Connection from CO_GWascii_open().
+ */
+void CO_GWascii_close(CO_GWascii_t *gw, CO_GWconn_t *conn);
+
+
+/**
+ * Process data received from the connection.
+ *
+ * Complete lines are executed. Responses are written with pFunctWrite, from
+ * this function or later from CO_SDOengine_process(). Function must be called
+ * from the same thread as CO_SDOengine_process().
+ *
+ * @param gw This object.
+ * @param conn Connection from CO_GWascii_open().
+ * @param data Received characters.
+ * @param length Number of characters.
+ *
+ * @return Number of accepted characters. If it is less than length,
+ * connection is blocked until pFunctReady is called.
+ */
+uint16_t CO_GWascii_receive(
+        CO_GWascii_t           *gw,
+        CO_GWconn_t            *conn,
+        const char             *data,
+        uint16_t                length);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
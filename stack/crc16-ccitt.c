@@ -47,6 +47,19 @@
 
 #include "crc16-ccitt.h"
 
+#if CO_CRC16_SLICES > 0
+    #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        #define CRC16_CLMUL_X86
+        #include <immintrin.h>
+    #elif defined(__GNUC__) && defined(__aarch64__) && defined(__linux__) \
+          && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+        #define CRC16_CLMUL_ARM
+        #include <arm_neon.h>
+        #include <sys/auxv.h>
+        #include <asm/hwcap.h>
+    #endif
+#endif
+
 
 /*
  * CRC table calculated by the following algorithm:
@@ -101,8 +114,13 @@ static const unsigned short crc16_ccitt_table[256] = {
 };
 
 
+
 /******************************************************************************/
+#if CO_CRC16_SLICES > 0
+unsigned short crc16_ccitt_bytewise(
+#else
 unsigned short crc16_ccitt(
+#endif
         const unsigned char     block[],
         unsigned int            blockLength,
         unsigned short          crc)
@@ -116,4 +134,309 @@ unsigned short crc16_ccitt(
     return crc;
 }
 
+
+#if CO_CRC16_SLICES > 0
+/*
+ * Tables for slicing-by-N. Table 0 is crc16_ccitt_table, table k gives CRC
+ * of byte followed by k zero bytes:
+ * crc16_ccitt_slice[k][i] = (crc16_ccitt_slice[k-1][i] << 8)
+ *                         ^ crc16_ccitt_table[crc16_ccitt_slice[k-1][i] >> 8]
+ */
+static unsigned short crc16_ccitt_slice[CO_CRC16_SLICES][256];
+
+/* Implementation used by crc16_ccitt(). */
+static unsigned short (*crc16_ccitt_fn)(const unsigned char block[],
+        unsigned int blockLength, unsigned short crc) = crc16_ccitt_bytewise;
+static const char *crc16_ccitt_name = "bytewise";
+static volatile int crc16_ccitt_initialized = 0;
+
+#if defined(CRC16_CLMUL_X86) || defined(CRC16_CLMUL_ARM)
+/* Constants for folding: x^n mod P, P = 0x11021. */
+static unsigned long long crc16_fold128[2];    /* x^192, x^128 */
+static unsigned long long crc16_fold512[2];    /* x^576, x^512 */
+static int crc16_clmulSupported = 0;
+
+static unsigned long long crc16_xnmodp(unsigned int n){
+    unsigned long r = 1U;
+
+    while(n-- > 0U){
+        r <<= 1;
+        if((r & 0x10000UL) != 0U){
+            r ^= 0x11021UL;
+        }
+    }
+    return r;
+}
+#endif
+
+
+/******************************************************************************/
+unsigned short crc16_ccitt_slicing(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc)
+{
+    const unsigned char *p = block;
+
+    while(blockLength >= CO_CRC16_SLICES){
+        unsigned int k;
+
+        /* CRC is combined with the first two bytes, each byte is then
+         * looked up in the table for its distance from the end. */
+        crc = crc16_ccitt_slice[CO_CRC16_SLICES - 1][p[0] ^ (crc >> 8)]
+            ^ crc16_ccitt_slice[CO_CRC16_SLICES - 2][p[1] ^ (crc & 0xFFU)];
+        for(k=2U; k<CO_CRC16_SLICES; k++){
+            crc ^= crc16_ccitt_slice[CO_CRC16_SLICES - 1U - k][p[k]];
+        }
+        p += CO_CRC16_SLICES;
+        blockLength -= CO_CRC16_SLICES;
+    }
+
+    return crc16_ccitt_bytewise(p, blockLength, crc);
+}
+
+
+#ifdef CRC16_CLMUL_X86
+/*
+ * CRC with carry-less multiplication. Data is processed in 16 byte blocks as
+ * 128 bit polynomials (bytes in big endian order). Accumulator is multiplied
+ * by x^128 (or x^512 with four parallel accumulators) modulo P and next block
+ * is added. Result is congruent to the data modulo P, so CRC of its 16 bytes
+ * equals CRC of all processed data.
+ */
+__attribute__((target("pclmul,ssse3")))
+static unsigned short crc16_ccitt_pclmul(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc)
+{
+    const __m128i bswap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i k128 = _mm_set_epi64x((long long)crc16_fold128[1], (long long)crc16_fold128[0]);
+    const __m128i k512 = _mm_set_epi64x((long long)crc16_fold512[1], (long long)crc16_fold512[0]);
+    const unsigned char *p = block;
+    unsigned char buf[16];
+    __m128i acc0;
+
+    if(blockLength < 32U){
+        return crc16_ccitt_slicing(block, blockLength, crc);
+    }
+
+    #define CRC16_LOAD(ptr)     _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(ptr)), bswap)
+    #define CRC16_FOLD(a, k)    _mm_xor_si128(_mm_clmulepi64_si128((a), (k), 0x01), \
+                                              _mm_clmulepi64_si128((a), (k), 0x10))
+
+    /* initial CRC is added to the first 16 bits of data */
+    acc0 = _mm_xor_si128(CRC16_LOAD(p), _mm_set_epi64x((long long)((unsigned long long)crc << 48), 0));
+    p += 16;
+    blockLength -= 16U;
+
+    if(blockLength >= 112U){
+        __m128i acc1 = CRC16_LOAD(p);
+        __m128i acc2 = CRC16_LOAD(p + 16);
+        __m128i acc3 = CRC16_LOAD(p + 32);
+        p += 48;
+        blockLength -= 48U;
+
+        while(blockLength >= 64U){
+            acc0 = _mm_xor_si128(CRC16_FOLD(acc0, k512), CRC16_LOAD(p));
+            acc1 = _mm_xor_si128(CRC16_FOLD(acc1, k512), CRC16_LOAD(p + 16));
+            acc2 = _mm_xor_si128(CRC16_FOLD(acc2, k512), CRC16_LOAD(p + 32));
+            acc3 = _mm_xor_si128(CRC16_FOLD(acc3, k512), CRC16_LOAD(p + 48));
+            p += 64;
+            blockLength -= 64U;
+        }
+
+        acc0 = _mm_xor_si128(CRC16_FOLD(acc0, k128), acc1);
+        acc0 = _mm_xor_si128(CRC16_FOLD(acc0, k128), acc2);
+        acc0 = _mm_xor_si128(CRC16_FOLD(acc0, k128), acc3);
+    }
+
+    while(blockLength >= 16U){
+        acc0 = _mm_xor_si128(CRC16_FOLD(acc0, k128), CRC16_LOAD(p));
+        p += 16;
+        blockLength -= 16U;
+    }
+
+    #undef CRC16_LOAD
+    #undef CRC16_FOLD
+
+    _mm_storeu_si128((__m128i *)buf, _mm_shuffle_epi8(acc0, bswap));
+    crc = crc16_ccitt_slicing(buf, 16U, 0U);
+
+    return crc16_ccitt_slicing(p, blockLength, crc);
+}
+#endif /* CRC16_CLMUL_X86 */
+
+
+#ifdef CRC16_CLMUL_ARM
+/* Same algorithm as crc16_ccitt_pclmul(), with PMULL instructions. */
+static inline uint64x2_t crc16_load(const unsigned char *p){
+    uint8x16_t v = vrev64q_u8(vld1q_u8(p));
+    return vreinterpretq_u64_u8(vextq_u8(v, v, 8));
+}
+
+static inline uint64x2_t crc16_fold(uint64x2_t a, const unsigned long long k[2]){
+    poly128_t h = vmull_p64((poly64_t)vgetq_lane_u64(a, 1), (poly64_t)k[0]);
+    poly128_t l = vmull_p64((poly64_t)vgetq_lane_u64(a, 0), (poly64_t)k[1]);
+    return veorq_u64(vreinterpretq_u64_p128(h), vreinterpretq_u64_p128(l));
+}
+
+static unsigned short crc16_ccitt_pmull(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc)
+{
+    const unsigned char *p = block;
+    unsigned char buf[16];
+    uint8x16_t v;
+    uint64x2_t acc0;
+
+    if(blockLength < 32U){
+        return crc16_ccitt_slicing(block, blockLength, crc);
+    }
+
+    /* initial CRC is added to the first 16 bits of data */
+    acc0 = veorq_u64(crc16_load(p), vcombine_u64(vcreate_u64(0), vcreate_u64((unsigned long long)crc << 48)));
+    p += 16;
+    blockLength -= 16U;
+
+    if(blockLength >= 112U){
+        uint64x2_t acc1 = crc16_load(p);
+        uint64x2_t acc2 = crc16_load(p + 16);
+        uint64x2_t acc3 = crc16_load(p + 32);
+        p += 48;
+        blockLength -= 48U;
+
+        while(blockLength >= 64U){
+            acc0 = veorq_u64(crc16_fold(acc0, crc16_fold512), crc16_load(p));
+            acc1 = veorq_u64(crc16_fold(acc1, crc16_fold512), crc16_load(p + 16));
+            acc2 = veorq_u64(crc16_fold(acc2, crc16_fold512), crc16_load(p + 32));
+            acc3 = veorq_u64(crc16_fold(acc3, crc16_fold512), crc16_load(p + 48));
+            p += 64;
+            blockLength -= 64U;
+        }
+
+        acc0 = veorq_u64(crc16_fold(acc0, crc16_fold128), acc1);
+        acc0 = veorq_u64(crc16_fold(acc0, crc16_fold128), acc2);
+        acc0 = veorq_u64(crc16_fold(acc0, crc16_fold128), acc3);
+    }
+
+    while(blockLength >= 16U){
+        acc0 = veorq_u64(crc16_fold(acc0, crc16_fold128), crc16_load(p));
+        p += 16;
+        blockLength -= 16U;
+    }
+
+    v = vrev64q_u8(vreinterpretq_u8_u64(acc0));
+    vst1q_u8(buf, vextq_u8(v, v, 8));
+    crc = crc16_ccitt_slicing(buf, 16U, 0U);
+
+    return crc16_ccitt_slicing(p, blockLength, crc);
+}
+#endif /* CRC16_CLMUL_ARM */
+
+
+/* Prepare tables and select the fastest implementation. Called before
+ * main() on GCC, otherwise on first use. Result is always the same, so
+ * repeated initialization is harmless. */
+#ifdef __GNUC__
+__attribute__((constructor))
+#endif
+static void crc16_ccitt_init(void){
+    unsigned int i, k;
+
+    for(i=0U; i<256U; i++){
+        crc16_ccitt_slice[0][i] = crc16_ccitt_table[i];
+        for(k=1U; k<CO_CRC16_SLICES; k++){
+            unsigned short c = crc16_ccitt_slice[k-1U][i];
+            crc16_ccitt_slice[k][i] = (unsigned short)(c << 8) ^ crc16_ccitt_table[c >> 8];
+        }
+    }
+    crc16_ccitt_fn = crc16_ccitt_slicing;
+    crc16_ccitt_name = (CO_CRC16_SLICES == 16) ? "slicing-by-16" : "slicing-by-8";
+
+#if defined(CRC16_CLMUL_X86) || defined(CRC16_CLMUL_ARM)
+    crc16_fold128[0] = crc16_xnmodp(192U);
+    crc16_fold128[1] = crc16_xnmodp(128U);
+    crc16_fold512[0] = crc16_xnmodp(576U);
+    crc16_fold512[1] = crc16_xnmodp(512U);
+#endif
+#ifdef CRC16_CLMUL_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")){
+        crc16_clmulSupported = 1;
+        crc16_ccitt_fn = crc16_ccitt_pclmul;
+        crc16_ccitt_name = "pclmul";
+    }
+#endif
+#ifdef CRC16_CLMUL_ARM
+    if((getauxval(AT_HWCAP) & HWCAP_PMULL) != 0U){
+        crc16_clmulSupported = 1;
+        crc16_ccitt_fn = crc16_ccitt_pmull;
+        crc16_ccitt_name = "pmull";
+    }
+#endif
+
+    crc16_ccitt_initialized = 1;
+}
+
+
+/******************************************************************************/
+unsigned short crc16_ccitt_clmul(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc)
+{
+    if(!crc16_ccitt_initialized){
+        crc16_ccitt_init();
+    }
+#ifdef CRC16_CLMUL_X86
+    if(crc16_clmulSupported){
+        return crc16_ccitt_pclmul(block, blockLength, crc);
+    }
+#endif
+#ifdef CRC16_CLMUL_ARM
+    if(crc16_clmulSupported){
+        return crc16_ccitt_pmull(block, blockLength, crc);
+    }
+#endif
+    return crc16_ccitt_slicing(block, blockLength, crc);
+}
+
+
+/******************************************************************************/
+int crc16_ccitt_clmulSupported(void){
+    if(!crc16_ccitt_initialized){
+        crc16_ccitt_init();
+    }
+#if defined(CRC16_CLMUL_X86) || defined(CRC16_CLMUL_ARM)
+    return crc16_clmulSupported;
+#else
+    return 0;
+#endif
+}
+
+
+/******************************************************************************/
+const char *crc16_ccitt_implementation(void){
+    if(!crc16_ccitt_initialized){
+        crc16_ccitt_init();
+    }
+    return crc16_ccitt_name;
+}
+
+
+/******************************************************************************/
+unsigned short crc16_ccitt(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc)
+{
+    if(!crc16_ccitt_initialized){
+        crc16_ccitt_init();
+    }
+    return crc16_ccitt_fn(block, blockLength, crc);
+}
+#endif /* CO_CRC16_SLICES > 0 */
+
 #endif /* CO_USE_OWN_CRC16 */
@@ -62,9 +62,29 @@ extern "C" {
  * Equation:
  *
  * `x^16 + x^12 + x^5 + 1`
+ *
+ * Portable implementation uses one 256 entry table and processes one byte at
+ * a time. If CO_CRC16_SLICES is 8 or 16, crc16_ccitt() uses faster
+ * implementation, selected at runtime: carry-less multiplication (PCLMULQDQ
+ * on x86, PMULL on ARMv8 with crypto extension), if CPU supports it, or
+ * slicing-by-N tables (N * 512 bytes of RAM) otherwise. All implementations
+ * give the same result.
  */
 
 
+/**
+ * Number of table slices for fast CRC calculation: 0 (portable byte at a
+ * time implementation only), 8 or 16. Default is 8 on Linux, 0 otherwise.
+ */
+#ifndef CO_CRC16_SLICES
+    #ifdef __linux__
+        #define CO_CRC16_SLICES 8
+    #else
+        #define CO_CRC16_SLICES 0
+    #endif
+#endif
+
+
 /**
  * Calculate CRC sum on block of data.
  *
@@ -83,6 +103,53 @@ unsigned short crc16_ccitt(
         unsigned int            blockLength,
         unsigned short          crc);
 
+#if CO_CRC16_SLICES > 0
+/**
+ * Calculate CRC with portable byte at a time implementation.
+ *
+ * Parameters and return value are the same as in crc16_ccitt().
+ */
+unsigned short crc16_ccitt_bytewise(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc);
+
+/**
+ * Calculate CRC with slicing-by-N implementation, N = CO_CRC16_SLICES.
+ *
+ * Parameters and return value are the same as in crc16_ccitt().
+ */
+unsigned short crc16_ccitt_slicing(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc);
+
+/**
+ * Calculate CRC with carry-less multiplication. If CPU does not support it,
+ * slicing-by-N implementation is used.
+ *
+ * Parameters and return value are the same as in crc16_ccitt().
+ */
+unsigned short crc16_ccitt_clmul(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc);
+
+/**
+ * Check CPU support for carry-less multiplication.
+ *
+ * @return Nonzero, if crc16_ccitt_clmul() uses carry-less multiplication.
+ */
+int crc16_ccitt_clmulSupported(void);
+
+/**
+ * Get name of the implementation used by crc16_ccitt().
+ *
+ * @return "bytewise", "slicing-by-8", "slicing-by-16", "pclmul" or "pmull".
+ */
+const char *crc16_ccitt_implementation(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
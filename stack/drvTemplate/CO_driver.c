@@ -94,10 +94,20 @@ CO_ReturnError_t CO_CANmodule_init(
     CANmodule->CANtxCount = 0U;
     CANmodule->errOld = 0U;
     CANmodule->em = NULL;
+#ifdef CO_USE_STATISTICS
+    CANmodule->stats.rxMsg = 0U;
+    CANmodule->stats.rxUnmatched = 0U;
+    CANmodule->stats.rxError = 0U;
+    CANmodule->stats.txMsg = 0U;
+    CANmodule->stats.txOverflow = 0U;
+#endif
 
     for(i=0U; i<rxSize; i++){
         rxArray[i].ident = 0U;
         rxArray[i].pFunct = NULL;
+#ifdef CO_USE_STATISTICS
+        rxArray[i].rxCount = 0U;
+#endif
     }
     for(i=0U; i<txSize; i++){
         txArray[i].bufferFull = false;
@@ -216,6 +226,9 @@ CO_CANtx_t *CO_CANtxBufferInit(
 CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
     CO_ReturnError_t err = CO_ERROR_NO;
 
+#ifdef CO_USE_STATISTICS
+    CO_STAT_INC(CANmodule->stats.txMsg);
+#endif
     /* Verify overflow */
     if(buffer->bufferFull){
         if(!CANmodule->firstCANtxMessage){
@@ -223,6 +236,9 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
             CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, buffer->ident);
         }
         err = CO_ERROR_TX_OVERFLOW;
+#ifdef CO_USE_STATISTICS
+        CO_STAT_INC(CANmodule->stats.txOverflow);
+#endif
     }
 
     CO_LOCK_CAN_SEND();
@@ -375,6 +391,16 @@ void CO_CANinterrupt(CO_CANmodule_t *CANmodule){
             }
         }
 
+#ifdef CO_USE_STATISTICS
+        CO_STAT_INC(CANmodule->stats.rxMsg);
+        if(msgMatched && (buffer != NULL)){
+            CO_STAT_INC(buffer->rxCount);
+        }
+        else{
+            CO_STAT_INC(CANmodule->stats.rxUnmatched);
+        }
+#endif
+
         /* Call specific function, which will process the message */
         if(msgMatched && (buffer != NULL) && (buffer->pFunct != NULL)){
             buffer->pFunct(buffer->object, rcvMsg);
@@ -181,6 +181,23 @@ extern "C" {
 /** @} */
 
 
+/**
+ * @name Statistics counters
+ * If CO_USE_STATISTICS is defined, CAN module and CANopen objects contain
+ * additional counters (received frames per CAN-ID, dropped frames, RPDO
+ * overwrites, SDO aborts, emergency overflows, etc.). Counters are
+ * incremented from CAN receive interrupt and from mainline or timer thread,
+ * so they must be updated atomically. Ordering is not important, because
+ * counters are only informative. Counters are read by CO_getStats().
+ * @{
+ */
+#ifdef CO_USE_STATISTICS
+    #define CO_STAT_INC(cnt)    __atomic_fetch_add(&(cnt), 1U, __ATOMIC_RELAXED) /**< Increment counter */
+    #define CO_STAT_GET(cnt)    __atomic_load_n(&(cnt), __ATOMIC_RELAXED)        /**< Read counter */
+#endif
+/** @} */
+
+
 /**
  * @defgroup CO_dataTypes Data types
  * @{
@@ -240,6 +257,9 @@ typedef struct{
     uint16_t            mask;           /**< Standard Identifier mask with same alignment as ident */
     void               *object;         /**< From CO_CANrxBufferInit() */
     void              (*pFunct)(void *object, const CO_CANrxMsg_t *message);  /**< From CO_CANrxBufferInit() */
+#ifdef CO_USE_STATISTICS
+    uint32_t            rxCount;        /**< Number of received messages with this identifier */
+#endif
 }CO_CANrx_t;
 
 
@@ -256,6 +276,20 @@ typedef struct{
 }CO_CANtx_t;
 
 
+#ifdef CO_USE_STATISTICS
+/**
+ * Statistics counters of the CAN module, see CO_USE_STATISTICS.
+ */
+typedef struct{
+    uint32_t            rxMsg;          /**< Number of all received messages */
+    uint32_t            rxUnmatched;    /**< Received messages without matching CO_CANrx_t */
+    uint32_t            rxError;        /**< CAN receive errors (read failed, overflow) */
+    uint32_t            txMsg;          /**< Number of messages passed to CO_CANsend() */
+    uint32_t            txOverflow;     /**< CO_CANsend() returned CO_ERROR_TX_OVERFLOW */
+}CO_CANstats_t;
+#endif
+
+
 /**
  * CAN module object. It may be different in different microcontrollers.
  */
@@ -282,6 +316,9 @@ typedef struct{
     volatile uint16_t   CANtxCount;
     uint32_t            errOld;         /**< Previous state of CAN errors */
     void               *em;             /**< Emergency object */
+#ifdef CO_USE_STATISTICS
+    CO_CANstats_t       stats;          /**< Statistics counters */
+#endif
 }CO_CANmodule_t;
 
 
@@ -0,0 +1,342 @@
+/*
+ * Asynchronous binary logger of CAN messages for Linux.
+ *
+ * @file        CO_CANlog.c
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_CANlog.h"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+#define CO_CANLOG_IDLE_NS       (2000000)   /* Sleep of writer thread, if ring is empty */
+
+
+/* Write data to the mapped log file. */
+static int logWriteMmap(CO_CANlog_t *log, const void *data, size_t size){
+    while(size > 0){
+        size_t n;
+
+        /* map next block */
+        if(log->map == NULL){
+            if(ftruncate(log->fd, (off_t)(log->mapOffset + CO_CANLOG_BLOCK_SIZE)) != 0){
+                return -1;
+            }
+            log->map = (uint8_t *) mmap(NULL, CO_CANLOG_BLOCK_SIZE, PROT_WRITE,
+                                        MAP_SHARED, log->fd, (off_t)log->mapOffset);
+            if(log->map == MAP_FAILED){
+                log->map = NULL;
+                return -1;
+            }
+            log->mapUsed = 0;
+        }
+
+        n = CO_CANLOG_BLOCK_SIZE - log->mapUsed;
+        if(n > size){
+            n = size;
+        }
+        memcpy(log->map + log->mapUsed, data, n);
+        log->mapUsed += n;
+        data = (const uint8_t *)data + n;
+        size -= n;
+
+        if(log->mapUsed == CO_CANLOG_BLOCK_SIZE){
+            munmap(log->map, CO_CANLOG_BLOCK_SIZE);
+            log->map = NULL;
+            log->mapOffset += CO_CANLOG_BLOCK_SIZE;
+        }
+    }
+    return 0;
+}
+
+
+/* Data in the stdio buffer were not written completely. Records counted as
+ * written, which are not in the file, are counted as write errors. */
+static void logLost(CO_CANlog_t *log){
+    struct stat st;
+    uint64_t inFile = 0;
+
+    if(fstat(fileno(log->fp), &st) == 0 && st.st_size > (off_t)sizeof(CO_CANlogHeader_t)){
+        inFile = ((uint64_t)st.st_size - sizeof(CO_CANlogHeader_t)) / sizeof(CO_CANlogRecord_t);
+    }
+    if(inFile < log->written){
+        __atomic_fetch_add(&log->writeErrors, (uint32_t)(log->written - inFile), __ATOMIC_RELAXED);
+        log->written = inFile;
+    }
+}
+
+
+/* Write data to the log file. After error file is not written any more,
+ * because record may be written partially. */
+static int logWrite(CO_CANlog_t *log, const void *data, size_t size){
+    int ret;
+
+    if(log->writeFailed){
+        return -1;
+    }
+    if(log->useMmap){
+        ret = logWriteMmap(log, data, size);
+    }
+    else{
+        ret = (fwrite(data, size, 1, log->fp) == 1) ? 0 : -1;
+        if(ret != 0){
+            logLost(log);
+        }
+    }
+    if(ret != 0){
+        log->writeFailed = true;
+    }
+    return ret;
+}
+
+
+/* Write one record, count it as written or as write error. */
+static void logRecord(CO_CANlog_t *log, const CO_CANlogRecord_t *rec){
+    if(logWrite(log, rec, sizeof(*rec)) == 0){
+        log->written++;
+    }
+    else{
+        __atomic_fetch_add(&log->writeErrors, 1U, __ATOMIC_RELAXED);
+    }
+}
+
+
+/* Move records from ring to the file. Returns number of records. */
+static uint32_t logDrain(CO_CANlog_t *log){
+    uint32_t count = 0;
+    uint32_t dropped;
+
+    for(;;){
+        CO_CANlogSlot_t *slot = &log->ring[log->tail & log->ringMask];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+        if(seq != log->tail + 1){
+            break;  /* empty */
+        }
+        logRecord(log, &slot->rec);
+        __atomic_store_n(&slot->seq, log->tail + log->ringMask + 1, __ATOMIC_RELEASE);
+        log->tail++;
+        count++;
+    }
+
+    /* mark dropped records in the log */
+    dropped = __atomic_load_n(&log->dropped, __ATOMIC_RELAXED);
+    if(dropped != log->droppedLogged){
+        CO_CANlogRecord_t rec;
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        memset(&rec, 0, sizeof(rec));
+        rec.timestamp_ns = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+        rec.ident = dropped - log->droppedLogged;
+        rec.flags = CO_CANLOG_FLAG_DROPPED;
+        logRecord(log, &rec);
+        log->droppedLogged = dropped;
+    }
+
+    return count;
+}
+
+
+/* Writer thread */
+static void *logThread(void *arg){
+    CO_CANlog_t *log = (CO_CANlog_t *) arg;
+
+    while(__atomic_load_n(&log->running, __ATOMIC_ACQUIRE)){
+        if(logDrain(log) == 0){
+            struct timespec ts = {0, CO_CANLOG_IDLE_NS};
+            nanosleep(&ts, NULL);
+        }
+    }
+    logDrain(log);
+
+    return NULL;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANlog_init(
+        CO_CANlog_t            *log,
+        const char             *fileName,
+        uint32_t                ringSize,
+        bool_t                  useMmap)
+{
+    CO_CANlogHeader_t header;
+    uint32_t i;
+
+    /* verify arguments */
+    if(log == NULL || fileName == NULL || ringSize < 2 || (ringSize & (ringSize - 1)) != 0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    log->ring = (CO_CANlogSlot_t *) calloc(ringSize, sizeof(CO_CANlogSlot_t));
+    if(log->ring == NULL){
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    for(i = 0; i < ringSize; i++){
+        log->ring[i].seq = i;
+    }
+    log->ringMask = ringSize - 1;
+    log->head = 0;
+    log->tail = 0;
+    log->dropped = 0;
+    log->droppedLogged = 0;
+    log->written = 0;
+    log->writeErrors = 0;
+    log->writeFailed = false;
+    log->useMmap = useMmap;
+    log->fp = NULL;
+    log->fd = -1;
+    log->map = NULL;
+    log->mapOffset = 0;
+    log->mapUsed = 0;
+
+    /* open file */
+    if(useMmap){
+        log->fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(log->fd < 0){
+            free(log->ring);
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
+    else{
+        log->fp = fopen(fileName, "wb");
+        if(log->fp == NULL){
+            free(log->ring);
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        setvbuf(log->fp, NULL, _IOFBF, CO_CANLOG_BLOCK_SIZE);
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "COCANLOG", sizeof(header.magic));
+    header.version = 1;
+    header.recordSize = sizeof(CO_CANlogRecord_t);
+    if(logWrite(log, &header, sizeof(header)) != 0){
+        CO_CANlog_close(log);
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* start writer thread */
+    __atomic_store_n(&log->running, true, __ATOMIC_RELEASE);
+    if(pthread_create(&log->thread, NULL, logThread, log) != 0){
+        __atomic_store_n(&log->running, false, __ATOMIC_RELEASE);
+        CO_CANlog_close(log);
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_CANlog_close(CO_CANlog_t *log){
+    if(__atomic_load_n(&log->running, __ATOMIC_ACQUIRE)){
+        __atomic_store_n(&log->running, false, __ATOMIC_RELEASE);
+        pthread_join(log->thread, NULL);
+    }
+
+    if(log->useMmap){
+        if(log->map != NULL){
+            munmap(log->map, CO_CANLOG_BLOCK_SIZE);
+            log->map = NULL;
+        }
+        if(log->fd >= 0){
+            /* cut unused part of the last block */
+            if(ftruncate(log->fd, (off_t)(log->mapOffset + log->mapUsed)) != 0){
+                /* file is still valid, only longer */
+            }
+            close(log->fd);
+            log->fd = -1;
+        }
+    }
+    else if(log->fp != NULL){
+        if(fflush(log->fp) != 0){
+            logLost(log);
+        }
+        fclose(log->fp);
+        log->fp = NULL;
+    }
+
+    free(log->ring);
+    log->ring = NULL;
+}
+
+
+/******************************************************************************/
+void CO_CANlog_put(CO_CANlog_t *log, const void *frame, bool_t tx){
+    const struct can_frame *msg = (const struct can_frame *) frame;
+    CO_CANlogSlot_t *slot;
+    uint32_t pos;
+    struct timespec ts;
+
+    /* reserve slot */
+    pos = __atomic_load_n(&log->head, __ATOMIC_RELAXED);
+    for(;;){
+        int32_t dif;
+
+        slot = &log->ring[pos & log->ringMask];
+        dif = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if(dif == 0){
+            if(__atomic_compare_exchange_n(&log->head, &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+                break;
+            }
+        }
+        else if(dif < 0){
+            /* ring is full */
+            __atomic_fetch_add(&log->dropped, 1U, __ATOMIC_RELAXED);
+            return;
+        }
+        else{
+            pos = __atomic_load_n(&log->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    /* fill record and publish it */
+    clock_gettime(CLOCK_REALTIME, &ts);
+    slot->rec.timestamp_ns = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+    slot->rec.ident = msg->can_id;
+    slot->rec.DLC = msg->can_dlc;
+    slot->rec.flags = tx ? CO_CANLOG_FLAG_TX : 0;
+    slot->rec.reserved[0] = 0;
+    slot->rec.reserved[1] = 0;
+    memcpy(slot->rec.data, msg->data, sizeof(slot->rec.data));
+
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+
+/******************************************************************************/
+uint32_t CO_CANlog_getDropped(const CO_CANlog_t *log){
+    return __atomic_load_n(&log->dropped, __ATOMIC_RELAXED);
+}
+
+
+/******************************************************************************/
+uint32_t CO_CANlog_getWriteErrors(const CO_CANlog_t *log){
+    return __atomic_load_n(&log->writeErrors, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,173 @@
+/**
+ * Asynchronous binary logger of CAN messages for Linux.
+ *
+ * @file        CO_CANlog.h
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_CANLOG_H
+#define CO_CANLOG_H
+
+#include <stdio.h>
+#include <pthread.h>
+
+
+/**
+ * Size of the output block in bytes. Output file is written (or mapped, if
+ * mmap is used) in blocks of this size.
+ */
+#ifndef CO_CANLOG_BLOCK_SIZE
+    #define CO_CANLOG_BLOCK_SIZE    (1024 * 1024)
+#endif
+
+/**
+ * Flags in CO_CANlogRecord_t.
+ */
+#define CO_CANLOG_FLAG_TX       0x01    /**< Message was transmitted */
+#define CO_CANLOG_FLAG_DROPPED  0x80    /**< Marker record, ident contains number of dropped records */
+
+
+/**
+ * Header at the beginning of the log file.
+ */
+typedef struct{
+    char                magic[8];       /**< "COCANLOG" */
+    uint16_t            version;        /**< 1 */
+    uint16_t            recordSize;     /**< sizeof(CO_CANlogRecord_t) */
+    uint32_t            reserved;
+}CO_CANlogHeader_t;
+
+
+/**
+ * One record in the log file, host byte order.
+ */
+typedef struct{
+    uint64_t            timestamp_ns;   /**< CLOCK_REALTIME */
+    uint32_t            ident;          /**< can_id from struct can_frame, with flags */
+    uint8_t             DLC;
+    uint8_t             flags;          /**< CO_CANLOG_FLAG_* */
+    uint8_t             reserved[2];
+    uint8_t             data[8];
+}CO_CANlogRecord_t;
+
+
+/**
+ * Slot in the ring buffer.
+ */
+typedef struct{
+    uint32_t            seq;            /**< Sequence for lock-free access */
+    uint32_t            reserved;
+    CO_CANlogRecord_t   rec;
+}CO_CANlogSlot_t;
+
+
+/**
+ * CAN logger object.
+ *
+ * CO_CANlog_put() is called from CO_CANsend() and CO_CANrxDispatch(), if
+ * CO_LOG_CAN_MESSAGES is defined and CO_CANmodule_t.log is set. It stores
+ * timestamped message into the ring buffer without locks and system calls
+ * (except vDSO clock_gettime). Background writer thread drains the ring into
+ * the log file. If ring is full, record is dropped and counted. Number of
+ * dropped records is also written to the log as marker record.
+ *
+ * If writing to the file fails (disk is full, for example), file is not
+ * written any more, because last record may be written partially. Each
+ * record, which is not written, is counted, see CO_CANlog_getWriteErrors().
+ *
+ * Ring has a single consumer (writer thread), but allows multiple producers,
+ * because messages are transmitted from mainline and from realtime thread.
+ */
+typedef struct CO_CANlog_t{
+    CO_CANlogSlot_t    *ring;           /**< Ring buffer, size is power of 2 */
+    uint32_t            ringMask;       /**< Ring size - 1 */
+    uint32_t            head;           /**< Next position for producers */
+    uint32_t            tail;           /**< Next position for consumer */
+    uint32_t            dropped;        /**< Number of dropped records */
+    uint32_t            droppedLogged;  /**< Dropped records already marked in log */
+    uint64_t            written;        /**< Number of records written to file */
+    uint32_t            writeErrors;    /**< Number of records not written because of error */
+    bool_t              writeFailed;    /**< Writing to the file failed */
+    bool_t              useMmap;        /**< From CO_CANlog_init() */
+    bool_t              running;        /**< Writer thread runs, accessed atomically */
+    pthread_t           thread;
+    FILE               *fp;             /**< Output file, if mmap is not used */
+    int                 fd;             /**< Output file, if mmap is used */
+    uint8_t            *map;            /**< Mapped block */
+    uint64_t            mapOffset;      /**< File offset of mapped block */
+    size_t              mapUsed;        /**< Bytes used in mapped block */
+}CO_CANlog_t;
+
+
+/**
+ * Initialize CAN logger and start writer thread.
+ *
+ * @param log This object will be initialized.
+ * @param fileName Name of the log file, it will be overwritten.
+ * @param ringSize Number of records in the ring buffer. Must be power of 2.
+ * @param useMmap If true, file is written through mmap, otherwise with
+ * block-buffered stdio.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT (also if
+ * file can not be opened or written) or CO_ERROR_OUT_OF_MEMORY.
+ */
+CO_ReturnError_t CO_CANlog_init(
+        CO_CANlog_t            *log,
+        const char             *fileName,
+        uint32_t                ringSize,
+        bool_t                  useMmap);
+
+/**
+ * Stop writer thread, write remaining records and close the file.
+ *
+ * @param log This object.
+ */
+void CO_CANlog_close(CO_CANlog_t *log);
+
+/**
+ * Put CAN message into the log. Function is lock-free.
+ *
+ * @param log This object.
+ * @param frame CAN message, layout of struct can_frame.
+ * @param tx True, if message is transmitted.
+ */
+void CO_CANlog_put(CO_CANlog_t *log, const void *frame, bool_t tx);
+
+/**
+ * Get number of records, which were dropped, because ring was full.
+ *
+ * @param log This object.
+ *
+ * @return Number of dropped records.
+ */
+uint32_t CO_CANlog_getDropped(const CO_CANlog_t *log);
+
+/**
+ * Get number of records, which were not written, because writing to the
+ * file failed. If mmap is not used, records lost from the stdio buffer are
+ * included.
+ *
+ * @param log This object.
+ *
+ * @return Number of write errors.
+ */
+uint32_t CO_CANlog_getWriteErrors(const CO_CANlog_t *log);
+
+#endif
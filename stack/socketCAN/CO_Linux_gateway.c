@@ -0,0 +1,332 @@
+/*
+ * CANopen ASCII gateway on Unix domain socket.
+ *
+ * @file        CO_Linux_gateway.c
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CANopen.h"
+#include "CO_Linux_tasks.h"
+#include "CO_Linux_gateway.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+
+/* External helper function ***************************************************/
+void CO_error(const uint32_t info);
+
+
+/* Send NMT command with NMT master from CANopen.c. */
+#if CO_NO_NMT_MASTER == 1
+static uint8_t gatewayNMT(void *object, uint8_t command, uint8_t nodeId) {
+    return CO_sendNMTcommand((CO_t *)object, command, nodeId);
+}
+#endif
+
+
+/* Set epoll events of the connection: wait until queued responses can be
+ * sent, otherwise receive, if gateway accepts characters. */
+static void gatewayPoll(CO_Linux_gatewayConn_t *s) {
+    struct epoll_event ev;
+
+    if(s->txLen > 0) {
+        ev.events = EPOLLOUT;
+    }
+    else {
+        ev.events = s->rxBlocked ? 0 : EPOLLIN;
+    }
+    ev.data.fd = s->fd;
+    if(epoll_ctl(s->gwl->fdEpoll, EPOLL_CTL_MOD, s->fd, &ev) == -1)
+        CO_error(0x24100000L + errno);
+}
+
+
+/* Send data without blocking. Return number of bytes sent or -1 on error. */
+static ssize_t gatewaySend(CO_Linux_gatewayConn_t *s, const char *data, uint16_t length) {
+    ssize_t n;
+
+    do {
+        n = send(s->fd, data, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while(n < 0 && errno == EINTR);
+
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        n = 0;
+    }
+    return n;
+}
+
+
+/* Write response. If socket buffer is full, queue the rest. Close connection
+ * on error or if client does not read responses and queue is full. Shutdown
+ * is reported by epoll and connection is closed in CO_Linux_gateway_process(). */
+static void gatewayWrite(void *object, const char *text, uint16_t length) {
+    CO_Linux_gatewayConn_t *s = (CO_Linux_gatewayConn_t *)object;
+    ssize_t n = 0;
+
+    if(s->txLen == 0) {
+        n = gatewaySend(s, text, length);
+        if(n == (ssize_t)length) {
+            return;
+        }
+    }
+
+    if(n < 0 || (length - n) > (ssize_t)(sizeof(s->txBuf) - s->txLen)) {
+        shutdown(s->fd, SHUT_RDWR);
+        return;
+    }
+    memcpy(&s->txBuf[s->txLen], &text[n], length - n);
+    if(s->txLen == 0) {
+        s->txLen = (uint16_t)(length - n);
+        gatewayPoll(s);
+    }
+    else {
+        s->txLen += (uint16_t)(length - n);
+    }
+}
+
+
+/* Send queued responses. Return false on error. */
+static bool_t gatewayFlush(CO_Linux_gatewayConn_t *s) {
+    ssize_t n = gatewaySend(s, s->txBuf, s->txLen);
+
+    if(n < 0) {
+        return false;
+    }
+    if(n > 0) {
+        s->txLen -= (uint16_t)n;
+        memmove(s->txBuf, &s->txBuf[n], s->txLen);
+        if(s->txLen == 0) {
+            gatewayPoll(s);
+        }
+    }
+    return true;
+}
+
+
+/* Blocked connection can receive again. */
+static void gatewayReady(void *object) {
+    CO_Linux_gatewayConn_t *s = (CO_Linux_gatewayConn_t *)object;
+
+    s->rxBlocked = false;
+    gatewayPoll(s);
+}
+
+
+/* Close connection. */
+static void gatewayDisconnect(CO_Linux_gateway_t *gwl, CO_Linux_gatewayConn_t *s) {
+    epoll_ctl(gwl->fdEpoll, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    CO_GWascii_close(&gwl->gw, s->conn);
+    s->conn = NULL;
+    s->fd = -1;
+}
+
+
+/* Accept new connection. */
+static void gatewayAccept(CO_Linux_gateway_t *gwl) {
+    struct epoll_event ev;
+    CO_Linux_gatewayConn_t *s = NULL;
+    int fd;
+    int flags;
+    int i;
+
+    fd = accept(gwl->fdListen, NULL, NULL);
+    if(fd < 0) {
+        return;
+    }
+    flags = fcntl(fd, F_GETFL);
+    if(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        close(fd);
+        return;
+    }
+
+    for(i = 0; i < CO_GW_LINUX_CONNECTIONS; i++) {
+        if(gwl->sockets[i].fd < 0) {
+            s = &gwl->sockets[i];
+            break;
+        }
+    }
+    if(s == NULL) {
+        close(fd);  /* too many connections */
+        return;
+    }
+
+    s->fd = fd;
+    s->rxBlocked = false;
+    s->txLen = 0;
+    s->conn = CO_GWascii_open(&gwl->gw, s);
+
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if(s->conn == NULL || epoll_ctl(gwl->fdEpoll, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        close(fd);
+        if(s->conn != NULL) {
+            CO_GWascii_close(&gwl->gw, s->conn);
+        }
+        s->conn = NULL;
+        s->fd = -1;
+    }
+}
+
+
+/* Receive data. Data are peeked first, so characters, which are not accepted
+ * by the gateway, stay in the socket. */
+static void gatewayReceive(CO_Linux_gateway_t *gwl, CO_Linux_gatewayConn_t *s) {
+    char buf[CO_GW_ASCII_LINE_SIZE];
+    ssize_t n;
+    uint16_t accepted;
+
+    n = recv(s->fd, buf, sizeof(buf), MSG_PEEK);
+    if(n < 0 && (errno == EINTR || errno == EAGAIN)) {
+        return;
+    }
+    if(n <= 0) {
+        gatewayDisconnect(gwl, s);
+        return;
+    }
+
+    accepted = CO_GWascii_receive(&gwl->gw, s->conn, buf, (uint16_t)n);
+    if(accepted > 0) {
+        if(recv(s->fd, buf, accepted, 0) != (ssize_t)accepted)
+            CO_error(0x24200000L + errno);
+
+        /* start queued SDO jobs in mainline */
+        taskMain_cbSignal();
+    }
+
+    /* stop polling until gatewayReady() */
+    if(accepted < (uint16_t)n) {
+        s->rxBlocked = true;
+        gatewayPoll(s);
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_Linux_gateway_init(
+        CO_Linux_gateway_t     *gwl,
+        int                     fdEpoll,
+        const char             *path,
+        CO_SDOengine_t         *engine,
+        uint8_t                 defaultNode)
+{
+    struct epoll_event ev;
+    uint8_t (*pFunctNMT)(void *object, uint8_t command, uint8_t nodeId) = NULL;
+    int i;
+
+    /* verify arguments */
+    if(gwl == NULL || path == NULL || strlen(path) >= sizeof(gwl->addr.sun_path)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+#if CO_NO_NMT_MASTER == 1
+    pFunctNMT = gatewayNMT;
+#endif
+    if(CO_GWascii_init(&gwl->gw, engine, gwl->requests, CO_GW_LINUX_REQUESTS,
+            gwl->conns, CO_GW_LINUX_CONNECTIONS, defaultNode, pFunctNMT, CO,
+            gatewayWrite, gatewayReady) != CO_ERROR_NO)
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    for(i = 0; i < CO_GW_LINUX_CONNECTIONS; i++) {
+        gwl->sockets[i].gwl = gwl;
+        gwl->sockets[i].conn = NULL;
+        gwl->sockets[i].fd = -1;
+    }
+    gwl->fdEpoll = fdEpoll;
+
+    /* listening socket */
+    memset(&gwl->addr, 0, sizeof(gwl->addr));
+    gwl->addr.sun_family = AF_UNIX;
+    strcpy(gwl->addr.sun_path, path);
+    unlink(path);
+
+    gwl->fdListen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(gwl->fdListen < 0) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    ev.events = EPOLLIN;
+    ev.data.fd = gwl->fdListen;
+    if(bind(gwl->fdListen, (struct sockaddr *)&gwl->addr, sizeof(gwl->addr)) != 0
+        || listen(gwl->fdListen, CO_GW_LINUX_CONNECTIONS) != 0
+        || epoll_ctl(fdEpoll, EPOLL_CTL_ADD, gwl->fdListen, &ev) != 0)
+    {
+        close(gwl->fdListen);
+        gwl->fdListen = -1;
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_Linux_gateway_close(CO_Linux_gateway_t *gwl) {
+    int i;
+
+    for(i = 0; i < CO_GW_LINUX_CONNECTIONS; i++) {
+        if(gwl->sockets[i].fd >= 0) {
+            gatewayDisconnect(gwl, &gwl->sockets[i]);
+        }
+    }
+    if(gwl->fdListen >= 0) {
+        epoll_ctl(gwl->fdEpoll, EPOLL_CTL_DEL, gwl->fdListen, NULL);
+        close(gwl->fdListen);
+        gwl->fdListen = -1;
+        unlink(gwl->addr.sun_path);
+    }
+}
+
+
+/******************************************************************************/
+bool_t CO_Linux_gateway_process(CO_Linux_gateway_t *gwl, int fd) {
+    int i;
+
+    if(fd == gwl->fdListen) {
+        gatewayAccept(gwl);
+        return true;
+    }
+
+    for(i = 0; i < CO_GW_LINUX_CONNECTIONS; i++) {
+        CO_Linux_gatewayConn_t *s = &gwl->sockets[i];
+
+        if(fd == s->fd) {
+            /* socket is writable or readable, event type is not known */
+            if(s->txLen > 0) {
+                if(!gatewayFlush(s)) {
+                    gatewayDisconnect(gwl, s);
+                    return true;
+                }
+                if(s->txLen > 0) {
+                    return true;
+                }
+            }
+            gatewayReceive(gwl, s);
+            return true;
+        }
+    }
+
+    return false;
+}
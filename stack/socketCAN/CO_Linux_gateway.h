@@ -0,0 +1,132 @@
+/**
+ * CANopen ASCII gateway on Unix domain socket.
+ *
+ * @file        CO_Linux_gateway.h
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_LINUX_GATEWAY_H
+#define CO_LINUX_GATEWAY_H
+
+#include <sys/un.h>
+#include "CO_gateway_ascii.h"
+
+
+/** Maximum number of simultaneous connections. */
+#ifndef CO_GW_LINUX_CONNECTIONS
+    #define CO_GW_LINUX_CONNECTIONS     8
+#endif
+
+/** Maximum number of SDO requests in progress, shared by all connections. */
+#ifndef CO_GW_LINUX_REQUESTS
+    #define CO_GW_LINUX_REQUESTS        32
+#endif
+
+/** Size of the queue for responses, which were not sent yet, per connection. */
+#ifndef CO_GW_LINUX_TX_SIZE
+    #define CO_GW_LINUX_TX_SIZE         4096
+#endif
+
+
+struct CO_Linux_gateway_t;
+
+/**
+ * Connection socket.
+ */
+typedef struct {
+    struct CO_Linux_gateway_t *gwl;     /**< Gateway */
+    CO_GWconn_t        *conn;           /**< Connection in the ASCII gateway or NULL */
+    int                 fd;             /**< Socket or -1 */
+    bool_t              rxBlocked;      /**< Gateway does not accept more characters */
+    uint16_t            txLen;          /**< Number of bytes in txBuf */
+    char                txBuf[CO_GW_LINUX_TX_SIZE]; /**< Responses to be sent */
+} CO_Linux_gatewayConn_t;
+
+
+/**
+ * ASCII gateway on Unix domain socket.
+ *
+ * Gateway listens on stream socket. Each accepted connection sends CiA 309-3
+ * commands, see CO_gateway_ascii.h. Sockets are added to the same epoll as
+ * tasks from CO_Linux_tasks.h and CO_Linux_gateway_process() must be called
+ * from the same thread as taskMain_process(). SDO engine must be processed
+ * in mainline task, see taskMain_setSDOengine().
+ *
+ * Example with socat:
+ * ~~~{.txt}
+ * echo "[1] 4 r 0x1017 0 u16" | socat - UNIX-CONNECT:/tmp/CO_command_socket
+ * ~~~
+ *
+ * Responses are written without blocking. If socket buffer is full, they are
+ * queued and sent, when socket becomes writable. Connection is not read
+ * meanwhile. If client does not read responses and queue of
+ * CO_GW_LINUX_TX_SIZE bytes is full, connection is closed.
+ */
+typedef struct CO_Linux_gateway_t {
+    CO_GWascii_t        gw;             /**< ASCII gateway */
+    CO_GWconn_t         conns[CO_GW_LINUX_CONNECTIONS];
+    CO_GWrequest_t      requests[CO_GW_LINUX_REQUESTS];
+    CO_Linux_gatewayConn_t sockets[CO_GW_LINUX_CONNECTIONS];
+    int                 fdEpoll;        /**< From CO_Linux_gateway_init() */
+    int                 fdListen;       /**< Listening socket */
+    struct sockaddr_un  addr;           /**< Address of the listening socket */
+} CO_Linux_gateway_t;
+
+
+/**
+ * Initialize gateway and start listening.
+ *
+ * Existing socket file with the same name is removed.
+ *
+ * @param gwl This object will be initialized.
+ * @param fdEpoll File descriptor for Linux epoll API.
+ * @param path Path of the socket file.
+ * @param engine SDO client engine.
+ * @param defaultNode Default node-ID, 0 if not set.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_Linux_gateway_init(
+        CO_Linux_gateway_t     *gwl,
+        int                     fdEpoll,
+        const char             *path,
+        CO_SDOengine_t         *engine,
+        uint8_t                 defaultNode);
+
+/**
+ * Close all connections, listening socket and remove socket file.
+ *
+ * @param gwl This object.
+ */
+void CO_Linux_gateway_close(CO_Linux_gateway_t *gwl);
+
+/**
+ * Process gateway.
+ *
+ * Function must be called after epoll.
+ *
+ * @param gwl This object.
+ * @param fd Available file descriptor from epoll().
+ *
+ * @return True, if fd was matched.
+ */
+bool_t CO_Linux_gateway_process(CO_Linux_gateway_t *gwl, int fd);
+
+#endif
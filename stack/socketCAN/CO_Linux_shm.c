@@ -0,0 +1,223 @@
+/*
+ * Process image in POSIX shared memory for other processes on Linux.
+ *
+ * @file        CO_Linux_shm.c
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_Linux_shm.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+static const char CO_Linux_shmMagic[8] = {'C','O','P','R','O','C','I','M'};
+
+
+/* Initialize the object with unmapped segment. */
+static void shmClear(CO_Linux_shm_t *shm) {
+    memset(shm, 0, sizeof(*shm));
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_Linux_shmCreate(
+        CO_Linux_shm_t         *shm,
+        const char             *name,
+        const void             *region,
+        uint32_t                size)
+{
+    CO_Linux_shmHeader_t *header;
+    void *map;
+    int fd;
+
+    /* verify arguments */
+    if(shm == NULL || name == NULL || region == NULL || size == 0U
+        || strlen(name) >= sizeof(shm->name)
+    ) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    shmClear(shm);
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    shm->mapSize = sizeof(CO_Linux_shmHeader_t) + size;
+    if(ftruncate(fd, (off_t)shm->mapSize) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    map = mmap(NULL, shm->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        shm_unlink(name);
+        shmClear(shm);
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* header is written before the first data, magic last */
+    header = (CO_Linux_shmHeader_t *)map;
+    header->version = 1;
+    header->headerSize = sizeof(CO_Linux_shmHeader_t);
+    header->size = size;
+    header->seq = 0;
+
+    shm->header = header;
+    shm->data = (uint8_t *)map + sizeof(CO_Linux_shmHeader_t);
+    shm->region = region;
+    shm->size = size;
+    strcpy(shm->name, name);
+
+    CO_Linux_shmPublish(shm);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(header->magic, CO_Linux_shmMagic, sizeof(header->magic));
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_Linux_shmPublish(CO_Linux_shm_t *shm) {
+    uint32_t seq = shm->header->seq;
+
+    /* odd sequence: readers retry. Fence orders it before the data. */
+    __atomic_store_n(&shm->header->seq, seq + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(shm->data, shm->region, shm->size);
+
+    __atomic_store_n(&shm->header->seq, seq + 2U, __ATOMIC_RELEASE);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_Linux_shmOpen(
+        CO_Linux_shm_t         *shm,
+        const char             *name)
+{
+    CO_Linux_shmHeader_t *header;
+    struct stat st;
+    void *map;
+    int fd;
+
+    /* verify arguments */
+    if(shm == NULL || name == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    shmClear(shm);
+    fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if(fd < 0) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CO_Linux_shmHeader_t)) {
+        close(fd);
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* verify header, segment may be still initializing */
+    header = (CO_Linux_shmHeader_t *)map;
+    if(memcmp(header->magic, CO_Linux_shmMagic, sizeof(header->magic)) != 0
+        || header->version != 1
+        || header->headerSize != sizeof(CO_Linux_shmHeader_t)
+        || (size_t)st.st_size < sizeof(CO_Linux_shmHeader_t) + header->size
+    ) {
+        munmap(map, (size_t)st.st_size);
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    shm->header = header;
+    shm->data = (uint8_t *)map + sizeof(CO_Linux_shmHeader_t);
+    shm->mapSize = (size_t)st.st_size;
+    shm->size = header->size;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_Linux_shmRead(
+        const CO_Linux_shm_t   *shm,
+        uint32_t                offset,
+        void                   *buf,
+        uint32_t                count,
+        uint32_t               *seq)
+{
+    uint32_t i;
+
+    /* verify arguments */
+    if(shm == NULL || shm->header == NULL || buf == NULL
+        || offset > shm->size || count > (shm->size - offset)
+    ) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    for(i = 0; i < CO_LINUX_SHM_READ_RETRIES; i++) {
+        uint32_t seq1 = __atomic_load_n(&shm->header->seq, __ATOMIC_ACQUIRE);
+        uint32_t seq2;
+
+        if((seq1 & 1U) != 0U) {
+            continue;
+        }
+
+        memcpy(buf, shm->data + offset, count);
+
+        /* data must be read before the sequence is verified */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq2 = __atomic_load_n(&shm->header->seq, __ATOMIC_RELAXED);
+
+        if(seq1 == seq2) {
+            if(seq != NULL) {
+                *seq = seq1;
+            }
+            return CO_ERROR_NO;
+        }
+    }
+
+    return CO_ERROR_TIMEOUT;
+}
+
+
+/******************************************************************************/
+void CO_Linux_shmClose(CO_Linux_shm_t *shm) {
+    if(shm == NULL) {
+        return;
+    }
+    if(shm->header != NULL) {
+        munmap(shm->header, shm->mapSize);
+    }
+    if(shm->region != NULL) {
+        shm_unlink(shm->name);
+    }
+    shmClear(shm);
+}
@@ -0,0 +1,158 @@
+/**
+ * Process image in POSIX shared memory for other processes on Linux.
+ *
+ * @file        CO_Linux_shm.h
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_LINUX_SHM_H
+#define CO_LINUX_SHM_H
+
+#include <stddef.h>
+
+
+/**
+ * Number of attempts in CO_Linux_shmRead(), before it gives up, if the
+ * writer is always in the middle of the update (or has died there).
+ */
+#ifndef CO_LINUX_SHM_READ_RETRIES
+    #define CO_LINUX_SHM_READ_RETRIES   1000
+#endif
+
+
+/**
+ * Header at the beginning of the shared memory segment.
+ *
+ * Data follow the header, at offset sizeof(CO_Linux_shmHeader_t).
+ */
+typedef struct {
+    char                magic[8];       /**< "COPROCIM" */
+    uint16_t            version;        /**< 1 */
+    uint16_t            headerSize;     /**< sizeof(CO_Linux_shmHeader_t) */
+    uint32_t            size;           /**< Size of the data in bytes */
+    uint32_t            seq;            /**< Sequence counter, odd while data are written */
+    uint8_t             reserved[44];   /**< Header occupies one cache line */
+} CO_Linux_shmHeader_t;
+
+
+/**
+ * Shared process image object.
+ *
+ * Writer (CANopenNode process) creates the segment with CO_Linux_shmCreate()
+ * and copies the memory region, for example CO_OD_RAM, into it with
+ * CO_Linux_shmPublish(). Generated Object Dictionary points into CO_OD_RAM
+ * directly, so the region can not be moved into the segment. Instead, the
+ * snapshot is published by realtime task after CO_process_SYNC_RPDO() and
+ * CO_process_TPDO(), see CANrx_taskTmr_setShm(). So snapshot is consistent
+ * with PDO processing and other processes see new RPDO inputs and TPDO
+ * outputs after each cycle.
+ *
+ * Readers (HMI, data logger) open the segment with CO_Linux_shmOpen() and
+ * copy the data with CO_Linux_shmRead(). Segment is protected by the
+ * sequence lock: writer makes the sequence counter odd before it copies the
+ * data and even after. Reader retries, if counter was odd or has changed
+ * during the copy. Neither side uses locks or system calls, and readers
+ * can not delay the realtime task.
+ *
+ * Memory layout of the data is the layout of the published region, so
+ * reader compiled with the same CO_OD.h may read into struct sCO_OD_RAM and
+ * use offsetof() for single variables.
+ */
+typedef struct {
+    CO_Linux_shmHeader_t *header;       /**< Mapped segment */
+    uint8_t            *data;           /**< Data in the segment */
+    size_t              mapSize;        /**< Size of the mapping */
+    const void         *region;         /**< Published region, writer only */
+    uint32_t            size;           /**< Size of the data */
+    char                name[64];       /**< Name of the segment, writer only, for unlink */
+} CO_Linux_shm_t;
+
+
+/**
+ * Create shared memory segment and publish the region for the first time.
+ *
+ * Existing segment with the same name is replaced.
+ *
+ * @param shm This object will be initialized.
+ * @param name Name of the segment for shm_open(), for example "/canopen".
+ * @param region Memory region to publish, for example &CO_OD_RAM.
+ * @param size Size of the region in bytes.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_Linux_shmCreate(
+        CO_Linux_shm_t         *shm,
+        const char             *name,
+        const void             *region,
+        uint32_t                size);
+
+/**
+ * Copy the region into the shared memory segment.
+ *
+ * Function must be called by single thread, with the region locked
+ * (CO_LOCK_OD()).
+ *
+ * @param shm This object.
+ */
+void CO_Linux_shmPublish(CO_Linux_shm_t *shm);
+
+/**
+ * Open existing shared memory segment for reading.
+ *
+ * @param shm This object will be initialized.
+ * @param name Name of the segment.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_DATA_CORRUPT, if segment has wrong header.
+ */
+CO_ReturnError_t CO_Linux_shmOpen(
+        CO_Linux_shm_t         *shm,
+        const char             *name);
+
+/**
+ * Read consistent snapshot of data from the shared memory segment.
+ *
+ * @param shm This object.
+ * @param offset Offset of the data in the region.
+ * @param buf Buffer for the data.
+ * @param count Number of bytes to read.
+ * @param seq If not NULL, sequence counter of the snapshot is written here.
+ * It increments by 2 with each CO_Linux_shmPublish(), so reader may detect
+ * new data.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_TIMEOUT, if snapshot was not consistent after
+ * CO_LINUX_SHM_READ_RETRIES attempts.
+ */
+CO_ReturnError_t CO_Linux_shmRead(
+        const CO_Linux_shm_t   *shm,
+        uint32_t                offset,
+        void                   *buf,
+        uint32_t                count,
+        uint32_t               *seq);
+
+/**
+ * Unmap the segment. If this is the writer, segment is also unlinked.
+ *
+ * @param shm This object.
+ */
+void CO_Linux_shmClose(CO_Linux_shm_t *shm);
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Streams for SDO transfers from and to files on Linux.
+ *
+ * @file        CO_Linux_stream.c
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_Linux_stream.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/* Read from the file, if it is not mapped. */
+static int32_t streamRead(void *object, uint32_t offset, uint8_t *buf, uint16_t count) {
+    CO_Linux_stream_t *fs = (CO_Linux_stream_t *)object;
+    ssize_t n;
+
+    do {
+        n = pread(fs->fd, buf, count, (off_t)offset);
+    } while(n < 0 && errno == EINTR);
+
+    return (n < 0) ? -1 : (int32_t)n;
+}
+
+
+/* Write to the file. */
+static int32_t streamWrite(void *object, uint32_t offset, const uint8_t *buf, uint16_t count) {
+    CO_Linux_stream_t *fs = (CO_Linux_stream_t *)object;
+    uint16_t done = 0;
+
+    while(done < count) {
+        ssize_t n = pwrite(fs->fd, buf + done, count - done, (off_t)offset + done);
+
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            return -1;
+        }
+        done += (uint16_t)n;
+    }
+
+    return count;
+}
+
+
+/* Initialize the object with closed file. */
+static void streamClear(CO_Linux_stream_t *fs) {
+    memset(&fs->stream, 0, sizeof(fs->stream));
+    fs->stream.object = fs;
+    fs->fd = -1;
+    fs->map = NULL;
+    fs->mapSize = 0;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_Linux_streamOpenRead(
+        CO_Linux_stream_t      *fs,
+        const char             *fileName)
+{
+    struct stat st;
+
+    /* verify arguments */
+    if(fs == NULL || fileName == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    streamClear(fs);
+    fs->fd = open(fileName, O_RDONLY | O_CLOEXEC);
+    if(fs->fd < 0 || fstat(fs->fd, &st) != 0 || st.st_size > (off_t)0xFFFFFFFFUL) {
+        CO_Linux_streamClose(fs);
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* map regular file, data are read sequentially */
+    if(S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fs->fd, 0);
+
+        if(map != MAP_FAILED) {
+            madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+            fs->map = (uint8_t *)map;
+            fs->mapSize = (size_t)st.st_size;
+            fs->stream.data = fs->map;
+        }
+    }
+
+    fs->stream.size = (uint32_t)st.st_size;
+    fs->stream.read = streamRead;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_Linux_streamOpenWrite(
+        CO_Linux_stream_t      *fs,
+        const char             *fileName,
+        uint32_t                maxSize)
+{
+    /* verify arguments */
+    if(fs == NULL || fileName == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    streamClear(fs);
+    fs->fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fs->fd < 0) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    fs->stream.size = maxSize;
+    fs->stream.write = streamWrite;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_Linux_streamClose(CO_Linux_stream_t *fs) {
+    if(fs == NULL) {
+        return;
+    }
+    if(fs->map != NULL) {
+        munmap(fs->map, fs->mapSize);
+    }
+    if(fs->fd >= 0) {
+        close(fs->fd);
+    }
+    streamClear(fs);
+}
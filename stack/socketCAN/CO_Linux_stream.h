@@ -0,0 +1,92 @@
+/**
+ * Streams for SDO transfers from and to files on Linux.
+ *
+ * @file        CO_Linux_stream.h
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_LINUX_STREAM_H
+#define CO_LINUX_STREAM_H
+
+#include <stddef.h>
+
+
+/**
+ * File stream object.
+ *
+ * Contains CO_SDO_stream_t, which may be used with
+ * CO_SDOclientDownloadInitiateStream(), CO_SDOclientUploadInitiateStream()
+ * or CO_OD_configureStream().
+ *
+ * File opened for reading is mapped into memory, so SDO sends data directly
+ * from the page cache, without intermediate copies and without reading the
+ * whole file first. Pages are loaded on demand. If file can not be mapped
+ * (empty file or not a regular file), it is read with pread().
+ *
+ * File opened for writing is written with pwrite() from the window of the SDO
+ * client or from the SDO buffer of the server, because size of the uploaded
+ * data is not known in advance.
+ */
+typedef struct {
+    CO_SDO_stream_t     stream;         /**< Stream for SDO */
+    int                 fd;             /**< File descriptor or -1 */
+    uint8_t            *map;            /**< Mapped file or NULL */
+    size_t              mapSize;        /**< Size of the mapping */
+} CO_Linux_stream_t;
+
+
+/**
+ * Open file for reading as SDO stream.
+ *
+ * Stream must not be used for writing (download to the SDO server).
+ *
+ * @param fs This object will be initialized.
+ * @param fileName Name of the file, maximum size is 4 GiB - 1.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_Linux_streamOpenRead(
+        CO_Linux_stream_t      *fs,
+        const char             *fileName);
+
+
+/**
+ * Open file for writing as SDO stream. File is truncated.
+ *
+ * @param fs This object will be initialized.
+ * @param fileName Name of the file.
+ * @param maxSize Maximum number of bytes written, 0 if not limited.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_Linux_streamOpenWrite(
+        CO_Linux_stream_t      *fs,
+        const char             *fileName,
+        uint32_t                maxSize);
+
+
+/**
+ * Unmap and close the file.
+ *
+ * @param fs This object.
+ */
+void CO_Linux_streamClose(CO_Linux_stream_t *fs);
+
+#endif
@@ -25,6 +25,7 @@
 
 
 #include "CANopen.h"
+#include "CO_Linux_tasks.h"
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/timerfd.h>
@@ -40,6 +41,55 @@ void CO_errExit(char* msg);
 void CO_error(const uint32_t info);
 
 
+/* Clock source ***************************************************************/
+static int monotonic_gettime(void *object, struct timespec *ts) {
+    return clock_gettime(CLOCK_MONOTONIC, ts);
+}
+
+static int monotonic_timerCreate(void *object) {
+    return timerfd_create(CLOCK_MONOTONIC, 0);
+}
+
+static int monotonic_timerSet(void *object, int fd, int flags, const struct itimerspec *newValue) {
+    return timerfd_settime(fd, flags, newValue, NULL);
+}
+
+static int monotonic_timerRead(void *object, int fd, uint64_t *expirations) {
+    return read(fd, expirations, sizeof(uint64_t));
+}
+
+static void monotonic_timerClose(void *object, int fd) {
+    close(fd);
+}
+
+const CO_taskClock_t CO_taskClockMonotonic = {
+    NULL,
+    true,
+    monotonic_gettime,
+    monotonic_timerCreate,
+    monotonic_timerSet,
+    monotonic_timerRead,
+    monotonic_timerClose
+};
+
+static const CO_taskClock_t *taskClock = &CO_taskClockMonotonic;
+
+
+void CO_taskClock_set(const CO_taskClock_t *clock) {
+    taskClock = (clock != NULL) ? clock : &CO_taskClockMonotonic;
+}
+
+
+uint16_t CO_taskClock_timer1ms(void) {
+    struct timespec ts;
+
+    if(taskClock->gettime(taskClock->object, &ts) != 0)
+        CO_error(0x20100000L + errno);
+
+    return (uint16_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / NSEC_PER_MSEC);
+}
+
+
 /* Mainline task (taskMain) ***************************************************/
 static struct {
     int                 fdTmr;          /* file descriptor for taskTmr */
@@ -47,6 +97,7 @@ static struct {
     struct itimerspec   tmrSpec;
     uint16_t            tmr1msPrev;
     uint16_t           *maxTime;
+    CO_SDOengine_t     *engine;
 } taskMain;
 
 
@@ -77,7 +128,7 @@ void taskMain_init(int fdEpoll, uint16_t *maxTime) {
         CO_errExit("taskMain_init - fcntl-F_SETFL[1] failed");
 
     /* get file descriptor for timer */
-    taskMain.fdTmr = timerfd_create(CLOCK_MONOTONIC, 0);
+    taskMain.fdTmr = taskClock->timerCreate(taskClock->object);
     if(taskMain.fdTmr == -1)
         CO_errExit("taskMain_init - timerfd_create failed");
 
@@ -87,10 +138,12 @@ void taskMain_init(int fdEpoll, uint16_t *maxTime) {
     if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, taskMain.fdPipe[0], &ev) == -1)
         CO_errExit("taskMain_init - epoll_ctl CANrx failed");
 
-    ev.events = EPOLLIN;
-    ev.data.fd = taskMain.fdTmr;
-    if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, taskMain.fdTmr, &ev) == -1)
-        CO_errExit("taskMain_init - epoll_ctl taskTmr failed");
+    if(taskClock->pollable) {
+        ev.events = EPOLLIN;
+        ev.data.fd = taskMain.fdTmr;
+        if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, taskMain.fdTmr, &ev) == -1)
+            CO_errExit("taskMain_init - epoll_ctl taskTmr failed");
+    }
 
     /* Prepare timer, use no interval, delay time will be set each cycle. */
     taskMain.tmrSpec.it_interval.tv_sec = 0;
@@ -99,7 +152,7 @@ void taskMain_init(int fdEpoll, uint16_t *maxTime) {
     taskMain.tmrSpec.it_value.tv_sec = 0;
     taskMain.tmrSpec.it_value.tv_nsec = 1;
 
-    if(timerfd_settime(taskMain.fdTmr, 0, &taskMain.tmrSpec, NULL) != 0)
+    if(taskClock->timerSet(taskClock->object, taskMain.fdTmr, 0, &taskMain.tmrSpec) != 0)
         CO_errExit("taskMain_init - timerfd_settime failed");
 
     taskMain.tmr1msPrev = 0;
@@ -110,7 +163,7 @@ void taskMain_init(int fdEpoll, uint16_t *maxTime) {
 void taskMain_close(void) {
     close(taskMain.fdPipe[0]);
     close(taskMain.fdPipe[1]);
-    close(taskMain.fdTmr);
+    taskClock->timerClose(taskClock->object, taskMain.fdTmr);
 }
 
 
@@ -133,7 +186,7 @@ bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
     /* Timer expired. */
     else if(fd == taskMain.fdTmr) {
         uint64_t tmrExp;
-        if(read(taskMain.fdTmr, &tmrExp, sizeof(tmrExp)) != sizeof(uint64_t))
+        if(taskClock->timerRead(taskClock->object, taskMain.fdTmr, &tmrExp) != sizeof(uint64_t))
             CO_error(0x21200000L + errno);
     }
     else {
@@ -160,10 +213,15 @@ bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
         /* CANopen process */
         *reset = CO_process(CO, timer1msDiff, &timerNext);
 
+        /* SDO client engine */
+        if(taskMain.engine != NULL) {
+            CO_SDOengine_process(taskMain.engine, timer1msDiff, &timerNext);
+        }
+
 
         /* Set delay for next sleep. */
         taskMain.tmrSpec.it_value.tv_nsec = (long)(++timerNext) * NSEC_PER_MSEC;
-        if(timerfd_settime(taskMain.fdTmr, 0, &taskMain.tmrSpec, NULL) == -1)
+        if(taskClock->timerSet(taskClock->object, taskMain.fdTmr, 0, &taskMain.tmrSpec) == -1)
             CO_error(0x21500000L + errno);
 
     }
@@ -172,6 +230,14 @@ bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
 }
 
 
+void taskMain_setSDOengine(CO_SDOengine_t *engine) {
+    taskMain.engine = engine;
+    if(engine != NULL) {
+        CO_SDOengine_initCallback(engine, taskMain_cbSignal);
+    }
+}
+
+
 void taskMain_cbSignal(void) {
     if(write(taskMain.fdPipe[1], "x", 1) == -1)
         CO_error(0x23100000L + errno);
@@ -187,6 +253,7 @@ static struct {
     long                intervalns;
     long                intervalus;
     uint16_t           *maxTime;
+    CO_Linux_shm_t     *shm;
 } taskRT;
 
 
@@ -196,7 +263,7 @@ void CANrx_taskTmr_init(int fdEpoll, long intervalns, uint16_t *maxTime) {
     /* get file descriptors */
     taskRT.fdRx0 = CO->CANmodule[0]->fd;
 
-    taskRT.fdTmr = timerfd_create(CLOCK_MONOTONIC, 0);
+    taskRT.fdTmr = taskClock->timerCreate(taskClock->object);
     if(taskRT.fdTmr == -1)
         CO_errExit("CANrx_taskTmr_init - timerfd_create failed");
 
@@ -206,10 +273,12 @@ void CANrx_taskTmr_init(int fdEpoll, long intervalns, uint16_t *maxTime) {
     if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, taskRT.fdRx0, &ev) == -1)
         CO_errExit("CANrx_taskTmr_init - epoll_ctl CANrx failed");
 
-    ev.events = EPOLLIN;
-    ev.data.fd = taskRT.fdTmr;
-    if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, taskRT.fdTmr, &ev) == -1)
-        CO_errExit("CANrx_taskTmr_init - epoll_ctl taskTmr failed");
+    if(taskClock->pollable) {
+        ev.events = EPOLLIN;
+        ev.data.fd = taskRT.fdTmr;
+        if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, taskRT.fdTmr, &ev) == -1)
+            CO_errExit("CANrx_taskTmr_init - epoll_ctl taskTmr failed");
+    }
 
     /* Prepare timer (one shot, each time calculate new expiration time) It is
      * necessary not to use taskRT.tmrSpec.it_interval, because it is sliding. */
@@ -217,10 +286,10 @@ void CANrx_taskTmr_init(int fdEpoll, long intervalns, uint16_t *maxTime) {
     taskRT.tmrSpec.it_interval.tv_nsec = 0;
 
     taskRT.tmrVal = &taskRT.tmrSpec.it_value;
-    if(clock_gettime(CLOCK_MONOTONIC, taskRT.tmrVal) != 0)
+    if(taskClock->gettime(taskClock->object, taskRT.tmrVal) != 0)
         CO_errExit("CANrx_taskTmr_init - clock_gettime failed");
 
-    if(timerfd_settime(taskRT.fdTmr, TFD_TIMER_ABSTIME, &taskRT.tmrSpec, NULL) != 0)
+    if(taskClock->timerSet(taskClock->object, taskRT.fdTmr, TFD_TIMER_ABSTIME, &taskRT.tmrSpec) != 0)
         CO_errExit("CANrx_taskTmr_init - timerfd_settime failed");
 
     taskRT.intervalns = intervalns;
@@ -230,7 +299,7 @@ void CANrx_taskTmr_init(int fdEpoll, long intervalns, uint16_t *maxTime) {
 
 
 void CANrx_taskTmr_close(void) {
-    close(taskRT.fdTmr);
+    taskClock->timerClose(taskClock->object, taskRT.fdTmr);
 }
 
 
@@ -247,13 +316,13 @@ bool_t CANrx_taskTmr_process(int fd) {
         uint64_t tmrExp;
 
         /* Wait for timer to expire */
-        if(read(taskRT.fdTmr, &tmrExp, sizeof(tmrExp)) != sizeof(uint64_t))
+        if(taskClock->timerRead(taskClock->object, taskRT.fdTmr, &tmrExp) != sizeof(uint64_t))
             CO_error(0x22100000L + errno);
 
         /* Calculate maximum interval in microseconds (informative) */
         if(taskRT.maxTime != NULL) {
             struct timespec tmrMeasure;
-            if(clock_gettime(CLOCK_MONOTONIC, &tmrMeasure) == -1)
+            if(taskClock->gettime(taskClock->object, &tmrMeasure) == -1)
                 CO_error(0x22200000L + errno);
             if(tmrMeasure.tv_sec == taskRT.tmrVal->tv_sec) {
                 long dt = tmrMeasure.tv_nsec - taskRT.tmrVal->tv_nsec;
@@ -273,7 +342,7 @@ bool_t CANrx_taskTmr_process(int fd) {
             taskRT.tmrVal->tv_nsec -= NSEC_PER_SEC;
             taskRT.tmrVal->tv_sec++;
         }
-        if(timerfd_settime(taskRT.fdTmr, TFD_TIMER_ABSTIME, &taskRT.tmrSpec, NULL) == -1)
+        if(taskClock->timerSet(taskClock->object, taskRT.fdTmr, TFD_TIMER_ABSTIME, &taskRT.tmrSpec) == -1)
             CO_error(0x22300000L + errno);
 
 
@@ -292,6 +361,11 @@ bool_t CANrx_taskTmr_process(int fd) {
             CO_process_TPDO(CO, syncWas, taskRT.intervalus);
         }
 
+        /* Publish process image for other processes */
+        if(taskRT.shm != NULL) {
+            CO_Linux_shmPublish(taskRT.shm);
+        }
+
         /* Unlock */
         CO_UNLOCK_OD();
     }
@@ -302,3 +376,8 @@ bool_t CANrx_taskTmr_process(int fd) {
 
     return wasProcessed;
 }
+
+
+void CANrx_taskTmr_setShm(CO_Linux_shm_t *shm) {
+    taskRT.shm = shm;
+}
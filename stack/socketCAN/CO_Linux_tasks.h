@@ -27,6 +27,54 @@
 #ifndef CO_LINUX_TASKS_H
 #define CO_LINUX_TASKS_H
 
+#include <time.h>
+#include "CO_SDOengine.h"
+#include "CO_Linux_shm.h"
+
+
+/**
+ * Clock and timer source for the tasks.
+ *
+ * Tasks read time and use one-shot timers only through this interface.
+ * Default source is CO_taskClockMonotonic, which uses CLOCK_MONOTONIC and
+ * Linux timerfd. Other source, for example virtual time from
+ * CO_Linux_vclock.h, may be set with CO_taskClock_set() before tasks are
+ * initialized. Functions have the same semantics and return values as
+ * clock_gettime(), timerfd_create(), timerfd_settime(), read() and close().
+ */
+typedef struct CO_taskClock_t {
+    void               *object;         /**< Object passed to functions */
+    /** If true, timer file descriptors are added to epoll. If false,
+     * application must pass expired timer to the *_process() functions. */
+    bool_t              pollable;
+    int               (*gettime)(void *object, struct timespec *ts);
+    int               (*timerCreate)(void *object);
+    int               (*timerSet)(void *object, int fd, int flags, const struct itimerspec *newValue);
+    int               (*timerRead)(void *object, int fd, uint64_t *expirations);
+    void              (*timerClose)(void *object, int fd);
+} CO_taskClock_t;
+
+/** Clock source with CLOCK_MONOTONIC and timerfd. */
+extern const CO_taskClock_t CO_taskClockMonotonic;
+
+/**
+ * Set clock source for the tasks.
+ *
+ * Must be called before taskMain_init() and CANrx_taskTmr_init().
+ *
+ * @param clock Clock source. If NULL, CO_taskClockMonotonic is used.
+ */
+void CO_taskClock_set(const CO_taskClock_t *clock);
+
+/**
+ * Get millisecond timer from the clock source of the tasks.
+ *
+ * It may be used as timer1ms argument of taskMain_process().
+ *
+ * @return Time in milliseconds, overflows at 16 bits.
+ */
+uint16_t CO_taskClock_timer1ms(void);
+
 
 /**
  * Initialize mainline task.
@@ -60,6 +108,17 @@ void taskMain_close(void);
  */
 bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms);
 
+/**
+ * Process SDO client engine in mainline task.
+ *
+ * Engine is processed after CO_process() in taskMain_process().
+ * taskMain_cbSignal() is set as its callback, so received SDO responses
+ * trigger mainline task immediately.
+ *
+ * @param engine SDO client engine or NULL.
+ */
+void taskMain_setSDOengine(CO_SDOengine_t *engine);
+
 /**
  * Signal function, which triggers mainline task.
  *
@@ -103,6 +162,16 @@ void CANrx_taskTmr_close(void);
  */
 bool_t CANrx_taskTmr_process(int fd);
 
+/**
+ * Publish process image from realtime task.
+ *
+ * If set, CO_Linux_shmPublish() is called in CANrx_taskTmr_process() after
+ * CO_process_TPDO(), while Object Dictionary is still locked.
+ *
+ * @param shm Shared process image created with CO_Linux_shmCreate() or NULL.
+ */
+void CANrx_taskTmr_setShm(CO_Linux_shm_t *shm);
+
 /**
  * Disable CAN receive thread temporary.
  *
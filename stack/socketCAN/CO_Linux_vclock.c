@@ -0,0 +1,227 @@
+/*
+ * Virtual time clock source for CANopen tasks in Linux.
+ *
+ * @file        CO_Linux_vclock.c
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CANopen.h"
+#include "CO_Linux_vclock.h"
+#include <errno.h>
+#include <sys/timerfd.h>
+
+
+#define NSEC_PER_SEC            (1000000000ULL) /* The number of nanoseconds per second. */
+
+
+static uint64_t ts2ns(const struct timespec *ts) {
+    return (uint64_t)ts->tv_sec * NSEC_PER_SEC + (uint64_t)ts->tv_nsec;
+}
+
+
+/* Get timer index from file descriptor, -1 if invalid. */
+static int vclock_index(CO_vclock_t *vclock, int fd) {
+    int i = fd - CO_VCLOCK_FD_BASE;
+
+    if(i < 0 || i >= CO_VCLOCK_NO_TIMERS || !vclock->timer[i].used) {
+        errno = EBADF;
+        return -1;
+    }
+    return i;
+}
+
+
+/* Register expirations of timer up to current time. */
+static void vclock_update(CO_vclock_t *vclock, int i) {
+    if(vclock->timer[i].armed && vclock->timer[i].expire_ns <= vclock->time_ns) {
+        if(vclock->timer[i].interval_ns == 0) {
+            vclock->timer[i].expirations++;
+            vclock->timer[i].armed = false;
+        }
+        else {
+            uint64_t n = (vclock->time_ns - vclock->timer[i].expire_ns)
+                       / vclock->timer[i].interval_ns + 1;
+            vclock->timer[i].expirations += n;
+            vclock->timer[i].expire_ns += n * vclock->timer[i].interval_ns;
+        }
+    }
+}
+
+
+/* Functions for CO_taskClock_t ***********************************************/
+static int vclock_gettime(void *object, struct timespec *ts) {
+    CO_vclock_t *vclock = (CO_vclock_t*)object;
+
+    ts->tv_sec = (time_t)(vclock->time_ns / NSEC_PER_SEC);
+    ts->tv_nsec = (long)(vclock->time_ns % NSEC_PER_SEC);
+    return 0;
+}
+
+
+static int vclock_timerCreate(void *object) {
+    CO_vclock_t *vclock = (CO_vclock_t*)object;
+    int i;
+
+    for(i = 0; i < CO_VCLOCK_NO_TIMERS; i++) {
+        if(!vclock->timer[i].used) {
+            vclock->timer[i].used = true;
+            vclock->timer[i].armed = false;
+            vclock->timer[i].expirations = 0;
+            return CO_VCLOCK_FD_BASE + i;
+        }
+    }
+    errno = EMFILE;
+    return -1;
+}
+
+
+static int vclock_timerSet(void *object, int fd, int flags, const struct itimerspec *newValue) {
+    CO_vclock_t *vclock = (CO_vclock_t*)object;
+    int i = vclock_index(vclock, fd);
+    uint64_t value;
+
+    if(i < 0) {
+        return -1;
+    }
+
+    value = ts2ns(&newValue->it_value);
+    vclock->timer[i].interval_ns = ts2ns(&newValue->it_interval);
+    vclock->timer[i].expirations = 0;
+
+    if(value == 0) {
+        vclock->timer[i].armed = false;
+    }
+    else {
+        vclock->timer[i].armed = true;
+        vclock->timer[i].expire_ns = ((flags & TFD_TIMER_ABSTIME) != 0) ?
+                                     value : vclock->time_ns + value;
+        vclock_update(vclock, i);
+    }
+    return 0;
+}
+
+
+static int vclock_timerRead(void *object, int fd, uint64_t *expirations) {
+    CO_vclock_t *vclock = (CO_vclock_t*)object;
+    int i = vclock_index(vclock, fd);
+
+    if(i < 0) {
+        return -1;
+    }
+    if(vclock->timer[i].expirations == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    *expirations = vclock->timer[i].expirations;
+    vclock->timer[i].expirations = 0;
+    return sizeof(uint64_t);
+}
+
+
+static void vclock_timerClose(void *object, int fd) {
+    CO_vclock_t *vclock = (CO_vclock_t*)object;
+    int i = vclock_index(vclock, fd);
+
+    if(i >= 0) {
+        vclock->timer[i].used = false;
+        vclock->timer[i].armed = false;
+    }
+}
+
+
+/******************************************************************************/
+void CO_vclock_init(CO_vclock_t *vclock, uint64_t startTime_ns) {
+    int i;
+
+    vclock->time_ns = startTime_ns;
+    for(i = 0; i < CO_VCLOCK_NO_TIMERS; i++) {
+        vclock->timer[i].used = false;
+        vclock->timer[i].armed = false;
+        vclock->timer[i].expirations = 0;
+    }
+
+    vclock->clock.object = vclock;
+    vclock->clock.pollable = false;
+    vclock->clock.gettime = vclock_gettime;
+    vclock->clock.timerCreate = vclock_timerCreate;
+    vclock->clock.timerSet = vclock_timerSet;
+    vclock->clock.timerRead = vclock_timerRead;
+    vclock->clock.timerClose = vclock_timerClose;
+}
+
+
+/******************************************************************************/
+uint64_t CO_vclock_now(const CO_vclock_t *vclock) {
+    return vclock->time_ns;
+}
+
+
+/******************************************************************************/
+int CO_vclock_next(CO_vclock_t *vclock, uint64_t limit_ns) {
+    int i, next = -1;
+
+    /* Timer, which has already expired and was not read yet, comes first. */
+    for(i = 0; i < CO_VCLOCK_NO_TIMERS; i++) {
+        if(vclock->timer[i].used && vclock->timer[i].expirations != 0) {
+            return CO_VCLOCK_FD_BASE + i;
+        }
+    }
+
+    /* Find the earliest deadline. On equal deadlines lower index wins, so
+     * order of execution is deterministic. */
+    for(i = 0; i < CO_VCLOCK_NO_TIMERS; i++) {
+        if(vclock->timer[i].used && vclock->timer[i].armed
+            && vclock->timer[i].expire_ns <= limit_ns
+            && (next < 0 || vclock->timer[i].expire_ns < vclock->timer[next].expire_ns))
+        {
+            next = i;
+        }
+    }
+
+    if(next < 0) {
+        if(limit_ns > vclock->time_ns) {
+            vclock->time_ns = limit_ns;
+        }
+        return -1;
+    }
+
+    if(vclock->timer[next].expire_ns > vclock->time_ns) {
+        vclock->time_ns = vclock->timer[next].expire_ns;
+    }
+    for(i = 0; i < CO_VCLOCK_NO_TIMERS; i++) {
+        if(vclock->timer[i].used) {
+            vclock_update(vclock, i);
+        }
+    }
+    return CO_VCLOCK_FD_BASE + next;
+}
+
+
+/******************************************************************************/
+void CO_vclock_advance(CO_vclock_t *vclock, uint64_t interval_ns) {
+    int i;
+
+    vclock->time_ns += interval_ns;
+    for(i = 0; i < CO_VCLOCK_NO_TIMERS; i++) {
+        if(vclock->timer[i].used) {
+            vclock_update(vclock, i);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * Virtual time clock source for CANopen tasks in Linux.
+ *
+ * @file        CO_Linux_vclock.h
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_LINUX_VCLOCK_H
+#define CO_LINUX_VCLOCK_H
+
+#include "CO_Linux_tasks.h"
+
+
+/**
+ * Number of timers in virtual clock. taskMain and taskRT use one each.
+ */
+#ifndef CO_VCLOCK_NO_TIMERS
+    #define CO_VCLOCK_NO_TIMERS     4
+#endif
+
+/**
+ * Timer file descriptors of virtual clock are CO_VCLOCK_FD_BASE + index.
+ * They are not real file descriptors, so they can not be added to epoll.
+ */
+#define CO_VCLOCK_FD_BASE           0x40000000
+
+
+/**
+ * Virtual clock object.
+ *
+ * Time does not run by itself. Application calls CO_vclock_next(), which
+ * jumps straight to the earliest timer deadline, and then passes returned
+ * file descriptor to taskMain_process() or CANrx_taskTmr_process(). So long
+ * soak tests run as fast as processing allows and are exactly reproducible.
+ *
+ * Usage:
+ * @code
+ * CO_vclock_init(&vclock, 0);
+ * CO_taskClock_set(&vclock.clock);
+ * taskMain_init(fdEpoll, &maxTime);
+ * CANrx_taskTmr_init(fdEpoll, 1000000, &maxTime);
+ * while(CO_vclock_now(&vclock) < endTime) {
+ *     int fd = CO_vclock_next(&vclock, endTime);
+ *     if(!CANrx_taskTmr_process(fd))
+ *         taskMain_process(fd, &reset, CO_taskClock_timer1ms());
+ * }
+ * @endcode
+ */
+typedef struct {
+    uint64_t            time_ns;        /**< Current virtual time */
+    struct {
+        bool_t          used;
+        bool_t          armed;
+        uint64_t        expire_ns;      /**< Absolute time of next expiration */
+        uint64_t        interval_ns;    /**< Period, 0 for one-shot timer */
+        uint64_t        expirations;    /**< Expirations not yet read */
+    } timer[CO_VCLOCK_NO_TIMERS];
+    CO_taskClock_t      clock;          /**< Clock source for CO_taskClock_set() */
+} CO_vclock_t;
+
+
+/**
+ * Initialize virtual clock.
+ *
+ * @param vclock This object will be initialized.
+ * @param startTime_ns Initial virtual time in nanoseconds.
+ */
+void CO_vclock_init(CO_vclock_t *vclock, uint64_t startTime_ns);
+
+/**
+ * Get current virtual time.
+ *
+ * @param vclock This object.
+ *
+ * @return Time in nanoseconds.
+ */
+uint64_t CO_vclock_now(const CO_vclock_t *vclock);
+
+/**
+ * Advance virtual time to the next timer deadline.
+ *
+ * If earliest armed timer expires before or at limit_ns, time is set to its
+ * deadline, timer expiration is registered and its file descriptor is
+ * returned. Otherwise time is set to limit_ns.
+ *
+ * @param vclock This object.
+ * @param limit_ns Time, over which clock will not advance.
+ *
+ * @return File descriptor of expired timer or -1, if no timer expired.
+ */
+int CO_vclock_next(CO_vclock_t *vclock, uint64_t limit_ns);
+
+/**
+ * Advance virtual time by specified interval.
+ *
+ * Expirations of all timers, which expire in that interval, are registered,
+ * but no file descriptor is returned. Use it for simulating processing time.
+ *
+ * @param vclock This object.
+ * @param interval_ns Time interval in nanoseconds.
+ */
+void CO_vclock_advance(CO_vclock_t *vclock, uint64_t interval_ns);
+
+#endif
@@ -33,64 +33,239 @@
 #include <stdio.h>
 #include <string.h>     /* for memcpy */
 #include <stdlib.h>     /* for malloc, free */
+#include <time.h>
+#ifdef CO_OD_STORAGE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 
 #define RETURN_SUCCESS  0
 #define RETURN_ERROR   -1
 
 
+/* True, if worker thread is writing or going to write a snapshot. */
+static bool_t workerBusy(CO_OD_storage_t *odStor) {
+    bool_t busy = false;
+
+    if(odStor->workerRunning) {
+        pthread_mutex_lock(&odStor->workerMtx);
+        busy = odStor->workerState == CO_OD_STORAGE_WORKER_REQUEST
+            || odStor->workerState == CO_OD_STORAGE_WORKER_BUSY;
+        pthread_mutex_unlock(&odStor->workerMtx);
+    }
+    return busy;
+}
+
+
+#ifdef CO_USE_STATISTICS
+static uint64_t time_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+
+
+/* True, if storage group is selected by subindex of 1010 or 1011. Subindex 1
+ * selects all groups. Object without group is selected by subindex 1 of 1010
+ * and by any subindex of 1011. */
+static bool_t groupSelected(CO_OD_storage_t *odStor, uint8_t subIndex, bool_t restore) {
+    if(subIndex == 1 || odStor->group == subIndex) {
+        return true;
+    }
+    return restore && odStor->group == 0 && subIndex > 1;
+}
+
+
+#ifndef CO_OD_STORAGE_MMAP
+/* File opened by CO_OD_storage_autoSave() was renamed to '.old' and replaced
+ * (also on error, old file is then renamed back). autoSave reopens it and
+ * writes all pages. */
+static void setFileReplaced(CO_OD_storage_t *odStor) {
+    if(odStor->workerRunning) {
+        pthread_mutex_lock(&odStor->workerMtx);
+        odStor->fileReplaced = true;
+        pthread_mutex_unlock(&odStor->workerMtx);
+    }
+    else {
+        odStor->fileReplaced = true;
+    }
+}
+#endif
+
+
+/* Save or restore one group synchronously. */
+static int saveGroup(CO_OD_storage_t *odStor) {
+#ifdef CO_OD_STORAGE_MMAP
+    return CO_OD_storage_saveSlot(odStor);
+#else
+    int ret = CO_OD_storage_saveSecure(odStor->odAddress, odStor->odSize, odStor->filename);
+
+    setFileReplaced(odStor);
+    return ret;
+#endif
+}
+
+static int restoreGroup(CO_OD_storage_t *odStor) {
+#ifdef CO_OD_STORAGE_MMAP
+    return CO_OD_storage_restoreSlot(odStor);
+#else
+    int ret = CO_OD_storage_restoreSecure(odStor->filename);
+
+    setFileReplaced(odStor);
+    return ret;
+#endif
+}
+
+
 /******************************************************************************/
 CO_SDO_abortCode_t CO_ODF_1010(CO_ODF_arg_t *ODF_arg) {
-    CO_OD_storage_t *odStor;
+    CO_OD_storage_t *first, *odStor;
     uint32_t value;
     CO_SDO_abortCode_t ret = CO_SDO_AB_NONE;
+#ifdef CO_USE_STATISTICS
+    uint64_t t0 = time_us();
+    uint32_t t;
+#endif
 
-    odStor = (CO_OD_storage_t*) ODF_arg->object;
+    first = (CO_OD_storage_t*) ODF_arg->object;
     value = CO_getUint32(ODF_arg->data);
 
-    if(!ODF_arg->reading) {
+    if(ODF_arg->pending) {
+        /* SDO server waits for the workers */
+        bool_t busy = false;
+        bool_t error = false;
+
+        for(odStor = first; odStor != NULL; odStor = odStor->next) {
+            if(odStor->savePending) {
+                int result = CO_OD_storage_saveAsyncResult(odStor);
+                if(result == 1) {
+                    busy = true;
+                }
+                else if(result != 0) {
+                    error = true;
+                }
+            }
+        }
+        if(!busy) {
+            for(odStor = first; odStor != NULL; odStor = odStor->next) {
+                odStor->savePending = false;
+            }
+            ODF_arg->pending = false;
+            if(error) {
+                ret = CO_SDO_AB_HW;
+            }
+        }
+    }
+    else if(!ODF_arg->reading) {
+        bool_t selected = false;
+        bool_t busy = false;
+
         /* don't change the old value */
         CO_memcpy(ODF_arg->data, (const uint8_t*)ODF_arg->ODdataStorage, 4U);
 
-        if(ODF_arg->subIndex == 1) {
-            /* store parameters */
-            if(value == 0x65766173UL) {
-                if(CO_OD_storage_saveSecure(odStor->odAddress, odStor->odSize, odStor->filename) != 0) {
+        for(odStor = first; odStor != NULL; odStor = odStor->next) {
+            odStor->savePending = false;
+            if(groupSelected(odStor, ODF_arg->subIndex, false)) {
+                selected = true;
+                if(workerBusy(odStor)) {
+                    busy = true;
+                }
+            }
+        }
+
+        /* store parameters of selected groups */
+        if(!selected) {
+            /* nothing to store */
+        }
+        else if(value != 0x65766173UL) {
+            ret = CO_SDO_AB_DATA_TRANSF;
+        }
+        else if(busy) {
+            ret = CO_SDO_AB_DATA_DEV_STATE;
+        }
+        else {
+            for(odStor = first; odStor != NULL; odStor = odStor->next) {
+                if(!groupSelected(odStor, ODF_arg->subIndex, false)) {
+                    continue;
+                }
+                if(odStor->workerRunning) {
+                    /* finish SDO transfer, when worker completes */
+                    if(CO_OD_storage_saveAsync(odStor) == 0) {
+                        odStor->savePending = true;
+                        ODF_arg->pending = true;
+                    }
+                    else {
+                        ret = CO_SDO_AB_HW;
+                    }
+                }
+                else if(saveGroup(odStor) != 0) {
                     ret = CO_SDO_AB_HW;
                 }
             }
-            else {
-                ret = CO_SDO_AB_DATA_TRANSF;
+            if(ret != CO_SDO_AB_NONE) {
+                ODF_arg->pending = false;
             }
         }
     }
 
+#ifdef CO_USE_STATISTICS
+    t = (uint32_t)(time_us() - t0);
+    if(t > first->stats.mainlineTimeMax_us) {
+        first->stats.mainlineTimeMax_us = t;
+    }
+#endif
+
     return ret;
 }
 
 
 /******************************************************************************/
 CO_SDO_abortCode_t CO_ODF_1011(CO_ODF_arg_t *ODF_arg) {
-    CO_OD_storage_t *odStor;
+    CO_OD_storage_t *first, *odStor;
     uint32_t value;
     CO_SDO_abortCode_t ret = CO_SDO_AB_NONE;
 
-    odStor = (CO_OD_storage_t*) ODF_arg->object;
+    first = (CO_OD_storage_t*) ODF_arg->object;
     value = CO_getUint32(ODF_arg->data);
 
     if(!ODF_arg->reading) {
+        bool_t selected = false;
+        bool_t busy = false;
+
         /* don't change the old value */
         CO_memcpy(ODF_arg->data, (const uint8_t*)ODF_arg->ODdataStorage, 4U);
 
-        if(ODF_arg->subIndex >= 1) {
-            /* restore default parameters */
-            if(value == 0x64616F6CUL) {
-                if(CO_OD_storage_restoreSecure(odStor->filename) != 0) {
-                    ret = CO_SDO_AB_HW;
+        for(odStor = first; odStor != NULL; odStor = odStor->next) {
+            if(groupSelected(odStor, ODF_arg->subIndex, true)) {
+                selected = true;
+                if(workerBusy(odStor)) {
+                    busy = true;
                 }
             }
-            else {
-                ret = CO_SDO_AB_DATA_TRANSF;
+        }
+
+        /* restore default parameters of selected groups */
+        if(!selected) {
+            /* nothing to restore */
+        }
+        else if(value != 0x64616F6CUL) {
+            ret = CO_SDO_AB_DATA_TRANSF;
+        }
+        else if(busy) {
+            ret = CO_SDO_AB_DATA_DEV_STATE;
+        }
+        else {
+            for(odStor = first; odStor != NULL; odStor = odStor->next) {
+                if(groupSelected(odStor, ODF_arg->subIndex, true)
+                    && restoreGroup(odStor) != 0)
+                {
+                    ret = CO_SDO_AB_HW;
+                }
             }
         }
     }
@@ -100,10 +275,38 @@ CO_SDO_abortCode_t CO_ODF_1011(CO_ODF_arg_t *ODF_arg) {
 
 
 /******************************************************************************/
-int CO_OD_storage_saveSecure(
+CO_ReturnError_t CO_OD_storage_addGroup(
+        CO_OD_storage_t        *first,
+        CO_OD_storage_t        *odStor,
+        uint8_t                 subIndex)
+{
+    CO_OD_storage_t *last;
+
+    /* verify arguments */
+    if(first==NULL || odStor==NULL || subIndex < 2) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    odStor->group = subIndex;
+
+    /* append to the list, if not already there */
+    for(last = first; last != odStor && last->next != NULL; last = last->next);
+    if(last != odStor) {
+        last->next = odStor;
+        odStor->next = NULL;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/* Save memory block to a file, see CO_OD_storage_saveSecure(). Lock is not
+ * necessary for private snapshot of the OD. */
+static int saveSecure(
         uint8_t                *odAddress,
         uint32_t                odSize,
-        char                   *filename)
+        char                   *filename,
+        bool_t                  lockOD)
 {
     int ret = RETURN_SUCCESS;
 
@@ -129,10 +332,14 @@ int CO_OD_storage_saveSecure(
         FILE *fp = fopen(filename, "w");
         if(fp != NULL) {
 
-            CO_LOCK_OD();
+            if(lockOD) {
+                CO_LOCK_OD();
+            }
             fwrite((const void *)odAddress, 1, odSize, fp);
             CRC = crc16_ccitt((unsigned char*)odAddress, odSize, 0);
-            CO_UNLOCK_OD();
+            if(lockOD) {
+                CO_UNLOCK_OD();
+            }
 
             fwrite((const void *)&CRC, 1, 2, fp);
             fclose(fp);
@@ -178,6 +385,16 @@ int CO_OD_storage_saveSecure(
 }
 
 
+/******************************************************************************/
+int CO_OD_storage_saveSecure(
+        uint8_t                *odAddress,
+        uint32_t                odSize,
+        char                   *filename)
+{
+    return saveSecure(odAddress, odSize, filename, true);
+}
+
+
 /******************************************************************************/
 int CO_OD_storage_restoreSecure(char *filename) {
     int ret = RETURN_SUCCESS;
@@ -220,6 +437,315 @@ int CO_OD_storage_restoreSecure(char *filename) {
     return ret;
 }
 
+#ifdef CO_OD_STORAGE_MMAP
+/* Header at the beginning of each slot. */
+typedef struct {
+    uint32_t    magic;      /* CO_OD_STORAGE_SLOT_MAGIC, if slot is valid */
+    uint32_t    seq;        /* incremented with each save */
+    uint32_t    size;       /* size of data */
+    uint16_t    crc;        /* CRC of seq, size and data */
+    uint16_t    reserved;
+} slotHeader_t;
+
+
+static slotHeader_t *slotHeader(CO_OD_storage_t *odStor, int slot) {
+    return (slotHeader_t*)&odStor->map[(uint32_t)slot * odStor->slotSize];
+}
+
+
+static uint8_t *slotData(CO_OD_storage_t *odStor, int slot) {
+    return &odStor->map[(uint32_t)slot * odStor->slotSize + sizeof(slotHeader_t)];
+}
+
+
+static uint16_t slotCRC(CO_OD_storage_t *odStor, int slot) {
+    slotHeader_t *hdr = slotHeader(odStor, slot);
+    uint16_t crc;
+
+    crc = crc16_ccitt((unsigned char*)&hdr->seq, 2 * sizeof(uint32_t), 0);
+    return crc16_ccitt(slotData(odStor, slot), odStor->odSize, crc);
+}
+
+
+static bool_t slotValid(CO_OD_storage_t *odStor, int slot) {
+    slotHeader_t *hdr = slotHeader(odStor, slot);
+
+    return hdr->magic == CO_OD_STORAGE_SLOT_MAGIC
+        && hdr->size == odStor->odSize
+        && hdr->crc == slotCRC(odStor, slot);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_OD_storage_init(
+        CO_OD_storage_t        *odStor,
+        uint8_t                *odAddress,
+        uint32_t                odSize,
+        char                   *filename)
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+    struct stat st;
+    uint32_t mapSize;
+    long pageSize;
+    bool_t empty = false;
+
+    /* verify arguments */
+    if(odStor==NULL || odAddress==NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* configure object variables */
+    pageSize = sysconf(_SC_PAGESIZE);
+    if(pageSize <= 0) {
+        pageSize = 4096;
+    }
+    odStor->odAddress = odAddress;
+    odStor->odSize = odSize;
+    odStor->filename = filename;
+    odStor->fp = NULL;
+    odStor->tmr1msPrev = 0;
+    odStor->lastSavedMs = 0;
+    odStor->group = 0;
+    odStor->next = NULL;
+    odStor->savePending = false;
+    odStor->workerRunning = false;
+    odStor->workerState = CO_OD_STORAGE_WORKER_IDLE;
+#ifdef CO_USE_STATISTICS
+    memset(&odStor->stats, 0, sizeof(odStor->stats));
+#endif
+    odStor->map = NULL;
+    odStor->slot = -1;
+    odStor->seq = 0;
+    odStor->slotSize = (sizeof(slotHeader_t) + odSize + pageSize - 1) / pageSize * pageSize;
+    mapSize = 2 * odStor->slotSize;
+
+    /* open or create the file and preallocate both slots */
+    odStor->fd = open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(odStor->fd < 0 || fstat(odStor->fd, &st) != 0) {
+        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    else if(st.st_size < (off_t)mapSize) {
+        empty = (st.st_size == 0);
+        if(ftruncate(odStor->fd, mapSize) != 0
+            || posix_fallocate(odStor->fd, 0, mapSize) != 0)
+        {
+            ret = CO_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    if(ret == CO_ERROR_NO) {
+        void *map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, odStor->fd, 0);
+        if(map == MAP_FAILED) {
+            ret = CO_ERROR_OUT_OF_MEMORY;
+        }
+        else {
+            odStor->map = (uint8_t*)map;
+        }
+    }
+
+    /* find the newest valid slot */
+    if(ret == CO_ERROR_NO) {
+        bool_t valid0 = slotValid(odStor, 0);
+        bool_t valid1 = slotValid(odStor, 1);
+
+        if(valid0 && valid1) {
+            /* sequence number may wrap around */
+            int32_t diff = (int32_t)(slotHeader(odStor, 1)->seq - slotHeader(odStor, 0)->seq);
+            odStor->slot = (diff > 0) ? 1 : 0;
+        }
+        else if(valid0 || valid1) {
+            odStor->slot = valid0 ? 0 : 1;
+        }
+
+        if(odStor->slot >= 0) {
+            odStor->seq = slotHeader(odStor, odStor->slot)->seq;
+            memcpy(odStor->odAddress, slotData(odStor, odStor->slot), odStor->odSize);
+        }
+        else if(!empty && (slotHeader(odStor, 0)->magic != 0
+                        || slotHeader(odStor, 1)->magic != 0))
+        {
+            /* no valid slot, default values will be used */
+            ret = CO_ERROR_CRC;
+        }
+    }
+
+    if(ret != CO_ERROR_NO && ret != CO_ERROR_CRC) {
+        CO_OD_storage_autoSaveClose(odStor);
+    }
+
+    return ret;
+}
+
+
+/* Copy OD into the older slot, which is invalid until slotCommit(). Newest
+ * slot stays untouched. */
+static void slotSnapshot(CO_OD_storage_t *odStor) {
+    int target = (odStor->slot == 0) ? 1 : 0;
+
+    slotHeader(odStor, target)->magic = 0;
+
+    CO_LOCK_OD();
+    memcpy(slotData(odStor, target), odStor->odAddress, odStor->odSize);
+    CO_UNLOCK_OD();
+}
+
+
+/* Write header of the older slot and synchronize it to disk. */
+static int slotCommit(CO_OD_storage_t *odStor) {
+    int target = (odStor->slot == 0) ? 1 : 0;
+    slotHeader_t *hdr = slotHeader(odStor, target);
+
+    hdr->seq = odStor->seq + 1;
+    hdr->size = odStor->odSize;
+    hdr->reserved = 0;
+    hdr->crc = slotCRC(odStor, target);
+    hdr->magic = CO_OD_STORAGE_SLOT_MAGIC;
+
+    if(msync(hdr, odStor->slotSize, MS_SYNC) != 0) {
+        return RETURN_ERROR;
+    }
+
+    odStor->seq = hdr->seq;
+    odStor->slot = target;
+
+    return RETURN_SUCCESS;
+}
+
+
+/******************************************************************************/
+int CO_OD_storage_saveSlot(CO_OD_storage_t *odStor) {
+    if(odStor == NULL || odStor->map == NULL) {
+        return RETURN_ERROR;
+    }
+
+    slotSnapshot(odStor);
+
+    return slotCommit(odStor);
+}
+
+
+/******************************************************************************/
+int CO_OD_storage_restoreSlot(CO_OD_storage_t *odStor) {
+    int i;
+
+    if(odStor == NULL || odStor->map == NULL) {
+        return RETURN_ERROR;
+    }
+
+    for(i=0; i<2; i++) {
+        slotHeader(odStor, i)->magic = 0;
+    }
+    if(msync(odStor->map, 2 * odStor->slotSize, MS_SYNC) != 0) {
+        return RETURN_ERROR;
+    }
+
+    /* Data in the newest slot remain for comparison in autoSave, so it does
+     * not store unchanged OD again. */
+
+    return RETURN_SUCCESS;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_OD_storage_autoSave(
+        CO_OD_storage_t        *odStor,
+        uint16_t                timer1ms,
+        uint16_t                delay)
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    /* verify arguments */
+    if(odStor==NULL || odStor->odAddress==NULL || odStor->map==NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* don't save file more often than delay */
+    if(odStor->lastSavedMs < delay) {
+        odStor->lastSavedMs += timer1ms - odStor->tmr1msPrev;
+    }
+    else if(workerBusy(odStor)) {
+        /* try again in the next cycle */
+    }
+    else {
+        bool_t changed;
+
+        /* compare with the newest slot */
+        CO_LOCK_OD();
+        changed = odStor->slot < 0
+            || memcmp(slotData(odStor, odStor->slot), odStor->odAddress, odStor->odSize) != 0;
+        CO_UNLOCK_OD();
+
+        if(changed) {
+            if(CO_OD_storage_saveSlot(odStor) != 0) {
+                ret = CO_ERROR_DATA_CORRUPT;
+            }
+            odStor->lastSavedMs = 0;
+        }
+    }
+
+    odStor->tmr1msPrev = timer1ms;
+
+    return ret;
+}
+
+void CO_OD_storage_autoSaveClose(CO_OD_storage_t *odStor) {
+    if(odStor->map != NULL) {
+        munmap(odStor->map, 2 * odStor->slotSize);
+        odStor->map = NULL;
+    }
+    if(odStor->fd >= 0) {
+        close(odStor->fd);
+        odStor->fd = -1;
+    }
+}
+
+#else /* CO_OD_STORAGE_MMAP */
+/* Prepare table for combining CRC of data with CRC of following block of
+ * size len: crc16_ccitt(block, len, init) = crc16_ccitt(block, len, 0) ^
+ * tab[0][init >> 8] ^ tab[1][init & 0xFF]. */
+static void crcShiftInit(uint16_t tab[2][256], uint32_t len) {
+    static const uint8_t zeros[CO_OD_STORAGE_PAGE_SIZE];
+    uint16_t m[16];
+    int i, b;
+
+    for(b=0; b<16; b++) {
+        m[b] = crc16_ccitt(zeros, len, (unsigned short)(1U << b));
+    }
+    for(i=0; i<256; i++) {
+        tab[0][i] = 0;
+        tab[1][i] = 0;
+        for(b=0; b<8; b++) {
+            if((i & (1 << b)) != 0) {
+                tab[0][i] ^= m[b + 8];
+                tab[1][i] ^= m[b];
+            }
+        }
+    }
+}
+
+
+/* CRC of whole shadow, combined from CRCs of pages. */
+static uint16_t shadowCRC(CO_OD_storage_t *odStor) {
+    uint16_t crc = 0;
+    uint32_t i;
+
+    for(i=0; i<odStor->pageCount; i++) {
+        int t = (i == (odStor->pageCount - 1)) ? 2 : 0;
+        crc = odStor->crcShift[t][crc >> 8] ^ odStor->crcShift[t+1][crc & 0xFF]
+            ^ odStor->pageCRC[i];
+    }
+    return crc;
+}
+
+
+/* Size of the page. */
+static uint32_t pageLen(CO_OD_storage_t *odStor, uint32_t page) {
+    uint32_t offset = page * CO_OD_STORAGE_PAGE_SIZE;
+    uint32_t len = odStor->odSize - offset;
+
+    return (len > CO_OD_STORAGE_PAGE_SIZE) ? CO_OD_STORAGE_PAGE_SIZE : len;
+}
+
 
 /******************************************************************************/
 CO_ReturnError_t CO_OD_storage_init(
@@ -229,14 +755,14 @@ CO_ReturnError_t CO_OD_storage_init(
         char                   *filename)
 {
     CO_ReturnError_t ret = CO_ERROR_NO;
-    void *buf = NULL;
+    uint8_t *buf = NULL;
 
     /* verify arguments */
     if(odStor==NULL || odAddress==NULL) {
         ret = CO_ERROR_ILLEGAL_ARGUMENT;
     }
 
-    /* configure object variables and allocate buffer */
+    /* configure object variables and allocate buffers */
     if(ret == CO_ERROR_NO) {
         odStor->odAddress = odAddress;
         odStor->odSize = odSize;
@@ -244,11 +770,37 @@ CO_ReturnError_t CO_OD_storage_init(
         odStor->fp = NULL;
         odStor->tmr1msPrev = 0;
         odStor->lastSavedMs = 0;
-
-        buf = malloc(odStor->odSize);
-        if(buf == NULL) {
+        odStor->group = 0;
+        odStor->next = NULL;
+        odStor->savePending = false;
+        odStor->workerRunning = false;
+        odStor->workerState = CO_OD_STORAGE_WORKER_IDLE;
+#ifdef CO_USE_STATISTICS
+        memset(&odStor->stats, 0, sizeof(odStor->stats));
+#endif
+        odStor->shadowValid = false;
+        odStor->snapshot = NULL;
+        odStor->fileReplaced = false;
+        odStor->pageCount = (odSize + CO_OD_STORAGE_PAGE_SIZE - 1) / CO_OD_STORAGE_PAGE_SIZE;
+
+        /* shadow is at least two bytes for empty file marker */
+        odStor->shadow = malloc(odStor->odSize + 2);
+        odStor->pageCRC = malloc((odStor->pageCount + 1) * sizeof(uint16_t));
+        odStor->crcShift = malloc(4 * 256 * sizeof(uint16_t));
+        buf = odStor->shadow;
+        if(odStor->shadow == NULL || odStor->pageCRC == NULL || odStor->crcShift == NULL) {
+            free(odStor->shadow);
+            free(odStor->pageCRC);
+            free(odStor->crcShift);
+            odStor->shadow = NULL;
+            odStor->pageCRC = NULL;
+            odStor->crcShift = NULL;
             ret = CO_ERROR_OUT_OF_MEMORY;
         }
+        else if(odStor->pageCount > 0) {
+            crcShiftInit(&odStor->crcShift[0], CO_OD_STORAGE_PAGE_SIZE);
+            crcShiftInit(&odStor->crcShift[2], pageLen(odStor, odStor->pageCount - 1));
+        }
     }
 
     /* read data from the file and verify CRC */
@@ -279,13 +831,19 @@ CO_ReturnError_t CO_OD_storage_init(
             ret = CO_ERROR_CRC;
         }
         else {
+            uint32_t i;
+
             /* no errors, copy data into Object dictionary */
             memcpy(odStor->odAddress, buf, odStor->odSize);
+
+            /* shadow equals file */
+            for(i=0; i<odStor->pageCount; i++) {
+                odStor->pageCRC[i] = crc16_ccitt(&buf[i * CO_OD_STORAGE_PAGE_SIZE], pageLen(odStor, i), 0);
+            }
+            odStor->shadowValid = true;
         }
     }
 
-    free(buf);
-
     return ret;
 }
 
@@ -299,72 +857,94 @@ CO_ReturnError_t CO_OD_storage_autoSave(
     CO_ReturnError_t ret = CO_ERROR_NO;
 
     /* verify arguments */
-    if(odStor==NULL || odStor->odAddress==NULL) {
-        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    if(odStor==NULL || odStor->odAddress==NULL || odStor->shadow==NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
     }
 
     /* don't save file more often than delay */
     if(odStor->lastSavedMs < delay) {
         odStor->lastSavedMs += timer1ms - odStor->tmr1msPrev;
     }
+    else if(workerBusy(odStor)) {
+        /* try again in the next cycle */
+    }
     else {
-        void *buf = NULL;
-        bool_t saveData = false;
+        uint32_t i;
+        uint32_t pagesWritten = 0;
 
-        /* allocate buffer and open file if necessary */
-        if(ret == CO_ERROR_NO) {
-            buf = malloc(odStor->odSize);
-            if(odStor->fp == NULL) {
-                odStor->fp = fopen(odStor->filename, "r+");
-            }
-            if(buf == NULL || odStor->fp == NULL) {
-                ret = CO_ERROR_OUT_OF_MEMORY;
+        /* file was replaced by 1010, 1011 or worker thread, write all pages
+         * into new file */
+        if(odStor->workerRunning) {
+            pthread_mutex_lock(&odStor->workerMtx);
+        }
+        if(odStor->fileReplaced) {
+            odStor->fileReplaced = false;
+            odStor->shadowValid = false;
+            if(odStor->fp != NULL) {
+                fclose(odStor->fp);
+                odStor->fp = NULL;
             }
         }
+        if(odStor->workerRunning) {
+            pthread_mutex_unlock(&odStor->workerMtx);
+        }
 
-        /* read data from the beginning of the file */
-        if(ret == CO_ERROR_NO) {
-            uint32_t cnt = 0;
+        /* open file if necessary */
+        if(odStor->fp == NULL) {
+            odStor->fp = fopen(odStor->filename, "r+");
+            if(odStor->fp == NULL) {
+                ret = CO_ERROR_ILLEGAL_ARGUMENT;
+            }
+        }
 
-            rewind(odStor->fp);
-            cnt = fread(buf, 1, odStor->odSize, odStor->fp);
+        /* Compare each page with shadow, copy and write changed pages. OD is
+         * locked only for comparing and copying to the shadow. */
+        for(i=0; ret == CO_ERROR_NO && i<odStor->pageCount; i++) {
+            uint32_t offset = i * CO_OD_STORAGE_PAGE_SIZE;
+            uint32_t len = pageLen(odStor, i);
+            bool_t changed = false;
 
-            if(cnt == 2 && *((char*)buf) == '-') {
-                /* file is empty, data will be saved. */
-                saveData = true;
+            CO_LOCK_OD();
+            if(!odStor->shadowValid
+                || memcmp(&odStor->shadow[offset], &odStor->odAddress[offset], len) != 0)
+            {
+                memcpy(&odStor->shadow[offset], &odStor->odAddress[offset], len);
+                changed = true;
             }
-            else if(cnt == odStor->odSize) {
-                /* verify, if data differs */
-                if(memcmp((const void *)buf, (const void *)odStor->odAddress, odStor->odSize) != 0) {
-                    saveData = true;
+            CO_UNLOCK_OD();
+
+            if(changed) {
+                odStor->pageCRC[i] = crc16_ccitt(&odStor->shadow[offset], len, 0);
+                if(fseek(odStor->fp, offset, SEEK_SET) != 0
+                    || fwrite(&odStor->shadow[offset], 1, len, odStor->fp) != len)
+                {
+                    ret = CO_ERROR_DATA_CORRUPT;
                 }
-            }
-            else {
-                /* file length does not match */
-                ret = CO_ERROR_DATA_CORRUPT;
+                pagesWritten++;
             }
         }
 
-        /* Save the data to the file only if data differs. */
-        if(ret == CO_ERROR_NO && saveData) {
-            uint16_t CRC;
-
-            /* copy data to temporary buffer */
-            memcpy(buf, odStor->odAddress, odStor->odSize);
-
-            rewind(odStor->fp);
-            fwrite((const void *)buf, 1, odStor->odSize, odStor->fp);
+        /* write also CRC of whole block */
+        if(ret == CO_ERROR_NO && (pagesWritten > 0 || !odStor->shadowValid)) {
+            uint16_t CRC = shadowCRC(odStor);
 
-            /* write also CRC */
-            CRC = crc16_ccitt((unsigned char*)buf, odStor->odSize, 0);
-            fwrite((const void *)&CRC, 1, 2, odStor->fp);
-
-            fflush(odStor->fp);
+            if(fseek(odStor->fp, odStor->odSize, SEEK_SET) != 0
+                || fwrite((const void *)&CRC, 1, 2, odStor->fp) != 2
+                || fflush(odStor->fp) != 0)
+            {
+                ret = CO_ERROR_DATA_CORRUPT;
+            }
+            else {
+                odStor->shadowValid = true;
+            }
 
             odStor->lastSavedMs = 0;
         }
 
-        free(buf);
+        /* on error write all pages next time */
+        if(ret != CO_ERROR_NO) {
+            odStor->shadowValid = false;
+        }
     }
 
     odStor->tmr1msPrev = timer1ms;
@@ -375,5 +955,188 @@ CO_ReturnError_t CO_OD_storage_autoSave(
 void CO_OD_storage_autoSaveClose(CO_OD_storage_t *odStor) {
     if(odStor->fp != NULL) {
         fclose(odStor->fp);
+        odStor->fp = NULL;
+    }
+    free(odStor->shadow);
+    free(odStor->pageCRC);
+    free(odStor->crcShift);
+    odStor->shadow = NULL;
+    odStor->pageCRC = NULL;
+    odStor->crcShift = NULL;
+}
+
+#endif /* CO_OD_STORAGE_MMAP */
+
+
+/* Write the snapshot, called from worker thread. */
+static int workerSave(CO_OD_storage_t *odStor) {
+#ifdef CO_OD_STORAGE_MMAP
+    return slotCommit(odStor);
+#else
+    return saveSecure(odStor->snapshot, odStor->odSize, odStor->filename, false);
+#endif
+}
+
+
+/* Worker thread waits for the snapshot and writes it. */
+static void *storageWorker(void *arg) {
+    CO_OD_storage_t *odStor = (CO_OD_storage_t*)arg;
+
+    pthread_mutex_lock(&odStor->workerMtx);
+    for(;;) {
+        int result;
+#ifdef CO_USE_STATISTICS
+        uint64_t t0;
+        uint32_t t;
+#endif
+
+        while(odStor->workerState != CO_OD_STORAGE_WORKER_REQUEST && odStor->workerRunning) {
+            pthread_cond_wait(&odStor->workerCond, &odStor->workerMtx);
+        }
+        if(odStor->workerState != CO_OD_STORAGE_WORKER_REQUEST) {
+            break;
+        }
+        odStor->workerState = CO_OD_STORAGE_WORKER_BUSY;
+        pthread_mutex_unlock(&odStor->workerMtx);
+
+#ifdef CO_USE_STATISTICS
+        t0 = time_us();
+#endif
+        result = workerSave(odStor);
+
+        pthread_mutex_lock(&odStor->workerMtx);
+#ifdef CO_USE_STATISTICS
+        t = (uint32_t)(time_us() - t0);
+        odStor->stats.saveTime_us = t;
+        if(t > odStor->stats.saveTimeMax_us) {
+            odStor->stats.saveTimeMax_us = t;
+        }
+        if(result == RETURN_SUCCESS) {
+            odStor->stats.saves++;
+        }
+        else {
+            odStor->stats.errors++;
+        }
+#endif
+#ifndef CO_OD_STORAGE_MMAP
+        /* file opened by autoSave was renamed to '.old', see setFileReplaced() */
+        odStor->fileReplaced = true;
+#endif
+        odStor->workerState = (result == RETURN_SUCCESS) ?
+                CO_OD_STORAGE_WORKER_DONE : CO_OD_STORAGE_WORKER_ERROR;
+    }
+    pthread_mutex_unlock(&odStor->workerMtx);
+
+    return NULL;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_OD_storage_initWorker(CO_OD_storage_t *odStor) {
+    /* verify arguments */
+    if(odStor==NULL || odStor->odAddress==NULL || odStor->workerRunning) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+#ifndef CO_OD_STORAGE_MMAP
+    odStor->fileReplaced = false;
+    odStor->snapshot = malloc(odStor->odSize);
+    if(odStor->snapshot == NULL) {
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+#else
+    if(odStor->map == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+#endif
+
+    odStor->workerState = CO_OD_STORAGE_WORKER_IDLE;
+    pthread_mutex_init(&odStor->workerMtx, NULL);
+    pthread_cond_init(&odStor->workerCond, NULL);
+
+    odStor->workerRunning = true;
+    if(pthread_create(&odStor->worker, NULL, storageWorker, odStor) != 0) {
+        odStor->workerRunning = false;
+        pthread_cond_destroy(&odStor->workerCond);
+        pthread_mutex_destroy(&odStor->workerMtx);
+#ifndef CO_OD_STORAGE_MMAP
+        free(odStor->snapshot);
+        odStor->snapshot = NULL;
+#endif
+        return CO_ERROR_OUT_OF_MEMORY;
     }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_OD_storage_closeWorker(CO_OD_storage_t *odStor) {
+    if(!odStor->workerRunning) {
+        return;
+    }
+
+    pthread_mutex_lock(&odStor->workerMtx);
+    odStor->workerRunning = false;
+    pthread_cond_signal(&odStor->workerCond);
+    pthread_mutex_unlock(&odStor->workerMtx);
+    pthread_join(odStor->worker, NULL);
+
+    pthread_cond_destroy(&odStor->workerCond);
+    pthread_mutex_destroy(&odStor->workerMtx);
+#ifndef CO_OD_STORAGE_MMAP
+    free(odStor->snapshot);
+    odStor->snapshot = NULL;
+#endif
+}
+
+
+/******************************************************************************/
+int CO_OD_storage_saveAsync(CO_OD_storage_t *odStor) {
+    if(odStor == NULL || !odStor->workerRunning || workerBusy(odStor)) {
+        return RETURN_ERROR;
+    }
+
+    /* Worker is idle, take the snapshot */
+#ifdef CO_OD_STORAGE_MMAP
+    slotSnapshot(odStor);
+#else
+    CO_LOCK_OD();
+    memcpy(odStor->snapshot, odStor->odAddress, odStor->odSize);
+    CO_UNLOCK_OD();
+#endif
+
+    pthread_mutex_lock(&odStor->workerMtx);
+    odStor->workerState = CO_OD_STORAGE_WORKER_REQUEST;
+    pthread_cond_signal(&odStor->workerCond);
+    pthread_mutex_unlock(&odStor->workerMtx);
+
+    return RETURN_SUCCESS;
+}
+
+
+/******************************************************************************/
+int CO_OD_storage_saveAsyncResult(CO_OD_storage_t *odStor) {
+    int ret;
+
+    if(odStor == NULL || !odStor->workerRunning) {
+        return RETURN_ERROR;
+    }
+
+    pthread_mutex_lock(&odStor->workerMtx);
+    switch(odStor->workerState) {
+        case CO_OD_STORAGE_WORKER_REQUEST:
+        case CO_OD_STORAGE_WORKER_BUSY:
+            ret = 1;
+            break;
+        case CO_OD_STORAGE_WORKER_DONE:
+            ret = RETURN_SUCCESS;
+            break;
+        default:
+            ret = RETURN_ERROR;
+            break;
+    }
+    pthread_mutex_unlock(&odStor->workerMtx);
+
+    return ret;
 }
@@ -32,13 +32,50 @@
 #include "CO_SDO.h"
 
 #include <stdio.h>
+#include <pthread.h>
 
 
 /* For documentation see file drvTemplate/CO_OD_storage.h */
 
 
+/**
+ * Size of the page for CO_OD_storage_autoSave(). Only changed pages are
+ * written to the file.
+ */
+#ifndef CO_OD_STORAGE_PAGE_SIZE
+    #define CO_OD_STORAGE_PAGE_SIZE 512
+#endif
+
+
+/**
+ * @defgroup CO_OD_STORAGE_MMAP Crash-safe storage in memory mapped slots
+ *
+ * If CO_OD_STORAGE_MMAP is defined, storage file contains two fixed slots (A
+ * and B), each with header (magic, sequence number, size, CRC) and data. File
+ * is preallocated and mapped with mmap() in CO_OD_storage_init(), which loads
+ * data from the valid slot with the newest sequence number.
+ *
+ * CO_OD_storage_saveSlot() writes into the older slot: OD is locked only
+ * during memcpy of the snapshot into the mapping, CRC calculation and msync()
+ * are done outside the lock. Old slot stays intact until the new one is
+ * complete, so power loss during save never loses both copies.
+ *
+ * CO_ODF_1010, CO_ODF_1011 and CO_OD_storage_autoSave() then use slots instead
+ * of the plain file format. Slot file is not compatible with the plain file.
+ * @{
+ */
+#ifdef CO_OD_STORAGE_MMAP
+    #define CO_OD_STORAGE_SLOT_MAGIC 0x53444F43UL   /**< "CODS" */
+#endif
+/** @} */
+
+
 /**
  * Callbacks for using inside @ref CO_OD_configure() function (for OD objects 1010 and 1011).
+ *
+ * Object passed to CO_OD_configure() is CO_OD_storage_t. If more storage
+ * groups are added to it with CO_OD_storage_addGroup(), subindex 1 saves or
+ * restores all groups and other subindexes only the matching group.
  */
 CO_SDO_abortCode_t CO_ODF_1010(CO_ODF_arg_t *ODF_arg);
 CO_SDO_abortCode_t CO_ODF_1011(CO_ODF_arg_t *ODF_arg);
@@ -51,7 +88,9 @@ CO_SDO_abortCode_t CO_ODF_1011(CO_ODF_arg_t *ODF_arg);
  * to filename, adds two bytes of CRC code. It then verifies the written file and
  * in case of errors sets back the old file and returns error.
  *
- * Function is used with CANopen OD object at index 1010.
+ * Function is used with CANopen OD object at index 1010. If file is also
+ * written by CO_OD_storage_autoSave(), save it with CO_ODF_1010, which makes
+ * autoSave reopen the replaced file.
  *
  * @param odAddress Address of the memory block, which will be stored.
  * @param odSize Size of the above memory block.
@@ -75,7 +114,8 @@ int CO_OD_storage_saveSecure(
  *
  * Writing data to file is secured with mutex CO_LOCK_OD.
  *
- * Function is used with CANopen OD object at index 1011.
+ * Function is used with CANopen OD object at index 1011. If file is also
+ * written by CO_OD_storage_autoSave(), restore it with CO_ODF_1011.
  *
  * @param filename Name of the file.
  *
@@ -84,12 +124,40 @@ int CO_OD_storage_saveSecure(
 int CO_OD_storage_restoreSecure(char *filename);
 
 
+/**
+ * State of the storage worker thread, see CO_OD_storage_initWorker().
+ */
+typedef enum {
+    CO_OD_STORAGE_WORKER_IDLE       = 0,    /**< No save requested yet */
+    CO_OD_STORAGE_WORKER_REQUEST    = 1,    /**< Snapshot is ready, waiting for worker */
+    CO_OD_STORAGE_WORKER_BUSY       = 2,    /**< Worker is writing the snapshot */
+    CO_OD_STORAGE_WORKER_DONE       = 3,    /**< Last save was successful */
+    CO_OD_STORAGE_WORKER_ERROR      = 4     /**< Last save failed */
+} CO_OD_storage_workerState_t;
+
+
+#ifdef CO_USE_STATISTICS
+/**
+ * Statistics of the OD storage object, see CO_USE_STATISTICS in CO_driver.h.
+ */
+typedef struct {
+    uint32_t    saves;              /**< Number of saves completed by worker */
+    uint32_t    errors;             /**< Number of failed saves by worker */
+    uint32_t    saveTime_us;        /**< Duration of the last save in worker */
+    uint32_t    saveTimeMax_us;     /**< Longest save in worker */
+    /** Longest time spent in CO_ODF_1010, which blocks the caller (SDO
+     * server in mainline). Worst case mainline latency caused by save. */
+    uint32_t    mainlineTimeMax_us;
+} CO_OD_storage_stats_t;
+#endif
+
+
 /**
  * Object Dictionary storage object.
  *
  * Object is used with CANopen OD objects at index 1010 and 1011.
  */
-typedef struct {
+typedef struct CO_OD_storage_t {
     uint8_t    *odAddress;      /**< From CO_OD_storage_init() */
     uint32_t    odSize;         /**< From CO_OD_storage_init() */
     char       *filename;       /**< From CO_OD_storage_init() */
@@ -97,6 +165,40 @@ typedef struct {
     FILE       *fp;
     uint16_t    tmr1msPrev;     /**< used with CO_OD_storage_autoSave. */
     uint32_t    lastSavedMs;    /**< used with CO_OD_storage_autoSave. */
+    /** Subindex of 1010 and 1011, see CO_OD_storage_addGroup(), 0 if not set. */
+    uint8_t     group;
+    struct CO_OD_storage_t *next; /**< Next storage group in the list */
+    bool_t      savePending;    /**< Group is saved by worker for CO_ODF_1010 */
+#ifdef CO_OD_STORAGE_MMAP
+    int         fd;             /**< File descriptor of the slot file */
+    uint8_t    *map;            /**< Mapping of both slots */
+    uint32_t    slotSize;       /**< Size of one slot, multiple of page size */
+    int8_t      slot;           /**< Index of the newest valid slot, -1 if none */
+    uint32_t    seq;            /**< Sequence number of the newest valid slot */
+#else
+    /** Copy of data in file, used with CO_OD_storage_autoSave. */
+    uint8_t    *shadow;
+    /** False, if file does not contain data from shadow, so all pages must be written. */
+    bool_t      shadowValid;
+    uint32_t    pageCount;      /**< Number of pages of size CO_OD_STORAGE_PAGE_SIZE */
+    uint16_t   *pageCRC;        /**< CRC of each page of the shadow */
+    /** Tables for combining page CRCs into CRC of whole block. CRC of zeros,
+     * with initial value split into high and low byte: [0..1] for full page,
+     * [2..3] for the last page. */
+    uint16_t  (*crcShift)[256];
+    uint8_t    *snapshot;       /**< Copy of OD, written by the worker thread */
+    /** Set by CO_ODF_1010, CO_ODF_1011 or worker thread, if file opened by
+    CO_OD_storage_autoSave was replaced. */
+    bool_t      fileReplaced;
+#endif
+    pthread_t   worker;         /**< Worker thread, see CO_OD_storage_initWorker() */
+    pthread_mutex_t workerMtx;  /**< Protects workerState */
+    pthread_cond_t workerCond;  /**< Signals new request to the worker */
+    bool_t      workerRunning;  /**< True, if worker thread is running */
+    CO_OD_storage_workerState_t workerState; /**< State of the worker */
+#ifdef CO_USE_STATISTICS
+    CO_OD_storage_stats_t stats; /**< Statistics */
+#endif
 } CO_OD_storage_t;
 
 
@@ -122,19 +224,45 @@ CO_ReturnError_t CO_OD_storage_init(
         char                   *filename);
 
 
+/**
+ * Add storage group for OD objects 1010 and 1011.
+ *
+ * CiA 301 defines separate subindexes of 1010 and 1011 for communication
+ * parameters (2), application parameters (3) and manufacturer defined
+ * parameters (4 to 127). Each group is a separate CO_OD_storage_t object with
+ * own memory block, own file (or slots) and own CRC, so saving or restoring
+ * one group does not touch the others. Groups are linked into the list, which
+ * starts with the object registered by CO_OD_configure().
+ *
+ * Called after CO_OD_storage_init() of all groups.
+ *
+ * @param first Object registered for 1010 and 1011 by CO_OD_configure().
+ * @param odStor Storage group, added to the list. It may also be first.
+ * @param subIndex Subindex of 1010 and 1011 for the group, 2 or more.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_OD_storage_addGroup(
+        CO_OD_storage_t        *first,
+        CO_OD_storage_t        *odStor,
+        uint8_t                 subIndex);
+
+
 /**
  * Automatically save memory block if differs from file.
  *
- * Should be called cyclically by program. It first verifies, if memory block
- * differs from file and if it does, it saves it to file with two additional
- * CRC bytes. File remains opened.
+ * Should be called cyclically by program. It compares memory block with its
+ * copy (shadow) page by page. Only changed pages are written to the file,
+ * CRC is updated only for changed pages and combined into two additional
+ * CRC bytes of whole block. No memory is allocated and file is not read.
+ * File remains opened.
  *
  * @param odStor OD storage object.
  * @param timer1ms Variable, which must increment each millisecond.
  * @param delay Delay (inhibit) time between writes to disk in milliseconds (60000 for example).
  *
- * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_DATA_CORRUPT (Data in file corrupt),
- * CO_ERROR_ILLEGAL_ARGUMENT or CO_ERROR_OUT_OF_MEMORY (malloc failed).
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_DATA_CORRUPT (writing to file
+ * failed) or CO_ERROR_ILLEGAL_ARGUMENT.
  */
 CO_ReturnError_t CO_OD_storage_autoSave(
         CO_OD_storage_t        *odStor,
@@ -143,10 +271,95 @@ CO_ReturnError_t CO_OD_storage_autoSave(
 
 
 /**
- * Closes file opened by CO_OD_storage_autoSave.
+ * Closes file opened by CO_OD_storage_autoSave and frees memory.
  *
  * @param odStor OD storage object.
  */
 void CO_OD_storage_autoSaveClose(CO_OD_storage_t *odStor);
 
+
+/**
+ * Start storage worker thread.
+ *
+ * If worker is running, CO_ODF_1010 does not write the file itself. It only
+ * takes a snapshot of the memory block (under CO_LOCK_OD) with
+ * CO_OD_storage_saveAsync() and defers SDO response (see ODF_arg->pending in
+ * @ref CO_SDO_OD_function). Snapshot is written by the worker and SDO transfer
+ * is finished from CO_SDO_process(), when worker reports completion. NMT,
+ * heartbeat, emergency and other SDO channels keep running meanwhile.
+ * CO_OD_storage_autoSave() skips the cycle while worker is busy.
+ *
+ * Called after CO_OD_storage_init().
+ *
+ * @param odStor OD storage object.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_OUT_OF_MEMORY.
+ */
+CO_ReturnError_t CO_OD_storage_initWorker(CO_OD_storage_t *odStor);
+
+
+/**
+ * Stop storage worker thread.
+ *
+ * Requested save is completed first.
+ *
+ * @param odStor OD storage object.
+ */
+void CO_OD_storage_closeWorker(CO_OD_storage_t *odStor);
+
+
+/**
+ * Take a snapshot of the memory block and pass it to the worker thread.
+ *
+ * @param odStor OD storage object with running worker.
+ *
+ * @return 0 on success, -1 if previous save is still in progress or worker
+ * is not running.
+ */
+int CO_OD_storage_saveAsync(CO_OD_storage_t *odStor);
+
+
+/**
+ * Get result of the save started with CO_OD_storage_saveAsync().
+ *
+ * @param odStor OD storage object.
+ *
+ * @return 1 if save is still in progress, 0 on success, -1 on error.
+ */
+int CO_OD_storage_saveAsyncResult(CO_OD_storage_t *odStor);
+
+
+#ifdef CO_OD_STORAGE_MMAP
+/**
+ * Save memory block into the older slot of the storage file.
+ *
+ * Snapshot of the memory block is copied into the mapping under CO_LOCK_OD,
+ * then header with incremented sequence number and CRC is written and slot is
+ * synchronized to disk with msync(). Only after that slot becomes the newest.
+ *
+ * Function is used with CANopen OD object at index 1010.
+ *
+ * @param odStor OD storage object, initialized with CO_OD_storage_init().
+ *
+ * @return 0 on success, -1 on error.
+ */
+int CO_OD_storage_saveSlot(CO_OD_storage_t *odStor);
+
+
+/**
+ * Invalidate both slots of the storage file.
+ *
+ * When program will start next time, default values are used for Object
+ * Dictionary.
+ *
+ * Function is used with CANopen OD object at index 1011.
+ *
+ * @param odStor OD storage object, initialized with CO_OD_storage_init().
+ *
+ * @return 0 on success, -1 on error.
+ */
+int CO_OD_storage_restoreSlot(CO_OD_storage_t *odStor);
+#endif
+
 #endif
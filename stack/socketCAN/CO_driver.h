@@ -47,7 +47,13 @@
 
 
 /* general configuration */
-//    #define CO_LOG_CAN_MESSAGES   /* Call external function for each received or transmitted CAN message. */
+//    #define CO_LOG_CAN_MESSAGES   /* Log received and transmitted CAN messages to CO_CANmodule_t.log, see CO_CANlog.h. */
+//    #define CO_USE_STATISTICS     /* Count received, dropped and transmitted messages, see CO_getStats(). */
+//    #define CO_CAN_REPLAY         /* CAN socket is not used, messages are exchanged with CO_replay_t, see CO_replay.h. */
+//    #define CO_SDO_FAST_PATH      /* Answer expedited SDO requests for plain variables in CAN receive thread, see CO_SDO.h. */
+//    #define CO_PDO_PROCESS_IMAGE  /* Exchange PDO data through contiguous input and output image, see CO_PDOimage_init(). */
+//    #define CO_PDO_BIT_MAPPING    /* Allow PDO mapping of variables, which are not multiple of 8 bits, see CO_PDO.h. */
+//    #define CO_PDO_MPDO           /* Multiplexed PDOs with scanner and dispatcher lists, see CO_MPDO_init(). */
     #define CO_SDO_BUFFER_SIZE           889    /* Override default SDO buffer size. */
 
 
@@ -75,6 +81,13 @@
 #endif
 
 
+/* Statistics counters, relaxed atomic access */
+#ifdef CO_USE_STATISTICS
+    #define CO_STAT_INC(cnt)        __atomic_fetch_add(&(cnt), 1U, __ATOMIC_RELAXED)
+    #define CO_STAT_GET(cnt)        __atomic_load_n(&(cnt), __ATOMIC_RELAXED)
+#endif
+
+
 /* Data types */
     /* int8_t to uint64_t are defined in stdint.h */
     typedef _Bool                   bool_t;
@@ -119,6 +132,9 @@ typedef struct{
     uint32_t            mask;
     void               *object;
     void              (*pFunct)(void *object, const CO_CANrxMsg_t *message);
+#ifdef CO_USE_STATISTICS
+    uint32_t            rxCount;
+#endif
 }CO_CANrx_t;
 
 
@@ -132,11 +148,23 @@ typedef struct{
 }CO_CANtx_t;
 
 
+/* Statistics counters of the CAN module. */
+#ifdef CO_USE_STATISTICS
+typedef struct{
+    uint32_t            rxMsg;
+    uint32_t            rxUnmatched;
+    uint32_t            rxError;
+    uint32_t            txMsg;
+    uint32_t            txOverflow;
+}CO_CANstats_t;
+#endif
+
+
 /* CAN module object. */
 typedef struct{
     int32_t             CANbaseAddress;
 #ifdef CO_LOG_CAN_MESSAGES
-    CO_CANtx_t          txRecord;
+    struct CO_CANlog_t *log;        /* CAN logger, set by application, may be NULL */
 #endif
     CO_CANrx_t         *rxArray;
     uint16_t            rxSize;
@@ -153,6 +181,9 @@ typedef struct{
     volatile uint16_t   CANtxCount;
     uint32_t            errOld;
     void               *em;
+#ifdef CO_USE_STATISTICS
+    CO_CANstats_t       stats;
+#endif
 }CO_CANmodule_t;
 
 
@@ -234,4 +265,13 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule);
 void CO_CANrxWait(CO_CANmodule_t *CANmodule);
 
 
+/* Process received CAN message: find matching receive buffer and call its
+ * function. It is used by CO_CANrxWait() and by CO_replay_t.
+ *
+ * @param CANmodule This object.
+ * @param rcvMsg Received message, layout of struct can_frame.
+ */
+void CO_CANrxDispatch(CO_CANmodule_t *CANmodule, const CO_CANrxMsg_t *rcvMsg);
+
+
 #endif
@@ -0,0 +1,255 @@
+/*
+ * Replay of candump log files into CANopenNode.
+ *
+ * @file        CO_replay.c
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_replay.h"
+#include <string.h>
+
+
+/* Active replay object, used by CO_replay_txMessage(). */
+static CO_replay_t *CO_replayActive = NULL;
+
+
+static int hexValue(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+
+/* Parse one line of 'candump -l' format: "(1436509052.249713) can0 123#DEADBEEF".
+ * Returns true, if frame was parsed. */
+static bool_t parseLine(const char *line, struct can_frame *frame, uint64_t *time_us) {
+    unsigned long sec;
+    char frac[16];
+    char frameStr[64];
+    const char *p;
+    uint32_t ident = 0;
+    int nId = 0, i, h;
+    uint32_t usec = 0;
+
+    if(sscanf(line, " (%lu.%15[0-9]) %*s %63s", &sec, frac, frameStr) != 3) {
+        return false;
+    }
+    /* fraction to microseconds */
+    for(i = 0; i < 6; i++) {
+        usec = usec * 10 + ((frac[i] != 0) ? (uint32_t)(frac[i] - '0') : 0);
+        if(frac[i] == 0) {
+            /* pad remaining digits with zeros */
+            for(i++; i < 6; i++) usec *= 10;
+            break;
+        }
+    }
+    *time_us = (uint64_t)sec * 1000000 + usec;
+
+    /* identifier */
+    for(p = frameStr; (h = hexValue(*p)) >= 0; p++, nId++) {
+        ident = (ident << 4) | (uint32_t)h;
+    }
+    if(*p++ != '#' || nId == 0 || nId > 8) {
+        return false;
+    }
+    if(*p == '#') {
+        return false;   /* CAN FD frame */
+    }
+
+    memset(frame, 0, sizeof(*frame));
+    frame->can_id = (nId > 3) ? ((ident & CAN_EFF_MASK) | CAN_EFF_FLAG) : (ident & CAN_SFF_MASK);
+
+    /* remote frame, optionally with DLC: "123#R" or "123#R4" */
+    if(*p == 'R' || *p == 'r') {
+        frame->can_id |= CAN_RTR_FLAG;
+        h = hexValue(p[1]);
+        frame->can_dlc = (h >= 0 && h <= 8) ? (uint8_t)h : 0;
+        return true;
+    }
+
+    /* data bytes, optionally separated by '.' */
+    while(*p != 0) {
+        int hi, lo;
+
+        if(*p == '.') {
+            p++;
+            continue;
+        }
+        hi = hexValue(p[0]);
+        lo = (hi >= 0) ? hexValue(p[1]) : -1;
+        if(lo < 0 || frame->can_dlc >= 8) {
+            return false;
+        }
+        frame->data[frame->can_dlc++] = (uint8_t)((hi << 4) | lo);
+        p += 2;
+    }
+    return true;
+}
+
+
+/* Read next valid frame from input log. */
+static void readNext(CO_replay_t *replay) {
+    char line[256];
+
+    replay->nextValid = false;
+    while(fgets(line, sizeof(line), replay->fin) != NULL) {
+        if(parseLine(line, &replay->next, &replay->nextTime_us)) {
+            replay->nextValid = true;
+            return;
+        }
+        if(line[0] != '\n' && line[0] != '#') {
+            replay->skipped++;
+        }
+    }
+    replay->eof = true;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_replay_init(
+        CO_replay_t            *replay,
+        CO_CANmodule_t         *CANmodule,
+        FILE                   *fin,
+        FILE                   *fout,
+        const char             *ifName,
+        float64_t               speed)
+{
+    if(replay == NULL || CANmodule == NULL || fin == NULL || speed < 0) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    replay->CANmodule = CANmodule;
+    replay->fin = fin;
+    replay->fout = fout;
+    replay->ifName = (ifName != NULL) ? ifName : "can0";
+    replay->speed = speed;
+    replay->maxBurst = 1;
+    replay->eof = false;
+    replay->started = false;
+    replay->nextValid = false;
+    replay->logStart_us = 0;
+    replay->start_ns = 0;
+    replay->logTime_us = 0;
+    replay->rxFrames = 0;
+    replay->txFrames = 0;
+    replay->skipped = 0;
+
+    readNext(replay);
+    if(replay->nextValid) {
+        replay->logStart_us = replay->nextTime_us;
+        replay->logTime_us = replay->nextTime_us;
+    }
+
+    CO_replayActive = replay;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+uint32_t CO_replay_process(CO_replay_t *replay, uint64_t now_ns, uint64_t *next_ns) {
+    uint32_t count = 0;
+
+    if(!replay->started) {
+        replay->started = true;
+        replay->start_ns = now_ns;
+    }
+
+    if(replay->speed > 0) {
+        /* Current time in time base of input log */
+        replay->logTime_us = replay->logStart_us +
+            (uint64_t)((float64_t)(now_ns - replay->start_ns) * replay->speed / 1000);
+
+        while(replay->nextValid && replay->nextTime_us <= replay->logTime_us) {
+            if(replay->CANmodule->CANnormal) {
+                CO_CANrxDispatch(replay->CANmodule, (CO_CANrxMsg_t *) &replay->next);
+            }
+            replay->rxFrames++;
+            count++;
+            readNext(replay);
+        }
+
+        if(next_ns != NULL) {
+            *next_ns = now_ns;
+            if(replay->nextValid) {
+                /* round up, so frame is surely due at next_ns */
+                *next_ns = replay->start_ns + (uint64_t)((float64_t)
+                    (replay->nextTime_us - replay->logStart_us) * 1000 / replay->speed) + 1;
+            }
+        }
+    }
+    else {
+        /* As fast as possible, log time follows dispatched frames. */
+        while(replay->nextValid && count < replay->maxBurst) {
+            replay->logTime_us = replay->nextTime_us;
+            if(replay->CANmodule->CANnormal) {
+                CO_CANrxDispatch(replay->CANmodule, (CO_CANrxMsg_t *) &replay->next);
+            }
+            replay->rxFrames++;
+            count++;
+            readNext(replay);
+        }
+
+        if(next_ns != NULL) {
+            *next_ns = now_ns;
+        }
+    }
+
+    return count;
+}
+
+
+/******************************************************************************/
+ssize_t CO_replay_txMessage(CO_CANmodule_t *CANmodule, const CO_CANtx_t *buffer) {
+    CO_replay_t *replay = CO_replayActive;
+
+    if(replay != NULL) {
+        replay->txFrames++;
+
+        if(replay->fout != NULL) {
+            const struct can_frame *frame = (const struct can_frame *) buffer;
+            int i;
+
+            fprintf(replay->fout, "(%010llu.%06llu) %s ",
+                    (unsigned long long)(replay->logTime_us / 1000000),
+                    (unsigned long long)(replay->logTime_us % 1000000),
+                    replay->ifName);
+            if(frame->can_id & CAN_EFF_FLAG) {
+                fprintf(replay->fout, "%08X#", frame->can_id & CAN_EFF_MASK);
+            }
+            else {
+                fprintf(replay->fout, "%03X#", frame->can_id & CAN_SFF_MASK);
+            }
+            if(frame->can_id & CAN_RTR_FLAG) {
+                fprintf(replay->fout, "R");
+            }
+            else {
+                for(i = 0; i < frame->can_dlc && i < 8; i++) {
+                    fprintf(replay->fout, "%02X", frame->data[i]);
+                }
+            }
+            fprintf(replay->fout, "\n");
+        }
+    }
+
+    return sizeof(struct can_frame);
+}
@@ -0,0 +1,125 @@
+/**
+ * Replay of candump log files into CANopenNode.
+ *
+ * @file        CO_replay.h
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_REPLAY_H
+#define CO_REPLAY_H
+
+#include <stdio.h>
+
+
+/**
+ * Replay object.
+ *
+ * Frames from log file, written by 'candump -l', are passed to
+ * CO_CANrxDispatch() at original or scaled timing, or as fast as possible.
+ * All frames, transmitted by the stack, are written to the output file in
+ * the same format, so it can be compared with golden output log.
+ *
+ * Stack must be compiled with CO_CAN_REPLAY defined (see CO_driver.h). Then
+ * CAN socket is not used and any nonzero CANbaseAddress may be passed to
+ * CO_init(). Only one replay object may be active.
+ *
+ * Replay runs on the time of the caller, for example CLOCK_MONOTONIC or
+ * virtual clock from CO_Linux_vclock.h. Timestamps in the output file are
+ * in the time base of the input log, so output is reproducible.
+ *
+ * Usage:
+ * @code
+ * CO_replay_init(&replay, CO->CANmodule[0], fin, fout, "can0", 1.0);
+ * while(!replay.eof) {
+ *     uint64_t next_ns;
+ *     CO_replay_process(&replay, now_ns, &next_ns);
+ *     ... CO_process(), CO_process_SYNC_RPDO(), CO_process_TPDO(),
+ *         wait until next_ns or until timer of mainline expires ...
+ * }
+ * @endcode
+ */
+typedef struct {
+    CO_CANmodule_t     *CANmodule;      /**< From CO_replay_init() */
+    FILE               *fin;            /**< From CO_replay_init() */
+    FILE               *fout;           /**< From CO_replay_init() */
+    const char         *ifName;         /**< From CO_replay_init() */
+    float64_t           speed;          /**< From CO_replay_init() */
+    /** Maximum number of frames dispatched in one CO_replay_process() call,
+     * if speed is 0. Default is 1, so stack may respond after each frame. */
+    uint32_t            maxBurst;
+    bool_t              eof;            /**< True, if end of input log */
+    bool_t              started;        /**< True after first call to CO_replay_process() */
+    bool_t              nextValid;      /**< True, if 'next' contains frame */
+    struct can_frame    next;           /**< Next frame from input log */
+    uint64_t            nextTime_us;    /**< Log timestamp of the next frame */
+    uint64_t            logStart_us;    /**< Log timestamp of the first frame */
+    uint64_t            start_ns;       /**< Caller time of the first frame */
+    uint64_t            logTime_us;     /**< Current time in time base of input log */
+    uint32_t            rxFrames;       /**< Number of dispatched frames */
+    uint32_t            txFrames;       /**< Number of frames transmitted by stack */
+    uint32_t            skipped;        /**< Number of unparsable or CAN FD lines */
+} CO_replay_t;
+
+
+/**
+ * Initialize replay object.
+ *
+ * @param replay This object will be initialized.
+ * @param CANmodule CAN module, to which frames are dispatched.
+ * @param fin Input log file in 'candump -l' format.
+ * @param fout Output file for transmitted frames. May be NULL.
+ * @param ifName Interface name written to the output file.
+ * @param speed 1.0 for original timing, 2.0 for twice as fast, etc.
+ * 0 for as fast as possible.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_replay_init(
+        CO_replay_t            *replay,
+        CO_CANmodule_t         *CANmodule,
+        FILE                   *fin,
+        FILE                   *fout,
+        const char             *ifName,
+        float64_t               speed);
+
+/**
+ * Dispatch frames from input log, which are due.
+ *
+ * First call defines time of the first frame. Function must be called
+ * cyclically, together with processing functions of the stack.
+ *
+ * @param replay This object.
+ * @param now_ns Current time of the caller in nanoseconds.
+ * @param [out] next_ns Time, when next frame is due. If speed is 0, it
+ * is equal to now_ns. May be NULL.
+ *
+ * @return Number of dispatched frames.
+ */
+uint32_t CO_replay_process(CO_replay_t *replay, uint64_t now_ns, uint64_t *next_ns);
+
+/**
+ * Transmit function for stack compiled with CO_CAN_REPLAY, called from
+ * CO_CANsend(). Frame is written to the output file of active replay object.
+ *
+ * @return sizeof(struct can_frame).
+ */
+ssize_t CO_replay_txMessage(CO_CANmodule_t *CANmodule, const CO_CANtx_t *buffer);
+
+#endif
@@ -0,0 +1,558 @@
+/*
+ * CAN module object for in-process virtual CAN bus.
+ *
+ * @file        CO_driver.c
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_Emergency.h"
+#include <string.h> /* for memcpy */
+
+
+CO_VCANbus_t CO_VCANbus[CO_VCAN_NO_BUSES];
+
+
+/* Disconnect CAN module from any bus. Returns true, if it was connected. */
+static bool_t CO_VCAN_unlink(CO_CANmodule_t *CANmodule){
+    uint16_t i;
+
+    for(i=0U; i<CO_VCAN_NO_BUSES; i++){
+        CO_CANmodule_t **pp = &CO_VCANbus[i].first;
+
+        while(*pp != NULL){
+            if(*pp == CANmodule){
+                *pp = CANmodule->next;
+                CANmodule->next = NULL;
+                return true;
+            }
+            pp = &(*pp)->next;
+        }
+    }
+    return false;
+}
+
+
+/******************************************************************************/
+void CO_CANsetConfigurationMode(int32_t CANbaseAddress){
+    /* Put CAN module in configuration mode */
+}
+
+
+/******************************************************************************/
+void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
+    /* Put CAN module in normal mode */
+
+    CANmodule->CANnormal = true;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANmodule_init(
+        CO_CANmodule_t         *CANmodule,
+        int32_t                 CANbaseAddress,
+        CO_CANrx_t              rxArray[],
+        uint16_t                rxSize,
+        CO_CANtx_t              txArray[],
+        uint16_t                txSize,
+        uint16_t                CANbitRate)
+{
+    uint16_t i;
+    CO_VCANbus_t *bus;
+
+    /* verify arguments */
+    if(CANmodule==NULL || rxArray==NULL || txArray==NULL
+        || CANbaseAddress < 0 || CANbaseAddress >= CO_VCAN_NO_BUSES){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    bus = &CO_VCANbus[CANbaseAddress];
+    if(bus->bitTime_ps == 0U){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Module may be initialized again on communication reset. */
+    CO_VCAN_unlink(CANmodule);
+
+    /* Configure object variables */
+    CANmodule->CANbaseAddress = CANbaseAddress;
+    CANmodule->rxArray = rxArray;
+    CANmodule->rxSize = rxSize;
+    CANmodule->txArray = txArray;
+    CANmodule->txSize = txSize;
+    CANmodule->CANnormal = false;
+    CANmodule->useCANrxFilters = false;
+    CANmodule->bufferInhibitFlag = false;
+    CANmodule->firstCANtxMessage = true;
+    CANmodule->CANtxCount = 0U;
+    CANmodule->errOld = 0U;
+    CANmodule->em = NULL;
+    CANmodule->txQueue = NULL;
+    CANmodule->txQueueSize = 0U;
+    CANmodule->txQueueRd = 0U;
+    CANmodule->txQueueCount = 0U;
+#ifdef CO_USE_STATISTICS
+    CANmodule->stats.rxMsg = 0U;
+    CANmodule->stats.rxUnmatched = 0U;
+    CANmodule->stats.rxError = 0U;
+    CANmodule->stats.txMsg = 0U;
+    CANmodule->stats.txOverflow = 0U;
+#endif
+
+    for(i=0U; i<rxSize; i++){
+        rxArray[i].ident = 0U;
+        rxArray[i].pFunct = NULL;
+#ifdef CO_USE_STATISTICS
+        rxArray[i].rxCount = 0U;
+#endif
+    }
+    for(i=0U; i<txSize; i++){
+        txArray[i].bufferFull = false;
+    }
+
+    /* Connect to the bus, at the end of the list */
+    CANmodule->bus = bus;
+    CANmodule->next = NULL;
+    if(bus->first == NULL){
+        bus->first = CANmodule;
+    }
+    else{
+        CO_CANmodule_t *last = bus->first;
+        while(last->next != NULL){
+            last = last->next;
+        }
+        last->next = CANmodule;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_CANmodule_disable(CO_CANmodule_t *CANmodule){
+    CO_VCAN_unlink(CANmodule);
+    CANmodule->bus = NULL;
+    CANmodule->CANnormal = false;
+}
+
+
+/******************************************************************************/
+uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg){
+    return (uint16_t) (rxMsg->ident & 0x07FFU);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANrxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        uint16_t                mask,
+        bool_t                  rtr,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message))
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    if((CANmodule!=NULL) && (object!=NULL) && (pFunct!=NULL) && (index < CANmodule->rxSize)){
+        /* buffer, which will be configured */
+        CO_CANrx_t *buffer = &CANmodule->rxArray[index];
+
+        /* Configure object variables */
+        buffer->object = object;
+        buffer->pFunct = pFunct;
+
+        /* CAN identifier and CAN mask, RTR in bit 11 */
+        buffer->ident = ident & 0x07FFU;
+        if(rtr){
+            buffer->ident |= 0x0800U;
+        }
+        buffer->mask = (mask & 0x07FFU) | 0x0800U;
+    }
+    else{
+        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_CANtx_t *CO_CANtxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        bool_t                  rtr,
+        uint8_t                 noOfBytes,
+        bool_t                  syncFlag)
+{
+    CO_CANtx_t *buffer = NULL;
+
+    if((CANmodule != NULL) && (index < CANmodule->txSize)){
+        /* get specific buffer */
+        buffer = &CANmodule->txArray[index];
+
+        /* CAN identifier and RTR in bit 11 */
+        buffer->ident = (uint32_t)ident & 0x07FFU;
+        if(rtr){
+            buffer->ident |= 0x0800U;
+        }
+        buffer->DLC = (noOfBytes <= 8U) ? noOfBytes : 8U;
+
+        buffer->bufferFull = false;
+        buffer->syncFlag = syncFlag;
+    }
+
+    return buffer;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    CO_ReturnError_t err = CO_ERROR_NO;
+
+#ifdef CO_USE_STATISTICS
+    CO_STAT_INC(CANmodule->stats.txMsg);
+#endif
+    CO_LOCK_CAN_SEND();
+    /* Copy message into transmit queue, if used */
+    if(CANmodule->txQueue != NULL){
+        if(CANmodule->txQueueCount >= CANmodule->txQueueSize){
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, buffer->ident);
+            err = CO_ERROR_TX_OVERFLOW;
+#ifdef CO_USE_STATISTICS
+            CO_STAT_INC(CANmodule->stats.txOverflow);
+#endif
+        }
+        else{
+            uint16_t wr = CANmodule->txQueueRd + CANmodule->txQueueCount;
+
+            if(wr >= CANmodule->txQueueSize){
+                wr -= CANmodule->txQueueSize;
+            }
+            memcpy(&CANmodule->txQueue[wr], buffer, sizeof(CO_CANtx_t));
+            CANmodule->txQueue[wr].bufferFull = true;
+            CANmodule->txQueueCount++;
+            CANmodule->CANtxCount++;
+        }
+    }
+    /* Verify overflow, previous message is still waiting for the bus */
+    else if(buffer->bufferFull){
+        if(!CANmodule->firstCANtxMessage){
+            /* don't set error, if bootup message is still on buffers */
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, buffer->ident);
+        }
+        err = CO_ERROR_TX_OVERFLOW;
+#ifdef CO_USE_STATISTICS
+        CO_STAT_INC(CANmodule->stats.txOverflow);
+#endif
+    }
+    /* message will be sent, when it wins arbitration in CO_VCANbus_process() */
+    else{
+        buffer->bufferFull = true;
+        CANmodule->CANtxCount++;
+    }
+    CO_UNLOCK_CAN_SEND();
+
+    return err;
+}
+
+
+/******************************************************************************/
+void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule){
+    uint32_t tpdoDeleted = 0U;
+
+    CO_LOCK_CAN_SEND();
+    /* delete pending synchronous TPDOs in TX buffers. Message, which is
+     * currently on the bus, is already transmitted. */
+    if(CANmodule->CANtxCount != 0U){
+        uint16_t i;
+        CO_CANtx_t *buffer = &CANmodule->txArray[0];
+        for(i = CANmodule->txSize; i > 0U; i--){
+            if(buffer->bufferFull){
+                if(buffer->syncFlag){
+                    buffer->bufferFull = false;
+                    CANmodule->CANtxCount--;
+                    tpdoDeleted = 2U;
+                }
+            }
+            buffer++;
+        }
+    }
+    CO_UNLOCK_CAN_SEND();
+
+
+    if(tpdoDeleted != 0U){
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_TPDO_OUTSIDE_WINDOW, CO_EMC_COMMUNICATION, tpdoDeleted);
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
+    /* Virtual bus has no error frames, error counters are always zero. */
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_VCANmodule_initTxQueue(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANtx_t              txQueue[],
+        uint16_t                txQueueSize)
+{
+    if(CANmodule == NULL || (txQueue != NULL && txQueueSize == 0U)){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    CO_LOCK_CAN_SEND();
+    CANmodule->CANtxCount -= CANmodule->txQueueCount;
+    CANmodule->txQueue = txQueue;
+    CANmodule->txQueueSize = (txQueue != NULL) ? txQueueSize : 0U;
+    CANmodule->txQueueRd = 0U;
+    CANmodule->txQueueCount = 0U;
+    CO_UNLOCK_CAN_SEND();
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_VCANbus_init(CO_VCANbus_t *bus, uint16_t CANbitRate){
+    if(bus == NULL || CANbitRate == 0U || CANbitRate > 1000U){
+        return CO_ERROR_ILLEGAL_BAUDRATE;
+    }
+
+    bus->first = NULL;
+    bus->bitTime_ps = 1000000000UL / CANbitRate;
+    bus->time_ns = 0U;
+    bus->frames = 0U;
+    bus->bits = 0U;
+    bus->busyTime_ns = 0U;
+    bus->pFunctTx = NULL;
+    bus->functTxObject = NULL;
+
+    return CO_ERROR_NO;
+}
+
+
+/*
+ * Helper for counting bits of the CAN frame. Bits are added MSB first. CRC is
+ * calculated and stuff bits are inserted after five equal consecutive bits.
+ */
+typedef struct{
+    uint16_t            crc;
+    uint16_t            bits;
+    uint8_t             last;
+    uint8_t             run;
+}CO_VCAN_frameBits_t;
+
+static void CO_VCAN_addBits(CO_VCAN_frameBits_t *f, uint32_t value, uint8_t n, bool_t addToCRC){
+    while(n > 0U){
+        uint8_t bit;
+
+        n--;
+        bit = (uint8_t)((value >> n) & 1U);
+
+        if(addToCRC){
+            uint16_t crcNext = (uint16_t)(bit ^ ((f->crc >> 14) & 1U));
+            f->crc = (uint16_t)((f->crc << 1) & 0x7FFFU);
+            if(crcNext != 0U){
+                f->crc ^= 0x4599U;
+            }
+        }
+
+        f->bits++;
+        if(bit == f->last){
+            if(++f->run == 5U){
+                /* stuff bit has opposite value and starts new sequence */
+                f->bits++;
+                f->last = (uint8_t)(bit ^ 1U);
+                f->run = 1U;
+            }
+        }
+        else{
+            f->last = bit;
+            f->run = 1U;
+        }
+    }
+}
+
+
+/* Number of bits of the standard CAN frame on the bus. */
+static uint16_t CO_VCAN_frameBits(const CO_CANtx_t *msg){
+    CO_VCAN_frameBits_t f;
+    bool_t rtr = (msg->ident & 0x0800U) != 0U;
+    uint8_t DLC = msg->DLC;
+    uint8_t i;
+
+    f.crc = 0U;
+    f.bits = 0U;
+    f.last = 2U;
+    f.run = 0U;
+
+    CO_VCAN_addBits(&f, 0U, 1U, true);                      /* SOF */
+    CO_VCAN_addBits(&f, msg->ident & 0x07FFU, 11U, true);   /* identifier */
+    CO_VCAN_addBits(&f, rtr ? 1U : 0U, 1U, true);           /* RTR */
+    CO_VCAN_addBits(&f, 0U, 2U, true);                      /* IDE, r0 */
+    CO_VCAN_addBits(&f, DLC, 4U, true);                     /* DLC */
+    if(!rtr){
+        for(i=0U; i<DLC; i++){
+            CO_VCAN_addBits(&f, msg->data[i], 8U, true);
+        }
+    }
+    CO_VCAN_addBits(&f, f.crc, 15U, false);                 /* CRC */
+
+    /* CRC delimiter, ACK slot, ACK delimiter, EOF and interframe space */
+    f.bits += 1U + 2U + 7U + 3U;
+
+    return f.bits;
+}
+
+
+/******************************************************************************/
+uint32_t CO_VCANbus_frameTime(const CO_VCANbus_t *bus, const CO_CANtx_t *msg){
+    return (uint32_t)(((uint64_t)CO_VCAN_frameBits(msg) * bus->bitTime_ps) / 1000U);
+}
+
+
+/******************************************************************************/
+uint32_t CO_VCANbus_process(CO_VCANbus_t *bus, uint64_t time_ns){
+    uint32_t count = 0U;
+
+    while(bus->time_ns < time_ns){
+        CO_CANmodule_t *CANmodule;
+        CO_CANmodule_t *sender = NULL;
+        CO_CANtx_t *winner = NULL;
+        uint32_t winnerPrio = 0xFFFFFFFFUL;
+        CO_CANtx_t msg;
+        CO_CANrxMsg_t rcvMsg;
+        uint16_t bits;
+        uint32_t duration;
+
+        /* Arbitration. Lower identifier wins, data frame wins over RTR
+         * frame. On equal priority the module connected first wins. */
+        for(CANmodule = bus->first; CANmodule != NULL; CANmodule = CANmodule->next){
+            uint16_t i;
+            CO_CANtx_t *buffer;
+
+            if(CANmodule->CANtxCount == 0U || !CANmodule->CANnormal){
+                continue;
+            }
+            buffer = &CANmodule->txArray[0];
+            for(i = CANmodule->txSize; i > 0U; i--){
+                if(buffer->bufferFull){
+                    uint32_t prio = ((buffer->ident & 0x07FFU) << 1) | ((buffer->ident >> 11) & 1U);
+                    if(prio < winnerPrio){
+                        winnerPrio = prio;
+                        winner = buffer;
+                        sender = CANmodule;
+                    }
+                }
+                buffer++;
+            }
+            /* the oldest message in the transmit queue */
+            if(CANmodule->txQueueCount != 0U){
+                uint32_t prio;
+
+                buffer = &CANmodule->txQueue[CANmodule->txQueueRd];
+                prio = ((buffer->ident & 0x07FFU) << 1) | ((buffer->ident >> 11) & 1U);
+                if(prio < winnerPrio){
+                    winnerPrio = prio;
+                    winner = buffer;
+                    sender = CANmodule;
+                }
+            }
+        }
+
+        /* bus is idle */
+        if(winner == NULL){
+            bus->time_ns = time_ns;
+            break;
+        }
+
+        /* Transmit. Buffer is released before delivery, so it may be reused
+         * by the receive functions. */
+        memcpy(&msg, winner, sizeof(msg));
+        CO_LOCK_CAN_SEND();
+        winner->bufferFull = false;
+        if((sender->txQueueCount != 0U) && (winner == &sender->txQueue[sender->txQueueRd])){
+            sender->txQueueCount--;
+            sender->txQueueRd++;
+            if(sender->txQueueRd >= sender->txQueueSize){
+                sender->txQueueRd = 0U;
+            }
+        }
+        sender->CANtxCount--;
+        sender->firstCANtxMessage = false;
+        CO_UNLOCK_CAN_SEND();
+
+        bits = CO_VCAN_frameBits(&msg);
+        duration = (uint32_t)(((uint64_t)bits * bus->bitTime_ps) / 1000U);
+        bus->time_ns += duration;
+        bus->busyTime_ns += duration;
+        bus->bits += bits;
+        bus->frames++;
+        count++;
+
+        if(bus->pFunctTx != NULL){
+            bus->pFunctTx(bus->functTxObject, bus->time_ns, &msg);
+        }
+
+        /* Deliver to all other modules */
+        rcvMsg.ident = msg.ident & 0x0FFFU;
+        rcvMsg.DLC = msg.DLC;
+        memcpy(rcvMsg.data, msg.data, sizeof(rcvMsg.data));
+
+        for(CANmodule = bus->first; CANmodule != NULL; CANmodule = CANmodule->next){
+            uint16_t i;
+            CO_CANrx_t *buffer;
+            bool_t msgMatched = false;
+
+            if(CANmodule == sender || !CANmodule->CANnormal){
+                continue;
+            }
+
+            buffer = &CANmodule->rxArray[0];
+            for(i = CANmodule->rxSize; i > 0U; i--){
+                if((buffer->pFunct != NULL)
+                    && (((rcvMsg.ident ^ buffer->ident) & buffer->mask) == 0U)){
+                    msgMatched = true;
+                    break;
+                }
+                buffer++;
+            }
+
+#ifdef CO_USE_STATISTICS
+            CO_STAT_INC(CANmodule->stats.rxMsg);
+            if(msgMatched){
+                CO_STAT_INC(buffer->rxCount);
+            }
+            else{
+                CO_STAT_INC(CANmodule->stats.rxUnmatched);
+            }
+#endif
+            /* Call specific function, which will process the message */
+            if(msgMatched){
+                buffer->pFunct(buffer->object, &rcvMsg);
+            }
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,329 @@
+/*
+ * CAN module object for in-process virtual CAN bus.
+ *
+ * @file        CO_driver.h
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_DRIVER_H
+#define CO_DRIVER_H
+
+
+/* For documentation see file drvTemplate/CO_driver.h */
+
+
+/*
+ * Virtual CAN bus connects any number of CO_CANmodule_t objects inside one
+ * process. There are no threads and no system calls. Simulation is driven by
+ * the application: it calls processing functions of the CANopen objects and
+ * CO_VCANbus_process(), which advances simulated time of the bus.
+ *
+ * CO_CANsend() only marks the message as pending. When the bus is idle, all
+ * pending messages from all connected CAN modules take part in arbitration.
+ * Message with the lowest identifier wins (data frame wins over RTR frame with
+ * the same identifier) and occupies the bus for its exact number of bits,
+ * including stuff bits, at the bus bit rate. After transmission it is
+ * delivered to all other CAN modules on the bus, which call the receive
+ * functions of the matching CO_CANrx_t.
+ *
+ * CANbaseAddress in CO_CANmodule_init() is the index of the bus in
+ * CO_VCANbus[], which must be initialized before with CO_VCANbus_init().
+ */
+
+
+#include <stddef.h>         /* for 'NULL' */
+#include <stdint.h>         /* for 'int8_t' to 'uint64_t' */
+#include <stdbool.h>        /* for 'true', 'false' */
+
+
+/* general configuration */
+#ifndef CO_VCAN_NO_BUSES
+    #define CO_VCAN_NO_BUSES        4       /* Number of virtual CAN buses in CO_VCANbus[] */
+#endif
+
+
+/* Critical sections, simulation is single threaded */
+    #define CO_LOCK_CAN_SEND()
+    #define CO_UNLOCK_CAN_SEND()
+
+    #define CO_LOCK_EMCY()
+    #define CO_UNLOCK_EMCY()
+
+    #define CO_LOCK_OD()
+    #define CO_UNLOCK_OD()
+
+
+/* Statistics counters, relaxed atomic access */
+#ifdef CO_USE_STATISTICS
+    #define CO_STAT_INC(cnt)        __atomic_fetch_add(&(cnt), 1U, __ATOMIC_RELAXED)
+    #define CO_STAT_GET(cnt)        __atomic_load_n(&(cnt), __ATOMIC_RELAXED)
+#endif
+
+
+/* Data types */
+    /* int8_t to uint64_t are defined in stdint.h */
+    typedef unsigned char           bool_t;
+    typedef float                   float32_t;
+    typedef double                  float64_t;
+    typedef char                    char_t;
+    typedef unsigned char           oChar_t;
+    typedef unsigned char           domain_t;
+
+
+/* Return values */
+typedef enum{
+    CO_ERROR_NO                 = 0,
+    CO_ERROR_ILLEGAL_ARGUMENT   = -1,
+    CO_ERROR_OUT_OF_MEMORY      = -2,
+    CO_ERROR_TIMEOUT            = -3,
+    CO_ERROR_ILLEGAL_BAUDRATE   = -4,
+    CO_ERROR_RX_OVERFLOW        = -5,
+    CO_ERROR_RX_PDO_OVERFLOW    = -6,
+    CO_ERROR_RX_MSG_LENGTH      = -7,
+    CO_ERROR_RX_PDO_LENGTH      = -8,
+    CO_ERROR_TX_OVERFLOW        = -9,
+    CO_ERROR_TX_PDO_WINDOW      = -10,
+    CO_ERROR_TX_UNCONFIGURED    = -11,
+    CO_ERROR_PARAMETERS         = -12,
+    CO_ERROR_DATA_CORRUPT       = -13,
+    CO_ERROR_CRC                = -14
+}CO_ReturnError_t;
+
+
+/* CAN receive message structure. Identifier: bits 0..10 + RTR (bit 11). */
+typedef struct{
+    uint32_t            ident;
+    uint8_t             DLC;
+    uint8_t             data[8];
+}CO_CANrxMsg_t;
+
+
+/* Received message object */
+typedef struct{
+    uint16_t            ident;
+    uint16_t            mask;
+    void               *object;
+    void              (*pFunct)(void *object, const CO_CANrxMsg_t *message);
+#ifdef CO_USE_STATISTICS
+    uint32_t            rxCount;
+#endif
+}CO_CANrx_t;
+
+
+/* Transmit message object. Identifier: bits 0..10 + RTR (bit 11). */
+typedef struct{
+    uint32_t            ident;
+    uint8_t             DLC;
+    uint8_t             data[8];
+    volatile bool_t     bufferFull;
+    volatile bool_t     syncFlag;
+}CO_CANtx_t;
+
+
+/* Statistics counters of the CAN module. */
+#ifdef CO_USE_STATISTICS
+typedef struct{
+    uint32_t            rxMsg;
+    uint32_t            rxUnmatched;
+    uint32_t            rxError;
+    uint32_t            txMsg;
+    uint32_t            txOverflow;
+}CO_CANstats_t;
+#endif
+
+
+/* CAN module object. */
+typedef struct CO_CANmodule_t{
+    int32_t             CANbaseAddress; /* Index of the bus in CO_VCANbus[] */
+    CO_CANrx_t         *rxArray;
+    uint16_t            rxSize;
+    CO_CANtx_t         *txArray;
+    uint16_t            txSize;
+    volatile bool_t     CANnormal;
+    volatile bool_t     useCANrxFilters;
+    volatile bool_t     bufferInhibitFlag;
+    volatile bool_t     firstCANtxMessage;
+    volatile uint16_t   CANtxCount;
+    uint32_t            errOld;
+    void               *em;
+    struct CO_VCANbus_t *bus;           /* Bus, to which module is connected */
+    struct CO_CANmodule_t *next;        /* Next module connected to the same bus */
+    CO_CANtx_t         *txQueue;        /* Optional transmit queue, see CO_VCANmodule_initTxQueue() */
+    uint16_t            txQueueSize;
+    uint16_t            txQueueRd;      /* Index of the oldest message in txQueue */
+    uint16_t            txQueueCount;   /* Number of messages in txQueue */
+#ifdef CO_USE_STATISTICS
+    CO_CANstats_t       stats;
+#endif
+}CO_CANmodule_t;
+
+
+/* Virtual CAN bus object. */
+typedef struct CO_VCANbus_t{
+    CO_CANmodule_t     *first;          /* List of connected CAN modules */
+    uint32_t            bitTime_ps;     /* Duration of one bit in picoseconds */
+    uint64_t            time_ns;        /* Current simulated time */
+    uint32_t            frames;         /* Number of transmitted frames */
+    uint64_t            bits;           /* Number of transmitted bits, including stuff bits */
+    uint64_t            busyTime_ns;    /* Sum of frame durations, for bus load calculation */
+    /* Optional callback, called for each transmitted frame, before it is
+     * delivered. It may be used for logging. */
+    void              (*pFunctTx)(void *object, uint64_t time_ns, const CO_CANtx_t *msg);
+    void               *functTxObject;
+}CO_VCANbus_t;
+
+
+/* Virtual CAN buses. */
+extern CO_VCANbus_t CO_VCANbus[CO_VCAN_NO_BUSES];
+
+
+/* Endianes */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    #define CO_BIG_ENDIAN
+#else
+    #define CO_LITTLE_ENDIAN
+#endif
+
+
+/* Request CAN configuration or normal mode */
+void CO_CANsetConfigurationMode(int32_t CANbaseAddress);
+void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule);
+
+
+/* Initialize CAN module object and connect it to the bus CO_VCANbus[CANbaseAddress]. */
+CO_ReturnError_t CO_CANmodule_init(
+        CO_CANmodule_t         *CANmodule,
+        int32_t                 CANbaseAddress,
+        CO_CANrx_t              rxArray[],
+        uint16_t                rxSize,
+        CO_CANtx_t              txArray[],
+        uint16_t                txSize,
+        uint16_t                CANbitRate); /* not used, see CO_VCANbus_init() */
+
+
+/* Switch off CANmodule and disconnect it from the bus. */
+void CO_CANmodule_disable(CO_CANmodule_t *CANmodule);
+
+
+/* Read CAN identifier */
+uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg);
+
+
+/* Configure CAN message receive buffer. */
+CO_ReturnError_t CO_CANrxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        uint16_t                mask,
+        bool_t                  rtr,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message));
+
+
+/* Configure CAN message transmit buffer. */
+CO_CANtx_t *CO_CANtxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        bool_t                  rtr,
+        uint8_t                 noOfBytes,
+        bool_t                  syncFlag);
+
+
+/* Send CAN message. Message is pending until it wins arbitration. */
+CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
+
+
+/* Clear all synchronous TPDOs from CAN module transmit buffers. */
+void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule);
+
+
+/* Verify all errors of CAN module. */
+void CO_CANverifyErrors(CO_CANmodule_t *CANmodule);
+
+
+/**
+ * Initialize virtual CAN bus.
+ *
+ * Bus must be initialized before CAN modules are connected to it.
+ *
+ * @param bus Bus object, usually member of CO_VCANbus[].
+ * @param CANbitRate Bit rate in kbps, for example 125, 250, 500, 1000.
+ *
+ * @return CO_ERROR_NO or CO_ERROR_ILLEGAL_BAUDRATE.
+ */
+CO_ReturnError_t CO_VCANbus_init(CO_VCANbus_t *bus, uint16_t CANbitRate);
+
+
+/**
+ * Initialize optional transmit queue of the CAN module.
+ *
+ * Queue models transmit queue of the network interface in operating system,
+ * for example socketCAN (txqueuelen). CO_CANsend() copies the message into
+ * the queue, so transmit buffer is free immediately. Messages from the queue
+ * are transmitted in order; the oldest one takes part in arbitration. If queue
+ * is full, CO_CANsend() returns CO_ERROR_TX_OVERFLOW and message is not sent.
+ *
+ * Function must be called after CO_CANmodule_init().
+ *
+ * @param CANmodule CAN module.
+ * @param txQueue Array for queued messages, NULL disables the queue.
+ * @param txQueueSize Number of messages in txQueue.
+ *
+ * @return CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_VCANmodule_initTxQueue(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANtx_t              txQueue[],
+        uint16_t                txQueueSize);
+
+
+/**
+ * Process virtual CAN bus.
+ *
+ * Function transmits pending messages in arbitration order and delivers them
+ * to the receivers, until simulated time reaches time_ns. Messages, which are
+ * sent from receive functions, take part in the next arbitration. Transmission
+ * of the frame, which starts before time_ns, is completed, so bus time may
+ * end up slightly after time_ns.
+ *
+ * @param bus Bus object.
+ * @param time_ns Simulated time in nanoseconds, until which bus is processed.
+ *
+ * @return Number of frames transmitted in this call.
+ */
+uint32_t CO_VCANbus_process(CO_VCANbus_t *bus, uint64_t time_ns);
+
+
+/**
+ * Get duration of the CAN frame on the bus.
+ *
+ * Duration is calculated from the exact number of bits of the standard data
+ * or remote frame, including stuff bits and interframe space.
+ *
+ * @param bus Bus object.
+ * @param msg CAN message.
+ *
+ * @return Duration in nanoseconds.
+ */
+uint32_t CO_VCANbus_frameTime(const CO_VCANbus_t *bus, const CO_CANtx_t *msg);
+
+
+#endif